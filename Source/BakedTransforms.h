@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// bakedtransforms.h
+// =================
+// compile-time composition of model and normal matrices for static objects
+//
+// The scale, rotation and position literals used for the static objects in
+// the scene never change, so the translation * rotZ * rotY * rotX * scale
+// product is evaluated by the compiler and emitted as read-only data.  At
+// runtime setting one of these transforms is a single copy into the shader.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  BAKED_VEC3
+ *
+ *  Literal XYZ triple usable in constant expressions.
+ ***********************************************************/
+struct BAKED_VEC3
+{
+	float x;
+	float y;
+	float z;
+};
+
+/***********************************************************
+ *  BAKED_TRANSFORM
+ *
+ *  Column-major model matrix and the matching normal matrix,
+ *  the inverse-transpose of the upper 3x3 of the model
+ *  matrix.  Both use the glm::mat4 layout (OBJECT_TRANSFORM)
+ *  so each can be copied straight into its uniform.
+ ***********************************************************/
+struct BAKED_TRANSFORM
+{
+	float model[16];
+	float normal[16];
+};
+
+namespace BakedMath
+{
+	constexpr double PI = 3.14159265358979323846;
+
+	// wrap an angle in radians into the range [-PI, PI]
+	constexpr double WrapRadians(double radians)
+	{
+		while (radians > PI)
+		{
+			radians -= 2.0 * PI;
+		}
+		while (radians < -PI)
+		{
+			radians += 2.0 * PI;
+		}
+		return(radians);
+	}
+
+	// Taylor series sine, accurate to double precision in [-PI, PI]
+	constexpr double Sin(double radians)
+	{
+		double x = WrapRadians(radians);
+		double term = x;
+		double sum = x;
+		for (int n = 1; n < 16; n++)
+		{
+			term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+			sum += term;
+		}
+		return(sum);
+	}
+
+	constexpr double Cos(double radians)
+	{
+		return(Sin(radians + PI / 2.0));
+	}
+
+	constexpr double Radians(double degrees)
+	{
+		return(degrees * PI / 180.0);
+	}
+}
+
+/***********************************************************
+ *  BakeTransformations()
+ *
+ *  Compose the same translation * rotZ * rotY * rotX * scale
+ *  product as SceneManager::SetTransformations(), in a form
+ *  the compiler can evaluate.  A zero scale on an axis (used
+ *  to flatten planes) is treated as one when building the
+ *  normal matrix, which keeps the normal along that axis.
+ ***********************************************************/
+constexpr BAKED_TRANSFORM BakeTransformations(
+	BAKED_VEC3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	BAKED_VEC3 positionXYZ)
+{
+	const double cx = BakedMath::Cos(BakedMath::Radians(XrotationDegrees));
+	const double sx = BakedMath::Sin(BakedMath::Radians(XrotationDegrees));
+	const double cy = BakedMath::Cos(BakedMath::Radians(YrotationDegrees));
+	const double sy = BakedMath::Sin(BakedMath::Radians(YrotationDegrees));
+	const double cz = BakedMath::Cos(BakedMath::Radians(ZrotationDegrees));
+	const double sz = BakedMath::Sin(BakedMath::Radians(ZrotationDegrees));
+
+	// rotation = rotZ * rotY * rotX, stored as rotation[column][row]
+	const double rotation[3][3] = {
+		{ cz * cy, sz * cy, -sy },
+		{ cz * sy * sx - sz * cx, sz * sy * sx + cz * cx, cy * sx },
+		{ cz * sy * cx + sz * sx, sz * sy * cx - cz * sx, cy * cx } };
+	const double scale[3] = { scaleXYZ.x, scaleXYZ.y, scaleXYZ.z };
+
+	BAKED_TRANSFORM transform = {};
+	for (int column = 0; column < 3; column++)
+	{
+		const double inverseScale = (scale[column] != 0.0) ? 1.0 / scale[column] : 1.0;
+		for (int row = 0; row < 3; row++)
+		{
+			transform.model[column * 4 + row] = static_cast<float>(rotation[column][row] * scale[column]);
+			transform.normal[column * 4 + row] = static_cast<float>(rotation[column][row] * inverseScale);
+		}
+		transform.model[column * 4 + 3] = 0.0f;
+		transform.normal[column * 4 + 3] = 0.0f;
+	}
+	transform.normal[15] = 1.0f;
+	transform.model[12] = positionXYZ.x;
+	transform.model[13] = positionXYZ.y;
+	transform.model[14] = positionXYZ.z;
+	transform.model[15] = 1.0f;
+
+	return(transform);
+}
@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteratlas.cpp
+// ================
+// texture atlas baked for the merged cluster meshes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusterAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// smallest power of two that is at least the passed in value
+	int NextPowerOfTwo(int value)
+	{
+		int power = 1;
+		while (power < value)
+		{
+			power <<= 1;
+		}
+		return(power);
+	}
+
+	/***********************************************************
+	 *  ReadTexture()
+	 *
+	 *  Read back the smallest mip level of a texture that is
+	 *  still at least minimumSize texels on each side.  The
+	 *  texture bound to the active unit is left as it was,
+	 *  since the scene keeps its textures bound to fixed units.
+	 ***********************************************************/
+	bool ReadTexture(GLuint texture, int minimumSize, std::vector<unsigned char>& pixels, int& width, int& height)
+	{
+		GLint previousTexture = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+
+		GLint levelWidth = 0;
+		GLint levelHeight = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &levelWidth);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &levelHeight);
+
+		int level = 0;
+		while ((levelWidth / 2 >= minimumSize) && (levelHeight / 2 >= minimumSize))
+		{
+			levelWidth /= 2;
+			levelHeight /= 2;
+			level++;
+		}
+
+		const bool bValid = (levelWidth > 0) && (levelHeight > 0);
+		if (bValid)
+		{
+			width = levelWidth;
+			height = levelHeight;
+			pixels.resize((size_t)width * height * 4);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		}
+
+		glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+		return(bValid);
+	}
+
+	// texture coordinate of one texel row or column of a tile, with
+	// the border texels repeating the edge
+	inline float TileCoordinate(int texel)
+	{
+		const float inner = (float)(ClusterAtlas::TILE_SIZE - (2 * ClusterAtlas::TILE_BORDER));
+		return(std::min(std::max((texel - ClusterAtlas::TILE_BORDER + 0.5f) / inner, 0.0f), 1.0f));
+	}
+
+	// source texel index of a repeated texture coordinate
+	inline int WrapTexel(float coordinate, int size)
+	{
+		const float wrapped = coordinate - std::floor(coordinate);
+		return(std::min((int)(wrapped * size), size - 1));
+	}
+
+	/***********************************************************
+	 *  BakeTile()
+	 *
+	 *  Fill one tile of the atlas image with its texture
+	 *  repeated by the UV scale, or its color, times its tint.
+	 ***********************************************************/
+	void BakeTile(const ATLAS_TILE& tile, int tileX, int tileY, int atlasWidth, std::vector<unsigned char>& image)
+	{
+		std::vector<unsigned char> source;
+		int sourceWidth = 0;
+		int sourceHeight = 0;
+		const float repeats = std::max(1.0f, std::max(tile.uvScale.x, tile.uvScale.y));
+		const bool bTextured = (tile.texture != 0) &&
+			ReadTexture(tile.texture, (int)std::ceil(ClusterAtlas::TILE_SIZE / repeats), source, sourceWidth, sourceHeight);
+
+		for (int y = 0; y < ClusterAtlas::TILE_SIZE; y++)
+		{
+			const int sourceRow = bTextured ? WrapTexel(TileCoordinate(y) * tile.uvScale.y, sourceHeight) : 0;
+			unsigned char* pOut = &image[(((size_t)(tileY + y) * atlasWidth) + tileX) * 4];
+
+			for (int x = 0; x < ClusterAtlas::TILE_SIZE; x++)
+			{
+				glm::vec3 color = tile.color;
+				if (bTextured)
+				{
+					const int sourceColumn = WrapTexel(TileCoordinate(x) * tile.uvScale.x, sourceWidth);
+					const unsigned char* pTexel = &source[(((size_t)sourceRow * sourceWidth) + sourceColumn) * 4];
+					color = glm::vec3(pTexel[0], pTexel[1], pTexel[2]) / 255.0f;
+				}
+				color = color * tile.tint;
+
+				for (int channel = 0; channel < 3; channel++)
+				{
+					pOut[channel] = (unsigned char)std::min(std::max(color[channel] * 255.0f + 0.5f, 0.0f), 255.0f);
+				}
+				pOut[3] = 255;
+				pOut += 4;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  BakeAtlas()
+ *
+ *  This method is used for laying the tiles out in rows of
+ *  a power of two sized texture, baking each one, and
+ *  uploading the result with a full mip chain.
+ ***********************************************************/
+GLuint ClusterAtlas::BakeAtlas(const std::vector<ATLAS_TILE>& tiles, std::vector<ATLAS_RECT>& rects)
+{
+	rects.clear();
+	if (tiles.empty())
+	{
+		return(0);
+	}
+
+	const int columns = (int)std::ceil(std::sqrt((double)tiles.size()));
+	const int rows = ((int)tiles.size() + columns - 1) / columns;
+	const int atlasWidth = NextPowerOfTwo(columns * TILE_SIZE);
+	const int atlasHeight = NextPowerOfTwo(rows * TILE_SIZE);
+	const float inner = (float)(TILE_SIZE - (2 * TILE_BORDER));
+	std::vector<unsigned char> image((size_t)atlasWidth * atlasHeight * 4, 0);
+
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		const int tileX = ((int)i % columns) * TILE_SIZE;
+		const int tileY = ((int)i / columns) * TILE_SIZE;
+		BakeTile(tiles[i], tileX, tileY, atlasWidth, image);
+
+		ATLAS_RECT rect;
+		rect.offset = glm::vec2((float)(tileX + TILE_BORDER) / atlasWidth, (float)(tileY + TILE_BORDER) / atlasHeight);
+		rect.scale = glm::vec2(inner / atlasWidth, inner / atlasHeight);
+		rects.push_back(rect);
+	}
+
+	GLint previousTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+
+	return(texture);
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteratlas.h
+// ==============
+// texture atlas baked for the merged cluster meshes
+//
+// Every distinct surface of a cluster - a texture repeated by its UV scale,
+// or a flat color - becomes one square tile of the atlas, tinted by the
+// diffuse color of its material so the merged mesh can be lit with a plain
+// white material.  The source textures are read back from the GPU at the
+// mip level closest to the tile size and resampled on the CPU.  Each tile
+// keeps a border of repeated edge texels so filtering near its edges does
+// not pick up its neighbours.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ATLAS_TILE
+ *
+ *  One surface to bake: a texture, or a color when the
+ *  texture is 0, scaled by the diffuse tint.
+ ***********************************************************/
+struct ATLAS_TILE
+{
+	GLuint texture;
+	glm::vec2 uvScale;
+	glm::vec3 color;
+	glm::vec3 tint;
+};
+
+/***********************************************************
+ *  ATLAS_RECT
+ *
+ *  Where texture coordinates 0..1 of one tile land in the
+ *  atlas: offset + uv * scale.
+ ***********************************************************/
+struct ATLAS_RECT
+{
+	glm::vec2 offset;
+	glm::vec2 scale;
+};
+
+namespace ClusterAtlas
+{
+	// size in texels of one tile and of the border inside it
+	const int TILE_SIZE = 128;
+	const int TILE_BORDER = 4;
+
+	// bake the tiles into a new mipmapped RGBA texture and return
+	// it, with the rectangle of each tile, or 0 if there are none
+	GLuint BakeAtlas(const std::vector<ATLAS_TILE>& tiles, std::vector<ATLAS_RECT>& rects);
+}
@@ -0,0 +1,195 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecache.cpp
+// ==============
+// least recently used cache of encoded frames keyed by quantized camera pose
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCache.h"
+#include "MeshCache.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <sys/stat.h>
+
+const float FrameCache::POSITION_STEP = 0.001f;
+const float FrameCache::DIRECTION_STEP = 0.0001f;
+const float FrameCache::ZOOM_STEP = 0.01f;
+
+// declaration of global variables
+namespace
+{
+	int32_t Quantize(float value, float step)
+	{
+		return((int32_t)std::lround(value / step));
+	}
+}
+
+/***********************************************************
+ *  operator==()
+ *
+ *  Keys are equal when every quantized value is.
+ ***********************************************************/
+bool FRAME_KEY::operator==(const FRAME_KEY& other) const
+{
+	return(memcmp(this, &other, sizeof(FRAME_KEY)) == 0);
+}
+
+/***********************************************************
+ *  operator()()
+ *
+ *  The hash of a key is the FNV-1a hash of its values.
+ ***********************************************************/
+size_t FrameCache::FRAME_KEY_HASH::operator()(const FRAME_KEY& key) const
+{
+	return((size_t)MeshCache::Hash(&key, sizeof(FRAME_KEY)));
+}
+
+/***********************************************************
+ *  FrameCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameCache::FrameCache(size_t budgetBytes)
+{
+	m_budgetBytes = budgetBytes;
+	m_usedBytes = 0;
+	m_lookups = 0;
+	m_hits = 0;
+	m_insertions = 0;
+	m_evictions = 0;
+	m_rejections = 0;
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for rounding the camera values to
+ *  their steps, after normalizing the direction vectors,
+ *  and combining them with the rest of the frame's inputs.
+ ***********************************************************/
+FRAME_KEY FrameCache::MakeKey(const CAMERA_POSE& pose, int width, int height, int format, uint64_t sceneVersion)
+{
+	FRAME_KEY key;
+	// the whole key is compared and hashed as bytes
+	memset(&key, 0, sizeof(key));
+
+	const glm::vec3 front = glm::normalize(pose.front);
+	const glm::vec3 up = glm::normalize(pose.up);
+	for (int i = 0; i < 3; i++)
+	{
+		key.pose[i] = Quantize(pose.position[i], POSITION_STEP);
+		key.pose[3 + i] = Quantize(front[i], DIRECTION_STEP);
+		key.pose[6 + i] = Quantize(up[i], DIRECTION_STEP);
+	}
+	// the orthographic projection does not use the zoom
+	key.pose[9] = pose.bOrthographic ? 0 : Quantize(pose.zoom, ZOOM_STEP);
+	key.orthographic = pose.bOrthographic ? 1 : 0;
+	key.width = width;
+	key.height = height;
+	key.format = format;
+	key.sceneVersion = sceneVersion;
+	return(key);
+}
+
+/***********************************************************
+ *  HashFile()
+ *
+ *  This method is used for hashing what identifies a version
+ *  of a file without reading it, the way the mesh cache key
+ *  covers the model files.
+ ***********************************************************/
+uint64_t FrameCache::HashFile(const char* filename, uint64_t hash)
+{
+	struct stat status;
+	int64_t fileValues[2] = { -1, -1 };
+	if (stat(filename, &status) == 0)
+	{
+		fileValues[0] = (int64_t)status.st_size;
+		fileValues[1] = (int64_t)status.st_mtime;
+	}
+	hash = MeshCache::Hash(filename, strlen(filename) + 1, hash);
+	return(MeshCache::Hash(fileValues, sizeof(fileValues), hash));
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for looking a frame up and moving it
+ *  to the front of the recently used list.
+ ***********************************************************/
+CACHED_FRAME FrameCache::Find(const FRAME_KEY& key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_lookups++;
+	std::unordered_map<FRAME_KEY, std::list<CACHE_ENTRY>::iterator, FRAME_KEY_HASH>::iterator found = m_index.find(key);
+	if (found == m_index.end())
+	{
+		return(NULL);
+	}
+
+	m_hits++;
+	m_entries.splice(m_entries.begin(), m_entries, found->second);
+	return(found->second->frame);
+}
+
+/***********************************************************
+ *  Insert()
+ *
+ *  This method is used for storing a frame as the most
+ *  recently used one.  A frame already stored under the key
+ *  is replaced, and a frame larger than the whole budget is
+ *  not stored.
+ ***********************************************************/
+void FrameCache::Insert(const FRAME_KEY& key, const CACHED_FRAME& frame)
+{
+	const size_t frameBytes = frame->size();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (frameBytes > m_budgetBytes)
+	{
+		m_rejections++;
+		return;
+	}
+
+	std::unordered_map<FRAME_KEY, std::list<CACHE_ENTRY>::iterator, FRAME_KEY_HASH>::iterator found = m_index.find(key);
+	if (found != m_index.end())
+	{
+		m_usedBytes -= found->second->frame->size();
+		m_entries.erase(found->second);
+		m_index.erase(found);
+	}
+
+	while (m_usedBytes + frameBytes > m_budgetBytes)
+	{
+		const CACHE_ENTRY& oldest = m_entries.back();
+		m_usedBytes -= oldest.frame->size();
+		m_index.erase(oldest.key);
+		m_entries.pop_back();
+		m_evictions++;
+	}
+
+	CACHE_ENTRY entry;
+	entry.key = key;
+	entry.frame = frame;
+	m_entries.push_front(entry);
+	m_index[key] = m_entries.begin();
+	m_usedBytes += frameBytes;
+	m_insertions++;
+}
+
+/***********************************************************
+ *  ReportStatistics()
+ *
+ *  This method is used for printing how often lookups hit
+ *  and how much of the budget the stored frames use.
+ ***********************************************************/
+void FrameCache::ReportStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::cout << "INFO: Frame cache: " << m_lookups << " lookups, " << m_hits << " hits ("
+		<< ((m_lookups > 0) ? (100.0 * m_hits) / m_lookups : 0.0) << "%), "
+		<< m_insertions << " frames stored, " << m_evictions << " evicted, "
+		<< m_rejections << " too large, " << m_entries.size() << " frames in "
+		<< m_usedBytes / (1024.0 * 1024.0) << " of " << m_budgetBytes / (1024.0 * 1024.0) << " MB" << std::endl;
+}
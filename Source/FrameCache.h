@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecache.h
+// ============
+// least recently used cache of encoded frames keyed by quantized camera pose
+//
+// The scene is static, so an image depends only on the camera, the viewport,
+// the image format and the scene itself - the server renders each request
+// without the level of detail hysteresis of the requests before it, so this
+// holds for the detail chosen as well.  Frames are stored under a key made
+// of the camera position, direction vectors and zoom rounded to fixed steps,
+// the viewport size, the format and a scene version hash, and a request whose
+// key matches is answered with the stored frame without touching OpenGL.
+// The direction vectors are normalized first since their length does not
+// change the view.  Poses closer than a step apart share a frame.
+//
+// The encoded frames are held by shared pointers, so a frame being sent stays
+// valid when it is evicted.  Once the frames exceed the memory budget the
+// least recently used are evicted.  All methods may be called from any thread.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ViewManager.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// an encoded frame shared between the cache and its senders
+typedef std::shared_ptr<const std::vector<unsigned char>> CACHED_FRAME;
+
+/***********************************************************
+ *  FRAME_KEY
+ *
+ *  The quantized values that identify a rendered frame.
+ ***********************************************************/
+struct FRAME_KEY
+{
+	int32_t pose[10];
+	int32_t orthographic;
+	int32_t width;
+	int32_t height;
+	int32_t format;
+	uint64_t sceneVersion;
+
+	bool operator==(const FRAME_KEY& other) const;
+};
+
+/***********************************************************
+ *  FrameCache
+ *
+ *  This class keeps the most recently used encoded frames
+ *  within a memory budget and counts its hits.
+ ***********************************************************/
+class FrameCache
+{
+public:
+	// quantization steps of the camera values, in world units,
+	// units of the normalized direction vectors, and degrees
+	static const float POSITION_STEP;
+	static const float DIRECTION_STEP;
+	static const float ZOOM_STEP;
+
+	// constructor
+	FrameCache(size_t budgetBytes);
+
+	// the key of a frame rendered from pose at the passed in size
+	// and format, of the scene with the passed in version
+	static FRAME_KEY MakeKey(const CAMERA_POSE& pose, int width, int height, int format, uint64_t sceneVersion);
+	// chain the name, size and modification time of a file that
+	// the rendered frames depend on into a scene version hash
+	static uint64_t HashFile(const char* filename, uint64_t hash);
+
+	// the stored frame for key, or NULL - a hit makes the frame
+	// the most recently used
+	CACHED_FRAME Find(const FRAME_KEY& key);
+	// store a frame, evicting the least recently used frames
+	// until it fits the budget
+	void Insert(const FRAME_KEY& key, const CACHED_FRAME& frame);
+	// print the lookups, hit rate, evictions and memory used
+	void ReportStatistics() const;
+
+private:
+	struct FRAME_KEY_HASH
+	{
+		size_t operator()(const FRAME_KEY& key) const;
+	};
+
+	struct CACHE_ENTRY
+	{
+		FRAME_KEY key;
+		CACHED_FRAME frame;
+	};
+
+	size_t m_budgetBytes;
+	size_t m_usedBytes;
+	// entries from the most to the least recently used, and the
+	// position of each key in that list
+	std::list<CACHE_ENTRY> m_entries;
+	std::unordered_map<FRAME_KEY, std::list<CACHE_ENTRY>::iterator, FRAME_KEY_HASH> m_index;
+	mutable std::mutex m_mutex;
+
+	// statistics
+	uint64_t m_lookups;
+	uint64_t m_hits;
+	uint64_t m_insertions;
+	uint64_t m_evictions;
+	uint64_t m_rejections;
+};
@@ -0,0 +1,423 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.cpp
+// ================
+// asynchronous readback and encoding of rendered frames
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCapture.h"
+#include "ImageEncoders.h"
+#include "WorkerThreads.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// copied frames allowed to wait for an encoder before the
+	// render thread waits for one to be taken
+	const size_t MAX_QUEUED_COPIES = 8;
+	// longest single wait on a fence, in nanoseconds
+	const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+	const char* g_FormatNames[] = { "png", "qoi", "y4m" };
+}
+
+/***********************************************************
+ *  FrameCapture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameCapture::FrameCapture()
+{
+	m_bCapturing = false;
+	m_bPersistent = false;
+	m_width = 0;
+	m_height = 0;
+	m_format = CAPTURE_PNG;
+	m_pStream = NULL;
+	m_nextSlot = 0;
+	m_pendingSlots = 0;
+	m_frameCount = 0;
+	m_bStopping = false;
+	m_nextWrittenFrame = 0;
+	m_totalCaptureTime = 0.0;
+	m_maxCaptureTime = 0.0;
+}
+
+/***********************************************************
+ *  ~FrameCapture()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameCapture::~FrameCapture()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  ParseFormat()
+ *
+ *  This method is used for getting the capture format from
+ *  its name - png, qoi or y4m.
+ ***********************************************************/
+bool FrameCapture::ParseFormat(const char* name, CAPTURE_FORMAT& format)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (strcmp(name, g_FormatNames[i]) == 0)
+		{
+			format = (CAPTURE_FORMAT)i;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for creating the ring of pixel pack
+ *  buffers, opening the video stream when one is captured,
+ *  and starting the encoder threads.
+ ***********************************************************/
+bool FrameCapture::Start(
+	int width,
+	int height,
+	CAPTURE_FORMAT format,
+	const char* outputPath,
+	int framesPerSecond,
+	int ringSize,
+	unsigned int encoderThreads)
+{
+	Stop();
+
+	m_width = width;
+	m_height = height;
+	m_format = format;
+	m_outputPath = outputPath;
+	m_frameCount = 0;
+	m_nextWrittenFrame = 0;
+	m_nextSlot = 0;
+	m_pendingSlots = 0;
+	m_bStopping = false;
+	m_totalCaptureTime = 0.0;
+	m_maxCaptureTime = 0.0;
+
+	if (format == CAPTURE_Y4M)
+	{
+		m_pStream = fopen(outputPath, "wb");
+		if (m_pStream == NULL)
+		{
+			std::cout << "Could not open capture stream " << outputPath << std::endl;
+			return(false);
+		}
+		std::vector<unsigned char> header;
+		ImageEncoders::EncodeY4mHeader(width, height, framesPerSecond, header);
+		fwrite(header.data(), 1, header.size(), m_pStream);
+	}
+
+	// persistently mapped buffers let the encoders read the frames
+	// where the GPU wrote them
+	m_bPersistent = (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+	const GLsizeiptr frameSize = (GLsizeiptr)width * height * 4;
+	m_slots.resize(std::max(ringSize, 1));
+	for (CAPTURE_SLOT& slot : m_slots)
+	{
+		slot.fence = NULL;
+		slot.pMapped = NULL;
+		slot.frame = -1;
+		slot.state = SLOT_FREE;
+		glGenBuffers(1, &slot.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		if (m_bPersistent == true)
+		{
+			const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_PIXEL_PACK_BUFFER, frameSize, NULL, flags);
+			slot.pMapped = (unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, flags);
+		}
+		else
+		{
+			glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, NULL, GL_STREAM_READ);
+		}
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// the render thread is one of the hardware threads
+	const unsigned int threadCount = std::max(1u, WorkerThreads::ResolveThreadCount(encoderThreads) - ((encoderThreads == 0) ? 1u : 0u));
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		m_encoders.emplace_back(&FrameCapture::EncodeFrames, this);
+	}
+
+	m_bCapturing = true;
+	std::cout << "INFO: Capturing " << width << "x" << height << " frames as " << g_FormatNames[format]
+		<< " to " << outputPath << " through " << m_slots.size() << " pixel pack buffers"
+		<< (m_bPersistent ? " (persistently mapped)" : "") << " and " << threadCount << " encoder threads" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  CaptureFrame()
+ *
+ *  This method is used for starting the readback of the
+ *  frame just rendered.  Readbacks that have finished are
+ *  handed to the encoders first, and the render thread only
+ *  waits when every buffer of the ring is still in use.
+ ***********************************************************/
+void FrameCapture::CaptureFrame()
+{
+	if (m_bCapturing == false)
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// pick up the finished readbacks, oldest first
+	while ((m_pendingSlots > 0) && (RetireOldestSlot(false) == true))
+	{
+	}
+
+	// the ring is full when the next slot is still being read
+	CAPTURE_SLOT& slot = m_slots[m_nextSlot];
+	if (slot.state == SLOT_READING)
+	{
+		RetireOldestSlot(true);
+	}
+	{
+		// or still being encoded from its mapping
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_slotFreed.wait(lock, [&slot]() { return(slot.state == SLOT_FREE); });
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = m_frameCount++;
+	slot.state = SLOT_READING;
+	m_nextSlot = (m_nextSlot + 1) % (int)m_slots.size();
+	m_pendingSlots++;
+
+	const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_totalCaptureTime += elapsed;
+	m_maxCaptureTime = std::max(m_maxCaptureTime, elapsed);
+}
+
+/***********************************************************
+ *  RetireOldestSlot()
+ *
+ *  This method is used for handing the oldest readback in
+ *  flight to the encoders once its fence has signaled.  A
+ *  persistently mapped slot is read by the encoder in place
+ *  and freed by it; otherwise the frame is copied out and
+ *  the slot is free at once.
+ ***********************************************************/
+bool FrameCapture::RetireOldestSlot(bool bWait)
+{
+	const int oldest = (m_nextSlot - m_pendingSlots + (int)m_slots.size()) % (int)m_slots.size();
+	CAPTURE_SLOT& slot = m_slots[oldest];
+
+	// the first wait flushes so the fence is sure to be reached
+	GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, bWait ? FENCE_TIMEOUT : 0);
+	while ((bWait == true) && (result == GL_TIMEOUT_EXPIRED))
+	{
+		result = glClientWaitSync(slot.fence, 0, FENCE_TIMEOUT);
+	}
+	if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+	{
+		return(false);
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = NULL;
+	m_pendingSlots--;
+
+	CAPTURE_JOB job;
+	job.frame = slot.frame;
+	job.slot = -1;
+	if (slot.pMapped != NULL)
+	{
+		job.slot = oldest;
+	}
+	else
+	{
+		const size_t frameSize = (size_t)m_width * m_height * 4;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		const unsigned char* pPixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+		if (pPixels != NULL)
+		{
+			job.pixels.assign(pPixels, pPixels + frameSize);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	slot.state = (job.slot >= 0) ? SLOT_ENCODING : SLOT_FREE;
+	// copies are bounded here, mapped slots by the ring itself
+	m_jobTaken.wait(lock, [this]() { return(m_jobs.size() < MAX_QUEUED_COPIES); });
+	m_jobs.push_back(std::move(job));
+	m_jobQueued.notify_one();
+	return(true);
+}
+
+/***********************************************************
+ *  EncodeFrames()
+ *
+ *  This method is used for running one encoder thread,
+ *  which takes frames in capture order until the capture
+ *  stops and the queue is empty.
+ ***********************************************************/
+void FrameCapture::EncodeFrames()
+{
+	while (true)
+	{
+		CAPTURE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobQueued.wait(lock, [this]() { return((m_jobs.empty() == false) || (m_bStopping == true)); });
+			if (m_jobs.empty())
+			{
+				return;
+			}
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+			m_jobTaken.notify_one();
+		}
+		EncodeJob(job);
+	}
+}
+
+/***********************************************************
+ *  EncodeJob()
+ *
+ *  This method is used for encoding one frame from the
+ *  bottom-up readback, releasing its slot as soon as the
+ *  pixels have been encoded, and writing the result - a
+ *  numbered still, or the next frame of the stream once the
+ *  frames before it are written.
+ ***********************************************************/
+void FrameCapture::EncodeJob(CAPTURE_JOB& job)
+{
+	const ptrdiff_t rowSize = (ptrdiff_t)m_width * 4;
+	const unsigned char* pPixels = (job.slot >= 0) ? m_slots[job.slot].pMapped : job.pixels.data();
+	std::vector<unsigned char> encoded;
+	if (job.pixels.empty() && (job.slot < 0))
+	{
+		pPixels = NULL;
+	}
+
+	if (pPixels != NULL)
+	{
+		const unsigned char* pTopRow = pPixels + ((m_height - 1) * rowSize);
+		switch (m_format)
+		{
+		case CAPTURE_PNG:
+			ImageEncoders::EncodePng(pTopRow, m_width, m_height, -rowSize, encoded);
+			break;
+		case CAPTURE_QOI:
+			ImageEncoders::EncodeQoi(pTopRow, m_width, m_height, -rowSize, encoded);
+			break;
+		default:
+			ImageEncoders::EncodeY4mFrame(pTopRow, m_width, m_height, -rowSize, encoded);
+			break;
+		}
+	}
+
+	if (job.slot >= 0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_slots[job.slot].state = SLOT_FREE;
+		m_slotFreed.notify_all();
+	}
+
+	if (m_format != CAPTURE_Y4M)
+	{
+		if (encoded.empty() == false)
+		{
+			char filename[1024];
+			snprintf(filename, sizeof(filename), "%s/frame_%05d.%s", m_outputPath.c_str(), job.frame, g_FormatNames[m_format]);
+			FILE* pFile = fopen(filename, "wb");
+			if (pFile != NULL)
+			{
+				fwrite(encoded.data(), 1, encoded.size(), pFile);
+				fclose(pFile);
+			}
+			else
+			{
+				std::cout << "Could not write captured frame " << filename << std::endl;
+			}
+		}
+		return;
+	}
+
+	// stream frames go out in capture order - the earliest queued
+	// frame is always with some encoder, so this cannot deadlock
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_frameWritten.wait(lock, [this, &job]() { return(m_nextWrittenFrame == job.frame); });
+	if (encoded.empty() == false)
+	{
+		fwrite(encoded.data(), 1, encoded.size(), m_pStream);
+	}
+	m_nextWrittenFrame++;
+	m_frameWritten.notify_all();
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for waiting for every readback in
+ *  flight, letting the encoders finish the queue, freeing
+ *  the ring and reporting the render thread capture time.
+ ***********************************************************/
+void FrameCapture::Stop()
+{
+	if (m_bCapturing == false)
+	{
+		return;
+	}
+
+	while (m_pendingSlots > 0)
+	{
+		RetireOldestSlot(true);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_jobQueued.notify_all();
+	for (std::thread& encoder : m_encoders)
+	{
+		encoder.join();
+	}
+	m_encoders.clear();
+
+	for (CAPTURE_SLOT& slot : m_slots)
+	{
+		if (slot.pMapped != NULL)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glDeleteBuffers(1, &slot.buffer);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_slots.clear();
+
+	if (m_pStream != NULL)
+	{
+		fclose(m_pStream);
+		m_pStream = NULL;
+	}
+
+	m_bCapturing = false;
+	if (m_frameCount > 0)
+	{
+		std::cout << "INFO: Captured " << m_frameCount << " frames, render thread time "
+			<< m_totalCaptureTime / m_frameCount << " ms average, " << m_maxCaptureTime << " ms max per frame" << std::endl;
+	}
+}
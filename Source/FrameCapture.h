@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.h
+// ==============
+// asynchronous readback and encoding of rendered frames
+//
+// glReadPixels into client memory waits for the GPU to finish the frame.
+// Instead, each captured frame is read into the next pixel pack buffer of a
+// small ring and a fence is placed after it; the render thread moves on at
+// once.  Frames are picked up, oldest first, once their fence has signaled,
+// which is normally a few frames later, and only when the ring is full does
+// the render thread wait.  Where buffer storage is available (OpenGL 4.4)
+// the ring stays persistently mapped and the encoder threads read straight
+// from it, so the render thread does no copying at all; otherwise finished
+// frames are copied out of a briefly mapped buffer.
+//
+// A pool of encoder threads turns the frames into numbered PNG or QOI stills,
+// in any order, or into the frames of one raw Y4M video stream, which are
+// written in capture order.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the file formats frames can be captured to
+enum CAPTURE_FORMAT
+{
+	CAPTURE_PNG,
+	CAPTURE_QOI,
+	CAPTURE_Y4M
+};
+
+/***********************************************************
+ *  FrameCapture
+ *
+ *  This class reads rendered frames back through a ring of
+ *  pixel pack buffers and encodes them on worker threads.
+ ***********************************************************/
+class FrameCapture
+{
+public:
+	// frames in flight between a readback and its encoding
+	static const int DEFAULT_RING_SIZE = 3;
+
+	// constructor
+	FrameCapture();
+	// destructor
+	~FrameCapture();
+
+	// the capture format named on the command line
+	static bool ParseFormat(const char* name, CAPTURE_FORMAT& format);
+
+	// start capturing frames of the passed in size from the bound
+	// read framebuffer - stills are written into the outputPath
+	// directory and a Y4M stream to the outputPath file
+	bool Start(
+		int width,
+		int height,
+		CAPTURE_FORMAT format,
+		const char* outputPath,
+		int framesPerSecond = 30,
+		int ringSize = DEFAULT_RING_SIZE,
+		unsigned int encoderThreads = 0);
+	// queue the readback of the frame just rendered
+	void CaptureFrame();
+	// finish and encode every frame in flight, then report the
+	// time the render thread spent capturing
+	void Stop();
+
+	bool IsCapturing() const { return(m_bCapturing); }
+
+private:
+	enum SLOT_STATE
+	{
+		SLOT_FREE,
+		SLOT_READING,
+		SLOT_ENCODING
+	};
+
+	// one pixel pack buffer of the ring
+	struct CAPTURE_SLOT
+	{
+		GLuint buffer;
+		GLsync fence;
+		// persistently mapped contents, or NULL
+		unsigned char* pMapped;
+		int frame;
+		SLOT_STATE state;
+	};
+
+	// a finished frame waiting for an encoder - its pixels are in
+	// a persistently mapped slot, or copied into the job
+	struct CAPTURE_JOB
+	{
+		int frame;
+		int slot;
+		std::vector<unsigned char> pixels;
+	};
+
+	bool m_bCapturing;
+	bool m_bPersistent;
+	int m_width;
+	int m_height;
+	CAPTURE_FORMAT m_format;
+	std::string m_outputPath;
+	FILE* m_pStream;
+
+	// the ring, the slot the next frame goes to and the number
+	// of slots whose readback has not been picked up yet
+	std::vector<CAPTURE_SLOT> m_slots;
+	int m_nextSlot;
+	int m_pendingSlots;
+	int m_frameCount;
+
+	// encoder threads and their queue, guarded by m_mutex along
+	// with the slot states
+	std::vector<std::thread> m_encoders;
+	std::deque<CAPTURE_JOB> m_jobs;
+	std::mutex m_mutex;
+	std::condition_variable m_jobQueued;
+	std::condition_variable m_jobTaken;
+	std::condition_variable m_slotFreed;
+	std::condition_variable m_frameWritten;
+	bool m_bStopping;
+	int m_nextWrittenFrame;
+
+	// render thread time spent in CaptureFrame()
+	double m_totalCaptureTime;
+	double m_maxCaptureTime;
+
+	// hand the oldest pending readback to the encoders, waiting
+	// for its fence when bWait is set - returns false if it has
+	// not finished and bWait is not set
+	bool RetireOldestSlot(bool bWait);
+	// the loop each encoder thread runs
+	void EncodeFrames();
+	// encode one frame and write it out
+	void EncodeJob(CAPTURE_JOB& job);
+};
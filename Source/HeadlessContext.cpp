@@ -0,0 +1,345 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.cpp
+// ===================
+// offscreen OpenGL context and framebuffer for rendering without a window
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HeadlessContext.h"
+
+#ifdef USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#ifdef USE_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// the offscreen framebuffer and its attachments
+	GLuint g_Framebuffer = 0;
+	GLuint g_ColorBuffer = 0;
+	GLuint g_DepthBuffer = 0;
+	int g_Width = 0;
+	int g_Height = 0;
+	const char* g_ApiName = "none";
+
+#ifdef USE_EGL
+	EGLDisplay g_Display = EGL_NO_DISPLAY;
+	EGLContext g_EglContext = EGL_NO_CONTEXT;
+#endif
+#ifdef USE_OSMESA
+	OSMesaContext g_OSMesaContext = NULL;
+	// OSMesa always renders into client memory, even when only a
+	// framebuffer object is drawn to
+	std::vector<unsigned char> g_OSMesaBuffer;
+#endif
+
+	// newest OpenGL 4 minor version asked for, then each older one
+	const int NEWEST_MINOR_VERSION = 6;
+
+#ifdef USE_EGL
+	/***********************************************************
+	 *  CreateEglContext()
+	 *
+	 *  Create a core profile context on the Mesa surfaceless
+	 *  platform, which needs no display server, and make it
+	 *  current without any surface.
+	 ***********************************************************/
+	bool CreateEglContext()
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay == NULL)
+		{
+			return(false);
+		}
+
+		EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		EGLint major = 0;
+		EGLint minor = 0;
+		if ((display == EGL_NO_DISPLAY) || (eglInitialize(display, &major, &minor) == EGL_FALSE))
+		{
+			return(false);
+		}
+		if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+		{
+			eglTerminate(display);
+			return(false);
+		}
+
+		// the context never draws to a surface, so any OpenGL
+		// config will do, or none where the driver allows it
+		const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		EGLConfig config = EGL_NO_CONFIG_KHR;
+		EGLint configCount = 0;
+		if ((eglChooseConfig(display, configAttributes, &config, 1, &configCount) == EGL_FALSE) || (configCount == 0))
+		{
+			config = EGL_NO_CONFIG_KHR;
+		}
+
+		EGLContext context = EGL_NO_CONTEXT;
+		for (int minorVersion = NEWEST_MINOR_VERSION; (minorVersion >= 0) && (context == EGL_NO_CONTEXT); minorVersion--)
+		{
+			const EGLint contextAttributes[] =
+			{
+				EGL_CONTEXT_MAJOR_VERSION, 4,
+				EGL_CONTEXT_MINOR_VERSION, minorVersion,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_NONE
+			};
+			context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+		}
+
+		if ((context == EGL_NO_CONTEXT) ||
+			(eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_FALSE))
+		{
+			if (context != EGL_NO_CONTEXT)
+			{
+				eglDestroyContext(display, context);
+			}
+			eglTerminate(display);
+			return(false);
+		}
+
+		g_Display = display;
+		g_EglContext = context;
+		g_ApiName = "EGL surfaceless";
+		return(true);
+	}
+#endif
+
+#ifdef USE_OSMESA
+	/***********************************************************
+	 *  CreateOSMesaContext()
+	 *
+	 *  Create a core profile context on the OSMesa software
+	 *  renderer, backed by a buffer in client memory.
+	 ***********************************************************/
+	bool CreateOSMesaContext(int width, int height)
+	{
+		OSMesaContext context = NULL;
+		for (int minorVersion = NEWEST_MINOR_VERSION; (minorVersion >= 0) && (context == NULL); minorVersion--)
+		{
+			const int contextAttributes[] =
+			{
+				OSMESA_FORMAT, OSMESA_RGBA,
+				OSMESA_DEPTH_BITS, 0,
+				OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+				OSMESA_CONTEXT_MAJOR_VERSION, 4,
+				OSMESA_CONTEXT_MINOR_VERSION, minorVersion,
+				0
+			};
+			context = OSMesaCreateContextAttribs(contextAttributes, NULL);
+		}
+		if (context == NULL)
+		{
+			return(false);
+		}
+
+		g_OSMesaBuffer.resize((size_t)width * height * 4);
+		if (OSMesaMakeCurrent(context, g_OSMesaBuffer.data(), GL_UNSIGNED_BYTE, width, height) == GL_FALSE)
+		{
+			OSMesaDestroyContext(context);
+			g_OSMesaBuffer.clear();
+			return(false);
+		}
+
+		g_OSMesaContext = context;
+		g_ApiName = "OSMesa";
+		return(true);
+	}
+#endif
+}
+
+/***********************************************************
+ *  CreateContext()
+ *
+ *  This method is used for creating the offscreen context
+ *  with the first headless API that succeeds and making it
+ *  current on the calling thread.
+ ***********************************************************/
+bool HeadlessContext::CreateContext(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		std::cout << "Invalid headless frame size " << width << "x" << height << std::endl;
+		return(false);
+	}
+
+	bool bCreated = false;
+#ifdef USE_EGL
+	bCreated = CreateEglContext();
+#endif
+#ifdef USE_OSMESA
+	if (bCreated == false)
+	{
+		bCreated = CreateOSMesaContext(width, height);
+	}
+#endif
+
+	if (bCreated == false)
+	{
+#if defined(USE_EGL) || defined(USE_OSMESA)
+		std::cout << "Failed to create a headless OpenGL 4 context" << std::endl;
+#else
+		std::cout << "Headless rendering needs a build with USE_EGL or USE_OSMESA" << std::endl;
+#endif
+		return(false);
+	}
+
+	g_Width = width;
+	g_Height = height;
+	std::cout << "INFO: Headless OpenGL context created with " << g_ApiName << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  CreateFramebuffer()
+ *
+ *  This method is used for creating the color and depth
+ *  framebuffer the scene is rendered into and binding it,
+ *  with the viewport covering it.
+ ***********************************************************/
+bool HeadlessContext::CreateFramebuffer()
+{
+	glGenRenderbuffers(1, &g_ColorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, g_ColorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, g_Width, g_Height);
+
+	glGenRenderbuffers(1, &g_DepthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, g_DepthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, g_Width, g_Height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &g_Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_Framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, g_ColorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_DepthBuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Headless framebuffer is incomplete" << std::endl;
+		return(false);
+	}
+
+	// reads come from the same attachment the scene draws into
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glViewport(0, 0, g_Width, g_Height);
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the framebuffer and
+ *  releasing the offscreen context.
+ ***********************************************************/
+void HeadlessContext::Destroy()
+{
+	if (g_Framebuffer != 0)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &g_Framebuffer);
+		glDeleteRenderbuffers(1, &g_ColorBuffer);
+		glDeleteRenderbuffers(1, &g_DepthBuffer);
+		g_Framebuffer = 0;
+		g_ColorBuffer = 0;
+		g_DepthBuffer = 0;
+	}
+
+#ifdef USE_EGL
+	if (g_EglContext != EGL_NO_CONTEXT)
+	{
+		eglMakeCurrent(g_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(g_Display, g_EglContext);
+		eglTerminate(g_Display);
+		g_EglContext = EGL_NO_CONTEXT;
+		g_Display = EGL_NO_DISPLAY;
+	}
+#endif
+#ifdef USE_OSMESA
+	if (g_OSMesaContext != NULL)
+	{
+		OSMesaDestroyContext(g_OSMesaContext);
+		g_OSMesaContext = NULL;
+		g_OSMesaBuffer.clear();
+	}
+#endif
+
+	g_ApiName = "none";
+}
+
+/***********************************************************
+ *  GetApiName()
+ *
+ *  This method is used for getting the name of the API the
+ *  context was created with.
+ ***********************************************************/
+const char* HeadlessContext::GetApiName()
+{
+	return(g_ApiName);
+}
+
+/***********************************************************
+ *  GetFramebuffer()
+ *
+ *  This method is used for getting the framebuffer object
+ *  the scene is rendered into.
+ ***********************************************************/
+GLuint HeadlessContext::GetFramebuffer()
+{
+	return(g_Framebuffer);
+}
+
+int HeadlessContext::GetWidth()
+{
+	return(g_Width);
+}
+
+int HeadlessContext::GetHeight()
+{
+	return(g_Height);
+}
+
+/***********************************************************
+ *  WriteFrame()
+ *
+ *  This method is used for reading back the color buffer
+ *  and writing it to a binary PPM file.  OpenGL returns the
+ *  bottom row first, so the rows are written in reverse.
+ ***********************************************************/
+bool HeadlessContext::WriteFrame(const char* filename)
+{
+	if (g_Framebuffer == 0)
+	{
+		return(false);
+	}
+
+	const size_t rowSize = (size_t)g_Width * 3;
+	std::vector<unsigned char> pixels(rowSize * g_Height);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, g_Framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, g_Width, g_Height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Could not write frame to " << filename << std::endl;
+		return(false);
+	}
+
+	file << "P6\n" << g_Width << " " << g_Height << "\n255\n";
+	for (int row = g_Height - 1; row >= 0; row--)
+	{
+		file.write((const char*)&pixels[row * rowSize], rowSize);
+	}
+
+	return(file.good());
+}
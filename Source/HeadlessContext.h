@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.h
+// =================
+// offscreen OpenGL context and framebuffer for rendering without a window
+//
+// Batch servers have no display and often no GPU, so the headless mode
+// creates its OpenGL 4.x core context directly through EGL on the Mesa
+// surfaceless platform, or failing that through OSMesa, and never touches
+// GLFW.  Neither context has a default framebuffer to draw into, so the
+// scene is rendered into a color and depth framebuffer object of the
+// requested size, which stays bound for the life of the context.
+//
+// EGL support is compiled in with USE_EGL (linking libEGL) and OSMesa
+// support with USE_OSMESA (linking libOSMesa).  Without either,
+// CreateContext() reports that headless rendering is not available.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+namespace HeadlessContext
+{
+	// create and make current an offscreen context for frames of
+	// the passed in size - returns false if no headless API could
+	bool CreateContext(int width, int height);
+	// create and bind the framebuffer the frames are rendered
+	// into - called once GLEW has loaded the OpenGL functions
+	bool CreateFramebuffer();
+	// free the framebuffer and the context
+	void Destroy();
+
+	// the API the context was created with, for reporting
+	const char* GetApiName();
+	// the framebuffer the scene is rendered into, and its size
+	GLuint GetFramebuffer();
+	int GetWidth();
+	int GetHeight();
+
+	// write the color buffer of the last frame to a binary
+	// PPM image, top row first
+	bool WriteFrame(const char* filename);
+}
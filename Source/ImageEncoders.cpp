@@ -0,0 +1,365 @@
+///////////////////////////////////////////////////////////////////////////////
+// imageencoders.cpp
+// =================
+// encoders for captured frames - PNG and QOI stills and Y4M video frames
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImageEncoders.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// largest payload of one stored deflate block
+	const size_t MAX_STORED_BLOCK = 65535;
+
+	// CRC-32 lookup table for the PNG chunks
+	struct CRC_TABLE
+	{
+		uint32_t values[256];
+
+		CRC_TABLE()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+				}
+				values[i] = crc;
+			}
+		}
+	};
+
+	// built on first use - the encoder threads may race to it,
+	// which a function local static makes safe
+	const uint32_t* GetCrcTable()
+	{
+		static const CRC_TABLE table;
+		return(table.values);
+	}
+
+	inline void AppendBigEndian(std::vector<unsigned char>& output, uint32_t value)
+	{
+		output.push_back((unsigned char)(value >> 24));
+		output.push_back((unsigned char)(value >> 16));
+		output.push_back((unsigned char)(value >> 8));
+		output.push_back((unsigned char)value);
+	}
+
+	/***********************************************************
+	 *  AppendPngChunk()
+	 *
+	 *  Append a PNG chunk - length, type, data and the CRC of
+	 *  the type and data.
+	 ***********************************************************/
+	void AppendPngChunk(std::vector<unsigned char>& output, const char* type, const unsigned char* pData, size_t size)
+	{
+		AppendBigEndian(output, (uint32_t)size);
+		const size_t start = output.size();
+		output.insert(output.end(), type, type + 4);
+		output.insert(output.end(), pData, pData + size);
+
+		const uint32_t* table = GetCrcTable();
+		uint32_t crc = 0xFFFFFFFFu;
+		for (size_t i = start; i < output.size(); i++)
+		{
+			crc = table[(crc ^ output[i]) & 0xFF] ^ (crc >> 8);
+		}
+		AppendBigEndian(output, crc ^ 0xFFFFFFFFu);
+	}
+
+	// one QOI pixel - the encoded pixels are all opaque, but the
+	// decoder's index starts out transparent black, so the alpha
+	// keeps black pixels from matching unused index entries
+	struct QOI_PIXEL
+	{
+		unsigned char r;
+		unsigned char g;
+		unsigned char b;
+		unsigned char a;
+	};
+
+	inline int QoiHash(const QOI_PIXEL& pixel)
+	{
+		return(((pixel.r * 3) + (pixel.g * 5) + (pixel.b * 7) + (pixel.a * 11)) % 64);
+	}
+
+	inline bool QoiEqual(const QOI_PIXEL& first, const QOI_PIXEL& second)
+	{
+		return((first.r == second.r) && (first.g == second.g) && (first.b == second.b) && (first.a == second.a));
+	}
+}
+
+/***********************************************************
+ *  EncodePng()
+ *
+ *  This method is used for writing the PNG signature, the
+ *  header, one zlib stream of stored deflate blocks holding
+ *  the unfiltered scanlines, and the end chunk.
+ ***********************************************************/
+void ImageEncoders::EncodePng(const unsigned char* pTopRow, int width, int height, ptrdiff_t stride, std::vector<unsigned char>& output)
+{
+	static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	output.assign(signature, signature + sizeof(signature));
+
+	unsigned char header[13];
+	header[0] = (unsigned char)(width >> 24);
+	header[1] = (unsigned char)(width >> 16);
+	header[2] = (unsigned char)(width >> 8);
+	header[3] = (unsigned char)width;
+	header[4] = (unsigned char)(height >> 24);
+	header[5] = (unsigned char)(height >> 16);
+	header[6] = (unsigned char)(height >> 8);
+	header[7] = (unsigned char)height;
+	header[8] = 8;		// bits per channel
+	header[9] = 2;		// RGB
+	header[10] = 0;		// deflate
+	header[11] = 0;		// adaptive filtering
+	header[12] = 0;		// not interlaced
+	AppendPngChunk(output, "IHDR", header, sizeof(header));
+
+	// the scanlines, each with the None filter
+	const size_t rowSize = 1 + ((size_t)width * 3);
+	std::vector<unsigned char> scanlines(rowSize * height);
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* pIn = pTopRow + (y * stride);
+		unsigned char* pOut = &scanlines[y * rowSize];
+		*pOut++ = 0;
+		for (int x = 0; x < width; x++)
+		{
+			pOut[0] = pIn[0];
+			pOut[1] = pIn[1];
+			pOut[2] = pIn[2];
+			pOut += 3;
+			pIn += 4;
+		}
+	}
+
+	// zlib header, stored blocks, then the Adler-32 of the data
+	const size_t blockCount = (scanlines.size() + MAX_STORED_BLOCK - 1) / MAX_STORED_BLOCK;
+	std::vector<unsigned char> stream;
+	stream.reserve(2 + (blockCount * 5) + scanlines.size() + 4);
+	stream.push_back(0x78);
+	stream.push_back(0x01);
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	for (size_t offset = 0; offset < scanlines.size(); offset += MAX_STORED_BLOCK)
+	{
+		const size_t size = std::min(MAX_STORED_BLOCK, scanlines.size() - offset);
+		stream.push_back((offset + size == scanlines.size()) ? 1 : 0);
+		stream.push_back((unsigned char)size);
+		stream.push_back((unsigned char)(size >> 8));
+		stream.push_back((unsigned char)~size);
+		stream.push_back((unsigned char)(~size >> 8));
+		stream.insert(stream.end(), scanlines.begin() + offset, scanlines.begin() + offset + size);
+
+		for (size_t i = offset; i < offset + size; i++)
+		{
+			adlerA = (adlerA + scanlines[i]) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+		}
+	}
+	AppendBigEndian(stream, (adlerB << 16) | adlerA);
+
+	AppendPngChunk(output, "IDAT", stream.data(), stream.size());
+	AppendPngChunk(output, "IEND", NULL, 0);
+}
+
+/***********************************************************
+ *  EncodeQoi()
+ *
+ *  This method is used for encoding the pixels with the QOI
+ *  format's runs, index hits, small differences and literal
+ *  colors, as three channel sRGB.
+ ***********************************************************/
+void ImageEncoders::EncodeQoi(const unsigned char* pTopRow, int width, int height, ptrdiff_t stride, std::vector<unsigned char>& output)
+{
+	output.clear();
+	output.reserve(14 + ((size_t)width * height * 4) + 8);
+	output.push_back('q');
+	output.push_back('o');
+	output.push_back('i');
+	output.push_back('f');
+	AppendBigEndian(output, (uint32_t)width);
+	AppendBigEndian(output, (uint32_t)height);
+	output.push_back(3);		// RGB
+	output.push_back(0);		// sRGB
+
+	QOI_PIXEL index[64];
+	memset(index, 0, sizeof(index));
+	QOI_PIXEL previous = { 0, 0, 0, 255 };
+	int run = 0;
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* pIn = pTopRow + (y * stride);
+		for (int x = 0; x < width; x++, pIn += 4)
+		{
+			QOI_PIXEL pixel = { pIn[0], pIn[1], pIn[2], 255 };
+			if (QoiEqual(pixel, previous) == true)
+			{
+				run++;
+				if (run == 62)
+				{
+					output.push_back((unsigned char)(0xC0 | (run - 1)));
+					run = 0;
+				}
+				continue;
+			}
+			if (run > 0)
+			{
+				output.push_back((unsigned char)(0xC0 | (run - 1)));
+				run = 0;
+			}
+
+			const int hash = QoiHash(pixel);
+			if (QoiEqual(index[hash], pixel) == true)
+			{
+				output.push_back((unsigned char)hash);
+			}
+			else
+			{
+				index[hash] = pixel;
+				const int dr = (signed char)(pixel.r - previous.r);
+				const int dg = (signed char)(pixel.g - previous.g);
+				const int db = (signed char)(pixel.b - previous.b);
+				const int drg = dr - dg;
+				const int dbg = db - dg;
+				if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1))
+				{
+					output.push_back((unsigned char)(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+				}
+				else if ((dg >= -32) && (dg <= 31) && (drg >= -8) && (drg <= 7) && (dbg >= -8) && (dbg <= 7))
+				{
+					output.push_back((unsigned char)(0x80 | (dg + 32)));
+					output.push_back((unsigned char)(((drg + 8) << 4) | (dbg + 8)));
+				}
+				else
+				{
+					output.push_back(0xFE);
+					output.push_back(pixel.r);
+					output.push_back(pixel.g);
+					output.push_back(pixel.b);
+				}
+			}
+			previous = pixel;
+		}
+	}
+	if (run > 0)
+	{
+		output.push_back((unsigned char)(0xC0 | (run - 1)));
+	}
+
+	static const unsigned char endMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	output.insert(output.end(), endMarker, endMarker + sizeof(endMarker));
+}
+
+/***********************************************************
+ *  EncodeRgb()
+ *
+ *  This method is used for dropping the alpha channel and
+ *  packing the rows with no header or padding.
+ ***********************************************************/
+void ImageEncoders::EncodeRgb(const unsigned char* pTopRow, int width, int height, ptrdiff_t stride, std::vector<unsigned char>& output)
+{
+	output.resize((size_t)width * height * 3);
+	unsigned char* pOut = output.data();
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* pIn = pTopRow + (y * stride);
+		for (int x = 0; x < width; x++, pIn += 4, pOut += 3)
+		{
+			pOut[0] = pIn[0];
+			pOut[1] = pIn[1];
+			pOut[2] = pIn[2];
+		}
+	}
+}
+
+/***********************************************************
+ *  EncodeY4mHeader()
+ *
+ *  This method is used for writing the stream header, with
+ *  progressive frames, square pixels and JPEG 4:2:0 chroma.
+ ***********************************************************/
+void ImageEncoders::EncodeY4mHeader(int width, int height, int framesPerSecond, std::vector<unsigned char>& output)
+{
+	char header[128];
+	const int length = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, framesPerSecond);
+	output.assign(header, header + length);
+}
+
+/***********************************************************
+ *  EncodeY4mFrame()
+ *
+ *  This method is used for converting the pixels to full
+ *  range BT.601 YUV in 16.16 fixed point, averaging the
+ *  chroma of each 2x2 block, and writing the planes after
+ *  the FRAME marker.
+ ***********************************************************/
+void ImageEncoders::EncodeY4mFrame(const unsigned char* pTopRow, int width, int height, ptrdiff_t stride, std::vector<unsigned char>& output)
+{
+	static const char marker[] = "FRAME\n";
+	const int chromaWidth = (width + 1) / 2;
+	const int chromaHeight = (height + 1) / 2;
+	const size_t lumaSize = (size_t)width * height;
+	const size_t chromaSize = (size_t)chromaWidth * chromaHeight;
+
+	output.resize((sizeof(marker) - 1) + lumaSize + (2 * chromaSize));
+	memcpy(output.data(), marker, sizeof(marker) - 1);
+	unsigned char* pLuma = output.data() + (sizeof(marker) - 1);
+	unsigned char* pBlue = pLuma + lumaSize;
+	unsigned char* pRed = pBlue + chromaSize;
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* pIn = pTopRow + (y * stride);
+		unsigned char* pOut = pLuma + ((size_t)y * width);
+		for (int x = 0; x < width; x++, pIn += 4)
+		{
+			pOut[x] = (unsigned char)(((19595 * pIn[0]) + (38470 * pIn[1]) + (7471 * pIn[2]) + 32768) >> 16);
+		}
+	}
+
+	for (int chromaY = 0; chromaY < chromaHeight; chromaY++)
+	{
+		const int y0 = chromaY * 2;
+		const int y1 = std::min(y0 + 1, height - 1);
+		for (int chromaX = 0; chromaX < chromaWidth; chromaX++)
+		{
+			const int x0 = chromaX * 2;
+			const int x1 = std::min(x0 + 1, width - 1);
+			const unsigned char* pixels[4] =
+			{
+				pTopRow + (y0 * stride) + (x0 * 4),
+				pTopRow + (y0 * stride) + (x1 * 4),
+				pTopRow + (y1 * stride) + (x0 * 4),
+				pTopRow + (y1 * stride) + (x1 * 4)
+			};
+			int r = 0;
+			int g = 0;
+			int b = 0;
+			for (const unsigned char* pPixel : pixels)
+			{
+				r += pPixel[0];
+				g += pPixel[1];
+				b += pPixel[2];
+			}
+
+			// the sums are four pixels, so the shift is 18, and the
+			// 128 offset is added before rounding
+			const int blue = ((-11059 * r) - (21709 * g) + (32768 * b) + (128 << 18) + (1 << 17)) >> 18;
+			const int red = ((32768 * r) - (27439 * g) - (5329 * b) + (128 << 18) + (1 << 17)) >> 18;
+			const size_t offset = ((size_t)chromaY * chromaWidth) + chromaX;
+			pBlue[offset] = (unsigned char)std::min(std::max(blue, 0), 255);
+			pRed[offset] = (unsigned char)std::min(std::max(red, 0), 255);
+		}
+	}
+}
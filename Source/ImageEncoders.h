@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////////////
+// imageencoders.h
+// ===============
+// encoders for captured frames - PNG and QOI stills and Y4M video frames
+//
+// Captured frames are RGBA rows as read back from OpenGL.  Each encoder takes
+// a pointer to the top row and the byte stride from one row to the next, so
+// bottom-up OpenGL readbacks are encoded top row first by passing the last
+// row and a negative stride, with no flip copy.  Alpha is dropped: blending
+// leaves arbitrary values in the framebuffer's alpha channel.
+//
+// There is no zlib in the project, so PNG files are written with stored
+// (uncompressed) deflate blocks; they are valid PNGs that any reader opens,
+// at the size of the raw pixels.  QOI is the compressed still format.  Y4M
+// frames are BT.601 full range YUV 4:2:0 (C420jpeg).
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace ImageEncoders
+{
+	// encode an RGB PNG file image
+	void EncodePng(const unsigned char* pTopRow, int width, int height, ptrdiff_t stride, std::vector<unsigned char>& output);
+	// encode an RGB QOI file image
+	void EncodeQoi(const unsigned char* pTopRow, int width, int height, ptrdiff_t stride, std::vector<unsigned char>& output);
+	// pack the pixels as raw RGB rows, top row first
+	void EncodeRgb(const unsigned char* pTopRow, int width, int height, ptrdiff_t stride, std::vector<unsigned char>& output);
+
+	// the header at the start of a Y4M stream
+	void EncodeY4mHeader(int width, int height, int framesPerSecond, std::vector<unsigned char>& output);
+	// one FRAME of a Y4M stream
+	void EncodeY4mFrame(const unsigned char* pTopRow, int width, int height, ptrdiff_t stride, std::vector<unsigned char>& output);
+}
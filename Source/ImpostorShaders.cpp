@@ -0,0 +1,425 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostorshaders.cpp
+// ===================
+// ray-cast impostor variant of the scene shader program
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImpostorShaders.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the define that builds the impostor path of the shaders
+	const char* g_ImpostorsDefine = "#define IMPOSTORS\n";
+	// names of the uniforms only the impostor program has
+	const char* g_ImpostorUniformNames[IMPOSTOR_UNIFORM_COUNT] =
+	{
+		"impostorType",
+		"impostorParts",
+		"meshBoundsMin",
+		"meshBoundsExtent",
+		"torusTubeRadius",
+		"impostorCameraPosition",
+		"impostorCameraForward"
+	};
+
+	// compile one shader from source, returning 0 on failure
+	GLuint CompileShader(GLenum type, const std::string& source, const char* name)
+	{
+		const char* pSource = source.c_str();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &pSource, NULL);
+		glCompileShader(shader);
+
+		GLint success = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR::SHADER_COMPILATION_ERROR of " << name << "\n" << infoLog << std::endl;
+			glDeleteShader(shader);
+			return(0);
+		}
+
+		return(shader);
+	}
+
+	// check the link status of a program and print its log on failure
+	bool CheckLink(GLuint program)
+	{
+		GLint success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			char infoLog[1024];
+			glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+			return(false);
+		}
+		return(true);
+	}
+
+	// the source of a shader of the passed in stage attached to a
+	// program, with the define added after its #version line, which
+	// has to come first - empty when the program has no such shader
+	std::string GetImpostorSource(GLuint program, GLenum stage)
+	{
+		GLuint attached[8];
+		GLsizei attachedCount = 0;
+		glGetAttachedShaders(program, 8, &attachedCount, attached);
+		for (GLsizei i = 0; i < attachedCount; i++)
+		{
+			GLint type = 0;
+			glGetShaderiv(attached[i], GL_SHADER_TYPE, &type);
+			if ((GLenum)type != stage)
+			{
+				continue;
+			}
+
+			GLint sourceLength = 0;
+			glGetShaderiv(attached[i], GL_SHADER_SOURCE_LENGTH, &sourceLength);
+			std::vector<char> source(sourceLength + 1, '\0');
+			glGetShaderSource(attached[i], (GLsizei)source.size(), NULL, source.data());
+
+			std::string impostorSource = source.data();
+			size_t versionEnd = 0;
+			if (impostorSource.compare(0, 8, "#version") == 0)
+			{
+				versionEnd = impostorSource.find('\n');
+				versionEnd = (versionEnd == std::string::npos) ? impostorSource.size() : versionEnd + 1;
+			}
+			impostorSource.insert(versionEnd, g_ImpostorsDefine);
+			return(impostorSource);
+		}
+		return(std::string());
+	}
+}
+
+/***********************************************************
+ *  ImpostorShaders()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ImpostorShaders::ImpostorShaders()
+{
+	m_program = 0;
+	m_sourceProgram = 0;
+	for (int uniform = 0; uniform < IMPOSTOR_UNIFORM_COUNT; uniform++)
+	{
+		m_locations[uniform] = -1;
+	}
+	m_bCopied = false;
+}
+
+/***********************************************************
+ *  ~ImpostorShaders()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ImpostorShaders::~ImpostorShaders()
+{
+	if (m_program != 0)
+	{
+		glDeleteProgram(m_program);
+		m_program = 0;
+	}
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for building the impostor program
+ *  from the sources of the vertex and fragment shaders the
+ *  program in use was linked with, read back from OpenGL,
+ *  and finding the uniforms it shares with that program.
+ ***********************************************************/
+bool ImpostorShaders::Create()
+{
+	if (m_program != 0)
+	{
+		return(true);
+	}
+
+	GLint sourceProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &sourceProgram);
+	if (sourceProgram == 0)
+	{
+		return(false);
+	}
+
+	const std::string vertexSource = GetImpostorSource(sourceProgram, GL_VERTEX_SHADER);
+	const std::string fragmentSource = GetImpostorSource(sourceProgram, GL_FRAGMENT_SHADER);
+	if (vertexSource.empty() || fragmentSource.empty())
+	{
+		return(false);
+	}
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource, "the impostor vertex shader");
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource, "the impostor fragment shader");
+	if ((vertexShader == 0) || (fragmentShader == 0))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return(false);
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+	// the program keeps the shaders alive while they are attached
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	if (CheckLink(program) == false)
+	{
+		glDeleteProgram(program);
+		return(false);
+	}
+
+	m_program = program;
+	m_sourceProgram = (GLuint)sourceProgram;
+	for (int uniform = 0; uniform < IMPOSTOR_UNIFORM_COUNT; uniform++)
+	{
+		m_locations[uniform] = glGetUniformLocation(m_program, g_ImpostorUniformNames[uniform]);
+	}
+	FindSharedUniforms();
+	m_bCopied = false;
+
+	std::cout << "INFO: ray-cast impostors enabled for the curved shapes, sharing "
+		<< m_sharedUniforms.size() << " uniforms with the scene program" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  FindSharedUniforms()
+ *
+ *  This method is used for listing the active uniforms of
+ *  the impostor program that the scene program also has,
+ *  leaving out those of the impostor path.  The elements of
+ *  an array are listed one by one.
+ ***********************************************************/
+void ImpostorShaders::FindSharedUniforms()
+{
+	m_sharedUniforms.clear();
+	m_floatValues.clear();
+	m_intValues.clear();
+
+	GLint uniformCount = 0;
+	glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	for (GLint index = 0; index < uniformCount; index++)
+	{
+		char name[256];
+		GLsizei nameLength = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_program, (GLuint)index, sizeof(name), &nameLength, &size, &type, name);
+
+		std::string baseName(name, nameLength);
+		bool bImpostorUniform = false;
+		for (int uniform = 0; uniform < IMPOSTOR_UNIFORM_COUNT; uniform++)
+		{
+			bImpostorUniform = bImpostorUniform || (baseName == g_ImpostorUniformNames[uniform]);
+		}
+		if (bImpostorUniform == true)
+		{
+			continue;
+		}
+
+		// an array is named after its first element
+		const size_t bracket = baseName.rfind("[0]");
+		if ((size > 1) && (bracket != std::string::npos) && (bracket + 3 == baseName.size()))
+		{
+			baseName.erase(bracket);
+			for (GLint element = 0; element < size; element++)
+			{
+				AddSharedUniform(baseName + "[" + std::to_string(element) + "]", type);
+			}
+		}
+		else if (AddSharedUniform(baseName, type) == false)
+		{
+			std::cout << "Impostor uniform " << baseName << " has a type that is not copied from the scene program" << std::endl;
+		}
+	}
+}
+
+/***********************************************************
+ *  AddSharedUniform()
+ *
+ *  This method is used for adding a uniform to the ones
+ *  copied from the scene program, when that program has it,
+ *  with room for its last copied value.
+ ***********************************************************/
+bool ImpostorShaders::AddSharedUniform(const std::string& name, GLenum type)
+{
+	SHARED_UNIFORM uniform;
+	uniform.type = type;
+	uniform.bInteger = false;
+	switch (type)
+	{
+	case GL_FLOAT:
+		uniform.components = 1;
+		break;
+	case GL_FLOAT_VEC2:
+		uniform.components = 2;
+		break;
+	case GL_FLOAT_VEC3:
+		uniform.components = 3;
+		break;
+	case GL_FLOAT_VEC4:
+		uniform.components = 4;
+		break;
+	case GL_FLOAT_MAT3:
+		uniform.components = 9;
+		break;
+	case GL_FLOAT_MAT4:
+		uniform.components = 16;
+		break;
+	case GL_INT:
+	case GL_BOOL:
+	case GL_SAMPLER_2D:
+		uniform.components = 1;
+		uniform.bInteger = true;
+		break;
+	default:
+		return(false);
+	}
+
+	uniform.sourceLocation = glGetUniformLocation(m_sourceProgram, name.c_str());
+	uniform.location = glGetUniformLocation(m_program, name.c_str());
+	if ((uniform.sourceLocation < 0) || (uniform.location < 0))
+	{
+		// only the impostor program reads it
+		return(true);
+	}
+
+	if (uniform.bInteger == true)
+	{
+		uniform.offset = m_intValues.size();
+		m_intValues.resize(m_intValues.size() + uniform.components, 0);
+	}
+	else
+	{
+		uniform.offset = m_floatValues.size();
+		m_floatValues.resize(m_floatValues.size() + uniform.components, 0.0f);
+	}
+	m_sharedUniforms.push_back(uniform);
+	return(true);
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for switching the draws that follow
+ *  to the impostor program.  Each shared uniform is read
+ *  back from the scene program and only written when its
+ *  value changed since the last switch.
+ ***********************************************************/
+void ImpostorShaders::Begin()
+{
+	if (m_program == 0)
+	{
+		return;
+	}
+
+	glUseProgram(m_program);
+	for (const SHARED_UNIFORM& uniform : m_sharedUniforms)
+	{
+		if (uniform.bInteger == true)
+		{
+			GLint value = 0;
+			glGetUniformiv(m_sourceProgram, uniform.sourceLocation, &value);
+			if ((m_bCopied == true) && (m_intValues[uniform.offset] == value))
+			{
+				continue;
+			}
+			m_intValues[uniform.offset] = value;
+			glUniform1i(uniform.location, value);
+			continue;
+		}
+
+		float values[16];
+		glGetUniformfv(m_sourceProgram, uniform.sourceLocation, values);
+		float* pCopied = &m_floatValues[uniform.offset];
+		if ((m_bCopied == true) && (memcmp(pCopied, values, uniform.components * sizeof(float)) == 0))
+		{
+			continue;
+		}
+		memcpy(pCopied, values, uniform.components * sizeof(float));
+		switch (uniform.type)
+		{
+		case GL_FLOAT:
+			glUniform1fv(uniform.location, 1, values);
+			break;
+		case GL_FLOAT_VEC2:
+			glUniform2fv(uniform.location, 1, values);
+			break;
+		case GL_FLOAT_VEC3:
+			glUniform3fv(uniform.location, 1, values);
+			break;
+		case GL_FLOAT_VEC4:
+			glUniform4fv(uniform.location, 1, values);
+			break;
+		case GL_FLOAT_MAT3:
+			glUniformMatrix3fv(uniform.location, 1, GL_FALSE, values);
+			break;
+		case GL_FLOAT_MAT4:
+			glUniformMatrix4fv(uniform.location, 1, GL_FALSE, values);
+			break;
+		default:
+			break;
+		}
+	}
+	m_bCopied = true;
+}
+
+/***********************************************************
+ *  End()
+ *
+ *  This method is used for switching back to the scene
+ *  program, whose uniforms the ShaderManager sets.
+ ***********************************************************/
+void ImpostorShaders::End()
+{
+	if (m_program != 0)
+	{
+		glUseProgram(m_sourceProgram);
+	}
+}
+
+/***********************************************************
+ *  SetInt()
+ *
+ *  This method is used for setting an integer uniform of the
+ *  impostor path.
+ ***********************************************************/
+void ImpostorShaders::SetInt(IMPOSTOR_UNIFORM uniform, int value)
+{
+	glUniform1i(m_locations[uniform], value);
+}
+
+/***********************************************************
+ *  SetFloat()
+ *
+ *  This method is used for setting a float uniform of the
+ *  impostor path.
+ ***********************************************************/
+void ImpostorShaders::SetFloat(IMPOSTOR_UNIFORM uniform, float value)
+{
+	glUniform1f(m_locations[uniform], value);
+}
+
+/***********************************************************
+ *  SetVec3()
+ *
+ *  This method is used for setting a vector uniform of the
+ *  impostor path.
+ ***********************************************************/
+void ImpostorShaders::SetVec3(IMPOSTOR_UNIFORM uniform, const glm::vec3& value)
+{
+	glUniform3fv(m_locations[uniform], 1, glm::value_ptr(value));
+}
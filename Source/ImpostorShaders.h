@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostorshaders.h
+// =================
+// ray-cast impostor variant of the scene shader program
+//
+// A fragment shader that writes gl_FragDepth anywhere turns off early and
+// hierarchical depth testing for every draw made with its program, so the
+// scene program never ray-casts impostors.  The impostor program is a second
+// program object, built from the same vertex and fragment shader sources
+// compiled with IMPOSTORS defined, and only the proxy box draws switch to it.
+//
+// The ShaderManager sets the uniforms of the scene program alone, so before
+// each proxy draw the values of the uniforms both programs have are copied
+// from the scene program - only the ones that changed since the last copy
+// are written.  The uniforms of the impostor path itself are set through
+// this class while the impostor program is in use, and no ShaderManager
+// setter may be called until the scene program is back in use.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// the uniforms only the impostor program has
+enum IMPOSTOR_UNIFORM
+{
+	// shape to ray-cast, and the cylinder parts intersected
+	IMPOSTOR_TYPE = 0,
+	IMPOSTOR_PARTS,
+	// object space box the shape fills
+	IMPOSTOR_BOUNDS_MIN,
+	IMPOSTOR_BOUNDS_EXTENT,
+	// tube radius of the torus relative to its main radius
+	IMPOSTOR_TUBE_RADIUS,
+	// object space camera position and view direction of the shape
+	IMPOSTOR_CAMERA_POSITION,
+	IMPOSTOR_CAMERA_FORWARD,
+	IMPOSTOR_UNIFORM_COUNT
+};
+
+/***********************************************************
+ *  ImpostorShaders
+ *
+ *  This class holds the impostor program and switches the
+ *  proxy box draws to it and back.
+ ***********************************************************/
+class ImpostorShaders
+{
+public:
+	// constructor
+	ImpostorShaders();
+	// destructor
+	~ImpostorShaders();
+
+	// build the impostor program from the shaders of the program
+	// in use, which the proxy draws switch back to - returns false
+	// when it does not build
+	bool Create();
+	bool IsCreated() const { return(m_program != 0); }
+
+	// switch to the impostor program, copying the uniform values
+	// the scene program changed since the last switch
+	void Begin();
+	// switch back to the scene program
+	void End();
+
+	// set a uniform of the impostor path - called between Begin()
+	// and End()
+	void SetInt(IMPOSTOR_UNIFORM uniform, int value);
+	void SetFloat(IMPOSTOR_UNIFORM uniform, float value);
+	void SetVec3(IMPOSTOR_UNIFORM uniform, const glm::vec3& value);
+
+private:
+	// a uniform both programs have, and where its last copied
+	// value is kept
+	struct SHARED_UNIFORM
+	{
+		GLenum type;
+		GLint sourceLocation;
+		GLint location;
+		int components;
+		bool bInteger;
+		size_t offset;
+	};
+
+	GLuint m_program;
+	GLuint m_sourceProgram;
+	GLint m_locations[IMPOSTOR_UNIFORM_COUNT];
+	std::vector<SHARED_UNIFORM> m_sharedUniforms;
+	// the values last copied, floats and integers by offset
+	std::vector<float> m_floatValues;
+	std::vector<GLint> m_intValues;
+	bool m_bCopied;
+
+	// find the uniforms both programs have
+	void FindSharedUniforms();
+	// add one uniform of the impostor program if the scene program
+	// has it - returns false for a type that cannot be copied
+	bool AddSharedUniform(const std::string& name, GLenum type);
+};
@@ -9,6 +9,11 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <cstdio>           // sscanf
+#include <chrono>           // headless frame timing
+#include <fstream>          // software frame output
+#include <cmath>            // abs
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -21,14 +26,44 @@
 
 #include "SceneManager.h"
 #include "ViewManager.h"
-#include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "TransformBatch.h"
+#include "TessellationShaders.h"
+#include "MeshImporter.h"
+#include "ParallelMeshes.h"
+#include "HeadlessContext.h"
+#include "RenderFarm.h"
+#include "SharedImages.h"
+#include "FrameCapture.h"
+#include "RenderServer.h"
+#include "SoftwareRasterizer.h"
+#include "ImageEncoders.h"
+#include "RenderBackend.h"
+#include "OpenGLBackend.h"
 
 // Namespace for declaring global variables
 namespace
 {
 	// Macro for window title
 	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
+	// default size of the headless frames, the same as the window
+	const int HEADLESS_WIDTH = 1000;
+	const int HEADLESS_HEIGHT = 800;
+	// default memory budget of the render server's frame cache
+	const int FRAME_CACHE_MEGABYTES = 256;
+	// frame sizes the software rasterizer is timed at against
+	// OpenGL, and the frames timed at each
+	const int BENCHMARK_SIZES[][2] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+	const int SOFTWARE_BENCHMARK_FRAMES = 20;
+	// shader files the rendered frames depend on
+	const char* const SHADER_FILES[] =
+	{
+		"shaders/vertexShader.glsl",
+		"shaders/fragmentShader.glsl",
+		"shaders/tessVertexShader.glsl",
+		"shaders/tessControlShader.glsl",
+		"shaders/tessEvaluationShader.glsl"
+	};
 
 	// Main GLFW window
 	GLFWwindow* g_Window = nullptr;
@@ -39,12 +74,32 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame capture object for recording the rendered frames
+	FrameCapture* g_FrameCapture = nullptr;
+	// backend the frames of the scene are rendered with
+	IRenderBackend* g_RenderBackend = nullptr;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
-bool InitializeGLEW();
+bool InitializeGLEW(bool bHeadless);
+bool GetFrameSize(int argc, char* argv[], int& width, int& height);
+bool CreateHeadlessView(int width, int height);
+bool PrepareRenderer(int argc, char* argv[], bool& bTessellation);
+void DestroyRenderer(bool bHeadless);
+bool StartFrameCapture(int argc, char* argv[]);
+bool RunBatchRender(int argc, char* argv[], const char* cameraListFilename);
+bool RunRenderServer(int argc, char* argv[], const char* socketPath);
+bool HasArgument(int argc, char* argv[], const char* name);
+const char* GetArgumentValue(int argc, char* argv[], const char* name);
+void RenderFrame();
+void PresentFrame();
+void RenderHeadlessFrames(int frameCount, const char* outputFilename);
+void RenderSoftwareFrame(SoftwareRasterizer& rasterizer, RASTER_SCENE& scene, int width, int height);
+void RenderSoftwareFrames(int frameCount, const char* outputFilename);
+void RunImpostorBenchmark();
+void RunSoftwareBenchmark();
 
 
 /***********************************************************
@@ -55,8 +110,48 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// the transform benchmark is CPU only and does not need a window
+	if (HasArgument(argc, argv, "--bench-transforms"))
+	{
+		RunTransformBenchmark();
+		return(EXIT_SUCCESS);
+	}
+	// and neither do the mesh generator and model import benchmarks
+	if (HasArgument(argc, argv, "--bench-generator"))
+	{
+		RunGeneratorBenchmark();
+		return(EXIT_SUCCESS);
+	}
+	const char* importFilename = GetArgumentValue(argc, argv, "--bench-import");
+	if (NULL != importFilename)
+	{
+		RunImportBenchmark(importFilename);
+		return(EXIT_SUCCESS);
+	}
+
+	// render image sequences from a camera list in worker
+	// processes, each with its own offscreen context
+	const char* cameraListFilename = GetArgumentValue(argc, argv, "--batch");
+	if (NULL != cameraListFilename)
+	{
+		return(RunBatchRender(argc, argv, cameraListFilename) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	// or keep one offscreen scene resident and render the
+	// camera requests sent to a UNIX socket
+	const char* socketPath = GetArgumentValue(argc, argv, "--serve");
+	if (NULL != socketPath)
+	{
+		return(RunRenderServer(argc, argv, socketPath) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// the headless mode renders offscreen with no window system,
+	// as does the software rasterizer and its benchmark
+	const bool bSoftware = HasArgument(argc, argv, "--software");
+	const bool bBenchSoftware = HasArgument(argc, argv, "--bench-software");
+	const bool bHeadless = HasArgument(argc, argv, "--headless") || bSoftware || bBenchSoftware;
+
 	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	if ((bHeadless == false) && (InitializeGLFW() == false))
 	{
 		return(EXIT_FAILURE);
 	}
@@ -67,75 +162,116 @@ int main(int argc, char* argv[])
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
 
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
-
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
+	if (bHeadless == true)
 	{
-		return(EXIT_FAILURE);
+		// try to create the offscreen context and framebuffer
+		int width = 0;
+		int height = 0;
+		if (GetFrameSize(argc, argv, width, height) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		// the benchmark needs room for its largest frame size
+		if ((bBenchSoftware == true) && (NULL == GetArgumentValue(argc, argv, "--size")))
+		{
+			width = BENCHMARK_SIZES[2][0];
+			height = BENCHMARK_SIZES[2][1];
+		}
+		if (CreateHeadlessView(width, height) == false)
+		{
+			return(EXIT_FAILURE);
+		}
 	}
-
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
-
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
-
-	std::cout << "\n*** KEY FUNCTIONS: ***\n";
-	std::cout << "ESC - close the window and exit\n";
-	std::cout << "W - zoom in\t" << "S - zoom out\n";
-	std::cout << "A - pan left\t" << "D - pan right\n";
-	std::cout << "Q - pan up\t" << "E - pan down\n";
-	std::cout << "O - front view (ortho)\n";
-	std::cout << "P - perspective view\n";
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
+	else
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
+		// try to create the main display window
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+
+		// if GLEW fails initialization, then terminate the application
+		if (InitializeGLEW(false) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
 
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+	// load the shaders and prepare the 3D scene
+	bool bTessellation = false;
+	PrepareRenderer(argc, argv, bTessellation);
 
-		// query the latest GLFW events
-		glfwPollEvents();
+	// optionally record every presented frame
+	if (StartFrameCapture(argc, argv) == false)
+	{
+		DestroyRenderer(bHeadless);
+		return(EXIT_FAILURE);
 	}
 
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
+	// time the curved shapes as meshes against impostors, then exit
+	if (HasArgument(argc, argv, "--bench-impostors"))
 	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
+		if (bTessellation)
+		{
+			std::cout << "Impostors are not drawn while tessellating - run the benchmark without --tessellation" << std::endl;
+		}
+		else
+		{
+			RunImpostorBenchmark();
+		}
+		if (NULL != g_Window)
+		{
+			glfwSetWindowShouldClose(g_Window, GLFW_TRUE);
+		}
 	}
-	if (NULL != g_ViewManager)
+	else if (bBenchSoftware == true)
 	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
+		// time the software rasterizer against OpenGL, then exit
+		RunSoftwareBenchmark();
 	}
-	if (NULL != g_ShaderManager)
+	else if (bHeadless == true)
 	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
+		// render the requested number of frames and optionally
+		// save the last one
+		int frameCount = 1;
+		const char* frames = GetArgumentValue(argc, argv, "--frames");
+		if (NULL != frames)
+		{
+			frameCount = atoi(frames);
+		}
+		if (bSoftware == true)
+		{
+			RenderSoftwareFrames(frameCount, GetArgumentValue(argc, argv, "--output"));
+		}
+		else
+		{
+			RenderHeadlessFrames(frameCount, GetArgumentValue(argc, argv, "--output"));
+		}
+	}
+
+	if (bHeadless == false)
+	{
+		std::cout << "\n*** KEY FUNCTIONS: ***\n";
+		std::cout << "ESC - close the window and exit\n";
+		std::cout << "W - zoom in\t" << "S - zoom out\n";
+		std::cout << "A - pan left\t" << "D - pan right\n";
+		std::cout << "Q - pan up\t" << "E - pan down\n";
+		std::cout << "O - front view (ortho)\n";
+		std::cout << "P - perspective view\n";
+
+		// loop will keep running until the application is closed 
+		// or until an error has occurred
+		while (!glfwWindowShouldClose(g_Window))
+		{
+			// draw the 3D scene into the back buffer
+			RenderFrame();
+
+			// Flips the the back buffer with the front buffer every frame
+			// and queries the latest GLFW events
+			PresentFrame();
+		}
 	}
 
+	// clear the allocated manager objects from memory
+	DestroyRenderer(bHeadless);
+
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
 }
@@ -172,14 +308,24 @@ bool InitializeGLFW()
  *
  *  This function is used to initialize the GLEW library.
  ***********************************************************/
-bool InitializeGLEW()
+bool InitializeGLEW(bool bHeadless)
 {
 	// GLEW: initialize
 	// -----------------------------------------
 	GLenum GLEWInitResult = GLEW_OK;
 
 	// try to initialize the GLEW library
-	GLEWInitResult = glewInit();
+	if (bHeadless == true)
+	{
+		// there is no GLX or WGL behind an EGL or OSMesa context,
+		// so only the OpenGL functions themselves are loaded
+		glewExperimental = GL_TRUE;
+		GLEWInitResult = glewContextInit();
+	}
+	else
+	{
+		GLEWInitResult = glewInit();
+	}
 	if (GLEW_OK != GLEWInitResult)
 	{
 		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
@@ -192,4 +338,656 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
+}
+
+/***********************************************************
+ *	GetFrameSize()
+ *
+ *  This function is used to get the size of offscreen frames,
+ *  given as --size WIDTHxHEIGHT or the window size by default.
+ ***********************************************************/
+bool GetFrameSize(int argc, char* argv[], int& width, int& height)
+{
+	width = HEADLESS_WIDTH;
+	height = HEADLESS_HEIGHT;
+
+	const char* size = GetArgumentValue(argc, argv, "--size");
+	if ((NULL != size) && (sscanf(size, "%dx%d", &width, &height) != 2))
+	{
+		std::cout << "Expected --size WIDTHxHEIGHT, got " << size << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *	CreateHeadlessView()
+ *
+ *  This function is used to create the offscreen context,
+ *  load the OpenGL functions, and create the framebuffer the
+ *  frames are drawn into, with no window system.
+ ***********************************************************/
+bool CreateHeadlessView(int width, int height)
+{
+	if (HeadlessContext::CreateContext(width, height) == false)
+	{
+		return(false);
+	}
+	g_ViewManager->CreateOffscreenView(width, height);
+
+	if (InitializeGLEW(true) == false)
+	{
+		return(false);
+	}
+
+	return(HeadlessContext::CreateFramebuffer());
+}
+
+/***********************************************************
+ *	PrepareRenderer()
+ *
+ *  This function is used to load the shader program, relink
+ *  it for tessellation if asked to, and create
+ *  and prepare the 3D scene with the options given on the
+ *  command line.  It returns false when the scene could not
+ *  load all of its textures.
+ ***********************************************************/
+bool PrepareRenderer(int argc, char* argv[], bool& bTessellation)
+{
+	// load the shader code from the external GLSL files
+	g_ShaderManager->LoadShaders(
+		SHADER_FILES[0],
+		SHADER_FILES[1]);
+	g_ShaderManager->use();
+
+	// optionally relink the shader program with the hardware
+	// tessellation stages, before any uniforms are set
+	bTessellation = false;
+	if (HasArgument(argc, argv, "--tessellation"))
+	{
+		bTessellation = TessellationShaders::Attach(
+			SHADER_FILES[2],
+			SHADER_FILES[3],
+			SHADER_FILES[4]);
+	}
+
+	// try to create a new scene manager object and prepare the 3D scene
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetTessellation(bTessellation);
+	// the impostor program is built from the program in use, which
+	// stays in use for every draw but the proxy boxes
+	g_SceneManager->SetImpostors(HasArgument(argc, argv, "--impostors"));
+	g_SceneManager->SetMeshletCulling(!HasArgument(argc, argv, "--no-meshlet-culling"));
+	g_SceneManager->SetClusters(!HasArgument(argc, argv, "--no-clusters"));
+	// the software rasterizer draws from a copy of the geometry
+	g_SceneManager->SetKeepGeometry(
+		HasArgument(argc, argv, "--software") || HasArgument(argc, argv, "--bench-software"));
+	const bool bPrepared = g_SceneManager->PrepareScene();
+
+	// the frames are drawn through the OpenGL context by default,
+	// optionally timing each pass
+	OpenGLBackend* pOpenGLBackend = new OpenGLBackend(g_SceneManager, g_ViewManager);
+	pOpenGLBackend->SetPassTimings(HasArgument(argc, argv, "--pass-timings"));
+	g_RenderBackend = pOpenGLBackend;
+
+	return(bPrepared);
+}
+
+/***********************************************************
+ *	DestroyRenderer()
+ *
+ *  This function is used to free the manager objects and,
+ *  after them, the offscreen context they used.
+ ***********************************************************/
+void DestroyRenderer(bool bHeadless)
+{
+	// finish the frames still being read back or encoded
+	if (NULL != g_FrameCapture)
+	{
+		delete g_FrameCapture;
+		g_FrameCapture = NULL;
+	}
+	if (NULL != g_RenderBackend)
+	{
+		g_RenderBackend->ReportPasses();
+		delete g_RenderBackend;
+		g_RenderBackend = NULL;
+	}
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+	if (NULL != g_ShaderManager)
+	{
+		delete g_ShaderManager;
+		g_ShaderManager = NULL;
+	}
+	// the offscreen context outlives the objects that free GL data
+	if (bHeadless == true)
+	{
+		HeadlessContext::Destroy();
+	}
+}
+
+/***********************************************************
+ *	StartFrameCapture()
+ *
+ *  This function is used to start recording the presented
+ *  frames when --capture is given - to numbered png or qoi
+ *  stills in that directory, or a y4m video in that file, as
+ *  chosen with --capture-format.
+ ***********************************************************/
+bool StartFrameCapture(int argc, char* argv[])
+{
+	const char* capturePath = GetArgumentValue(argc, argv, "--capture");
+	if (NULL == capturePath)
+	{
+		return(true);
+	}
+
+	CAPTURE_FORMAT format = CAPTURE_PNG;
+	const char* formatName = GetArgumentValue(argc, argv, "--capture-format");
+	if ((NULL != formatName) && (FrameCapture::ParseFormat(formatName, format) == false))
+	{
+		std::cout << "Unknown capture format " << formatName << " - use png, qoi or y4m" << std::endl;
+		return(false);
+	}
+	int framesPerSecond = 30;
+	const char* fps = GetArgumentValue(argc, argv, "--capture-fps");
+	if (NULL != fps)
+	{
+		framesPerSecond = atoi(fps);
+	}
+	if (framesPerSecond < 1)
+	{
+		framesPerSecond = 30;
+	}
+
+	// frames are read from the framebuffer they are drawn into
+	int width = 0;
+	int height = 0;
+	if (NULL != g_Window)
+	{
+		glfwGetFramebufferSize(g_Window, &width, &height);
+	}
+	else
+	{
+		width = HeadlessContext::GetWidth();
+		height = HeadlessContext::GetHeight();
+	}
+
+	g_FrameCapture = new FrameCapture();
+	return(g_FrameCapture->Start(width, height, format, capturePath, framesPerSecond));
+}
+
+/***********************************************************
+ *	RunBatchRender()
+ *
+ *  This function is used to render one image for every pose
+ *  of a camera list.  The scene textures are decoded once
+ *  into shared memory, then each worker process creates its
+ *  own offscreen context and scene and renders its share of
+ *  the poses to numbered images in --output-dir.
+ ***********************************************************/
+bool RunBatchRender(int argc, char* argv[], const char* cameraListFilename)
+{
+	std::vector<CAMERA_POSE> poses;
+	int width = 0;
+	int height = 0;
+	if ((RenderFarm::ReadCameraPoses(cameraListFilename, poses) == false) ||
+		(GetFrameSize(argc, argv, width, height) == false))
+	{
+		return(false);
+	}
+
+	// one worker per hardware thread unless --workers is given
+	int requestedWorkers = 0;
+	const char* workers = GetArgumentValue(argc, argv, "--workers");
+	if (NULL != workers)
+	{
+		requestedWorkers = atoi(workers);
+	}
+	const char* outputDirectory = GetArgumentValue(argc, argv, "--output-dir");
+	if (NULL == outputDirectory)
+	{
+		outputDirectory = ".";
+	}
+
+	// decode the textures before the workers start so they
+	// all upload from the same copy
+	SharedImages::Decode(SceneManager::GetTextureFilenames());
+
+	bool bResult = RenderFarm::Run(poses, requestedWorkers,
+		[&](int worker, int workerCount, double* latencies) -> bool
+		{
+			g_ShaderManager = new ShaderManager();
+			g_ViewManager = new ViewManager(g_ShaderManager);
+			if (CreateHeadlessView(width, height) == false)
+			{
+				DestroyRenderer(true);
+				return(false);
+			}
+			// a worker missing a texture would write untextured
+			// frames, so it fails instead
+			bool bTessellation = false;
+			if (PrepareRenderer(argc, argv, bTessellation) == false)
+			{
+				DestroyRenderer(true);
+				return(false);
+			}
+
+			bool bSucceeded = true;
+			for (size_t pose = worker; pose < poses.size(); pose += workerCount)
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+				// each worker renders its own share of the poses, so
+				// the detail of a frame cannot depend on the poses
+				// rendered before it
+				g_ViewManager->SetCameraPose(poses[pose]);
+				g_SceneManager->ResetDetailState();
+				RenderFrame();
+
+				// reading the frame back waits for it to finish
+				char filename[1024];
+				snprintf(filename, sizeof(filename), "%s/frame_%05d.ppm", outputDirectory, (int)pose);
+				if (HeadlessContext::WriteFrame(filename) == false)
+				{
+					bSucceeded = false;
+					continue;
+				}
+				latencies[pose] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+
+			DestroyRenderer(true);
+			return(bSucceeded);
+		});
+
+	SharedImages::Release();
+	return(bResult);
+}
+
+/***********************************************************
+ *	RunRenderServer()
+ *
+ *  This function is used to prepare the scene once in an
+ *  offscreen context the size of the largest frame served,
+ *  then render the requests that arrive on the socket into
+ *  its lower left corner until one asks the server to stop.
+ *  Frames are kept in a cache of --frame-cache megabytes,
+ *  which 0 turns off.
+ ***********************************************************/
+bool RunRenderServer(int argc, char* argv[], const char* socketPath)
+{
+	int width = 0;
+	int height = 0;
+	if (GetFrameSize(argc, argv, width, height) == false)
+	{
+		return(false);
+	}
+
+	g_ShaderManager = new ShaderManager();
+	g_ViewManager = new ViewManager(g_ShaderManager);
+	if (CreateHeadlessView(width, height) == false)
+	{
+		DestroyRenderer(true);
+		return(false);
+	}
+	bool bTessellation = false;
+	PrepareRenderer(argc, argv, bTessellation);
+
+	int cacheMegabytes = FRAME_CACHE_MEGABYTES;
+	const char* cacheSize = GetArgumentValue(argc, argv, "--frame-cache");
+	if (NULL != cacheSize)
+	{
+		cacheMegabytes = atoi(cacheSize);
+	}
+	if (cacheMegabytes < 0)
+	{
+		cacheMegabytes = 0;
+	}
+	FrameCache frameCache((size_t)cacheMegabytes * 1024 * 1024);
+
+	RenderServer server;
+	if (cacheMegabytes > 0)
+	{
+		uint64_t sceneVersion = g_SceneManager->GetSceneVersion();
+		for (const char* shaderFile : SHADER_FILES)
+		{
+			sceneVersion = FrameCache::HashFile(shaderFile, sceneVersion);
+		}
+		server.SetFrameCache(&frameCache, sceneVersion);
+	}
+	bool bResult = server.Run(socketPath, width, height,
+		[](const RENDER_REQUEST& request, std::vector<unsigned char>& pixels) -> bool
+		{
+			g_ViewManager->SetViewport(request.width, request.height);
+			g_ViewManager->SetCameraPose(request.pose);
+			// a cached frame may be served for any later request of
+			// its key, so it cannot depend on the requests before it
+			g_SceneManager->ResetDetailState();
+			RenderFrame();
+
+			pixels.resize((size_t)request.width * request.height * 4);
+			glReadPixels(0, 0, request.width, request.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			return(glGetError() == GL_NO_ERROR);
+		});
+
+	DestroyRenderer(true);
+	return(bResult);
+}
+
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to draw one frame of the 3D scene
+ *  with the current render backend - into the back buffer
+ *  with OpenGL.
+ ***********************************************************/
+void RenderFrame()
+{
+	g_RenderBackend->RenderFrame();
+}
+
+/***********************************************************
+ *	PresentFrame()
+ *
+ *  This function is used to show a rendered frame - the
+ *  window's buffers are swapped, while headless frames only
+ *  need their commands submitted.
+ ***********************************************************/
+void PresentFrame()
+{
+	// queue the readback before the back buffer is swapped away
+	if (NULL != g_FrameCapture)
+	{
+		g_FrameCapture->CaptureFrame();
+	}
+
+	if (NULL != g_Window)
+	{
+		glfwSwapBuffers(g_Window);
+		glfwPollEvents();
+	}
+	else
+	{
+		glFlush();
+	}
+}
+
+/***********************************************************
+ *	RenderHeadlessFrames()
+ *
+ *  This function is used to render frames of the scene into
+ *  the offscreen framebuffer, report the average time per
+ *  frame, and write the last frame to a file if one is given.
+ ***********************************************************/
+void RenderHeadlessFrames(int frameCount, const char* outputFilename)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		RenderFrame();
+		PresentFrame();
+	}
+	g_RenderBackend->Finish();
+	const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	if (frameCount > 0)
+	{
+		std::cout << "INFO: Rendered " << frameCount << " headless frames of "
+			<< HeadlessContext::GetWidth() << "x" << HeadlessContext::GetHeight()
+			<< " with " << g_RenderBackend->GetName() << " on " << HeadlessContext::GetApiName() << ", "
+			<< elapsed / frameCount << " ms per frame" << std::endl;
+	}
+
+	if ((NULL != outputFilename) && (g_RenderBackend->WriteFrame(outputFilename) == true))
+	{
+		std::cout << "INFO: Wrote the last frame to " << outputFilename << std::endl;
+	}
+}
+
+/***********************************************************
+ *	RenderSoftwareFrame()
+ *
+ *  This function is used to render one frame of the scene
+ *  with the software rasterizer, from the same camera and
+ *  draws an OpenGL frame of the passed in size would use.
+ ***********************************************************/
+void RenderSoftwareFrame(SoftwareRasterizer& rasterizer, RASTER_SCENE& scene, int width, int height)
+{
+	g_ViewManager->SetViewport(width, height);
+	g_ViewManager->PrepareSceneView();
+	g_SceneManager->SetViewProjection(
+		g_ViewManager->GetViewMatrix(),
+		g_ViewManager->GetProjectionMatrix());
+
+	g_SceneManager->RecordRasterScene(scene);
+	scene.view = g_ViewManager->GetViewMatrix();
+	scene.projection = g_ViewManager->GetProjectionMatrix();
+	scene.viewPosition = glm::vec3(glm::inverse(scene.view)[3]);
+
+	rasterizer.Render(scene, width, height);
+}
+
+/***********************************************************
+ *	RenderSoftwareFrames()
+ *
+ *  This function is used to render frames of the scene with
+ *  the software rasterizer, report the average time per
+ *  frame, and write the last frame to a png file if one is
+ *  given.
+ ***********************************************************/
+void RenderSoftwareFrames(int frameCount, const char* outputFilename)
+{
+	SoftwareRasterizer rasterizer;
+	RASTER_SCENE scene;
+	const int width = HeadlessContext::GetWidth();
+	const int height = HeadlessContext::GetHeight();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		RenderSoftwareFrame(rasterizer, scene, width, height);
+	}
+	const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	if (frameCount > 0)
+	{
+		std::cout << "INFO: Rendered " << frameCount << " software frames of "
+			<< width << "x" << height << " with " << rasterizer.GetThreadCount() << " threads, "
+			<< elapsed / frameCount << " ms per frame, "
+			<< rasterizer.GetFrameTriangles() << " triangles per frame" << std::endl;
+	}
+
+	if ((NULL != outputFilename) && (frameCount > 0))
+	{
+		// the rasterizer keeps the bottom row first, like OpenGL
+		const ptrdiff_t rowSize = (ptrdiff_t)width * 4;
+		const unsigned char* pTopRow = rasterizer.GetPixels() + ((height - 1) * rowSize);
+		std::vector<unsigned char> encoded;
+		ImageEncoders::EncodePng(pTopRow, width, height, -rowSize, encoded);
+
+		std::ofstream file(outputFilename, std::ios::binary);
+		file.write((const char*)encoded.data(), encoded.size());
+		if (file.good())
+		{
+			std::cout << "INFO: Wrote the last frame to " << outputFilename << std::endl;
+		}
+		else
+		{
+			std::cout << "Could not write frame to " << outputFilename << std::endl;
+		}
+	}
+}
+
+/***********************************************************
+ *	RunImpostorBenchmark()
+ *
+ *  This function is used to time the scene on the GPU with
+ *  the curved shapes drawn as triangle meshes and then as
+ *  ray-cast impostors, reporting the average frame time and
+ *  the triangles drawn for each.  The meshes are drawn with
+ *  the default shader program alone, which keeps early depth
+ *  testing, and only the proxy boxes of the impostors switch
+ *  to the impostor program.
+ ***********************************************************/
+void RunImpostorBenchmark()
+{
+	const int BENCHMARK_FRAMES = 300;
+	const char* modeNames[2] = { "meshes", "impostors" };
+
+	GLuint query = 0;
+	glGenQueries(1, &query);
+
+	for (int mode = 0; mode < 2; mode++)
+	{
+		if (g_SceneManager->SetImpostors(mode == 1) == false)
+		{
+			std::cout << "The impostor shader program could not be built - the impostors are not timed" << std::endl;
+			break;
+		}
+
+		// one untimed frame lets the level of detail settle
+		RenderFrame();
+		PresentFrame();
+
+		GLuint64 totalTime = 0;
+		for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+		{
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			RenderFrame();
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+			totalTime += elapsed;
+
+			PresentFrame();
+		}
+
+		std::cout << "INFO: curved shapes as " << modeNames[mode] << ": "
+			<< ((double)totalTime / BENCHMARK_FRAMES) / 1.0e6 << " ms GPU time per frame, "
+			<< g_SceneManager->GetFrameTriangles() << " triangles per frame" << std::endl;
+	}
+
+	glDeleteQueries(1, &query);
+}
+
+/***********************************************************
+ *	RunSoftwareBenchmark()
+ *
+ *  This function is used to time the scene rendered by
+ *  OpenGL and by the software rasterizer at several frame
+ *  sizes, reporting the average frame time of each and the
+ *  mean difference between their pixels.
+ ***********************************************************/
+void RunSoftwareBenchmark()
+{
+	SoftwareRasterizer rasterizer;
+	RASTER_SCENE scene;
+	std::vector<unsigned char> glPixels;
+
+	for (const int* size : BENCHMARK_SIZES)
+	{
+		const int width = size[0];
+		const int height = size[1];
+		if ((width > HeadlessContext::GetWidth()) || (height > HeadlessContext::GetHeight()))
+		{
+			std::cout << "INFO: Skipping " << width << "x" << height
+				<< ", larger than the " << HeadlessContext::GetWidth() << "x"
+				<< HeadlessContext::GetHeight() << " framebuffer" << std::endl;
+			continue;
+		}
+
+		// OpenGL, finished before the clock is read; one untimed
+		// frame lets the level of detail settle
+		g_ViewManager->SetViewport(width, height);
+		RenderFrame();
+		glFinish();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < SOFTWARE_BENCHMARK_FRAMES; frame++)
+		{
+			RenderFrame();
+			glFinish();
+		}
+		const double glTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		glPixels.resize((size_t)width * height * 4);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, glPixels.data());
+
+		// the software rasterizer, after one frame that reads
+		// back the textures
+		RenderSoftwareFrame(rasterizer, scene, width, height);
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < SOFTWARE_BENCHMARK_FRAMES; frame++)
+		{
+			RenderSoftwareFrame(rasterizer, scene, width, height);
+		}
+		const double softwareTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// mean difference of the color channels
+		const unsigned char* pSoftware = rasterizer.GetPixels();
+		double difference = 0.0;
+		for (size_t i = 0; i < glPixels.size(); i++)
+		{
+			if ((i % 4) != 3)
+			{
+				difference += std::abs((int)glPixels[i] - (int)pSoftware[i]);
+			}
+		}
+		difference /= (double)width * height * 3;
+
+		std::cout << "INFO: " << width << "x" << height << ": "
+			<< HeadlessContext::GetApiName() << " OpenGL " << glTime / SOFTWARE_BENCHMARK_FRAMES << " ms per frame, "
+			<< "software " << softwareTime / SOFTWARE_BENCHMARK_FRAMES << " ms per frame with "
+			<< rasterizer.GetThreadCount() << " threads, mean pixel difference "
+			<< difference << std::endl;
+	}
+}
+
+/***********************************************************
+ *	HasArgument()
+ *
+ *  This function is used to check whether the passed in
+ *  option was given on the command line.
+ ***********************************************************/
+bool HasArgument(int argc, char* argv[], const char* name)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *	GetArgumentValue()
+ *
+ *  This function is used to get the value that follows the
+ *  passed in option on the command line, or NULL if the
+ *  option was not given with a value.
+ ***********************************************************/
+const char* GetArgumentValue(int argc, char* argv[], const char* name)
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return(argv[i + 1]);
+		}
+	}
+
+	return(NULL);
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// read-only memory mapping of a whole file
+//
+// The file contents are paged in by the operating system on first access and
+// can be handed directly to APIs such as glBufferData without first being
+// copied into a heap buffer.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map the whole file at the passed in path, returning false if it
+	// does not exist, is empty or cannot be mapped
+	bool Open(const char* filename);
+	// unmap the file
+	void Close();
+
+	// start and size of the mapped contents
+	const unsigned char* GetData() const { return(m_pData); }
+	size_t GetSize() const { return(m_size); }
+	bool IsOpen() const { return(NULL != m_pData); }
+
+private:
+	// mapped contents
+	const unsigned char* m_pData;
+	size_t m_size;
+#ifdef _WIN32
+	// file and file mapping handles
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+
+	// a mapping cannot be copied
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
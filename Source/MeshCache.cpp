@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcache.cpp
+// =============
+// versioned binary cache of the generated and optimized shared mesh buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const char g_CacheMagic[4] = { 'M', 'S', 'H', 'C' };
+	// every section starts on this boundary
+	const uint32_t g_SectionAlignment = 16;
+
+	/***********************************************************
+	 *  MESH_CACHE_HEADER
+	 *
+	 *  Start of the cache file.  Offsets are from the start of
+	 *  the file.
+	 ***********************************************************/
+	struct MESH_CACHE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+		uint32_t rangeCount;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t meshletCount;
+		uint32_t rangeOffset;
+		uint32_t vertexOffset;
+		uint32_t indexOffset;
+		uint32_t meshletOffset;
+		uint64_t fileSize;
+	};
+
+	// round an offset up to the next section boundary
+	uint32_t AlignSection(uint64_t offset)
+	{
+		return((uint32_t)((offset + g_SectionAlignment - 1) & ~(uint64_t)(g_SectionAlignment - 1)));
+	}
+
+	// fill the section offsets and file size of a header
+	void LayoutSections(MESH_CACHE_HEADER& header)
+	{
+		header.rangeOffset = AlignSection(sizeof(MESH_CACHE_HEADER));
+		header.vertexOffset = AlignSection(header.rangeOffset + ((uint64_t)header.rangeCount * sizeof(MESH_RANGE)));
+		header.indexOffset = AlignSection(header.vertexOffset + ((uint64_t)header.vertexCount * sizeof(PACKED_VERTEX)));
+		header.meshletOffset = AlignSection(header.indexOffset + ((uint64_t)header.indexCount * sizeof(uint32_t)));
+		header.fileSize = header.meshletOffset + ((uint64_t)header.meshletCount * sizeof(MESHLET));
+	}
+}
+
+/***********************************************************
+ *  Hash()
+ *
+ *  This method is used for hashing bytes with 64-bit FNV-1a.
+ *  Passing a previous result as the starting hash chains the
+ *  hashes of several values.
+ ***********************************************************/
+uint64_t MeshCache::Hash(const void* pData, size_t size, uint64_t hash)
+{
+	const unsigned char* pBytes = (const unsigned char*)pData;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return(hash);
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the cache file and, when
+ *  it matches the expected version, key and range count and
+ *  is not truncated, pointing the view at its sections.
+ ***********************************************************/
+bool MeshCache::Open(
+	const char* filename,
+	uint64_t key,
+	uint32_t rangeCount,
+	MappedFile& file,
+	MESH_CACHE_VIEW& view)
+{
+	if (file.Open(filename) == false)
+	{
+		return(false);
+	}
+	if (file.GetSize() < sizeof(MESH_CACHE_HEADER))
+	{
+		file.Close();
+		return(false);
+	}
+
+	MESH_CACHE_HEADER header;
+	memcpy(&header, file.GetData(), sizeof(header));
+
+	// recompute the layout rather than trusting the stored offsets
+	MESH_CACHE_HEADER expected = header;
+	LayoutSections(expected);
+
+	if ((memcmp(header.magic, g_CacheMagic, sizeof(g_CacheMagic)) != 0) ||
+		(header.version != FILE_VERSION) ||
+		(header.key != key) ||
+		(header.rangeCount != rangeCount) ||
+		(header.rangeOffset != expected.rangeOffset) ||
+		(header.vertexOffset != expected.vertexOffset) ||
+		(header.indexOffset != expected.indexOffset) ||
+		(header.meshletOffset != expected.meshletOffset) ||
+		(header.fileSize != expected.fileSize) ||
+		(file.GetSize() < header.fileSize))
+	{
+		file.Close();
+		return(false);
+	}
+
+	view.pRanges = (const MESH_RANGE*)(file.GetData() + header.rangeOffset);
+	view.rangeCount = header.rangeCount;
+	view.pVertices = (const PACKED_VERTEX*)(file.GetData() + header.vertexOffset);
+	view.vertexCount = header.vertexCount;
+	view.pIndices = (const uint32_t*)(file.GetData() + header.indexOffset);
+	view.indexCount = header.indexCount;
+	view.pMeshlets = (const MESHLET*)(file.GetData() + header.meshletOffset);
+	view.meshletCount = header.meshletCount;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the ranges, vertices,
+ *  indices and meshlets of the shared mesh buffer to a new
+ *  cache file.  The file is written under a name private to
+ *  this process and then renamed over the cache, so batch
+ *  render processes that map the cache never see it
+ *  truncated or half written.
+ ***********************************************************/
+bool MeshCache::Save(
+	const char* filename,
+	uint64_t key,
+	const MESH_RANGE* pRanges,
+	uint32_t rangeCount,
+	const std::vector<PACKED_VERTEX>& vertices,
+	const std::vector<uint32_t>& indices,
+	const std::vector<MESHLET>& meshlets)
+{
+	MESH_CACHE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, g_CacheMagic, sizeof(g_CacheMagic));
+	header.version = FILE_VERSION;
+	header.key = key;
+	header.rangeCount = rangeCount;
+	header.vertexCount = (uint32_t)vertices.size();
+	header.indexCount = (uint32_t)indices.size();
+	header.meshletCount = (uint32_t)meshlets.size();
+	LayoutSections(header);
+
+#ifdef _WIN32
+	const std::string temporaryName = std::string(filename) + ".tmp" + std::to_string(_getpid());
+#else
+	const std::string temporaryName = std::string(filename) + ".tmp" + std::to_string(getpid());
+#endif
+	std::ofstream stream(temporaryName, std::ios::binary | std::ios::trunc);
+	if (!stream)
+	{
+		return(false);
+	}
+
+	const char padding[g_SectionAlignment] = { 0 };
+	stream.write((const char*)&header, sizeof(header));
+	stream.write(padding, header.rangeOffset - sizeof(header));
+	stream.write((const char*)pRanges, rangeCount * sizeof(MESH_RANGE));
+	stream.write(padding, header.vertexOffset - (header.rangeOffset + (rangeCount * sizeof(MESH_RANGE))));
+	stream.write((const char*)vertices.data(), vertices.size() * sizeof(PACKED_VERTEX));
+	stream.write(padding, header.indexOffset - (header.vertexOffset + (vertices.size() * sizeof(PACKED_VERTEX))));
+	stream.write((const char*)indices.data(), indices.size() * sizeof(uint32_t));
+	stream.write(padding, header.meshletOffset - (header.indexOffset + (indices.size() * sizeof(uint32_t))));
+	stream.write((const char*)meshlets.data(), meshlets.size() * sizeof(MESHLET));
+
+	stream.close();
+	if (stream.fail())
+	{
+		std::remove(temporaryName.c_str());
+		return(false);
+	}
+#ifdef _WIN32
+	// rename does not replace an existing file on Windows
+	std::remove(filename);
+#endif
+	if (std::rename(temporaryName.c_str(), filename) != 0)
+	{
+		std::remove(temporaryName.c_str());
+		return(false);
+	}
+
+	return(true);
+}
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcache.h
+// ===========
+// versioned binary cache of the generated and optimized shared mesh buffer
+//
+// The cache file holds a header, the mesh ranges, the packed vertices, the
+// indices and the meshlets, each section aligned so it can be used in place
+// once the file is memory mapped.  The header records a key hashed from everything that
+// affects the generated data; a file with a different version or key is
+// ignored and rewritten.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "SceneMeshes.h"
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  MESH_CACHE_VIEW
+ *
+ *  Pointers into a mapped cache file.
+ ***********************************************************/
+struct MESH_CACHE_VIEW
+{
+	const MESH_RANGE* pRanges;
+	uint32_t rangeCount;
+	const PACKED_VERTEX* pVertices;
+	uint32_t vertexCount;
+	const uint32_t* pIndices;
+	uint32_t indexCount;
+	const MESHLET* pMeshlets;
+	uint32_t meshletCount;
+};
+
+namespace MeshCache
+{
+	// bumped whenever the file layout changes
+	const uint32_t FILE_VERSION = 2;
+
+	// FNV-1a hash of the passed in bytes, chained from a previous hash
+	uint64_t Hash(const void* pData, size_t size, uint64_t hash = 14695981039346656037ULL);
+
+	// map the cache file and check its version, key, range count and
+	// section sizes - the view points into the mapped file
+	bool Open(
+		const char* filename,
+		uint64_t key,
+		uint32_t rangeCount,
+		MappedFile& file,
+		MESH_CACHE_VIEW& view);
+
+	// write a new cache file
+	bool Save(
+		const char* filename,
+		uint64_t key,
+		const MESH_RANGE* pRanges,
+		uint32_t rangeCount,
+		const std::vector<PACKED_VERTEX>& vertices,
+		const std::vector<uint32_t>& indices,
+		const std::vector<MESHLET>& meshlets);
+}
@@ -0,0 +1,1249 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.cpp
+// ================
+// loading of Wavefront OBJ and binary glTF 2.0 (.glb) model files
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include "WorkerThreads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// files smaller than this are parsed on one thread
+	const size_t g_MinimumParallelBytes = 1 << 20;
+
+	// marks a face corner without that attribute
+	const int32_t g_NoIndex = std::numeric_limits<int32_t>::min();
+	// marks the attribute indices of a face corner that are still
+	// relative to the start of their chunk
+	const unsigned char g_LocalPosition = 1;
+	const unsigned char g_LocalTexture = 2;
+	const unsigned char g_LocalNormal = 4;
+
+	// marks an unused slot of the vertex hash table
+	const uint32_t g_EmptySlot = 0xFFFFFFFF;
+
+	// binary glTF container constants
+	const uint32_t g_GlbMagic = 0x46546C67;
+	const uint32_t g_GlbVersion = 2;
+	const uint32_t g_GlbChunkJson = 0x4E4F534A;
+	const uint32_t g_GlbChunkBinary = 0x004E4942;
+	const int g_GltfTriangles = 4;
+
+	// exact powers of ten for the number parser
+	const double g_PowersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	/***********************************************************
+	 *  OBJ_CORNER
+	 *
+	 *  Zero based position, texture coordinate and normal index
+	 *  of one triangle corner of an OBJ face.
+	 ***********************************************************/
+	struct OBJ_CORNER
+	{
+		int32_t position;
+		int32_t textureCoordinate;
+		int32_t normal;
+		unsigned char localMask;
+	};
+
+	/***********************************************************
+	 *  OBJ_CHUNK
+	 *
+	 *  One range of lines of an OBJ file and everything parsed
+	 *  from it.
+	 ***********************************************************/
+	struct OBJ_CHUNK
+	{
+		const char* pBegin;
+		const char* pEnd;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> textureCoordinates;
+		std::vector<glm::vec3> normals;
+		std::vector<OBJ_CORNER> corners;
+		size_t skippedFaces;
+	};
+
+	/***********************************************************
+	 *  JSON_VALUE
+	 *
+	 *  One value of a parsed JSON document.  Object members are
+	 *  kept in order as parallel key and item lists.
+	 ***********************************************************/
+	struct JSON_VALUE
+	{
+		enum TYPE { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+		TYPE type;
+		double number;
+		std::string text;
+		std::vector<std::string> keys;
+		std::vector<JSON_VALUE> items;
+
+		JSON_VALUE() : type(JSON_NULL), number(0.0) {}
+
+		// member of an object, or NULL
+		const JSON_VALUE* Find(const char* key) const
+		{
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				if (keys[i] == key)
+				{
+					return(&items[i]);
+				}
+			}
+			return(NULL);
+		}
+		// item of an array, or NULL
+		const JSON_VALUE* At(size_t index) const
+		{
+			return(((type == JSON_ARRAY) && (index < items.size())) ? &items[index] : NULL);
+		}
+		// numeric member of an object, or the fallback
+		double Number(const char* key, double fallback) const
+		{
+			const JSON_VALUE* pValue = Find(key);
+			return(((NULL != pValue) && (pValue->type == JSON_NUMBER)) ? pValue->number : fallback);
+		}
+	};
+
+	/***********************************************************
+	 *  GLTF_ACCESSOR
+	 *
+	 *  Location and format of one glTF accessor's elements
+	 *  inside the binary chunk.
+	 ***********************************************************/
+	struct GLTF_ACCESSOR
+	{
+		const unsigned char* pData;
+		size_t count;
+		size_t stride;
+		int componentType;
+		int componentCount;
+		bool bNormalized;
+	};
+
+	// number of worker threads for an input of the passed in size
+	unsigned int ResolveThreadCount(unsigned int threadCount, size_t bytes)
+	{
+		return((bytes < g_MinimumParallelBytes) ? 1 : WorkerThreads::ResolveThreadCount(threadCount));
+	}
+
+	inline bool IsSpace(char c)
+	{
+		return((c == ' ') || (c == '\t') || (c == '\r'));
+	}
+
+	inline bool IsDigit(char c)
+	{
+		return((c >= '0') && (c <= '9'));
+	}
+
+	inline const char* SkipSpaces(const char* p, const char* pEnd)
+	{
+		while ((p < pEnd) && IsSpace(*p))
+		{
+			p++;
+		}
+		return(p);
+	}
+
+	/***********************************************************
+	 *  ParseNumber()
+	 *
+	 *  Parse a decimal number such as -1.5e-3 without the
+	 *  locale handling of strtod.  The digits are gathered into
+	 *  a double and scaled once by an exact power of ten, which
+	 *  is exact for the short numbers model files hold.
+	 ***********************************************************/
+	bool ParseNumber(const char*& p, const char* pEnd, double& value)
+	{
+		bool bNegative = false;
+		if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+
+		double mantissa = 0.0;
+		int exponent = 0;
+		bool bDigits = false;
+		while ((p < pEnd) && IsDigit(*p))
+		{
+			mantissa = (mantissa * 10.0) + (*p - '0');
+			bDigits = true;
+			p++;
+		}
+		if ((p < pEnd) && (*p == '.'))
+		{
+			p++;
+			while ((p < pEnd) && IsDigit(*p))
+			{
+				mantissa = (mantissa * 10.0) + (*p - '0');
+				exponent--;
+				bDigits = true;
+				p++;
+			}
+		}
+		if (bDigits == false)
+		{
+			return(false);
+		}
+
+		if ((p < pEnd) && ((*p == 'e') || (*p == 'E')))
+		{
+			p++;
+			bool bNegativeExponent = false;
+			if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+			{
+				bNegativeExponent = (*p == '-');
+				p++;
+			}
+			int written = 0;
+			while ((p < pEnd) && IsDigit(*p))
+			{
+				written = std::min((written * 10) + (*p - '0'), 1000);
+				p++;
+			}
+			exponent += bNegativeExponent ? -written : written;
+		}
+
+		if ((exponent >= 0) && (exponent <= 22))
+		{
+			value = mantissa * g_PowersOfTen[exponent];
+		}
+		else if ((exponent < 0) && (exponent >= -22))
+		{
+			value = mantissa / g_PowersOfTen[-exponent];
+		}
+		else
+		{
+			value = mantissa * std::pow(10.0, (double)exponent);
+		}
+		if (bNegative)
+		{
+			value = -value;
+		}
+		return(true);
+	}
+
+	// parse a float after any spaces, leaving it unchanged if there
+	// is none
+	inline void ParseFloat(const char*& p, const char* pEnd, float& value)
+	{
+		double number = 0.0;
+		p = SkipSpaces(p, pEnd);
+		if (ParseNumber(p, pEnd, number))
+		{
+			value = (float)number;
+		}
+	}
+
+	// parse a signed integer
+	inline bool ParseInt(const char*& p, const char* pEnd, int32_t& value)
+	{
+		bool bNegative = false;
+		if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+		if ((p >= pEnd) || !IsDigit(*p))
+		{
+			return(false);
+		}
+		int64_t result = 0;
+		while ((p < pEnd) && IsDigit(*p))
+		{
+			result = std::min((result * 10) + (*p - '0'), (int64_t)std::numeric_limits<int32_t>::max());
+			p++;
+		}
+		value = (int32_t)(bNegative ? -result : result);
+		return(true);
+	}
+
+	// convert an OBJ index to zero based.  Positive indices count from
+	// the start of the file; negative ones count back from the latest
+	// attribute, which a chunk only knows relative to its own start
+	inline int32_t ToObjIndex(int32_t value, size_t localCount, unsigned char localBit, unsigned char& localMask)
+	{
+		if (value > 0)
+		{
+			return(value - 1);
+		}
+		localMask |= localBit;
+		return((int32_t)localCount + value);
+	}
+
+	/***********************************************************
+	 *  ParseObjCorner()
+	 *
+	 *  Parse one v, v/t, v//n or v/t/n face corner.
+	 ***********************************************************/
+	bool ParseObjCorner(const char*& p, const char* pEnd, const OBJ_CHUNK& chunk, OBJ_CORNER& corner)
+	{
+		int32_t value = 0;
+		corner.position = g_NoIndex;
+		corner.textureCoordinate = g_NoIndex;
+		corner.normal = g_NoIndex;
+		corner.localMask = 0;
+
+		if ((ParseInt(p, pEnd, value) == false) || (value == 0))
+		{
+			return(false);
+		}
+		corner.position = ToObjIndex(value, chunk.positions.size(), g_LocalPosition, corner.localMask);
+
+		if ((p < pEnd) && (*p == '/'))
+		{
+			p++;
+			if ((p < pEnd) && (*p != '/'))
+			{
+				if ((ParseInt(p, pEnd, value) == false) || (value == 0))
+				{
+					return(false);
+				}
+				corner.textureCoordinate = ToObjIndex(value, chunk.textureCoordinates.size(), g_LocalTexture, corner.localMask);
+			}
+			if ((p < pEnd) && (*p == '/'))
+			{
+				p++;
+				if ((ParseInt(p, pEnd, value) == false) || (value == 0))
+				{
+					return(false);
+				}
+				corner.normal = ToObjIndex(value, chunk.normals.size(), g_LocalNormal, corner.localMask);
+			}
+		}
+
+		return((p >= pEnd) || IsSpace(*p));
+	}
+
+	/***********************************************************
+	 *  ParseObjChunk()
+	 *
+	 *  Parse the v, vt, vn and f lines of one chunk of an OBJ
+	 *  file, fanning each face into triangles.  Every other
+	 *  kind of line is skipped.
+	 ***********************************************************/
+	void ParseObjChunk(OBJ_CHUNK& chunk)
+	{
+		std::vector<OBJ_CORNER> polygon;
+		const char* p = chunk.pBegin;
+
+		while (p < chunk.pEnd)
+		{
+			const char* pLineEnd = (const char*)memchr(p, '\n', chunk.pEnd - p);
+			if (NULL == pLineEnd)
+			{
+				pLineEnd = chunk.pEnd;
+			}
+			p = SkipSpaces(p, pLineEnd);
+
+			if ((pLineEnd - p >= 2) && (p[0] == 'v') && IsSpace(p[1]))
+			{
+				glm::vec3 position(0.0f);
+				p += 2;
+				ParseFloat(p, pLineEnd, position.x);
+				ParseFloat(p, pLineEnd, position.y);
+				ParseFloat(p, pLineEnd, position.z);
+				chunk.positions.push_back(position);
+			}
+			else if ((pLineEnd - p >= 3) && (p[0] == 'v') && (p[1] == 't') && IsSpace(p[2]))
+			{
+				glm::vec2 textureCoordinate(0.0f);
+				p += 3;
+				ParseFloat(p, pLineEnd, textureCoordinate.x);
+				ParseFloat(p, pLineEnd, textureCoordinate.y);
+				chunk.textureCoordinates.push_back(textureCoordinate);
+			}
+			else if ((pLineEnd - p >= 3) && (p[0] == 'v') && (p[1] == 'n') && IsSpace(p[2]))
+			{
+				glm::vec3 normal(0.0f);
+				p += 3;
+				ParseFloat(p, pLineEnd, normal.x);
+				ParseFloat(p, pLineEnd, normal.y);
+				ParseFloat(p, pLineEnd, normal.z);
+				chunk.normals.push_back(normal);
+			}
+			else if ((pLineEnd - p >= 2) && (p[0] == 'f') && IsSpace(p[1]))
+			{
+				polygon.clear();
+				p += 2;
+				bool bValid = true;
+				while (bValid)
+				{
+					p = SkipSpaces(p, pLineEnd);
+					if (p >= pLineEnd)
+					{
+						break;
+					}
+					OBJ_CORNER corner;
+					bValid = ParseObjCorner(p, pLineEnd, chunk, corner);
+					polygon.push_back(corner);
+				}
+
+				if (!bValid || (polygon.size() < 3))
+				{
+					chunk.skippedFaces++;
+				}
+				else
+				{
+					for (size_t i = 2; i < polygon.size(); i++)
+					{
+						chunk.corners.push_back(polygon[0]);
+						chunk.corners.push_back(polygon[i - 1]);
+						chunk.corners.push_back(polygon[i]);
+					}
+				}
+			}
+
+			p = pLineEnd + 1;
+		}
+	}
+
+	// resolve a chunk relative attribute index and check its range
+	inline bool ResolveObjIndex(int32_t& index, unsigned char localMask, unsigned char localBit, size_t base, size_t count, bool bRequired)
+	{
+		if (index == g_NoIndex)
+		{
+			return(!bRequired);
+		}
+		int64_t absolute = index;
+		if ((localMask & localBit) != 0)
+		{
+			absolute += (int64_t)base;
+		}
+		if ((absolute < 0) || (absolute >= (int64_t)count))
+		{
+			return(false);
+		}
+		index = (int32_t)absolute;
+		return(true);
+	}
+
+	// hash of the bytes of a vertex for the deduplication table
+	inline uint32_t HashVertex(const MESH_VERTEX& vertex)
+	{
+		uint32_t words[sizeof(MESH_VERTEX) / sizeof(uint32_t)];
+		memcpy(words, &vertex, sizeof(words));
+
+		uint32_t hash = 2166136261u;
+		for (uint32_t word : words)
+		{
+			hash = (hash ^ word) * 16777619u;
+		}
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6Bu;
+		hash ^= hash >> 13;
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  FillMissingNormals()
+	 *
+	 *  Give every corner whose normal is zero the normalized
+	 *  sum of the area weighted normals of the triangles that
+	 *  share its position, so faces without normals are shaded
+	 *  smoothly across texture seams.
+	 ***********************************************************/
+	void FillMissingNormals(std::vector<MESH_VERTEX>& corners, const std::vector<uint32_t>& positionIds, size_t positionCount)
+	{
+		const glm::vec3 zero(0.0f);
+		std::vector<glm::vec3> sums;
+
+		for (size_t i = 0; i + 2 < corners.size(); i += 3)
+		{
+			if ((corners[i].normal != zero) && (corners[i + 1].normal != zero) && (corners[i + 2].normal != zero))
+			{
+				continue;
+			}
+			if (sums.empty())
+			{
+				sums.resize(positionCount, zero);
+			}
+			const glm::vec3 faceNormal = glm::cross(
+				corners[i + 1].position - corners[i].position,
+				corners[i + 2].position - corners[i].position);
+			for (size_t corner = i; corner < i + 3; corner++)
+			{
+				sums[positionIds[corner]] += faceNormal;
+			}
+		}
+
+		if (sums.empty())
+		{
+			return;
+		}
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			if (corners[i].normal == zero)
+			{
+				const float length = glm::length(sums[positionIds[i]]);
+				corners[i].normal = (length > 0.0f) ? (sums[positionIds[i]] / length) : glm::vec3(0.0f, 1.0f, 0.0f);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  BuildIndexedMesh()
+	 *
+	 *  Merge identical triangle corners into unique vertices
+	 *  through an open addressing hash table kept under half
+	 *  full, and index the triangles by them.
+	 ***********************************************************/
+	void BuildIndexedMesh(const std::vector<MESH_VERTEX>& corners, MESH_DATA& mesh)
+	{
+		size_t tableSize = 16;
+		while (tableSize < corners.size() * 2)
+		{
+			tableSize <<= 1;
+		}
+		const size_t tableMask = tableSize - 1;
+		std::vector<uint32_t> table(tableSize, g_EmptySlot);
+
+		mesh.vertices.clear();
+		mesh.indices.resize(corners.size());
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			size_t slot = HashVertex(corners[i]) & tableMask;
+			while (true)
+			{
+				const uint32_t vertex = table[slot];
+				if (vertex == g_EmptySlot)
+				{
+					table[slot] = (uint32_t)mesh.vertices.size();
+					mesh.indices[i] = table[slot];
+					mesh.vertices.push_back(corners[i]);
+					break;
+				}
+				if (memcmp(&mesh.vertices[vertex], &corners[i], sizeof(MESH_VERTEX)) == 0)
+				{
+					mesh.indices[i] = vertex;
+					break;
+				}
+				slot = (slot + 1) & tableMask;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  ParseJsonString()
+	 *
+	 *  Parse a quoted JSON string.  Escapes of characters
+	 *  outside ASCII are replaced, since glTF keys never use
+	 *  them.
+	 ***********************************************************/
+	bool ParseJsonString(const char*& p, const char* pEnd, std::string& text)
+	{
+		if ((p >= pEnd) || (*p != '"'))
+		{
+			return(false);
+		}
+		p++;
+		text.clear();
+		while ((p < pEnd) && (*p != '"'))
+		{
+			if (*p == '\\')
+			{
+				p++;
+				if (p >= pEnd)
+				{
+					return(false);
+				}
+				switch (*p)
+				{
+				case 'b': text.push_back('\b'); break;
+				case 'f': text.push_back('\f'); break;
+				case 'n': text.push_back('\n'); break;
+				case 'r': text.push_back('\r'); break;
+				case 't': text.push_back('\t'); break;
+				case 'u':
+					if (pEnd - p < 5)
+					{
+						return(false);
+					}
+					text.push_back('?');
+					p += 4;
+					break;
+				default: text.push_back(*p); break;
+				}
+				p++;
+			}
+			else
+			{
+				text.push_back(*p++);
+			}
+		}
+		if (p >= pEnd)
+		{
+			return(false);
+		}
+		p++;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseJsonValue()
+	 *
+	 *  Parse one JSON value and everything nested in it.
+	 ***********************************************************/
+	bool ParseJsonValue(const char*& p, const char* pEnd, JSON_VALUE& value, int depth)
+	{
+		const char* const whitespace = " \t\r\n";
+		while ((p < pEnd) && (strchr(whitespace, *p) != NULL) && (*p != '\0'))
+		{
+			p++;
+		}
+		if ((p >= pEnd) || (depth > 64))
+		{
+			return(false);
+		}
+
+		if ((*p == '{') || (*p == '['))
+		{
+			const bool bObject = (*p == '{');
+			const char close = bObject ? '}' : ']';
+			value.type = bObject ? JSON_VALUE::JSON_OBJECT : JSON_VALUE::JSON_ARRAY;
+			p++;
+			bool bFirst = true;
+			while (true)
+			{
+				while ((p < pEnd) && (strchr(whitespace, *p) != NULL) && (*p != '\0'))
+				{
+					p++;
+				}
+				if (p >= pEnd)
+				{
+					return(false);
+				}
+				if (*p == close)
+				{
+					p++;
+					return(true);
+				}
+				if (!bFirst)
+				{
+					if (*p != ',')
+					{
+						return(false);
+					}
+					p++;
+					while ((p < pEnd) && (strchr(whitespace, *p) != NULL) && (*p != '\0'))
+					{
+						p++;
+					}
+				}
+				bFirst = false;
+
+				if (bObject)
+				{
+					std::string key;
+					if (ParseJsonString(p, pEnd, key) == false)
+					{
+						return(false);
+					}
+					while ((p < pEnd) && (strchr(whitespace, *p) != NULL) && (*p != '\0'))
+					{
+						p++;
+					}
+					if ((p >= pEnd) || (*p != ':'))
+					{
+						return(false);
+					}
+					p++;
+					value.keys.push_back(key);
+				}
+				value.items.push_back(JSON_VALUE());
+				if (ParseJsonValue(p, pEnd, value.items.back(), depth + 1) == false)
+				{
+					return(false);
+				}
+			}
+		}
+		if (*p == '"')
+		{
+			value.type = JSON_VALUE::JSON_STRING;
+			return(ParseJsonString(p, pEnd, value.text));
+		}
+		if ((pEnd - p >= 4) && (strncmp(p, "true", 4) == 0))
+		{
+			value.type = JSON_VALUE::JSON_BOOL;
+			value.number = 1.0;
+			p += 4;
+			return(true);
+		}
+		if ((pEnd - p >= 5) && (strncmp(p, "false", 5) == 0))
+		{
+			value.type = JSON_VALUE::JSON_BOOL;
+			p += 5;
+			return(true);
+		}
+		if ((pEnd - p >= 4) && (strncmp(p, "null", 4) == 0))
+		{
+			p += 4;
+			return(true);
+		}
+		value.type = JSON_VALUE::JSON_NUMBER;
+		return(ParseNumber(p, pEnd, value.number));
+	}
+
+	// size in bytes of a glTF component type, or 0 if unknown
+	size_t GltfComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case 5120: case 5121: return(1);
+		case 5122: case 5123: return(2);
+		case 5125: case 5126: return(4);
+		}
+		return(0);
+	}
+
+	/***********************************************************
+	 *  GetGltfAccessor()
+	 *
+	 *  Find where the elements of an accessor lie in the binary
+	 *  chunk and check that all of them fit inside it.
+	 ***********************************************************/
+	bool GetGltfAccessor(
+		const JSON_VALUE& root,
+		const JSON_VALUE* pIndex,
+		const unsigned char* pBinary,
+		size_t binarySize,
+		GLTF_ACCESSOR& accessor)
+	{
+		const JSON_VALUE* pAccessors = root.Find("accessors");
+		const JSON_VALUE* pViews = root.Find("bufferViews");
+		if ((NULL == pIndex) || (pIndex->type != JSON_VALUE::JSON_NUMBER) || (NULL == pAccessors) || (NULL == pViews))
+		{
+			return(false);
+		}
+		const JSON_VALUE* pAccessor = pAccessors->At((size_t)pIndex->number);
+		if ((NULL == pAccessor) || (NULL == pAccessor->Find("bufferView")))
+		{
+			return(false);
+		}
+		const JSON_VALUE* pView = pViews->At((size_t)pAccessor->Number("bufferView", -1.0));
+		if ((NULL == pView) || (pView->Number("buffer", 0.0) != 0.0))
+		{
+			return(false);
+		}
+
+		const JSON_VALUE* pType = pAccessor->Find("type");
+		if (NULL == pType)
+		{
+			return(false);
+		}
+		const char* const typeNames[] = { "SCALAR", "VEC2", "VEC3", "VEC4" };
+		accessor.componentCount = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			if (pType->text == typeNames[i])
+			{
+				accessor.componentCount = i + 1;
+			}
+		}
+		accessor.componentType = (int)pAccessor->Number("componentType", 0.0);
+		accessor.bNormalized = (NULL != pAccessor->Find("normalized")) && (pAccessor->Find("normalized")->number != 0.0);
+		accessor.count = (size_t)pAccessor->Number("count", 0.0);
+		const size_t componentSize = GltfComponentSize(accessor.componentType);
+		const size_t elementSize = componentSize * accessor.componentCount;
+		if (elementSize == 0)
+		{
+			return(false);
+		}
+
+		const size_t viewOffset = (size_t)pView->Number("byteOffset", 0.0);
+		const size_t viewLength = (size_t)pView->Number("byteLength", 0.0);
+		const size_t accessorOffset = (size_t)pAccessor->Number("byteOffset", 0.0);
+		accessor.stride = (size_t)pView->Number("byteStride", (double)elementSize);
+		if ((viewOffset + viewLength > binarySize) || (accessor.stride < elementSize))
+		{
+			return(false);
+		}
+		if ((accessor.count > 0) &&
+			(accessorOffset + (accessor.stride * (accessor.count - 1)) + elementSize > viewLength))
+		{
+			return(false);
+		}
+
+		accessor.pData = pBinary + viewOffset + accessorOffset;
+		return(true);
+	}
+
+	// one component of one element of an accessor as a float
+	inline float ReadGltfFloat(const GLTF_ACCESSOR& accessor, size_t element, int component)
+	{
+		const unsigned char* pValue = accessor.pData + (element * accessor.stride) +
+			(component * GltfComponentSize(accessor.componentType));
+		switch (accessor.componentType)
+		{
+		case 5126:
+		{
+			float value;
+			memcpy(&value, pValue, sizeof(value));
+			return(value);
+		}
+		case 5121:
+			return(accessor.bNormalized ? (pValue[0] / 255.0f) : (float)pValue[0]);
+		case 5120:
+			return(accessor.bNormalized ? std::max((signed char)pValue[0] / 127.0f, -1.0f) : (float)(signed char)pValue[0]);
+		case 5123:
+		{
+			uint16_t value;
+			memcpy(&value, pValue, sizeof(value));
+			return(accessor.bNormalized ? (value / 65535.0f) : (float)value);
+		}
+		case 5122:
+		{
+			int16_t value;
+			memcpy(&value, pValue, sizeof(value));
+			return(accessor.bNormalized ? std::max(value / 32767.0f, -1.0f) : (float)value);
+		}
+		}
+		return(0.0f);
+	}
+
+	// one element of an index accessor
+	inline uint32_t ReadGltfIndex(const GLTF_ACCESSOR& accessor, size_t element)
+	{
+		const unsigned char* pValue = accessor.pData + (element * accessor.stride);
+		switch (accessor.componentType)
+		{
+		case 5121:
+			return(pValue[0]);
+		case 5123:
+		{
+			uint16_t value;
+			memcpy(&value, pValue, sizeof(value));
+			return(value);
+		}
+		case 5125:
+		{
+			uint32_t value;
+			memcpy(&value, pValue, sizeof(value));
+			return(value);
+		}
+		}
+		return(g_EmptySlot);
+	}
+
+	// seconds since the passed in time
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+
+	// whether a file name ends with the passed in extension, in any case
+	bool HasExtension(const char* filename, const char* extension)
+	{
+		const size_t nameLength = strlen(filename);
+		const size_t extensionLength = strlen(extension);
+		if (nameLength < extensionLength)
+		{
+			return(false);
+		}
+		for (size_t i = 0; i < extensionLength; i++)
+		{
+			if (tolower((unsigned char)filename[nameLength - extensionLength + i]) != extension[i])
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	// import with the importer that matches the file extension
+	bool ImportByExtension(const char* filename, MESH_DATA& mesh, unsigned int threadCount, MESH_IMPORT_STATS& stats)
+	{
+		if (HasExtension(filename, ".obj"))
+		{
+			return(MeshImporter::ImportObj(filename, mesh, threadCount, &stats));
+		}
+		if (HasExtension(filename, ".glb"))
+		{
+			return(MeshImporter::ImportGlb(filename, mesh, threadCount, &stats));
+		}
+		std::cout << "Unsupported model file type " << filename << " - expected .obj or .glb" << std::endl;
+		return(false);
+	}
+}
+
+/***********************************************************
+ *  ImportMesh()
+ *
+ *  This method is used for loading a model file with the
+ *  importer that matches its extension and reporting the
+ *  import throughput.
+ ***********************************************************/
+bool MeshImporter::ImportMesh(const char* filename, MESH_DATA& mesh, unsigned int threadCount, MESH_IMPORT_STATS* pStats)
+{
+	MESH_IMPORT_STATS stats;
+	const bool bImported = ImportByExtension(filename, mesh, threadCount, stats);
+
+	if (bImported)
+	{
+		std::cout << "INFO: imported " << filename << ": " << stats.triangleCount << " triangles, "
+			<< stats.cornerCount << " corners merged into " << stats.vertexCount << " vertices, "
+			<< (stats.fileBytes / (1024.0 * 1024.0)) / stats.totalSeconds << " MB/s, "
+			<< stats.triangleCount / stats.totalSeconds << " triangles/s on "
+			<< stats.threadCount << " threads" << std::endl;
+		if (NULL != pStats)
+		{
+			*pStats = stats;
+		}
+	}
+
+	return(bImported);
+}
+
+/***********************************************************
+ *  ImportObj()
+ *
+ *  This method is used for loading a Wavefront OBJ file.
+ *  The mapped text is split at line breaks into one chunk
+ *  per thread and the chunks are parsed in parallel.  The
+ *  attribute counts of the chunks then give each chunk's
+ *  base index, which resolves the relative face indices,
+ *  and the corners are gathered in parallel and merged into
+ *  unique vertices.
+ ***********************************************************/
+bool MeshImporter::ImportObj(const char* filename, MESH_DATA& mesh, unsigned int threadCount, MESH_IMPORT_STATS* pStats)
+{
+	const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	MappedFile file;
+	if (file.Open(filename) == false)
+	{
+		std::cout << "Could not open model file " << filename << std::endl;
+		return(false);
+	}
+	const char* pText = (const char*)file.GetData();
+	const size_t size = file.GetSize();
+	threadCount = ResolveThreadCount(threadCount, size);
+
+	// split at line breaks
+	std::vector<OBJ_CHUNK> chunks(threadCount);
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		size_t begin = (size * i) / threadCount;
+		while ((begin > 0) && (begin < size) && (pText[begin - 1] != '\n'))
+		{
+			begin++;
+		}
+		chunks[i].pBegin = pText + begin;
+		chunks[i].skippedFaces = 0;
+		if (i > 0)
+		{
+			chunks[i - 1].pEnd = chunks[i].pBegin;
+		}
+	}
+	chunks[threadCount - 1].pEnd = pText + size;
+
+	WorkerThreads::ParallelFor(chunks.size(), threadCount, 1, [&chunks](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			ParseObjChunk(chunks[i]);
+		}
+	});
+	const double parseSeconds = SecondsSince(start);
+
+	// base index of each chunk's attributes and corners
+	std::vector<size_t> positionBase(chunks.size() + 1, 0);
+	std::vector<size_t> textureBase(chunks.size() + 1, 0);
+	std::vector<size_t> normalBase(chunks.size() + 1, 0);
+	std::vector<size_t> cornerBase(chunks.size() + 1, 0);
+	size_t skippedFaces = 0;
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		positionBase[i + 1] = positionBase[i] + chunks[i].positions.size();
+		textureBase[i + 1] = textureBase[i] + chunks[i].textureCoordinates.size();
+		normalBase[i + 1] = normalBase[i] + chunks[i].normals.size();
+		cornerBase[i + 1] = cornerBase[i] + chunks[i].corners.size();
+		skippedFaces += chunks[i].skippedFaces;
+	}
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> textureCoordinates;
+	std::vector<glm::vec3> normals;
+	positions.reserve(positionBase.back());
+	textureCoordinates.reserve(textureBase.back());
+	normals.reserve(normalBase.back());
+	for (const OBJ_CHUNK& chunk : chunks)
+	{
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		textureCoordinates.insert(textureCoordinates.end(), chunk.textureCoordinates.begin(), chunk.textureCoordinates.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+	}
+
+	// resolve and gather the corners of every chunk
+	std::vector<MESH_VERTEX> corners(cornerBase.back());
+	std::vector<uint32_t> positionIds(cornerBase.back());
+	std::atomic<bool> bValid(true);
+	WorkerThreads::ParallelFor(chunks.size(), threadCount, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const OBJ_CHUNK& chunk = chunks[i];
+			for (size_t c = 0; c < chunk.corners.size(); c++)
+			{
+				OBJ_CORNER corner = chunk.corners[c];
+				if (!ResolveObjIndex(corner.position, corner.localMask, g_LocalPosition, positionBase[i], positions.size(), true) ||
+					!ResolveObjIndex(corner.textureCoordinate, corner.localMask, g_LocalTexture, textureBase[i], textureCoordinates.size(), false) ||
+					!ResolveObjIndex(corner.normal, corner.localMask, g_LocalNormal, normalBase[i], normals.size(), false))
+				{
+					bValid = false;
+					return;
+				}
+
+				MESH_VERTEX& vertex = corners[cornerBase[i] + c];
+				vertex.position = positions[corner.position];
+				vertex.normal = (corner.normal != g_NoIndex) ? normals[corner.normal] : glm::vec3(0.0f);
+				vertex.textureCoordinate = (corner.textureCoordinate != g_NoIndex) ?
+					textureCoordinates[corner.textureCoordinate] : glm::vec2(0.0f);
+				positionIds[cornerBase[i] + c] = (uint32_t)corner.position;
+			}
+		}
+	});
+	if (bValid == false)
+	{
+		std::cout << "Model file " << filename << " has a face index out of range" << std::endl;
+		return(false);
+	}
+	if (skippedFaces > 0)
+	{
+		std::cout << "Skipped " << skippedFaces << " malformed faces in " << filename << std::endl;
+	}
+
+	FillMissingNormals(corners, positionIds, positions.size());
+	BuildIndexedMesh(corners, mesh);
+
+	if (NULL != pStats)
+	{
+		pStats->fileBytes = size;
+		pStats->triangleCount = mesh.indices.size() / 3;
+		pStats->cornerCount = corners.size();
+		pStats->vertexCount = mesh.vertices.size();
+		pStats->threadCount = threadCount;
+		pStats->parseSeconds = parseSeconds;
+		pStats->totalSeconds = SecondsSince(start);
+	}
+
+	return(!mesh.indices.empty());
+}
+
+/***********************************************************
+ *  ImportGlb()
+ *
+ *  This method is used for loading the triangle primitives
+ *  of every mesh in a binary glTF 2.0 file.  The JSON chunk
+ *  is parsed for the accessors, and the corners of each
+ *  primitive are read from the binary chunk in parallel
+ *  ranges and merged into unique vertices.
+ ***********************************************************/
+bool MeshImporter::ImportGlb(const char* filename, MESH_DATA& mesh, unsigned int threadCount, MESH_IMPORT_STATS* pStats)
+{
+	const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	MappedFile file;
+	if (file.Open(filename) == false)
+	{
+		std::cout << "Could not open model file " << filename << std::endl;
+		return(false);
+	}
+	const unsigned char* pData = file.GetData();
+	const size_t size = file.GetSize();
+	threadCount = ResolveThreadCount(threadCount, size);
+
+	// header, then the JSON chunk and an optional binary chunk
+	uint32_t header[3] = { 0, 0, 0 };
+	uint32_t chunkHeader[2] = { 0, 0 };
+	if (size >= sizeof(header) + sizeof(chunkHeader))
+	{
+		memcpy(header, pData, sizeof(header));
+		memcpy(chunkHeader, pData + sizeof(header), sizeof(chunkHeader));
+	}
+	const size_t jsonOffset = sizeof(header) + sizeof(chunkHeader);
+	if ((header[0] != g_GlbMagic) || (header[1] != g_GlbVersion) || (header[2] > size) ||
+		(chunkHeader[1] != g_GlbChunkJson) || (jsonOffset + chunkHeader[0] > header[2]))
+	{
+		std::cout << "Model file " << filename << " is not a binary glTF 2.0 file" << std::endl;
+		return(false);
+	}
+
+	const unsigned char* pBinary = NULL;
+	size_t binarySize = 0;
+	const size_t binaryChunkOffset = jsonOffset + chunkHeader[0];
+	if (binaryChunkOffset + sizeof(chunkHeader) <= header[2])
+	{
+		uint32_t binaryHeader[2];
+		memcpy(binaryHeader, pData + binaryChunkOffset, sizeof(binaryHeader));
+		if ((binaryHeader[1] == g_GlbChunkBinary) &&
+			(binaryChunkOffset + sizeof(binaryHeader) + binaryHeader[0] <= header[2]))
+		{
+			pBinary = pData + binaryChunkOffset + sizeof(binaryHeader);
+			binarySize = binaryHeader[0];
+		}
+	}
+
+	JSON_VALUE root;
+	const char* pJson = (const char*)(pData + jsonOffset);
+	if (ParseJsonValue(pJson, pJson + chunkHeader[0], root, 0) == false)
+	{
+		std::cout << "Model file " << filename << " has malformed JSON" << std::endl;
+		return(false);
+	}
+	const double parseSeconds = SecondsSince(start);
+
+	std::vector<MESH_VERTEX> corners;
+	std::vector<uint32_t> positionIds;
+	size_t positionCount = 0;
+	size_t skippedPrimitives = 0;
+	const JSON_VALUE* pMeshes = root.Find("meshes");
+	for (size_t m = 0; (NULL != pMeshes) && (m < pMeshes->items.size()); m++)
+	{
+		const JSON_VALUE* pPrimitives = pMeshes->items[m].Find("primitives");
+		for (size_t p = 0; (NULL != pPrimitives) && (p < pPrimitives->items.size()); p++)
+		{
+			const JSON_VALUE& primitive = pPrimitives->items[p];
+			const JSON_VALUE* pAttributes = primitive.Find("attributes");
+			GLTF_ACCESSOR positionAccessor;
+			GLTF_ACCESSOR normalAccessor;
+			GLTF_ACCESSOR textureAccessor;
+			GLTF_ACCESSOR indexAccessor;
+			if (((int)primitive.Number("mode", g_GltfTriangles) != g_GltfTriangles) || (NULL == pAttributes) ||
+				!GetGltfAccessor(root, pAttributes->Find("POSITION"), pBinary, binarySize, positionAccessor) ||
+				(positionAccessor.componentCount != 3))
+			{
+				skippedPrimitives++;
+				continue;
+			}
+			const bool bNormals = GetGltfAccessor(root, pAttributes->Find("NORMAL"), pBinary, binarySize, normalAccessor) &&
+				(normalAccessor.componentCount == 3) && (normalAccessor.count == positionAccessor.count);
+			const bool bTexture = GetGltfAccessor(root, pAttributes->Find("TEXCOORD_0"), pBinary, binarySize, textureAccessor) &&
+				(textureAccessor.componentCount == 2) && (textureAccessor.count == positionAccessor.count);
+			const bool bIndexed = (NULL != primitive.Find("indices"));
+			if (bIndexed &&
+				(!GetGltfAccessor(root, primitive.Find("indices"), pBinary, binarySize, indexAccessor) ||
+				(indexAccessor.componentCount != 1) || (indexAccessor.componentType == 5126)))
+			{
+				skippedPrimitives++;
+				continue;
+			}
+
+			const size_t cornerCount = (bIndexed ? indexAccessor.count : positionAccessor.count) / 3 * 3;
+			const size_t firstCorner = corners.size();
+			corners.resize(firstCorner + cornerCount);
+			positionIds.resize(firstCorner + cornerCount);
+
+			std::atomic<bool> bValid(true);
+			WorkerThreads::ParallelFor(cornerCount, threadCount, [&](size_t begin, size_t end)
+			{
+				for (size_t c = begin; c < end; c++)
+				{
+					const uint32_t index = bIndexed ? ReadGltfIndex(indexAccessor, c) : (uint32_t)c;
+					if (index >= positionAccessor.count)
+					{
+						bValid = false;
+						return;
+					}
+
+					MESH_VERTEX& vertex = corners[firstCorner + c];
+					for (int component = 0; component < 3; component++)
+					{
+						vertex.position[component] = ReadGltfFloat(positionAccessor, index, component);
+						vertex.normal[component] = bNormals ? ReadGltfFloat(normalAccessor, index, component) : 0.0f;
+					}
+					vertex.textureCoordinate = bTexture ?
+						glm::vec2(ReadGltfFloat(textureAccessor, index, 0), ReadGltfFloat(textureAccessor, index, 1)) :
+						glm::vec2(0.0f);
+					positionIds[firstCorner + c] = (uint32_t)(positionCount + index);
+				}
+			});
+			if (bValid == false)
+			{
+				std::cout << "Model file " << filename << " has a vertex index out of range" << std::endl;
+				return(false);
+			}
+			positionCount += positionAccessor.count;
+		}
+	}
+	if (skippedPrimitives > 0)
+	{
+		std::cout << "Skipped " << skippedPrimitives << " primitives of " << filename
+			<< " that are not readable triangle lists" << std::endl;
+	}
+
+	FillMissingNormals(corners, positionIds, positionCount);
+	BuildIndexedMesh(corners, mesh);
+
+	if (NULL != pStats)
+	{
+		pStats->fileBytes = size;
+		pStats->triangleCount = mesh.indices.size() / 3;
+		pStats->cornerCount = corners.size();
+		pStats->vertexCount = mesh.vertices.size();
+		pStats->threadCount = threadCount;
+		pStats->parseSeconds = parseSeconds;
+		pStats->totalSeconds = SecondsSince(start);
+	}
+
+	return(!mesh.indices.empty());
+}
+
+/***********************************************************
+ *  RunImportBenchmark()
+ *
+ *  This function is used to import a model file several
+ *  times on one thread and on every hardware thread, and
+ *  print the best throughput of each.
+ ***********************************************************/
+void RunImportBenchmark(const char* filename)
+{
+	const int REPEATS = 5;
+	const unsigned int threadCounts[2] = { 1, std::max(1u, std::thread::hardware_concurrency()) };
+
+	std::cout << "INFO: import benchmark of " << filename << std::endl;
+	for (unsigned int threadCount : threadCounts)
+	{
+		MESH_IMPORT_STATS best;
+		best.totalSeconds = 0.0;
+		for (int repeat = 0; repeat < REPEATS; repeat++)
+		{
+			MESH_DATA mesh;
+			MESH_IMPORT_STATS stats;
+			if (ImportByExtension(filename, mesh, threadCount, stats) == false)
+			{
+				return;
+			}
+			if ((best.totalSeconds == 0.0) || (stats.totalSeconds < best.totalSeconds))
+			{
+				best = stats;
+			}
+		}
+
+		const double megabytes = best.fileBytes / (1024.0 * 1024.0);
+		std::cout << "INFO: " << best.threadCount << " thread(s): " << megabytes / best.totalSeconds << " MB/s, "
+			<< best.triangleCount / best.totalSeconds << " triangles/s (parse "
+			<< best.parseSeconds * 1000.0 << " ms, total " << best.totalSeconds * 1000.0 << " ms)" << std::endl;
+	}
+}
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.h
+// ==============
+// loading of Wavefront OBJ and binary glTF 2.0 (.glb) model files
+//
+// The file is memory mapped and parsed in place.  An OBJ file is split at
+// line breaks into one chunk per hardware thread, and each chunk is parsed
+// on its own thread into local vertex attribute and face lists; relative
+// (negative) face indices are kept relative to their chunk until the chunk
+// sizes are known.  A .glb file has its JSON chunk read to find the
+// accessors of each triangle primitive, whose attributes are converted from
+// the binary chunk in parallel ranges.  Either way the triangle corners are
+// then merged into unique vertices through an open addressing hash table
+// and returned as the same MESH_DATA the shape generators produce, ready to
+// be optimized and packed into the shared buffers.
+//
+// glTF node transforms, materials and secondary texture coordinate sets are
+// not applied; each mesh is imported in its own object space.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+
+#include <cstddef>
+
+/***********************************************************
+ *  MESH_IMPORT_STATS
+ *
+ *  Size and timing of one import.
+ ***********************************************************/
+struct MESH_IMPORT_STATS
+{
+	size_t fileBytes;
+	size_t triangleCount;
+	size_t cornerCount;
+	size_t vertexCount;
+	unsigned int threadCount;
+	double parseSeconds;
+	double totalSeconds;
+};
+
+namespace MeshImporter
+{
+	// load an .obj or .glb file, chosen by its extension.  A thread
+	// count of 0 uses every hardware thread.
+	bool ImportMesh(const char* filename, MESH_DATA& mesh, unsigned int threadCount = 0, MESH_IMPORT_STATS* pStats = NULL);
+	bool ImportObj(const char* filename, MESH_DATA& mesh, unsigned int threadCount = 0, MESH_IMPORT_STATS* pStats = NULL);
+	bool ImportGlb(const char* filename, MESH_DATA& mesh, unsigned int threadCount = 0, MESH_IMPORT_STATS* pStats = NULL);
+}
+
+// import the passed in file with one thread and with every hardware
+// thread and print the throughput of each
+void RunImportBenchmark(const char* filename);
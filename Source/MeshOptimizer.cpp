@@ -0,0 +1,423 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.cpp
+// =================
+// index and vertex reordering for the post-transform vertex cache
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	const int g_NoVertex = -1;
+
+	// a cluster may cost this much more than the whole segment's
+	// cache efficiency before it is split off for overdraw sorting
+	const float g_ClusterAcmrTolerance = 1.05f;
+
+	/***********************************************************
+	 *  CLUSTER
+	 *
+	 *  A run of triangles in the cache-optimized order and the
+	 *  key used to sort it for overdraw.
+	 ***********************************************************/
+	struct CLUSTER
+	{
+		size_t firstTriangle;
+		size_t triangleCount;
+		float sortKey;
+	};
+
+	/***********************************************************
+	 *  FIFO_CACHE
+	 *
+	 *  Simulation of a first-in first-out post-transform cache
+	 *  using one timestamp per vertex.
+	 ***********************************************************/
+	struct FIFO_CACHE
+	{
+		std::vector<size_t> entryTimes;
+		size_t time;
+
+		FIFO_CACHE(size_t vertexCount)
+			: entryTimes(vertexCount, 0), time(MeshOptimizer::VERTEX_CACHE_SIZE + 1) {}
+
+		// start over with an empty cache
+		void Flush() { time += MeshOptimizer::VERTEX_CACHE_SIZE + 1; }
+
+		// look up one vertex and return true when it had to be transformed
+		bool Miss(uint32_t vertex)
+		{
+			if ((time - entryTimes[vertex]) > (size_t)MeshOptimizer::VERTEX_CACHE_SIZE)
+			{
+				entryTimes[vertex] = time;
+				time++;
+				return(true);
+			}
+			return(false);
+		}
+	};
+
+	/***********************************************************
+	 *  Tipsify()
+	 *
+	 *  Reorder the triangles of one segment by fanning around
+	 *  the vertex that will be reused soonest while it is still
+	 *  in the cache.  The position of every hard boundary, where
+	 *  no cached vertex had triangles left and the walk jumped
+	 *  elsewhere, is returned as a triangle offset.
+	 ***********************************************************/
+	void Tipsify(
+		const uint32_t* pIndices,
+		size_t triangleCount,
+		size_t vertexCount,
+		std::vector<uint32_t>& output,
+		std::vector<size_t>& hardBoundaries)
+	{
+		const int cacheSize = MeshOptimizer::VERTEX_CACHE_SIZE;
+
+		// triangles using each vertex, as offsets into one flat list
+		std::vector<int> liveCounts(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			liveCounts[pIndices[i]]++;
+		}
+		std::vector<size_t> adjacencyStarts(vertexCount + 1, 0);
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			adjacencyStarts[vertex + 1] = adjacencyStarts[vertex] + liveCounts[vertex];
+		}
+		std::vector<size_t> adjacency(adjacencyStarts[vertexCount]);
+		std::vector<size_t> fillCounts(adjacencyStarts.begin(), adjacencyStarts.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[fillCounts[pIndices[i]]++] = i / 3;
+		}
+
+		std::vector<int> cacheTimes(vertexCount, 0);
+		std::vector<unsigned char> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		int time = cacheSize + 1;
+		size_t cursor = 0;
+		int fanVertex = (triangleCount > 0) ? (int)pIndices[0] : g_NoVertex;
+		bool bHardBoundary = true;
+
+		while (fanVertex != g_NoVertex)
+		{
+			if (bHardBoundary)
+			{
+				hardBoundaries.push_back(output.size() / 3);
+			}
+
+			// emit every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (size_t a = adjacencyStarts[fanVertex]; a < adjacencyStarts[fanVertex + 1]; a++)
+			{
+				const size_t triangle = adjacency[a];
+				if (emitted[triangle] != 0)
+				{
+					continue;
+				}
+				for (int corner = 0; corner < 3; corner++)
+				{
+					const uint32_t vertex = pIndices[(triangle * 3) + corner];
+					output.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					liveCounts[vertex]--;
+					if ((time - cacheTimes[vertex]) > cacheSize)
+					{
+						cacheTimes[vertex] = time;
+						time++;
+					}
+				}
+				emitted[triangle] = 1;
+			}
+
+			// continue with the oldest candidate that will still be
+			// cached after its remaining triangles are emitted
+			int nextVertex = g_NoVertex;
+			int bestPriority = -1;
+			for (uint32_t vertex : candidates)
+			{
+				if (liveCounts[vertex] <= 0)
+				{
+					continue;
+				}
+				int priority = 0;
+				if ((time - cacheTimes[vertex] + (2 * liveCounts[vertex])) <= cacheSize)
+				{
+					priority = time - cacheTimes[vertex];
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					nextVertex = (int)vertex;
+				}
+			}
+
+			// otherwise back up to a recent vertex, then to any vertex
+			// that still has triangles left
+			bHardBoundary = false;
+			if (nextVertex == g_NoVertex)
+			{
+				bHardBoundary = true;
+				while ((deadEnds.empty() == false) && (nextVertex == g_NoVertex))
+				{
+					const uint32_t vertex = deadEnds.back();
+					deadEnds.pop_back();
+					if (liveCounts[vertex] > 0)
+					{
+						nextVertex = (int)vertex;
+					}
+				}
+				while ((nextVertex == g_NoVertex) && (cursor < vertexCount))
+				{
+					if (liveCounts[cursor] > 0)
+					{
+						nextVertex = (int)cursor;
+					}
+					cursor++;
+				}
+			}
+			fanVertex = nextVertex;
+		}
+	}
+
+	/***********************************************************
+	 *  BuildClusters()
+	 *
+	 *  Split the cache-optimized triangles of one segment into
+	 *  clusters.  Every hard boundary starts a cluster, and a
+	 *  cluster is also ended as soon as its own cache miss rate,
+	 *  starting from an empty cache, is within the tolerance of
+	 *  the whole segment's, so reordering the clusters later
+	 *  costs little cache efficiency.
+	 ***********************************************************/
+	std::vector<CLUSTER> BuildClusters(
+		const std::vector<uint32_t>& indices,
+		const std::vector<size_t>& hardBoundaries,
+		size_t vertexCount)
+	{
+		std::vector<CLUSTER> clusters;
+		const size_t triangleCount = indices.size() / 3;
+		const float targetAcmr =
+			MeshOptimizer::AnalyzeVertexCache(indices, vertexCount).acmr * g_ClusterAcmrTolerance;
+
+		FIFO_CACHE cache(vertexCount);
+		size_t nextHardBoundary = 0;
+		size_t misses = 0;
+		CLUSTER cluster = { 0, 0, 0.0f };
+
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			const bool bHardBoundary = (nextHardBoundary < hardBoundaries.size()) &&
+				(hardBoundaries[nextHardBoundary] == triangle);
+			if (bHardBoundary)
+			{
+				nextHardBoundary++;
+			}
+			if ((cluster.triangleCount > 0) &&
+				(bHardBoundary || ((float)misses <= (targetAcmr * (float)cluster.triangleCount))))
+			{
+				clusters.push_back(cluster);
+				cluster.firstTriangle = triangle;
+				cluster.triangleCount = 0;
+				misses = 0;
+				cache.Flush();
+			}
+
+			for (int corner = 0; corner < 3; corner++)
+			{
+				if (cache.Miss(indices[(triangle * 3) + corner]))
+				{
+					misses++;
+				}
+			}
+			cluster.triangleCount++;
+		}
+		if (cluster.triangleCount > 0)
+		{
+			clusters.push_back(cluster);
+		}
+
+		return(clusters);
+	}
+
+	/***********************************************************
+	 *  SortClustersForOverdraw()
+	 *
+	 *  Reorder the clusters of one segment so those whose
+	 *  average normal points away from the segment's center
+	 *  are drawn first.  On a convex shape they are the ones
+	 *  nearest the viewer whenever they are visible at all.
+	 ***********************************************************/
+	void SortClustersForOverdraw(
+		std::vector<uint32_t>& indices,
+		std::vector<CLUSTER>& clusters,
+		const std::vector<MESH_VERTEX>& vertices)
+	{
+		// area weighted center of each cluster and of the segment
+		std::vector<glm::vec3> clusterCenters(clusters.size());
+		std::vector<glm::vec3> clusterNormals(clusters.size());
+		glm::vec3 segmentCenter(0.0f);
+		float segmentArea = 0.0f;
+
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			glm::vec3 center(0.0f);
+			glm::vec3 normal(0.0f);
+			float area = 0.0f;
+			for (size_t t = 0; t < clusters[c].triangleCount; t++)
+			{
+				const size_t first = (clusters[c].firstTriangle + t) * 3;
+				const glm::vec3& a = vertices[indices[first]].position;
+				const glm::vec3& b = vertices[indices[first + 1]].position;
+				const glm::vec3& p = vertices[indices[first + 2]].position;
+				const glm::vec3 faceNormal = glm::cross(b - a, p - a);
+				const float faceArea = glm::length(faceNormal);
+
+				center += ((a + b + p) / 3.0f) * faceArea;
+				normal += faceNormal;
+				area += faceArea;
+			}
+			segmentCenter += center;
+			segmentArea += area;
+			clusterCenters[c] = (area > 0.0f) ? (center / area) : center;
+			clusterNormals[c] = normal;
+		}
+		if (segmentArea > 0.0f)
+		{
+			segmentCenter /= segmentArea;
+		}
+
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			const float normalLength = glm::length(clusterNormals[c]);
+			clusters[c].sortKey = 0.0f;
+			if (normalLength > 0.0f)
+			{
+				clusters[c].sortKey = glm::dot(clusterCenters[c] - segmentCenter, clusterNormals[c] / normalLength);
+			}
+		}
+
+		std::vector<CLUSTER> sorted(clusters);
+		std::stable_sort(sorted.begin(), sorted.end(),
+			[](const CLUSTER& left, const CLUSTER& right) { return(left.sortKey > right.sortKey); });
+
+		std::vector<uint32_t> reordered;
+		reordered.reserve(indices.size());
+		for (const CLUSTER& cluster : sorted)
+		{
+			reordered.insert(reordered.end(),
+				indices.begin() + (cluster.firstTriangle * 3),
+				indices.begin() + ((cluster.firstTriangle + cluster.triangleCount) * 3));
+		}
+		indices.swap(reordered);
+	}
+
+	/***********************************************************
+	 *  ReorderVertices()
+	 *
+	 *  Renumber the vertices in the order the triangles first
+	 *  use them.  Vertices that no triangle uses are dropped.
+	 ***********************************************************/
+	void ReorderVertices(MESH_DATA& mesh)
+	{
+		std::vector<int> remap(mesh.vertices.size(), g_NoVertex);
+		std::vector<MESH_VERTEX> vertices;
+		vertices.reserve(mesh.vertices.size());
+
+		for (uint32_t& index : mesh.indices)
+		{
+			if (remap[index] == g_NoVertex)
+			{
+				remap[index] = (int)vertices.size();
+				vertices.push_back(mesh.vertices[index]);
+			}
+			index = (uint32_t)remap[index];
+		}
+		mesh.vertices.swap(vertices);
+	}
+}
+
+/***********************************************************
+ *  AnalyzeVertexCache()
+ *
+ *  This method is used for counting the vertices a FIFO
+ *  post-transform cache would have to transform for the
+ *  passed in triangle list.
+ ***********************************************************/
+VERTEX_CACHE_STATS MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	VERTEX_CACHE_STATS stats = { 0.0f, 0.0f };
+	FIFO_CACHE cache(vertexCount);
+	std::vector<unsigned char> used(vertexCount, 0);
+	size_t misses = 0;
+	size_t usedCount = 0;
+
+	for (uint32_t index : indices)
+	{
+		if (cache.Miss(index))
+		{
+			misses++;
+		}
+		if (used[index] == 0)
+		{
+			used[index] = 1;
+			usedCount++;
+		}
+	}
+
+	if (indices.empty() == false)
+	{
+		stats.acmr = (float)misses / (float)(indices.size() / 3);
+		stats.atvr = (float)misses / (float)usedCount;
+	}
+
+	return(stats);
+}
+
+/***********************************************************
+ *  OptimizeMesh()
+ *
+ *  This method is used for reordering the triangles of each
+ *  segment for the vertex cache and for overdraw, and then
+ *  reordering the vertices for fetch locality.  A segment
+ *  that was already emitted in a cache friendly order, such
+ *  as a single triangle strip, keeps its original order.
+ ***********************************************************/
+void MeshOptimizer::OptimizeMesh(MESH_DATA& mesh, const std::vector<size_t>& segmentIndexCounts)
+{
+	std::vector<uint32_t> optimized;
+	optimized.reserve(mesh.indices.size());
+
+	size_t segmentStart = 0;
+	for (size_t indexCount : segmentIndexCounts)
+	{
+		std::vector<uint32_t> segment;
+		std::vector<size_t> hardBoundaries;
+		segment.reserve(indexCount);
+
+		Tipsify(&mesh.indices[segmentStart], indexCount / 3, mesh.vertices.size(), segment, hardBoundaries);
+		std::vector<CLUSTER> clusters = BuildClusters(segment, hardBoundaries, mesh.vertices.size());
+		SortClustersForOverdraw(segment, clusters, mesh.vertices);
+
+		const std::vector<uint32_t> original(
+			mesh.indices.begin() + segmentStart, mesh.indices.begin() + segmentStart + indexCount);
+		if (AnalyzeVertexCache(segment, mesh.vertices.size()).acmr >
+			AnalyzeVertexCache(original, mesh.vertices.size()).acmr)
+		{
+			segment = original;
+		}
+
+		optimized.insert(optimized.end(), segment.begin(), segment.end());
+		segmentStart += indexCount;
+	}
+
+	mesh.indices.swap(optimized);
+	ReorderVertices(mesh);
+}
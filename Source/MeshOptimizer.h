@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.h
+// ===============
+// index and vertex reordering for the post-transform vertex cache
+//
+// Triangles are reordered with Tipsify (Sander, Nehab and Barczak, 2007),
+// which walks the mesh fanning around recently used vertices so they are
+// still in the cache when reused.  The walk restarts at "hard boundaries"
+// where the cache no longer helps; the triangles between two boundaries form
+// a cluster, and the clusters are then sorted so the ones facing away from
+// the mesh center are drawn first, which lets early depth testing reject
+// more of the hidden fragments.  Finally the vertices are renumbered in
+// the order they are first used so vertex fetch walks memory forward.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  VERTEX_CACHE_STATS
+ *
+ *  Efficiency of an index order for a FIFO vertex cache.
+ *  ACMR is the average number of vertices transformed per
+ *  triangle (0.5 is the ideal for a large regular mesh, 3
+ *  is the worst case), ATVR is the number of vertices
+ *  transformed per unique vertex (1 is the ideal).
+ ***********************************************************/
+struct VERTEX_CACHE_STATS
+{
+	float acmr;
+	float atvr;
+};
+
+namespace MeshOptimizer
+{
+	// number of entries of the simulated post-transform cache
+	const int VERTEX_CACHE_SIZE = 16;
+
+	// simulate a FIFO vertex cache over the passed in triangle list
+	VERTEX_CACHE_STATS AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount);
+
+	// reorder the triangles and vertices of the passed in mesh.  The
+	// index list is made of consecutive segments with the passed in
+	// index counts, each of which is drawn on its own, so triangles are
+	// only reordered within their segment and the segments keep their
+	// order and size
+	void OptimizeMesh(MESH_DATA& mesh, const std::vector<size_t>& segmentIndexCounts);
+}
@@ -0,0 +1,425 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshlets.cpp
+// ============
+// small clusters of a mesh's triangles that are culled on their own
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Meshlets.h"
+#include "SimdMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// declaration of global variables
+namespace
+{
+	// marks a vertex not used by the meshlet being built
+	const uint32_t g_NotInMeshlet = 0xFFFFFFFF;
+
+	// weights of the terms that choose the next triangle of a meshlet -
+	// each new vertex, the distance of its facing from the meshlet's,
+	// and its distance from the meshlet's center relative to the size
+	// of the whole run
+	const float g_NewVertexWeight = 0.25f;
+	const float g_FacingWeight = 1.0f;
+	const float g_DistanceWeight = 25.0f;
+
+	/***********************************************************
+	 *  ComputeBounds()
+	 *
+	 *  Fill the bounding sphere and normal cone of a meshlet
+	 *  from its triangles.  The sphere is centered on the box
+	 *  around the vertices.  The cone axis is the average face
+	 *  normal, and its half angle reaches the face normal that
+	 *  is furthest from the axis.
+	 ***********************************************************/
+	void ComputeBounds(const std::vector<MESH_VERTEX>& vertices, const uint32_t* pIndices, MESHLET& meshlet)
+	{
+		glm::vec3 minimum(vertices[pIndices[0]].position);
+		glm::vec3 maximum(minimum);
+		for (uint32_t i = 0; i < meshlet.indexCount; i++)
+		{
+			const glm::vec3& position = vertices[pIndices[i]].position;
+			minimum = glm::min(minimum, position);
+			maximum = glm::max(maximum, position);
+		}
+
+		meshlet.center = (minimum + maximum) * 0.5f;
+		meshlet.radius = 0.0f;
+		glm::vec3 normalSum(0.0f);
+		std::vector<glm::vec3> faceNormals;
+		faceNormals.reserve(meshlet.indexCount / 3);
+		for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+		{
+			const glm::vec3& a = vertices[pIndices[i]].position;
+			const glm::vec3& b = vertices[pIndices[i + 1]].position;
+			const glm::vec3& c = vertices[pIndices[i + 2]].position;
+			meshlet.radius = std::max(meshlet.radius, glm::length(a - meshlet.center));
+			meshlet.radius = std::max(meshlet.radius, glm::length(b - meshlet.center));
+			meshlet.radius = std::max(meshlet.radius, glm::length(c - meshlet.center));
+
+			// degenerate triangles cannot be seen and do not widen the cone
+			const glm::vec3 normal = glm::cross(b - a, c - a);
+			const float length = glm::length(normal);
+			if (length > 1.0e-12f)
+			{
+				faceNormals.push_back(normal / length);
+				normalSum += normal / length;
+			}
+		}
+
+		// no cone by default
+		meshlet.coneAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+		meshlet.coneSin = 1.0f;
+
+		const float sumLength = glm::length(normalSum);
+		if (sumLength < 1.0e-6f)
+		{
+			return;
+		}
+		const glm::vec3 axis = normalSum / sumLength;
+		float minimumCos = 1.0f;
+		for (const glm::vec3& normal : faceNormals)
+		{
+			minimumCos = std::min(minimumCos, glm::dot(axis, normal));
+		}
+		if (minimumCos > 0.0f)
+		{
+			meshlet.coneAxis = axis;
+			meshlet.coneSin = std::sqrt(1.0f - (minimumCos * minimumCos));
+		}
+	}
+
+	/***********************************************************
+	 *  IsVisible()
+	 *
+	 *  Test one meshlet against the frustum planes, and against
+	 *  its normal cone when back faces are culled.  Every view
+	 *  direction from the camera into the bounding sphere lies
+	 *  within an angle of the cone axis; when that angle plus
+	 *  the cone's half angle stays under 90 degrees, every
+	 *  triangle faces away from every point it could be seen
+	 *  from.
+	 ***********************************************************/
+	bool IsVisible(const MESHLET& meshlet, const MESHLET_CULL_VIEW& view)
+	{
+		for (int plane = 0; plane < 6; plane++)
+		{
+			const glm::vec4& p = view.planes[plane];
+			if (glm::dot(glm::vec3(p), meshlet.center) + p.w < -meshlet.radius)
+			{
+				return(false);
+			}
+		}
+
+		if (view.bCullBackFacing)
+		{
+			const glm::vec3 toCenter = meshlet.center - view.cameraPosition;
+			const float limit = (meshlet.coneSin * glm::length(toCenter)) + (meshlet.radius * (1.0f + meshlet.coneSin));
+			if (glm::dot(meshlet.coneAxis, toCenter) > limit)
+			{
+				return(false);
+			}
+		}
+
+		return(true);
+	}
+
+#ifdef SIMD_MATH_SSE2
+	/***********************************************************
+	 *  CullSSE()
+	 *
+	 *  Run the same tests as IsVisible() on four meshlets and
+	 *  return a mask with a bit set for each visible one.
+	 ***********************************************************/
+	inline int CullSSE(const MESHLET* pMeshlets, const MESHLET_CULL_VIEW& view)
+	{
+		__m128 centerX = _mm_loadu_ps(&pMeshlets[0].center.x);
+		__m128 centerY = _mm_loadu_ps(&pMeshlets[1].center.x);
+		__m128 centerZ = _mm_loadu_ps(&pMeshlets[2].center.x);
+		__m128 radius = _mm_loadu_ps(&pMeshlets[3].center.x);
+		_MM_TRANSPOSE4_PS(centerX, centerY, centerZ, radius);
+
+		const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+		__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int plane = 0; plane < 6; plane++)
+		{
+			const glm::vec4& p = view.planes[plane];
+			__m128 distance = _mm_mul_ps(centerX, _mm_set1_ps(p.x));
+			distance = _mm_add_ps(distance, _mm_mul_ps(centerY, _mm_set1_ps(p.y)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(centerZ, _mm_set1_ps(p.z)));
+			distance = _mm_add_ps(distance, _mm_set1_ps(p.w));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		if (view.bCullBackFacing)
+		{
+			__m128 axisX = _mm_loadu_ps(&pMeshlets[0].coneAxis.x);
+			__m128 axisY = _mm_loadu_ps(&pMeshlets[1].coneAxis.x);
+			__m128 axisZ = _mm_loadu_ps(&pMeshlets[2].coneAxis.x);
+			__m128 coneSin = _mm_loadu_ps(&pMeshlets[3].coneAxis.x);
+			_MM_TRANSPOSE4_PS(axisX, axisY, axisZ, coneSin);
+
+			const __m128 toCenterX = _mm_sub_ps(centerX, _mm_set1_ps(view.cameraPosition.x));
+			const __m128 toCenterY = _mm_sub_ps(centerY, _mm_set1_ps(view.cameraPosition.y));
+			const __m128 toCenterZ = _mm_sub_ps(centerZ, _mm_set1_ps(view.cameraPosition.z));
+			const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(toCenterX, toCenterX),
+				_mm_mul_ps(toCenterY, toCenterY)),
+				_mm_mul_ps(toCenterZ, toCenterZ)));
+			const __m128 along = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(axisX, toCenterX),
+				_mm_mul_ps(axisY, toCenterY)),
+				_mm_mul_ps(axisZ, toCenterZ));
+			const __m128 limit = _mm_add_ps(_mm_mul_ps(coneSin, distance),
+				_mm_mul_ps(radius, _mm_add_ps(_mm_set1_ps(1.0f), coneSin)));
+			visible = _mm_andnot_ps(_mm_cmpgt_ps(along, limit), visible);
+		}
+
+		return(_mm_movemask_ps(visible));
+	}
+#endif
+}
+
+/***********************************************************
+ *  BuildMeshlets()
+ *
+ *  This method is used for splitting a run of an index list
+ *  into meshlets.  Each meshlet is seeded with the earliest
+ *  triangle not yet used and grown one neighbouring triangle
+ *  at a time, preferring triangles that are near its center,
+ *  face close to its average normal and add few vertices,
+ *  which keeps the bounding spheres small and the normal
+ *  cones narrow.  The triangles of the run
+ *  are rewritten in meshlet order, so each meshlet is a
+ *  contiguous range of indices.  Seeds are taken in the
+ *  existing order of the run.
+ ***********************************************************/
+void Meshlets::BuildMeshlets(
+	MESH_DATA& mesh,
+	size_t firstIndex,
+	size_t indexCount,
+	uint32_t indexOffset,
+	std::vector<MESHLET>& meshlets)
+{
+	const size_t triangleCount = indexCount / 3;
+	const uint32_t* pIndices = &mesh.indices[firstIndex];
+
+	// face normal and centroid of each triangle, and the size of
+	// the box around the run
+	std::vector<glm::vec3> faceNormals(triangleCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> centroids(triangleCount);
+	glm::vec3 minimum(std::numeric_limits<float>::max());
+	glm::vec3 maximum(-std::numeric_limits<float>::max());
+	for (size_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		const glm::vec3& a = mesh.vertices[pIndices[triangle * 3]].position;
+		const glm::vec3& b = mesh.vertices[pIndices[(triangle * 3) + 1]].position;
+		const glm::vec3& c = mesh.vertices[pIndices[(triangle * 3) + 2]].position;
+		centroids[triangle] = (a + b + c) / 3.0f;
+		minimum = glm::min(minimum, glm::min(a, glm::min(b, c)));
+		maximum = glm::max(maximum, glm::max(a, glm::max(b, c)));
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		const float length = glm::length(normal);
+		if (length > 1.0e-12f)
+		{
+			faceNormals[triangle] = normal / length;
+		}
+	}
+	const float runSize = glm::length(maximum - minimum);
+	const float distanceScale = (runSize > 0.0f) ? (g_DistanceWeight / runSize) : 0.0f;
+
+	// triangles using each vertex, stored as one list per vertex
+	std::vector<uint32_t> adjacencyStart(mesh.vertices.size() + 1, 0);
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		adjacencyStart[pIndices[i] + 1]++;
+	}
+	for (size_t vertex = 0; vertex < mesh.vertices.size(); vertex++)
+	{
+		adjacencyStart[vertex + 1] += adjacencyStart[vertex];
+	}
+	std::vector<uint32_t> adjacency(indexCount);
+	std::vector<uint32_t> adjacencyFill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		adjacency[adjacencyFill[pIndices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	std::vector<bool> bEmitted(triangleCount, false);
+	std::vector<uint32_t> vertexMeshlet(mesh.vertices.size(), g_NotInMeshlet);
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint32_t> ordered;
+	ordered.reserve(indexCount);
+	size_t seed = 0;
+	uint32_t meshletNumber = 0;
+
+	while (ordered.size() < indexCount)
+	{
+		while (bEmitted[seed])
+		{
+			seed++;
+		}
+
+		const size_t meshletStart = ordered.size();
+		meshletVertices.clear();
+		glm::vec3 normalSum(0.0f);
+		glm::vec3 centroidSum(0.0f);
+		size_t candidate = seed;
+
+		while (true)
+		{
+			// add the chosen triangle
+			bEmitted[candidate] = true;
+			normalSum += faceNormals[candidate];
+			centroidSum += centroids[candidate];
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t vertex = pIndices[(candidate * 3) + corner];
+				ordered.push_back(vertex);
+				if (vertexMeshlet[vertex] != meshletNumber)
+				{
+					vertexMeshlet[vertex] = meshletNumber;
+					meshletVertices.push_back(vertex);
+				}
+			}
+			if ((ordered.size() - meshletStart) / 3 == MAX_TRIANGLES)
+			{
+				break;
+			}
+
+			// choose the best unused triangle touching the meshlet
+			const float sumLength = glm::length(normalSum);
+			const glm::vec3 axis = (sumLength > 0.0f) ? (normalSum / sumLength) : glm::vec3(0.0f);
+			const glm::vec3 center = centroidSum / (float)((ordered.size() - meshletStart) / 3);
+			float bestScore = 0.0f;
+			size_t best = triangleCount;
+			for (uint32_t vertex : meshletVertices)
+			{
+				for (uint32_t a = adjacencyStart[vertex]; a < adjacencyStart[vertex + 1]; a++)
+				{
+					const uint32_t triangle = adjacency[a];
+					if (bEmitted[triangle])
+					{
+						continue;
+					}
+
+					size_t newVertices = 0;
+					for (size_t corner = 0; corner < 3; corner++)
+					{
+						if (vertexMeshlet[pIndices[(triangle * 3) + corner]] != meshletNumber)
+						{
+							newVertices++;
+						}
+					}
+					if (meshletVertices.size() + newVertices > MAX_VERTICES)
+					{
+						continue;
+					}
+
+					const float score = (g_NewVertexWeight * (float)newVertices) +
+						(g_FacingWeight * (1.0f - glm::dot(faceNormals[triangle], axis))) +
+						(distanceScale * glm::length(centroids[triangle] - center));
+					if ((best == triangleCount) || (score < bestScore))
+					{
+						best = triangle;
+						bestScore = score;
+					}
+				}
+			}
+			if (best == triangleCount)
+			{
+				break;
+			}
+			candidate = best;
+		}
+
+		MESHLET meshlet = {};
+		meshlet.firstIndex = indexOffset + (uint32_t)(firstIndex + meshletStart);
+		meshlet.indexCount = (uint32_t)(ordered.size() - meshletStart);
+		ComputeBounds(mesh.vertices, &ordered[meshletStart], meshlet);
+		meshlets.push_back(meshlet);
+		meshletNumber++;
+	}
+
+	std::copy(ordered.begin(), ordered.end(), mesh.indices.begin() + firstIndex);
+}
+
+/***********************************************************
+ *  MakeCullView()
+ *
+ *  This method is used for extracting the six frustum planes
+ *  from the rows of a model-view-projection matrix.  The
+ *  planes come out in the object space of the model matrix,
+ *  and normalizing them makes the plane distances object
+ *  space distances, so untransformed bounding spheres can be
+ *  tested against them directly.
+ ***********************************************************/
+MESHLET_CULL_VIEW Meshlets::MakeCullView(
+	const glm::mat4& modelViewProjection,
+	const glm::vec3& objectCameraPosition,
+	bool bCullBackFacing)
+{
+	const glm::mat4& m = modelViewProjection;
+	const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	MESHLET_CULL_VIEW view;
+	view.planes[0] = row3 + row0;
+	view.planes[1] = row3 - row0;
+	view.planes[2] = row3 + row1;
+	view.planes[3] = row3 - row1;
+	view.planes[4] = row3 + row2;
+	view.planes[5] = row3 - row2;
+	for (int plane = 0; plane < 6; plane++)
+	{
+		const float length = glm::length(glm::vec3(view.planes[plane]));
+		if (length > 0.0f)
+		{
+			view.planes[plane] /= length;
+		}
+	}
+	view.cameraPosition = objectCameraPosition;
+	view.bCullBackFacing = bCullBackFacing;
+
+	return(view);
+}
+
+/***********************************************************
+ *  CullMeshlets()
+ *
+ *  This method is used for testing meshlets against a cull
+ *  view, four at a time when SSE2 is available.
+ ***********************************************************/
+size_t Meshlets::CullMeshlets(
+	const MESHLET* pMeshlets,
+	size_t count,
+	const MESHLET_CULL_VIEW& view,
+	unsigned char* pVisible)
+{
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+#ifdef SIMD_MATH_SSE2
+	for (; i + 4 <= count; i += 4)
+	{
+		const int mask = CullSSE(&pMeshlets[i], view);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			pVisible[i + lane] = (unsigned char)((mask >> lane) & 1);
+			visibleCount += pVisible[i + lane];
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		pVisible[i] = IsVisible(pMeshlets[i], view) ? 1 : 0;
+		visibleCount += pVisible[i];
+	}
+
+	return(visibleCount);
+}
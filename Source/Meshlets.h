@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshlets.h
+// ==========
+// small clusters of a mesh's triangles that are culled on their own
+//
+// A meshlet is a run of at most 124 consecutive triangles of an index list
+// that together use no more than 64 vertices.  Meshlets are grown across
+// neighbouring triangles of similar facing, so each covers a compact patch
+// of the surface with a tight bounding sphere and a narrow cone around its
+// face normals.  Before a mesh is drawn, meshlets
+// outside the view frustum, and on closed meshes those facing entirely away
+// from the camera, are dropped; the rest are submitted as contiguous index
+// ranges of the shared index buffer.  Culling runs four meshlets at a time
+// with SSE2, in object space so no bounds have to be transformed.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  MESHLET
+ *
+ *  Bounds and index range of one meshlet.  The bounding
+ *  sphere and the normal cone are each stored as four
+ *  floats so four meshlets can be loaded and transposed
+ *  into SIMD registers.  A cone sine of 1 marks a meshlet
+ *  whose triangles face too many ways to be back-face
+ *  culled.
+ ***********************************************************/
+struct MESHLET
+{
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneAxis;
+	float coneSin;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t padding[2];
+};
+
+/***********************************************************
+ *  MESHLET_CULL_VIEW
+ *
+ *  The view frustum planes and camera position moved into
+ *  the object space of the mesh being drawn.
+ ***********************************************************/
+struct MESHLET_CULL_VIEW
+{
+	glm::vec4 planes[6];
+	glm::vec3 cameraPosition;
+	bool bCullBackFacing;
+};
+
+namespace Meshlets
+{
+	// limits of one meshlet
+	const size_t MAX_VERTICES = 64;
+	const size_t MAX_TRIANGLES = 124;
+
+	// split indexCount indices of the mesh, starting at firstIndex,
+	// into meshlets and append them, reordering the triangles of that
+	// run so each meshlet is contiguous - indexOffset is added to each
+	// meshlet's first index to place it in the shared index buffer
+	void BuildMeshlets(
+		MESH_DATA& mesh,
+		size_t firstIndex,
+		size_t indexCount,
+		uint32_t indexOffset,
+		std::vector<MESHLET>& meshlets);
+
+	// frustum planes of a model-view-projection matrix, and the
+	// camera position in the same object space.  Back-face culling
+	// is only correct for closed meshes, whose far side is always
+	// hidden behind their near side.
+	MESHLET_CULL_VIEW MakeCullView(
+		const glm::mat4& modelViewProjection,
+		const glm::vec3& objectCameraPosition,
+		bool bCullBackFacing);
+
+	// set one visibility flag per meshlet and return the number
+	// of visible meshlets
+	size_t CullMeshlets(
+		const MESHLET* pMeshlets,
+		size_t count,
+		const MESHLET_CULL_VIEW& view,
+		unsigned char* pVisible);
+}
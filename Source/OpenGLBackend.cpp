@@ -0,0 +1,272 @@
+///////////////////////////////////////////////////////////////////////////////
+// openglbackend.cpp
+// =================
+// renders the frames of the scene through the current OpenGL context
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OpenGLBackend.h"
+#include "HeadlessContext.h"
+
+#include <chrono>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* const COMPOSITE_SHADER_FILES[] =
+	{
+		"shaders/compositeVertexShader.glsl",
+		"shaders/compositeFragmentShader.glsl"
+	};
+
+	// the composite pass samples its targets on the units after
+	// the 16 the scene textures are bound to
+	const int COMPOSITE_TEXTURE_UNIT = 16;
+	const char* const COMPOSITE_SAMPLER_NAMES[] = { "opaqueColor", "accumulation", "revealage" };
+}
+
+/***********************************************************
+ *  OpenGLBackend()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OpenGLBackend::OpenGLBackend(SceneManager* pSceneManager, ViewManager* pViewManager)
+{
+	m_pSceneManager = pSceneManager;
+	m_pViewManager = pViewManager;
+	m_submitMilliseconds = 0.0;
+	m_bPassTimings = false;
+	m_sceneColor = -1;
+	m_accumulation = -1;
+	m_revealage = -1;
+	m_pCompositeShader = NULL;
+
+	m_backbuffer = m_renderGraph.ImportTarget("backbuffer");
+	if (AddTransparencyPasses() == false)
+	{
+		// the scene is drawn straight into the presented framebuffer
+		const int scenePass = m_renderGraph.AddPass("scene", [this]() { DrawScene(SceneManager::RENDER_ALL); });
+		m_renderGraph.Write(scenePass, m_backbuffer);
+	}
+	m_renderGraph.Compile();
+}
+
+/***********************************************************
+ *  ~OpenGLBackend()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OpenGLBackend::~OpenGLBackend()
+{
+	if (NULL != m_pCompositeShader)
+	{
+		delete m_pCompositeShader;
+		m_pCompositeShader = NULL;
+	}
+}
+
+/***********************************************************
+ *  AddTransparencyPasses()
+ *
+ *  This method is used for adding the opaque, transparent
+ *  and composite passes to the render graph, when the scene
+ *  has the weighted states to draw its transparent surfaces
+ *  with and the composite shader builds.  The depth of the
+ *  opaque pass is written again by the transparent pass, so
+ *  it is attached there and tested against.
+ ***********************************************************/
+bool OpenGLBackend::AddTransparencyPasses()
+{
+	if (m_pSceneManager->HasTransparencyPass() == false)
+	{
+		std::cout << "Transparent surfaces are blended in drawing order" << std::endl;
+		return(false);
+	}
+
+	// the scene program is in use again once the samplers are set
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	m_pCompositeShader = new ShaderManager;
+	if (m_pCompositeShader->LoadShaders(COMPOSITE_SHADER_FILES[0], COMPOSITE_SHADER_FILES[1]) == 0)
+	{
+		std::cout << "The composite shader did not build - transparent surfaces are blended in drawing order" << std::endl;
+		delete m_pCompositeShader;
+		m_pCompositeShader = NULL;
+		glUseProgram((GLuint)program);
+		return(false);
+	}
+	m_pCompositeShader->use();
+	for (int i = 0; i < 3; i++)
+	{
+		m_pCompositeShader->setSampler2DValue(COMPOSITE_SAMPLER_NAMES[i], COMPOSITE_TEXTURE_UNIT + i);
+	}
+	glUseProgram((GLuint)program);
+
+	m_sceneColor = m_renderGraph.CreateTarget("scene color", GL_RGBA8);
+	const int sceneDepth = m_renderGraph.CreateTarget("scene depth", GL_DEPTH_COMPONENT24);
+	m_accumulation = m_renderGraph.CreateTarget("accumulation", GL_RGBA16F);
+	m_revealage = m_renderGraph.CreateTarget("revealage", GL_R8);
+
+	const int opaquePass = m_renderGraph.AddPass("opaque", [this]() { DrawScene(SceneManager::RENDER_OPAQUE); });
+	m_renderGraph.Write(opaquePass, m_sceneColor);
+	m_renderGraph.Write(opaquePass, sceneDepth);
+
+	// the accumulation and revealage are the first and second
+	// draw buffers the weighted blend mode blends
+	const int transparentPass = m_renderGraph.AddPass("transparent", [this]() { DrawTransparent(); });
+	m_renderGraph.Write(transparentPass, m_accumulation);
+	m_renderGraph.Write(transparentPass, m_revealage);
+	m_renderGraph.Write(transparentPass, sceneDepth);
+
+	const int compositePass = m_renderGraph.AddPass("composite", [this]() { CompositeTransparent(); });
+	m_renderGraph.Read(compositePass, m_sceneColor);
+	m_renderGraph.Read(compositePass, m_accumulation);
+	m_renderGraph.Read(compositePass, m_revealage);
+	m_renderGraph.Write(compositePass, m_backbuffer);
+
+	std::cout << "INFO: Transparent surfaces are drawn with weighted blended order independent transparency" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  SetPassTimings()
+ *
+ *  This method is used to turn the timing of each pass of
+ *  the frames on or off.
+ ***********************************************************/
+void OpenGLBackend::SetPassTimings(bool bPassTimings)
+{
+	m_bPassTimings = bPassTimings;
+	m_renderGraph.SetTimings(bPassTimings);
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This method is used to draw one frame of the 3D scene
+ *  into the bound framebuffer, running the passes of the
+ *  render graph.
+ ***********************************************************/
+void OpenGLBackend::RenderFrame()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// blending, depth and culling are set by the pipeline state
+	// of each draw
+	// convert from 3D object space to 2D view
+	m_pViewManager->PrepareSceneView();
+	m_pSceneManager->SetViewProjection(
+		m_pViewManager->GetViewMatrix(),
+		m_pViewManager->GetProjectionMatrix());
+
+	m_renderGraph.Execute(m_pViewManager->GetWidth(), m_pViewManager->GetHeight());
+
+	m_submitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  DrawScene()
+ *
+ *  This method is used to clear the bound framebuffer and
+ *  draw the 3D scene into it, as the scene pass, or only
+ *  its opaque surfaces, as the opaque pass.
+ ***********************************************************/
+void OpenGLBackend::DrawScene(SceneManager::RENDER_PASS pass)
+{
+	// Clear the frame and z buffers - the transparent pass of
+	// the last frame left depth writes off
+	glDepthMask(GL_TRUE);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// refresh the 3D scene
+	m_pSceneManager->RenderScene(pass);
+}
+
+/***********************************************************
+ *  DrawTransparent()
+ *
+ *  This method is used to clear the accumulation and the
+ *  revealage and draw the transparent surfaces into them,
+ *  as the transparent pass.  The depth of the opaque pass
+ *  is kept.
+ ***********************************************************/
+void OpenGLBackend::DrawTransparent()
+{
+	// the weighted colors add up from nothing, and the revealed
+	// part multiplies down from all of it
+	const GLfloat accumulationClear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat revealageClear[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glClearBufferfv(GL_COLOR, 0, accumulationClear);
+	glClearBufferfv(GL_COLOR, 1, revealageClear);
+
+	m_pSceneManager->RenderScene(SceneManager::RENDER_TRANSPARENT);
+}
+
+/***********************************************************
+ *  CompositeTransparent()
+ *
+ *  This method is used to draw one triangle over the bound
+ *  framebuffer that lays the transparent surfaces over the
+ *  opaque scene, as the composite pass.  The scene program
+ *  and the active texture unit are restored afterwards; the
+ *  next frame sets its whole pipeline state again.
+ ***********************************************************/
+void OpenGLBackend::CompositeTransparent()
+{
+	GLint program = 0;
+	GLint activeTexture = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+
+	const int targets[3] = { m_sceneColor, m_accumulation, m_revealage };
+	for (int i = 0; i < 3; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + COMPOSITE_TEXTURE_UNIT + i);
+		glBindTexture(GL_TEXTURE_2D, m_renderGraph.GetTexture(targets[i]));
+	}
+
+	m_pCompositeShader->use();
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glDisable(GL_CULL_FACE);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	glUseProgram((GLuint)program);
+	glActiveTexture((GLenum)activeTexture);
+}
+
+/***********************************************************
+ *  ReportPasses()
+ *
+ *  This method is used to print the passes of the render
+ *  graph and their average times, when they are timed.
+ ***********************************************************/
+void OpenGLBackend::ReportPasses() const
+{
+	if (m_bPassTimings == true)
+	{
+		m_renderGraph.Report();
+	}
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used to wait for the submitted frames.
+ ***********************************************************/
+void OpenGLBackend::Finish()
+{
+	glFinish();
+}
+
+/***********************************************************
+ *  WriteFrame()
+ *
+ *  This method is used to write the last frame of the
+ *  offscreen framebuffer to a file.
+ ***********************************************************/
+bool OpenGLBackend::WriteFrame(const char* filename)
+{
+	return(HeadlessContext::WriteFrame(filename));
+}
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// openglbackend.h
+// ===============
+// renders the frames of the scene through the current OpenGL context
+//
+// The passes of a frame run through a render graph, which binds the targets
+// each pass declares and times the passes when asked to.
+//
+// When the scene can draw its transparent surfaces on their own, the frame
+// takes three passes.  The opaque pass draws the opaque surfaces, with
+// blending off, into a color and depth target.  The transparent pass draws
+// the transparent surfaces against that depth, without writing it, into an
+// accumulation and a revealage target for weighted blended order
+// independent transparency, so they blend correctly in any order.  The
+// composite pass lays the average of the transparent surfaces over the
+// opaque color, in the framebuffer the frame is presented from.  Otherwise
+// the scene is drawn straight into that framebuffer in one pass.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderBackend.h"
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "RenderGraph.h"
+
+/***********************************************************
+ *  OpenGLBackend
+ *
+ *  This class contains the code for drawing a frame of the
+ *  3D scene with OpenGL into the bound framebuffer.
+ ***********************************************************/
+class OpenGLBackend : public IRenderBackend
+{
+public:
+	// constructor
+	OpenGLBackend(SceneManager* pSceneManager, ViewManager* pViewManager);
+	// destructor
+	~OpenGLBackend();
+
+	const char* GetName() const { return("OpenGL"); }
+	void RenderFrame();
+	void Finish();
+	bool WriteFrame(const char* filename);
+	double GetSubmitMilliseconds() const { return(m_submitMilliseconds); }
+	void ReportPasses() const;
+
+	// time each pass of the frames, to be reported at the end
+	void SetPassTimings(bool bPassTimings);
+
+private:
+	SceneManager* m_pSceneManager;
+	ViewManager* m_pViewManager;
+	double m_submitMilliseconds;
+	bool m_bPassTimings;
+	// the passes of a frame and the framebuffer it is presented from
+	RenderGraph m_renderGraph;
+	int m_backbuffer;
+	// targets of the transparency passes
+	int m_sceneColor;
+	int m_accumulation;
+	int m_revealage;
+	// shader program of the composite pass, when the transparent
+	// surfaces are drawn in a pass of their own
+	ShaderManager* m_pCompositeShader;
+
+	// clear the bound framebuffer and draw the scene into it
+	void DrawScene(SceneManager::RENDER_PASS pass);
+	// add the passes that draw the transparent surfaces on their
+	// own - returns false when they cannot be drawn that way
+	bool AddTransparencyPasses();
+	// clear the bound targets and draw the transparent surfaces
+	void DrawTransparent();
+	// lay the transparent surfaces over the opaque scene
+	void CompositeTransparent();
+};
@@ -0,0 +1,415 @@
+///////////////////////////////////////////////////////////////////////////////
+// parallelmeshes.cpp
+// ==================
+// multithreaded, vectorized generation of the curved grid shapes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ParallelMeshes.h"
+#include "SimdMath.h"
+#include "WorkerThreads.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	const float g_Pi = 3.14159265358979f;
+
+	// the kernels write vertices as runs of eight floats
+	static_assert(sizeof(MESH_VERTEX) == 8 * sizeof(float), "MESH_VERTEX must be eight packed floats");
+
+	/***********************************************************
+	 *  GRID_ROW
+	 *
+	 *  Coefficients of one row of a grid shape.  A vertex whose
+	 *  column angle has cosine c and sine s, at column fraction
+	 *  t, is
+	 *    normal   = cosAxis * c + sinAxis * s + normalOffset
+	 *    position = normal * radius + center
+	 *    uv       = uvScale * t + uvOffset
+	 ***********************************************************/
+	struct GRID_ROW
+	{
+		glm::vec3 cosAxis;
+		glm::vec3 sinAxis;
+		glm::vec3 normalOffset;
+		float radius;
+		glm::vec3 center;
+		glm::vec2 uvScale;
+		glm::vec2 uvOffset;
+	};
+
+	/***********************************************************
+	 *  GRID_COLUMNS
+	 *
+	 *  Fraction, cosine and sine of every column angle, padded
+	 *  to a whole number of eight wide steps.
+	 ***********************************************************/
+	struct GRID_COLUMNS
+	{
+		std::vector<float> fractions;
+		std::vector<float> cosines;
+		std::vector<float> sines;
+	};
+
+	/***********************************************************
+	 *  ComputeColumns()
+	 *
+	 *  Compute the fraction t = column / columns of each of the
+	 *  columns + 1 columns and the sine and cosine of its angle
+	 *  2 * PI * t.
+	 ***********************************************************/
+	void ComputeColumns(int columns, unsigned int threadCount, GRID_COLUMNS& table)
+	{
+		const size_t count = (size_t)columns + 1;
+		const size_t padded = (count + 7) & ~(size_t)7;
+		table.fractions.resize(padded);
+		table.cosines.resize(padded);
+		table.sines.resize(padded);
+
+		WorkerThreads::ParallelFor(padded / 8, threadCount, WorkerThreads::MIN_PARALLEL_ITEMS / 8,
+			[&table, columns](size_t begin, size_t end)
+		{
+			size_t i = begin * 8;
+#if defined(SIMD_MATH_AVX2)
+			const __m256 columnCount = _mm256_set1_ps((float)columns);
+			const __m256 steps = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+			for (; i < end * 8; i += 8)
+			{
+				const __m256 t = _mm256_div_ps(_mm256_add_ps(_mm256_set1_ps((float)i), steps), columnCount);
+				__m256 s;
+				__m256 c;
+				SimdMath::SinCos8(_mm256_mul_ps(_mm256_mul_ps(t, _mm256_set1_ps(2.0f)), _mm256_set1_ps(g_Pi)), &s, &c);
+				_mm256_storeu_ps(&table.fractions[i], t);
+				_mm256_storeu_ps(&table.cosines[i], c);
+				_mm256_storeu_ps(&table.sines[i], s);
+			}
+#elif defined(SIMD_MATH_SSE2)
+			const __m128 columnCount = _mm_set1_ps((float)columns);
+			const __m128 steps = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+			for (; i < end * 8; i += 4)
+			{
+				const __m128 t = _mm_div_ps(_mm_add_ps(_mm_set1_ps((float)i), steps), columnCount);
+				__m128 s;
+				__m128 c;
+				SimdMath::SinCos4(_mm_mul_ps(_mm_mul_ps(t, _mm_set1_ps(2.0f)), _mm_set1_ps(g_Pi)), &s, &c);
+				_mm_storeu_ps(&table.fractions[i], t);
+				_mm_storeu_ps(&table.cosines[i], c);
+				_mm_storeu_ps(&table.sines[i], s);
+			}
+#else
+			for (; i < end * 8; i++)
+			{
+				const float t = (float)i / (float)columns;
+				const float angle = t * 2.0f * g_Pi;
+				table.fractions[i] = t;
+				table.cosines[i] = std::cos(angle);
+				table.sines[i] = std::sin(angle);
+			}
+#endif
+		});
+	}
+
+	// write one vertex of a row
+	inline void EmitVertex(const GRID_ROW& row, float t, float c, float s, MESH_VERTEX& vertex)
+	{
+		vertex.normal = (row.cosAxis * c) + (row.sinAxis * s) + row.normalOffset;
+		vertex.position = (vertex.normal * row.radius) + row.center;
+		vertex.textureCoordinate = (row.uvScale * t) + row.uvOffset;
+	}
+
+	/***********************************************************
+	 *  EmitRow()
+	 *
+	 *  Write the vertices of columns begin to end of one row.
+	 *  Four vertices are evaluated per step as one register for
+	 *  each of their eight floats, and two 4x4 transposes turn
+	 *  those into the four interleaved vertices.
+	 ***********************************************************/
+	void EmitRow(const GRID_ROW& row, const GRID_COLUMNS& table, size_t begin, size_t end, MESH_VERTEX* pVertices)
+	{
+		size_t i = begin;
+#ifdef SIMD_MATH_SSE2
+		for (; i + 4 <= end; i += 4)
+		{
+			const __m128 t = _mm_loadu_ps(&table.fractions[i]);
+			const __m128 c = _mm_loadu_ps(&table.cosines[i]);
+			const __m128 s = _mm_loadu_ps(&table.sines[i]);
+
+			__m128 normal[3];
+			__m128 position[3];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				normal[axis] = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(_mm_set1_ps(row.cosAxis[axis]), c),
+					_mm_mul_ps(_mm_set1_ps(row.sinAxis[axis]), s)),
+					_mm_set1_ps(row.normalOffset[axis]));
+				position[axis] = _mm_add_ps(_mm_mul_ps(normal[axis], _mm_set1_ps(row.radius)), _mm_set1_ps(row.center[axis]));
+			}
+			const __m128 u = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row.uvScale.x), t), _mm_set1_ps(row.uvOffset.x));
+			const __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row.uvScale.y), t), _mm_set1_ps(row.uvOffset.y));
+
+			// the first half of each vertex, then the second half
+			__m128 a0 = position[0];
+			__m128 a1 = position[1];
+			__m128 a2 = position[2];
+			__m128 a3 = normal[0];
+			__m128 b0 = normal[1];
+			__m128 b1 = normal[2];
+			__m128 b2 = u;
+			__m128 b3 = v;
+			_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+			_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+			float* pOut = &pVertices[i].position.x;
+			_mm_storeu_ps(pOut, a0);
+			_mm_storeu_ps(pOut + 4, b0);
+			_mm_storeu_ps(pOut + 8, a1);
+			_mm_storeu_ps(pOut + 12, b1);
+			_mm_storeu_ps(pOut + 16, a2);
+			_mm_storeu_ps(pOut + 20, b2);
+			_mm_storeu_ps(pOut + 24, a3);
+			_mm_storeu_ps(pOut + 28, b3);
+		}
+#endif
+		for (; i < end; i++)
+		{
+			EmitVertex(row, table.fractions[i], table.cosines[i], table.sines[i], pVertices[i]);
+		}
+	}
+
+	/***********************************************************
+	 *  GenerateGrid()
+	 *
+	 *  Generate a grid shape with one vertex row per GRID_ROW
+	 *  and columns + 1 vertices in each row, the last column
+	 *  repeating the first so the texture wraps once around.
+	 *  The vertices and the grid cells are each split evenly
+	 *  across the threads regardless of the grid's shape, so a
+	 *  cylinder wall of two very long rows is split as well as
+	 *  a sphere of many short ones.  The cells are indexed the
+	 *  same way as PrimitiveMeshes builds them.
+	 ***********************************************************/
+	MESH_DATA GenerateGrid(const std::vector<GRID_ROW>& rows, int columns, unsigned int threadCount)
+	{
+		MESH_DATA mesh;
+		const size_t rowVertices = (size_t)columns + 1;
+		const size_t vertexCount = rows.size() * rowVertices;
+		const size_t cellCount = (rows.size() - 1) * (size_t)columns;
+
+		GRID_COLUMNS table;
+		ComputeColumns(columns, threadCount, table);
+		mesh.vertices.resize(vertexCount);
+		mesh.indices.resize(cellCount * 6);
+
+		MESH_VERTEX* pVertices = mesh.vertices.data();
+		WorkerThreads::ParallelFor(vertexCount, threadCount, [&](size_t begin, size_t end)
+		{
+			size_t row = begin / rowVertices;
+			size_t column = begin % rowVertices;
+			while (begin < end)
+			{
+				const size_t rowEnd = std::min(rowVertices, column + (end - begin));
+				EmitRow(rows[row], table, column, rowEnd, pVertices + (row * rowVertices));
+				begin += rowEnd - column;
+				row++;
+				column = 0;
+			}
+		});
+
+		uint32_t* pIndices = mesh.indices.data();
+		WorkerThreads::ParallelFor(cellCount, threadCount, [&](size_t begin, size_t end)
+		{
+			uint32_t row = (uint32_t)(begin / columns);
+			uint32_t column = (uint32_t)(begin % columns);
+			uint32_t* pCell = pIndices + (begin * 6);
+			for (size_t cell = begin; cell < end; cell++)
+			{
+				const uint32_t rowStart = row * (uint32_t)rowVertices;
+				const uint32_t nextRowStart = rowStart + (uint32_t)rowVertices;
+				pCell[0] = rowStart + column;
+				pCell[1] = nextRowStart + column;
+				pCell[2] = nextRowStart + column + 1;
+				pCell[3] = rowStart + column;
+				pCell[4] = nextRowStart + column + 1;
+				pCell[5] = rowStart + column + 1;
+				pCell += 6;
+				if (++column == (uint32_t)columns)
+				{
+					column = 0;
+					row++;
+				}
+			}
+		});
+
+		return(mesh);
+	}
+
+	// largest distance between matching vertex positions and normals
+	// of two meshes, or infinity if their topology differs
+	float CompareMeshes(const MESH_DATA& expected, const MESH_DATA& actual)
+	{
+		if ((expected.vertices.size() != actual.vertices.size()) || (expected.indices != actual.indices))
+		{
+			return(INFINITY);
+		}
+		float maxError = 0.0f;
+		for (size_t i = 0; i < expected.vertices.size(); i++)
+		{
+			maxError = std::max(maxError, glm::length(expected.vertices[i].position - actual.vertices[i].position));
+			maxError = std::max(maxError, glm::length(expected.vertices[i].normal - actual.vertices[i].normal));
+			maxError = std::max(maxError, glm::length(expected.vertices[i].textureCoordinate - actual.vertices[i].textureCoordinate));
+		}
+		return(maxError);
+	}
+}
+
+/***********************************************************
+ *  GenerateCylinderSides()
+ *
+ *  This method is used for generating the side wall of a
+ *  cylinder with radius 1 from y = 0 to y = 1, with the top
+ *  row first.
+ ***********************************************************/
+MESH_DATA ParallelMeshes::GenerateCylinderSides(int slices, unsigned int threadCount)
+{
+	std::vector<GRID_ROW> rows(2);
+	for (int row = 0; row <= 1; row++)
+	{
+		const float y = 1.0f - (float)row;
+		rows[row].cosAxis = glm::vec3(1.0f, 0.0f, 0.0f);
+		rows[row].sinAxis = glm::vec3(0.0f, 0.0f, -1.0f);
+		rows[row].normalOffset = glm::vec3(0.0f);
+		rows[row].radius = 1.0f;
+		rows[row].center = glm::vec3(0.0f, y, 0.0f);
+		rows[row].uvScale = glm::vec2(1.0f, 0.0f);
+		rows[row].uvOffset = glm::vec2(0.0f, y);
+	}
+
+	return(GenerateGrid(rows, slices, threadCount));
+}
+
+/***********************************************************
+ *  GenerateSphere()
+ *
+ *  This method is used for generating a sphere of radius 1,
+ *  or only its upper hemisphere when bHemisphere is set.
+ *  Stacks run from the north pole downward.
+ ***********************************************************/
+MESH_DATA ParallelMeshes::GenerateSphere(int slices, int stacks, bool bHemisphere, unsigned int threadCount)
+{
+	const int rowCount = bHemisphere ? (stacks / 2) : stacks;
+	std::vector<GRID_ROW> rows(rowCount + 1);
+	for (int stack = 0; stack <= rowCount; stack++)
+	{
+		const float v = (float)stack / (float)stacks;
+		const float polarAngle = v * g_Pi;
+		const float ringRadius = std::sin(polarAngle);
+		rows[stack].cosAxis = glm::vec3(ringRadius, 0.0f, 0.0f);
+		rows[stack].sinAxis = glm::vec3(0.0f, 0.0f, -ringRadius);
+		rows[stack].normalOffset = glm::vec3(0.0f, std::cos(polarAngle), 0.0f);
+		rows[stack].radius = 1.0f;
+		rows[stack].center = glm::vec3(0.0f);
+		rows[stack].uvScale = glm::vec2(1.0f, 0.0f);
+		rows[stack].uvOffset = glm::vec2(0.0f, 1.0f - v);
+	}
+
+	return(GenerateGrid(rows, slices, threadCount));
+}
+
+/***********************************************************
+ *  GenerateTorus()
+ *
+ *  This method is used for generating a torus with a main
+ *  radius of 1 around the Z axis, swept from +X through +Y
+ *  for the passed in number of degrees.  Each main segment
+ *  is a row and each tube segment a column.
+ ***********************************************************/
+MESH_DATA ParallelMeshes::GenerateTorus(int mainSegments, int tubeSegments, float sweepDegrees, unsigned int threadCount)
+{
+	const float sweep = glm::radians(sweepDegrees);
+	std::vector<GRID_ROW> rows(mainSegments + 1);
+	for (int segment = 0; segment <= mainSegments; segment++)
+	{
+		const float u = (float)segment / (float)mainSegments;
+		const float mainAngle = u * sweep;
+		const glm::vec3 ringDirection(std::cos(mainAngle), std::sin(mainAngle), 0.0f);
+		rows[segment].cosAxis = ringDirection;
+		rows[segment].sinAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		rows[segment].normalOffset = glm::vec3(0.0f);
+		rows[segment].radius = PrimitiveMeshes::TORUS_TUBE_RADIUS;
+		rows[segment].center = ringDirection;
+		rows[segment].uvScale = glm::vec2(0.0f, 1.0f);
+		rows[segment].uvOffset = glm::vec2(u, 0.0f);
+	}
+
+	return(GenerateGrid(rows, tubeSegments, threadCount));
+}
+
+/***********************************************************
+ *  RunGeneratorBenchmark()
+ *
+ *  This function is used to time the scalar generators, the
+ *  parallel generators on one thread and the parallel
+ *  generators on every hardware thread, each producing over
+ *  a million triangles, and to report the largest
+ *  difference between the scalar and parallel results.
+ ***********************************************************/
+void RunGeneratorBenchmark()
+{
+	const unsigned int threadCount = WorkerThreads::ResolveThreadCount(0);
+	const char* const shapeNames[3] = { "sphere 1024x512", "torus 1024x512", "cylinder sides 524288" };
+
+#if defined(SIMD_MATH_AVX2)
+	std::cout << "INFO: Generator benchmark using AVX2 sine/cosine and SSE2 vertex emission\n";
+#elif defined(SIMD_MATH_SSE2)
+	std::cout << "INFO: Generator benchmark using SSE2 sine/cosine and vertex emission\n";
+#else
+	std::cout << "INFO: Generator benchmark using the scalar kernels\n";
+#endif
+
+	for (int shape = 0; shape < 3; shape++)
+	{
+		// generate one shape with the scalar or parallel generator
+		auto generate = [shape](bool bParallel, unsigned int threads)
+		{
+			switch (shape)
+			{
+			case 0:
+				return(bParallel ? ParallelMeshes::GenerateSphere(1024, 512, false, threads) :
+					PrimitiveMeshes::GenerateSphere(1024, 512, false));
+			case 1:
+				return(bParallel ? ParallelMeshes::GenerateTorus(1024, 512, 360.0f, threads) :
+					PrimitiveMeshes::GenerateTorus(1024, 512, 360.0f));
+			default:
+				return(bParallel ? ParallelMeshes::GenerateCylinderSides(524288, threads) :
+					PrimitiveMeshes::GenerateCylinderSides(524288));
+			}
+		};
+
+		double bestMilliseconds[3] = { 1e30, 1e30, 1e30 };
+		MESH_DATA results[3];
+		for (int trial = 0; trial < 3; trial++)
+		{
+			for (int mode = 0; mode < 3; mode++)
+			{
+				const auto start = std::chrono::high_resolution_clock::now();
+				results[mode] = generate(mode != 0, (mode == 1) ? 1 : threadCount);
+				const auto end = std::chrono::high_resolution_clock::now();
+				bestMilliseconds[mode] = std::min(bestMilliseconds[mode],
+					std::chrono::duration<double, std::milli>(end - start).count());
+			}
+		}
+
+		std::cout << "INFO: " << shapeNames[shape] << ", " << results[0].indices.size() / 3 << " triangles: scalar "
+			<< bestMilliseconds[0] << " ms, parallel on 1 thread " << bestMilliseconds[1] << " ms, on "
+			<< threadCount << " threads " << bestMilliseconds[2] << " ms, speedup "
+			<< bestMilliseconds[0] / bestMilliseconds[2] << "x, max abs difference "
+			<< std::max(CompareMeshes(results[0], results[1]), CompareMeshes(results[0], results[2])) << std::endl;
+	}
+}
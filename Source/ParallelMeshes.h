@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////////////
+// parallelmeshes.h
+// ================
+// multithreaded, vectorized generation of the curved grid shapes
+//
+// The sphere, the torus and the cylinder side wall are all grids of rows and
+// columns in which each vertex is a fixed linear function of the sine and
+// cosine of its column angle.  The column sines and cosines are computed
+// once, eight or four at a time with the SimdMath polynomial, and each row
+// only stores the coefficients of its linear function.  Vertices and indices
+// are then written in even slices across the worker threads, four vertices
+// per step with the interleaved layout produced by a register transpose.
+//
+// The results match PrimitiveMeshes vertex for vertex and index for index,
+// to within the accuracy of the sine/cosine approximation, so the two can be
+// used interchangeably.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+
+namespace ParallelMeshes
+{
+	// the side wall of a cylinder
+	MESH_DATA GenerateCylinderSides(int slices, unsigned int threadCount = 0);
+	// sphere, or its upper hemisphere when bHemisphere is set
+	MESH_DATA GenerateSphere(int slices, int stacks, bool bHemisphere, unsigned int threadCount = 0);
+	// torus swept around the Z axis from +X through +Y, for
+	// sweepDegrees (360 for a full ring, 180 for the upper half)
+	MESH_DATA GenerateTorus(int mainSegments, int tubeSegments, float sweepDegrees, unsigned int threadCount = 0);
+}
+
+// time the parallel generators against PrimitiveMeshes at high
+// tessellation and report the largest difference between them
+void RunGeneratorBenchmark();
@@ -0,0 +1,407 @@
+///////////////////////////////////////////////////////////////////////////////
+// pipelinestates.cpp
+// ==================
+// immutable pipeline states the draws of the scene switch between
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PipelineStates.h"
+#include "VertexPacking.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_UseTextureName = "bUseTexture";
+	const char* g_WeightedBlendName = "bWeightedBlend";
+
+	// uniforms each program variant draws with
+	const char* g_VariantUniforms[PROGRAM_VARIANT_COUNT][2] =
+	{
+		{ "bUseTexture", "objectColor" },
+		{ "bUseTexture", "objectTexture" },
+	};
+
+	const char* g_VariantNames[PROGRAM_VARIANT_COUNT] = { "colored", "textured" };
+
+	// one attribute of a vertex layout
+	struct VERTEX_ATTRIBUTE
+	{
+		GLint size;
+		GLenum type;
+	};
+
+	// quantized position, octahedral normal and texture coordinate,
+	// all normalized, at locations 0, 1 and 2
+	const VERTEX_ATTRIBUTE g_PackedAttributes[] =
+	{
+		{ 4, GL_UNSIGNED_SHORT },
+		{ 2, GL_SHORT },
+		{ 2, GL_UNSIGNED_SHORT },
+	};
+}
+
+/***********************************************************
+ *  PipelineStates()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PipelineStates::PipelineStates(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_bValidated = false;
+	for (int i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+	{
+		m_vertexArrays[i] = 0;
+	}
+	m_selected = -1;
+	m_applied = -1;
+	m_stateChanges = 0;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for adding a pipeline state.  The
+ *  states cannot change once they are validated, and no two
+ *  states may set the same values.
+ ***********************************************************/
+int PipelineStates::Create(const char* name, const PIPELINE_STATE_DESC& desc)
+{
+	if (m_bValidated == true)
+	{
+		std::cout << "Pipeline state " << name << " is created after the states were validated" << std::endl;
+		return(-1);
+	}
+
+	if ((desc.program < 0) || (desc.program >= PROGRAM_VARIANT_COUNT) ||
+		(desc.vertexLayout < 0) || (desc.vertexLayout >= VERTEX_LAYOUT_COUNT) ||
+		(desc.blend < 0) || (desc.blend >= BLEND_MODE_COUNT) ||
+		(desc.depth < 0) || (desc.depth >= DEPTH_MODE_COUNT) ||
+		(desc.cull < 0) || (desc.cull >= CULL_MODE_COUNT))
+	{
+		std::cout << "Pipeline state " << name << " has a value out of range" << std::endl;
+		return(-1);
+	}
+
+	for (size_t i = 0; i < m_states.size(); i++)
+	{
+		if (FindChanges(m_states[i].desc, desc) == 0)
+		{
+			std::cout << "Pipeline state " << name << " repeats " << m_states[i].name << std::endl;
+			return(-1);
+		}
+	}
+
+	PIPELINE_STATE state;
+	state.name = name;
+	state.desc = desc;
+	m_states.push_back(state);
+	return((int)m_states.size() - 1);
+}
+
+/***********************************************************
+ *  Validate()
+ *
+ *  This method is used for checking every state against the
+ *  shader program in use and the bound vertex array, which
+ *  the states then draw with, and for working out the
+ *  changes from each state to each other state and the cull
+ *  variants of each state.
+ ***********************************************************/
+bool PipelineStates::Validate()
+{
+	if (m_states.empty())
+	{
+		std::cout << "No pipeline states were created" << std::endl;
+		return(false);
+	}
+
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	GLint linked = GL_FALSE;
+	if (program != 0)
+	{
+		glGetProgramiv((GLuint)program, GL_LINK_STATUS, &linked);
+	}
+	if (linked == GL_FALSE)
+	{
+		std::cout << "Pipeline states need a linked shader program in use" << std::endl;
+		return(false);
+	}
+
+	bool bValid = true;
+	for (size_t i = 0; i < m_states.size(); i++)
+	{
+		const PIPELINE_STATE& state = m_states[i];
+		if ((state.desc.blend == BLEND_WEIGHTED) && (SupportsWeightedBlend() == false))
+		{
+			std::cout << "Pipeline state " << state.name << " needs OpenGL 4.0 to blend each target differently" << std::endl;
+			bValid = false;
+		}
+		if (ValidateProgram((GLuint)program, state.desc.program, state.desc.blend) == false)
+		{
+			std::cout << "Pipeline state " << state.name << " needs the " << g_VariantNames[state.desc.program]
+				<< " variant, which the shader program does not have" << std::endl;
+			bValid = false;
+		}
+		if (ValidateVertexLayout(state.desc.vertexLayout) == false)
+		{
+			std::cout << "Pipeline state " << state.name << " does not match the bound vertex array" << std::endl;
+			bValid = false;
+		}
+	}
+	if (bValid == false)
+	{
+		return(false);
+	}
+
+	GLint vertexArray = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+	m_vertexArrays[VERTEX_LAYOUT_PACKED] = (GLuint)vertexArray;
+
+	const size_t stateCount = m_states.size();
+	m_changes.resize(stateCount * stateCount);
+	m_cullVariants.assign(stateCount * CULL_MODE_COUNT, -1);
+	for (size_t from = 0; from < stateCount; from++)
+	{
+		for (size_t to = 0; to < stateCount; to++)
+		{
+			const unsigned int changes = FindChanges(m_states[from].desc, m_states[to].desc);
+			m_changes[from * stateCount + to] = changes;
+
+			PIPELINE_STATE_DESC culled = m_states[from].desc;
+			culled.cull = m_states[to].desc.cull;
+			if (FindChanges(culled, m_states[to].desc) == 0)
+			{
+				m_cullVariants[from * CULL_MODE_COUNT + m_states[to].desc.cull] = (int)to;
+			}
+		}
+	}
+
+	m_bValidated = true;
+	std::cout << "INFO: " << stateCount << " pipeline states validated" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  SupportsWeightedBlend()
+ *
+ *  This method is used for checking whether the context can
+ *  set a different blend function for each draw buffer, as
+ *  the weighted blend mode does.
+ ***********************************************************/
+bool PipelineStates::SupportsWeightedBlend()
+{
+	return(GLEW_VERSION_4_0 ? true : false);
+}
+
+/***********************************************************
+ *  GetCullVariant()
+ *
+ *  This method is used for finding the state that draws
+ *  like the passed in state with another cull mode.
+ ***********************************************************/
+int PipelineStates::GetCullVariant(int state, CULL_MODE cull) const
+{
+	if ((m_bValidated == false) || (state < 0))
+	{
+		return(-1);
+	}
+	return(m_cullVariants[state * CULL_MODE_COUNT + cull]);
+}
+
+/***********************************************************
+ *  Apply()
+ *
+ *  This method is used for switching the OpenGL state from
+ *  the applied state to the selected state, making only
+ *  the calls for the parts that differ between the two.
+ ***********************************************************/
+void PipelineStates::Apply()
+{
+	if ((m_bValidated == false) || (m_selected < 0) || (m_selected == m_applied))
+	{
+		return;
+	}
+
+	const PIPELINE_STATE_DESC& desc = m_states[m_selected].desc;
+	const unsigned int changes = (m_applied < 0) ?
+		(unsigned int)CHANGE_ALL :
+		m_changes[m_applied * m_states.size() + m_selected];
+
+	if (((changes & CHANGE_PROGRAM) != 0) && (NULL != m_pShaderManager))
+	{
+		m_pShaderManager->setIntValue(g_UseTextureName, desc.program == PROGRAM_TEXTURED);
+	}
+	if (((changes & CHANGE_PROGRAM_OUTPUT) != 0) && (NULL != m_pShaderManager))
+	{
+		m_pShaderManager->setIntValue(g_WeightedBlendName, desc.blend == BLEND_WEIGHTED);
+	}
+	if ((changes & CHANGE_VERTEX_LAYOUT) != 0)
+	{
+		glBindVertexArray(m_vertexArrays[desc.vertexLayout]);
+	}
+	if ((changes & CHANGE_BLEND) != 0)
+	{
+		if (desc.blend == BLEND_ALPHA)
+		{
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		}
+		else if (desc.blend == BLEND_WEIGHTED)
+		{
+			// the weighted colors add up, and the revealage is
+			// multiplied by one minus each opacity
+			glEnable(GL_BLEND);
+			glBlendFunci(0, GL_ONE, GL_ONE);
+			glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+		}
+		else
+		{
+			glDisable(GL_BLEND);
+		}
+	}
+	if ((changes & CHANGE_DEPTH_TEST) != 0)
+	{
+		if (desc.depth == DEPTH_DISABLED)
+		{
+			glDisable(GL_DEPTH_TEST);
+		}
+		else
+		{
+			glEnable(GL_DEPTH_TEST);
+		}
+	}
+	if ((changes & CHANGE_DEPTH_WRITE) != 0)
+	{
+		glDepthMask((desc.depth == DEPTH_READ_ONLY) ? GL_FALSE : GL_TRUE);
+	}
+	if ((changes & CHANGE_CULL_ENABLE) != 0)
+	{
+		if (desc.cull == CULL_NONE)
+		{
+			glDisable(GL_CULL_FACE);
+		}
+		else
+		{
+			glEnable(GL_CULL_FACE);
+		}
+	}
+	if (((changes & CHANGE_CULL_FACE) != 0) && (desc.cull != CULL_NONE))
+	{
+		glCullFace((desc.cull == CULL_FRONT) ? GL_FRONT : GL_BACK);
+	}
+
+	m_applied = m_selected;
+	m_stateChanges++;
+}
+
+/***********************************************************
+ *  FindChanges()
+ *
+ *  This method is used for comparing two states part by
+ *  part.  A depth test that is off never writes, so only
+ *  the write mask of a state that tests depth matters, and
+ *  only the cull face of a state that culls.
+ ***********************************************************/
+unsigned int PipelineStates::FindChanges(const PIPELINE_STATE_DESC& from, const PIPELINE_STATE_DESC& to) const
+{
+	unsigned int changes = 0;
+
+	if (from.program != to.program)
+	{
+		changes |= CHANGE_PROGRAM;
+	}
+	if (from.vertexLayout != to.vertexLayout)
+	{
+		changes |= CHANGE_VERTEX_LAYOUT;
+	}
+	if (from.blend != to.blend)
+	{
+		changes |= CHANGE_BLEND;
+	}
+	if ((from.blend == BLEND_WEIGHTED) != (to.blend == BLEND_WEIGHTED))
+	{
+		changes |= CHANGE_PROGRAM_OUTPUT;
+	}
+	if ((from.depth == DEPTH_DISABLED) != (to.depth == DEPTH_DISABLED))
+	{
+		changes |= CHANGE_DEPTH_TEST;
+	}
+	if ((from.depth == DEPTH_READ_ONLY) != (to.depth == DEPTH_READ_ONLY))
+	{
+		changes |= CHANGE_DEPTH_WRITE;
+	}
+	if ((from.cull == CULL_NONE) != (to.cull == CULL_NONE))
+	{
+		changes |= CHANGE_CULL_ENABLE;
+	}
+	if (from.cull != to.cull)
+	{
+		changes |= CHANGE_CULL_FACE;
+	}
+	return(changes);
+}
+
+/***********************************************************
+ *  ValidateProgram()
+ *
+ *  This method is used for checking that the shader program
+ *  has the uniforms a program variant is drawn with, and
+ *  the switch to its weighted outputs when it blends them.
+ ***********************************************************/
+bool PipelineStates::ValidateProgram(GLuint program, PROGRAM_VARIANT variant, BLEND_MODE blend) const
+{
+	for (int i = 0; i < 2; i++)
+	{
+		if (glGetUniformLocation(program, g_VariantUniforms[variant][i]) < 0)
+		{
+			return(false);
+		}
+	}
+	if ((blend == BLEND_WEIGHTED) && (glGetUniformLocation(program, g_WeightedBlendName) < 0))
+	{
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  ValidateVertexLayout()
+ *
+ *  This method is used for checking that the bound vertex
+ *  array reads the attributes of a vertex layout.
+ ***********************************************************/
+bool PipelineStates::ValidateVertexLayout(VERTEX_LAYOUT layout) const
+{
+	GLint vertexArray = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+	if ((vertexArray == 0) || (layout != VERTEX_LAYOUT_PACKED))
+	{
+		return(false);
+	}
+
+	const GLuint attributeCount = sizeof(g_PackedAttributes) / sizeof(g_PackedAttributes[0]);
+	for (GLuint i = 0; i < attributeCount; i++)
+	{
+		GLint enabled = 0;
+		GLint size = 0;
+		GLint type = 0;
+		GLint normalized = 0;
+		GLint stride = 0;
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &size);
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &type);
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &normalized);
+		glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride);
+		if ((enabled == GL_FALSE) || (normalized == GL_FALSE) ||
+			(size != g_PackedAttributes[i].size) ||
+			((GLenum)type != g_PackedAttributes[i].type) ||
+			(stride != (GLint)sizeof(PACKED_VERTEX)))
+		{
+			return(false);
+		}
+	}
+	return(true);
+}
@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+// pipelinestates.h
+// ================
+// immutable pipeline states the draws of the scene switch between
+//
+// A pipeline state bundles everything a draw needs besides its own uniforms:
+// the variant of the scene shader - colored or textured - the vertex layout
+// it reads, and its blend, depth and cull state.  The states are created
+// once, when the scene is prepared, and validated against the shader
+// program and vertex array they will draw with.  Validating them also works
+// out which parts differ between every pair of states, so switching from
+// one state to another only makes the OpenGL calls for the parts that
+// change, without comparing anything while drawing.
+//
+// A draw selects its state, and the selected state is applied right before
+// the draw call is made, so a draw that changes its color and then its
+// texture only switches state once.
+//
+// The weighted blend mode draws the transparent surfaces for weighted
+// blended order independent transparency: the shader writes each surface's
+// color, weighted by its depth and opacity, to an accumulation target that
+// adds them up, and its opacity to a revealage target that multiplies what
+// is left visible behind it.  Neither depends on the order of the surfaces.
+// It blends each target differently, which needs OpenGL 4.0.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+// the variants of the scene shader
+enum PROGRAM_VARIANT
+{
+	PROGRAM_COLORED = 0,
+	PROGRAM_TEXTURED,
+	PROGRAM_VARIANT_COUNT
+};
+
+// the vertex formats a state can draw
+enum VERTEX_LAYOUT
+{
+	// the quantized 16 byte vertices of vertexpacking.h
+	VERTEX_LAYOUT_PACKED = 0,
+	VERTEX_LAYOUT_COUNT
+};
+
+enum BLEND_MODE
+{
+	BLEND_OPAQUE = 0,
+	// source alpha over the framebuffer
+	BLEND_ALPHA,
+	// added to the accumulation target and multiplied into the
+	// revealage target
+	BLEND_WEIGHTED,
+	BLEND_MODE_COUNT
+};
+
+enum DEPTH_MODE
+{
+	DEPTH_READ_WRITE = 0,
+	// tested but not written
+	DEPTH_READ_ONLY,
+	DEPTH_DISABLED,
+	DEPTH_MODE_COUNT
+};
+
+enum CULL_MODE
+{
+	CULL_NONE = 0,
+	CULL_BACK,
+	CULL_FRONT,
+	CULL_MODE_COUNT
+};
+
+/***********************************************************
+ *  PIPELINE_STATE_DESC
+ *
+ *  Everything a pipeline state sets before a draw.
+ ***********************************************************/
+struct PIPELINE_STATE_DESC
+{
+	PROGRAM_VARIANT program;
+	VERTEX_LAYOUT vertexLayout;
+	BLEND_MODE blend;
+	DEPTH_MODE depth;
+	CULL_MODE cull;
+};
+
+/***********************************************************
+ *  PipelineStates
+ *
+ *  This class holds the pipeline states of the scene and
+ *  switches the OpenGL state between them.
+ ***********************************************************/
+class PipelineStates
+{
+public:
+	// constructor
+	PipelineStates(ShaderManager* pShaderManager);
+
+	// add a state - returns its handle, or -1 when the description
+	// is out of range, repeats a state or the states are validated
+	int Create(const char* name, const PIPELINE_STATE_DESC& desc);
+	// check the states against the shader program in use and the
+	// bound vertex array, and work out the changes between every
+	// pair of states - returns false if the states cannot be used
+	bool Validate();
+	// whether states with the weighted blend mode can be created
+	static bool SupportsWeightedBlend();
+
+	// the state that only differs from the passed in state by its
+	// cull mode, or -1 if it was not created
+	int GetCullVariant(int state, CULL_MODE cull) const;
+	const PIPELINE_STATE_DESC& GetDesc(int state) const { return(m_states[state].desc); }
+
+	// the state of the next draw
+	void Select(int state) { m_selected = state; }
+	int GetSelected() const { return(m_selected); }
+	// switch from the applied state to the selected state - called
+	// right before each draw call
+	void Apply();
+	// forget the applied state after other code changed the OpenGL
+	// state, so the next Apply() sets all of the selected state
+	void Invalidate() { m_applied = -1; }
+	// times Apply() switched state
+	size_t GetStateChanges() const { return(m_stateChanges); }
+
+private:
+	// the parts of the OpenGL state that can differ between states
+	enum STATE_CHANGE
+	{
+		CHANGE_PROGRAM = 1 << 0,
+		CHANGE_VERTEX_LAYOUT = 1 << 1,
+		CHANGE_BLEND = 1 << 2,
+		CHANGE_DEPTH_TEST = 1 << 3,
+		CHANGE_DEPTH_WRITE = 1 << 4,
+		CHANGE_CULL_ENABLE = 1 << 5,
+		CHANGE_CULL_FACE = 1 << 6,
+		CHANGE_PROGRAM_OUTPUT = 1 << 7,
+		CHANGE_ALL = (1 << 8) - 1
+	};
+
+	struct PIPELINE_STATE
+	{
+		std::string name;
+		PIPELINE_STATE_DESC desc;
+	};
+
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	std::vector<PIPELINE_STATE> m_states;
+	bool m_bValidated;
+	// the vertex array each layout is drawn from
+	GLuint m_vertexArrays[VERTEX_LAYOUT_COUNT];
+	// STATE_CHANGE bits from each state to each other state, at
+	// [from * state count + to]
+	std::vector<unsigned int> m_changes;
+	// state of each cull mode of each state, at
+	// [state * CULL_MODE_COUNT + cull]
+	std::vector<int> m_cullVariants;
+	int m_selected;
+	int m_applied;
+	size_t m_stateChanges;
+
+	// the changes needed to switch between two states
+	unsigned int FindChanges(const PIPELINE_STATE_DESC& from, const PIPELINE_STATE_DESC& to) const;
+	// check that the program in use has the uniforms of a variant
+	// and of its outputs for the blend mode
+	bool ValidateProgram(GLuint program, PROGRAM_VARIANT variant, BLEND_MODE blend) const;
+	// check that the bound vertex array has the attributes of a layout
+	bool ValidateVertexLayout(VERTEX_LAYOUT layout) const;
+};
@@ -0,0 +1,294 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivemeshes.cpp
+// ===================
+// CPU generation of the basic 3D shapes used to build the scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PrimitiveMeshes.h"
+
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	const float g_Pi = 3.14159265358979f;
+
+	// append one vertex to the passed in mesh
+	void AddVertex(MESH_DATA& mesh, glm::vec3 position, glm::vec3 normal, glm::vec2 uv)
+	{
+		MESH_VERTEX vertex;
+		vertex.position = position;
+		vertex.normal = normal;
+		vertex.textureCoordinate = uv;
+		mesh.vertices.push_back(vertex);
+	}
+
+	// append one triangle to the passed in mesh
+	void AddTriangle(MESH_DATA& mesh, uint32_t a, uint32_t b, uint32_t c)
+	{
+		mesh.indices.push_back(a);
+		mesh.indices.push_back(b);
+		mesh.indices.push_back(c);
+	}
+
+	// append the two triangles of a grid cell whose corners are the
+	// vertices (row, column) through (row + 1, column + 1), counter-
+	// clockwise when viewed from the side the normals face
+	void AddGridCell(MESH_DATA& mesh, uint32_t rowStart, uint32_t nextRowStart, uint32_t column)
+	{
+		AddTriangle(mesh, rowStart + column, nextRowStart + column, nextRowStart + column + 1);
+		AddTriangle(mesh, rowStart + column, nextRowStart + column + 1, rowStart + column + 1);
+	}
+}
+
+/***********************************************************
+ *  GeneratePlane()
+ *
+ *  This method is used for generating a flat plane that
+ *  spans -1 to 1 in X and Z, facing +Y.
+ ***********************************************************/
+MESH_DATA PrimitiveMeshes::GeneratePlane()
+{
+	MESH_DATA mesh;
+	const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+	AddVertex(mesh, glm::vec3(-1.0f, 0.0f, 1.0f), up, glm::vec2(0.0f, 0.0f));
+	AddVertex(mesh, glm::vec3(1.0f, 0.0f, 1.0f), up, glm::vec2(1.0f, 0.0f));
+	AddVertex(mesh, glm::vec3(1.0f, 0.0f, -1.0f), up, glm::vec2(1.0f, 1.0f));
+	AddVertex(mesh, glm::vec3(-1.0f, 0.0f, -1.0f), up, glm::vec2(0.0f, 1.0f));
+	AddTriangle(mesh, 0, 1, 2);
+	AddTriangle(mesh, 0, 2, 3);
+
+	return(mesh);
+}
+
+/***********************************************************
+ *  GenerateBox()
+ *
+ *  This method is used for generating a unit cube centered
+ *  on the origin.  Each face has its own four vertices so it
+ *  gets a flat normal and the full texture.
+ ***********************************************************/
+MESH_DATA PrimitiveMeshes::GenerateBox()
+{
+	MESH_DATA mesh;
+
+	// outward normal, texture U direction and texture V direction
+	// of each face - the cross product of U and V is the normal
+	const glm::vec3 faces[6][3] =
+	{
+		{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+		{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) }
+	};
+
+	for (int face = 0; face < 6; face++)
+	{
+		const glm::vec3 normal = faces[face][0];
+		const glm::vec3 u = faces[face][1];
+		const glm::vec3 v = faces[face][2];
+		const glm::vec3 center = normal * 0.5f;
+		const uint32_t first = (uint32_t)mesh.vertices.size();
+
+		AddVertex(mesh, center - (u * 0.5f) - (v * 0.5f), normal, glm::vec2(0.0f, 0.0f));
+		AddVertex(mesh, center + (u * 0.5f) - (v * 0.5f), normal, glm::vec2(1.0f, 0.0f));
+		AddVertex(mesh, center + (u * 0.5f) + (v * 0.5f), normal, glm::vec2(1.0f, 1.0f));
+		AddVertex(mesh, center - (u * 0.5f) + (v * 0.5f), normal, glm::vec2(0.0f, 1.0f));
+		AddTriangle(mesh, first, first + 1, first + 2);
+		AddTriangle(mesh, first, first + 2, first + 3);
+	}
+
+	return(mesh);
+}
+
+/***********************************************************
+ *  GenerateCylinderSides()
+ *
+ *  This method is used for generating the side wall of a
+ *  cylinder with radius 1 from y = 0 to y = 1.  The seam
+ *  column is duplicated so the texture wraps once around,
+ *  and the top row comes first as with the sphere stacks.
+ ***********************************************************/
+MESH_DATA PrimitiveMeshes::GenerateCylinderSides(int slices)
+{
+	MESH_DATA mesh;
+
+	for (int row = 0; row <= 1; row++)
+	{
+		const float y = 1.0f - (float)row;
+
+		for (int slice = 0; slice <= slices; slice++)
+		{
+			const float u = (float)slice / (float)slices;
+			const float angle = u * 2.0f * g_Pi;
+			const glm::vec3 normal(std::cos(angle), 0.0f, -std::sin(angle));
+
+			AddVertex(mesh, glm::vec3(normal.x, y, normal.z), normal, glm::vec2(u, y));
+		}
+	}
+	for (int slice = 0; slice < slices; slice++)
+	{
+		AddGridCell(mesh, 0, slices + 1, slice);
+	}
+
+	return(mesh);
+}
+
+/***********************************************************
+ *  GenerateCylinderCap()
+ *
+ *  This method is used for generating the top (y = 1) or
+ *  bottom (y = 0) disc of a cylinder with radius 1.
+ ***********************************************************/
+MESH_DATA PrimitiveMeshes::GenerateCylinderCap(int slices, bool bTop)
+{
+	MESH_DATA mesh;
+	const float y = bTop ? 1.0f : 0.0f;
+	const glm::vec3 normal(0.0f, bTop ? 1.0f : -1.0f, 0.0f);
+
+	AddVertex(mesh, glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		const float angle = ((float)slice / (float)slices) * 2.0f * g_Pi;
+		const float x = std::cos(angle);
+		const float z = -std::sin(angle);
+
+		AddVertex(mesh, glm::vec3(x, y, z), normal, glm::vec2((x * 0.5f) + 0.5f, 0.5f - (z * 0.5f)));
+	}
+	for (int slice = 0; slice < slices; slice++)
+	{
+		if (bTop)
+		{
+			AddTriangle(mesh, 0, slice + 1, slice + 2);
+		}
+		else
+		{
+			AddTriangle(mesh, 0, slice + 2, slice + 1);
+		}
+	}
+
+	return(mesh);
+}
+
+/***********************************************************
+ *  GenerateCone()
+ *
+ *  This method is used for generating a cone with a base of
+ *  radius 1 at y = 0 and its apex at y = 1.  Each side slice
+ *  gets its own apex vertex so the normals stay smooth
+ *  around the cone instead of averaging to straight up.
+ ***********************************************************/
+MESH_DATA PrimitiveMeshes::GenerateCone(int slices)
+{
+	MESH_DATA mesh = GenerateCylinderCap(slices, false);
+	const uint32_t sideStart = (uint32_t)mesh.vertices.size();
+
+	// the side slope rises 1 over a run of 1
+	const float normalScale = 1.0f / std::sqrt(2.0f);
+
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		const float u = (float)slice / (float)slices;
+		const float angle = u * 2.0f * g_Pi;
+		const float x = std::cos(angle);
+		const float z = -std::sin(angle);
+		const float apexAngle = (u + (0.5f / (float)slices)) * 2.0f * g_Pi;
+
+		AddVertex(mesh, glm::vec3(x, 0.0f, z),
+			glm::vec3(x, 1.0f, z) * normalScale, glm::vec2(u, 0.0f));
+		AddVertex(mesh, glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::vec3(std::cos(apexAngle), 1.0f, -std::sin(apexAngle)) * normalScale,
+			glm::vec2(u + (0.5f / (float)slices), 1.0f));
+	}
+	for (int slice = 0; slice < slices; slice++)
+	{
+		const uint32_t base = sideStart + (slice * 2);
+		AddTriangle(mesh, base, base + 2, base + 1);
+	}
+
+	return(mesh);
+}
+
+/***********************************************************
+ *  GenerateSphere()
+ *
+ *  This method is used for generating a sphere of radius 1,
+ *  or only its upper hemisphere when bHemisphere is set.
+ *  Stacks run from the north pole downward.
+ ***********************************************************/
+MESH_DATA PrimitiveMeshes::GenerateSphere(int slices, int stacks, bool bHemisphere)
+{
+	MESH_DATA mesh;
+	const int rows = bHemisphere ? (stacks / 2) : stacks;
+
+	for (int stack = 0; stack <= rows; stack++)
+	{
+		const float v = (float)stack / (float)stacks;
+		const float polarAngle = v * g_Pi;
+		const float ringRadius = std::sin(polarAngle);
+		const float y = std::cos(polarAngle);
+
+		for (int slice = 0; slice <= slices; slice++)
+		{
+			const float u = (float)slice / (float)slices;
+			const float angle = u * 2.0f * g_Pi;
+			const glm::vec3 normal(ringRadius * std::cos(angle), y, -ringRadius * std::sin(angle));
+
+			AddVertex(mesh, normal, normal, glm::vec2(u, 1.0f - v));
+		}
+	}
+	for (int stack = 0; stack < rows; stack++)
+	{
+		const uint32_t rowStart = stack * (slices + 1);
+		for (int slice = 0; slice < slices; slice++)
+		{
+			AddGridCell(mesh, rowStart, rowStart + slices + 1, slice);
+		}
+	}
+
+	return(mesh);
+}
+
+/***********************************************************
+ *  GenerateTorus()
+ *
+ *  This method is used for generating a torus with a main
+ *  radius of 1 around the Z axis.  The ring is swept from +X
+ *  through +Y for the passed in number of degrees, so a
+ *  sweep of 180 produces the upper half of the ring.
+ ***********************************************************/
+MESH_DATA PrimitiveMeshes::GenerateTorus(int mainSegments, int tubeSegments, float sweepDegrees)
+{
+	MESH_DATA mesh;
+	const float sweep = glm::radians(sweepDegrees);
+
+	for (int segment = 0; segment <= mainSegments; segment++)
+	{
+		const float u = (float)segment / (float)mainSegments;
+		const float mainAngle = u * sweep;
+		const glm::vec3 ringDirection(std::cos(mainAngle), std::sin(mainAngle), 0.0f);
+
+		for (int tube = 0; tube <= tubeSegments; tube++)
+		{
+			const float v = (float)tube / (float)tubeSegments;
+			const float tubeAngle = v * 2.0f * g_Pi;
+			const glm::vec3 normal =
+				(ringDirection * std::cos(tubeAngle)) + glm::vec3(0.0f, 0.0f, std::sin(tubeAngle));
+
+			AddVertex(mesh, ringDirection + (normal * TORUS_TUBE_RADIUS), normal, glm::vec2(u, v));
+		}
+	}
+	for (int segment = 0; segment < mainSegments; segment++)
+	{
+		const uint32_t rowStart = segment * (tubeSegments + 1);
+		for (int tube = 0; tube < tubeSegments; tube++)
+		{
+			AddGridCell(mesh, rowStart, rowStart + tubeSegments + 1, tube);
+		}
+	}
+
+	return(mesh);
+}
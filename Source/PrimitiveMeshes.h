@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivemeshes.h
+// =================
+// CPU generation of the basic 3D shapes used to build the scene
+//
+// The shapes follow the same conventions as the ShapeMeshes library: the
+// plane spans -1..1 in X and Z, the box is a unit cube centered on the
+// origin, the cylinder and cone have radius 1 and run from y = 0 to y = 1,
+// the sphere has radius 1 and the torus lies in the XY plane with a main
+// radius of 1.  Vertices are interleaved position / normal / texture
+// coordinate, matching vertex shader locations 0, 1 and 2.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  MESH_VERTEX
+ *
+ *  Full precision vertex as produced by the generators.
+ ***********************************************************/
+struct MESH_VERTEX
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 textureCoordinate;
+};
+
+/***********************************************************
+ *  MESH_DATA
+ *
+ *  Indexed triangle list for one mesh.
+ ***********************************************************/
+struct MESH_DATA
+{
+	std::vector<MESH_VERTEX> vertices;
+	std::vector<uint32_t> indices;
+};
+
+namespace PrimitiveMeshes
+{
+	// tube radius of the torus relative to its main radius of 1
+	const float TORUS_TUBE_RADIUS = 0.25f;
+
+	// flat 2x2 plane facing +Y
+	MESH_DATA GeneratePlane();
+	// unit cube centered on the origin
+	MESH_DATA GenerateBox();
+	// the side wall of a cylinder
+	MESH_DATA GenerateCylinderSides(int slices);
+	// the top (y = 1) or bottom (y = 0) cap of a cylinder
+	MESH_DATA GenerateCylinderCap(int slices, bool bTop);
+	// cone with its base cap at y = 0 and apex at y = 1
+	MESH_DATA GenerateCone(int slices);
+	// sphere, or its upper hemisphere when bHemisphere is set
+	MESH_DATA GenerateSphere(int slices, int stacks, bool bHemisphere);
+	// torus swept around the Z axis from +X through +Y, for
+	// sweepDegrees (360 for a full ring, 180 for the upper half)
+	MESH_DATA GenerateTorus(int mainSegments, int tubeSegments, float sweepDegrees);
+}
@@ -0,0 +1,40 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderbackend.h
+// ===============
+// interface of the APIs a frame of the scene can be rendered with
+//
+// The OpenGL backend draws the scene through the shared context as it always
+// has.  Other backends render the draws the scene records for a frame, so
+// the scene code itself stays the same whichever API the frame ends up in.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  IRenderBackend
+ *
+ *  This interface is implemented by each API the frames of
+ *  the 3D scene can be rendered with.
+ ***********************************************************/
+class IRenderBackend
+{
+public:
+	// destructor
+	virtual ~IRenderBackend() {}
+
+	// name of the API, for reporting
+	virtual const char* GetName() const = 0;
+	// render one frame of the scene from the current camera
+	virtual void RenderFrame() = 0;
+	// wait until every frame rendered so far is finished
+	virtual void Finish() = 0;
+	// write the last finished frame to a binary PPM image,
+	// top row first
+	virtual bool WriteFrame(const char* filename) = 0;
+	// CPU time the last RenderFrame() took to walk the scene
+	// and record and submit its draws, in milliseconds
+	virtual double GetSubmitMilliseconds() const = 0;
+	// print the time each pass of the frames took, when the
+	// passes are timed
+	virtual void ReportPasses() const = 0;
+};
@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderfarm.cpp
+// ==============
+// batch rendering of image sequences from a list of camera poses
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderFarm.h"
+#include "WorkerThreads.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// latency stored for a pose that was not rendered
+	const double NOT_RENDERED = -1.0;
+
+	/***********************************************************
+	 *  ReportResults()
+	 *
+	 *  Print the images rendered per second over the whole
+	 *  batch and the spread of the per-image latencies.
+	 ***********************************************************/
+	void ReportResults(const double* latencies, size_t poseCount, int workerCount, double seconds)
+	{
+		std::vector<double> rendered;
+		for (size_t pose = 0; pose < poseCount; pose++)
+		{
+			if (latencies[pose] != NOT_RENDERED)
+			{
+				rendered.push_back(latencies[pose] * 1000.0);
+			}
+		}
+
+		std::cout << "INFO: Rendered " << rendered.size() << " of " << poseCount << " images with "
+			<< workerCount << " workers in " << seconds << " s, "
+			<< ((seconds > 0.0) ? rendered.size() / seconds : 0.0) << " images per second" << std::endl;
+		if (rendered.empty())
+		{
+			return;
+		}
+
+		std::sort(rendered.begin(), rendered.end());
+		double total = 0.0;
+		for (double latency : rendered)
+		{
+			total += latency;
+		}
+		std::cout << "INFO: Per-image latency: mean " << total / rendered.size()
+			<< " ms, median " << rendered[rendered.size() / 2]
+			<< " ms, 95th percentile " << rendered[((rendered.size() - 1) * 95) / 100]
+			<< " ms, max " << rendered.back() << " ms" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ReadCameraPoses()
+ *
+ *  This method is used for reading a camera list, skipping
+ *  blank and comment lines and reporting malformed ones.
+ ***********************************************************/
+bool RenderFarm::ReadCameraPoses(const char* filename, std::vector<CAMERA_POSE>& poses)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not open camera list " << filename << std::endl;
+		return(false);
+	}
+
+	poses.clear();
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		const size_t first = line.find_first_not_of(" \t\r");
+		if ((first == std::string::npos) || (line[first] == '#'))
+		{
+			continue;
+		}
+
+		std::istringstream values(line);
+		CAMERA_POSE pose;
+		int orthographic = 0;
+		values >> pose.position.x >> pose.position.y >> pose.position.z
+			>> pose.front.x >> pose.front.y >> pose.front.z
+			>> pose.up.x >> pose.up.y >> pose.up.z
+			>> pose.zoom >> orthographic;
+		if (values.fail())
+		{
+			std::cout << filename << ":" << lineNumber << ": expected 11 values for a camera pose" << std::endl;
+			return(false);
+		}
+		pose.bOrthographic = (orthographic != 0);
+		poses.push_back(pose);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for forking the worker processes,
+ *  waiting for all of them, and reporting the throughput
+ *  and latency from the shared latency array.
+ ***********************************************************/
+bool RenderFarm::Run(const std::vector<CAMERA_POSE>& poses, int workerCount, const RENDER_WORKER& worker)
+{
+	if (poses.empty())
+	{
+		std::cout << "The camera list has no poses" << std::endl;
+		return(false);
+	}
+
+	workerCount = (int)std::min<size_t>(WorkerThreads::ResolveThreadCount((unsigned int)std::max(workerCount, 0)), poses.size());
+	const size_t latencySize = poses.size() * sizeof(double);
+	bool bSucceeded = true;
+
+#ifdef _WIN32
+	// without fork, one worker renders every pose here
+	workerCount = 1;
+	std::vector<double> latencyStorage(poses.size(), NOT_RENDERED);
+	double* latencies = latencyStorage.data();
+#else
+	double* latencies = (double*)mmap(NULL, latencySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (latencies == (double*)MAP_FAILED)
+	{
+		std::cout << "Could not map the shared latency array" << std::endl;
+		return(false);
+	}
+	std::fill(latencies, latencies + poses.size(), NOT_RENDERED);
+#endif
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+#ifdef _WIN32
+	bSucceeded = worker(0, 1, latencies);
+#else
+	// buffered output would otherwise be printed by every worker
+	std::cout.flush();
+
+	std::vector<pid_t> processes;
+	for (int index = 0; index < workerCount; index++)
+	{
+		pid_t process = fork();
+		if (process == 0)
+		{
+			const bool bWorkerSucceeded = worker(index, workerCount, latencies);
+			std::cout.flush();
+			_exit(bWorkerSucceeded ? 0 : 1);
+		}
+		if (process < 0)
+		{
+			std::cout << "Could not start render worker " << index << std::endl;
+			bSucceeded = false;
+			break;
+		}
+		processes.push_back(process);
+	}
+
+	for (pid_t process : processes)
+	{
+		int status = 0;
+		if ((waitpid(process, &status, 0) < 0) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+		{
+			bSucceeded = false;
+		}
+	}
+#endif
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ReportResults(latencies, poses.size(), workerCount, seconds);
+
+#ifndef _WIN32
+	munmap(latencies, latencySize);
+#endif
+	return(bSucceeded);
+}
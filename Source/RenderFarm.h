@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderfarm.h
+// ============
+// batch rendering of image sequences from a list of camera poses
+//
+// The camera list is a text file with one pose per line:
+//
+//     posX posY posZ  frontX frontY frontZ  upX upY upZ  zoom  ortho
+//
+// where zoom is the vertical field of view in degrees and ortho is 1 for
+// the orthographic projection and 0 for perspective.  Blank lines and lines
+// starting with '#' are skipped.
+//
+// The poses are dealt out round robin to worker processes.  The scene keeps
+// its camera, shader program and mesh state in process globals, so each
+// worker is a forked process with its own headless context and scene rather
+// than a thread.  Workers are forked before any context exists and report
+// the latency of each image through a shared memory array.  Where there is
+// no fork, one worker renders every pose in the calling process.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ViewManager.h"
+
+#include <functional>
+#include <vector>
+
+namespace RenderFarm
+{
+	// function run by each worker, which renders the poses
+	// worker, worker + workerCount, ... and stores the seconds
+	// each took in latencies[pose] - returns false on failure
+	typedef std::function<bool(int worker, int workerCount, double* latencies)> RENDER_WORKER;
+
+	// read the camera poses from a camera list file
+	bool ReadCameraPoses(const char* filename, std::vector<CAMERA_POSE>& poses);
+
+	// render the poses across workerCount workers (0 for one per
+	// hardware thread) and report the images rendered per second
+	// and the latency of each image
+	bool Run(const std::vector<CAMERA_POSE>& poses, int workerCount, const RENDER_WORKER& worker);
+}
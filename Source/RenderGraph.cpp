@@ -0,0 +1,650 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendergraph.cpp
+// ===============
+// orders the passes of a frame from the render targets they read and write
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+/***********************************************************
+ *  RenderGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderGraph::RenderGraph()
+{
+	m_bCompiled = false;
+	m_width = 0;
+	m_height = 0;
+	m_frame = 0;
+	m_bTimings = false;
+}
+
+/***********************************************************
+ *  ~RenderGraph()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderGraph::~RenderGraph()
+{
+	DestroyTextures();
+	for (PASS& pass : m_passes)
+	{
+		if (0 != pass.queries[0][0])
+		{
+			glDeleteQueries(4, &pass.queries[0][0]);
+		}
+	}
+}
+
+/***********************************************************
+ *  ImportTarget()
+ *
+ *  This method is used to add the target the frame is
+ *  presented from.  Its framebuffer is the one bound when
+ *  the frame starts, and the passes that write it are the
+ *  ones the graph keeps.
+ ***********************************************************/
+int RenderGraph::ImportTarget(const char* name)
+{
+	TARGET target;
+	target.name = name;
+	target.internalFormat = GL_NONE;
+	target.bImported = true;
+	target.firstPass = -1;
+	target.lastPass = -1;
+	target.texture = -1;
+	m_targets.push_back(target);
+	m_bCompiled = false;
+	return((int)m_targets.size() - 1);
+}
+
+/***********************************************************
+ *  CreateTarget()
+ *
+ *  This method is used to add a transient target, a texture
+ *  of the passed in internal format and the size of the
+ *  frame whose contents only live during the frame.
+ ***********************************************************/
+int RenderGraph::CreateTarget(const char* name, GLenum internalFormat)
+{
+	TARGET target;
+	target.name = name;
+	target.internalFormat = internalFormat;
+	target.bImported = false;
+	target.firstPass = -1;
+	target.lastPass = -1;
+	target.texture = -1;
+	m_targets.push_back(target);
+	m_bCompiled = false;
+	return((int)m_targets.size() - 1);
+}
+
+/***********************************************************
+ *  AddPass()
+ *
+ *  This method is used to add a pass to the frame.  The
+ *  passes run in the order they are added, each with the
+ *  targets it writes bound as its framebuffer.
+ ***********************************************************/
+int RenderGraph::AddPass(const char* name, PASS_FUNCTION execute)
+{
+	PASS pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.bCulled = false;
+	pass.bImported = false;
+	pass.framebuffer = 0;
+	pass.queries[0][0] = 0;
+	pass.queries[0][1] = 0;
+	pass.queries[1][0] = 0;
+	pass.queries[1][1] = 0;
+	pass.bQueried[0] = false;
+	pass.bQueried[1] = false;
+	pass.totalCpuTime = 0.0;
+	pass.totalGpuTime = 0.0;
+	pass.cpuFrames = 0;
+	pass.gpuFrames = 0;
+	m_passes.push_back(pass);
+	m_bCompiled = false;
+	return((int)m_passes.size() - 1);
+}
+
+/***********************************************************
+ *  Read()
+ *
+ *  This method is used to declare that a pass samples a
+ *  target written by an earlier pass.
+ ***********************************************************/
+void RenderGraph::Read(int pass, int target)
+{
+	m_passes[pass].reads.push_back(target);
+	m_bCompiled = false;
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used to declare that a pass draws into a
+ *  target.  A pass other than the first to write a target
+ *  keeps its contents and draws over them.
+ ***********************************************************/
+void RenderGraph::Write(int pass, int target)
+{
+	m_passes[pass].writes.push_back(target);
+	m_bCompiled = false;
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used to prepare the passes to run.  Going
+ *  back from the last pass, a pass is kept when it writes
+ *  the imported target or a target a kept pass uses later;
+ *  the others are culled.  Walking the kept passes forward
+ *  then gives the barriers where the use of each target
+ *  changes, and the span of passes each transient target
+ *  lives for, from which the targets are packed into the
+ *  fewest pool textures.
+ ***********************************************************/
+bool RenderGraph::Compile()
+{
+	DestroyTextures();
+	m_pool.clear();
+	m_bCompiled = false;
+
+	// cull the passes whose results are never used
+	std::vector<bool> bNeeded(m_targets.size(), false);
+	for (int index = (int)m_passes.size() - 1; index >= 0; index--)
+	{
+		PASS& pass = m_passes[index];
+		bool bKeep = false;
+		for (int target : pass.writes)
+		{
+			if ((m_targets[target].bImported == true) || (bNeeded[target] == true))
+			{
+				bKeep = true;
+			}
+		}
+
+		pass.bCulled = (bKeep == false);
+		if (bKeep == true)
+		{
+			// a pass drawing over a target needs what the earlier
+			// passes left in it
+			for (int target : pass.writes)
+			{
+				bNeeded[target] = true;
+			}
+			for (int target : pass.reads)
+			{
+				bNeeded[target] = true;
+			}
+		}
+	}
+
+	// the barriers and the lifetime of each target
+	std::vector<ACCESS> access(m_targets.size(), ACCESS_NONE);
+	for (TARGET& target : m_targets)
+	{
+		target.firstPass = -1;
+		target.lastPass = -1;
+		target.texture = -1;
+	}
+	for (int index = 0; index < (int)m_passes.size(); index++)
+	{
+		PASS& pass = m_passes[index];
+		pass.barriers.clear();
+		pass.bImported = false;
+		if (pass.bCulled == true)
+		{
+			continue;
+		}
+
+		bool bTransient = false;
+		for (int target : pass.writes)
+		{
+			if (std::find(pass.reads.begin(), pass.reads.end(), target) != pass.reads.end())
+			{
+				std::cout << "Render pass " << pass.name << " both reads and writes " << m_targets[target].name << std::endl;
+				return(false);
+			}
+			pass.bImported = pass.bImported || m_targets[target].bImported;
+			bTransient = bTransient || (m_targets[target].bImported == false);
+		}
+		if ((pass.bImported == true) && (bTransient == true))
+		{
+			std::cout << "Render pass " << pass.name << " writes the imported target and transient targets" << std::endl;
+			return(false);
+		}
+
+		for (int target : pass.reads)
+		{
+			if ((access[target] == ACCESS_NONE) && (m_targets[target].bImported == false))
+			{
+				std::cout << "Render pass " << pass.name << " reads " << m_targets[target].name
+					<< " before any pass writes it" << std::endl;
+				return(false);
+			}
+			if (access[target] != ACCESS_READ)
+			{
+				pass.barriers.push_back({ target, access[target], ACCESS_READ });
+				access[target] = ACCESS_READ;
+			}
+		}
+		for (int target : pass.writes)
+		{
+			if (access[target] != ACCESS_WRITE)
+			{
+				pass.barriers.push_back({ target, access[target], ACCESS_WRITE });
+				access[target] = ACCESS_WRITE;
+			}
+		}
+
+		// a target lives from the first to the last pass that uses
+		// it, whether or not its access changes there
+		std::vector<int> used = pass.reads;
+		used.insert(used.end(), pass.writes.begin(), pass.writes.end());
+		for (int usedTarget : used)
+		{
+			TARGET& target = m_targets[usedTarget];
+			if (target.firstPass < 0)
+			{
+				target.firstPass = index;
+			}
+			target.lastPass = index;
+		}
+	}
+
+	// give each transient target a pool texture of its format no
+	// other target uses during its passes
+	std::vector<int> order;
+	for (int index = 0; index < (int)m_targets.size(); index++)
+	{
+		if ((m_targets[index].bImported == false) && (m_targets[index].firstPass >= 0))
+		{
+			order.push_back(index);
+		}
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[this](int a, int b) { return(m_targets[a].firstPass < m_targets[b].firstPass); });
+	for (int index : order)
+	{
+		TARGET& target = m_targets[index];
+		for (int texture = 0; (texture < (int)m_pool.size()) && (target.texture < 0); texture++)
+		{
+			if ((m_pool[texture].internalFormat == target.internalFormat) &&
+				(m_pool[texture].lastPass < target.firstPass))
+			{
+				target.texture = texture;
+			}
+		}
+		if (target.texture < 0)
+		{
+			POOL_TEXTURE texture;
+			texture.internalFormat = target.internalFormat;
+			texture.texture = 0;
+			texture.lastPass = -1;
+			m_pool.push_back(texture);
+			target.texture = (int)m_pool.size() - 1;
+		}
+		m_pool[target.texture].lastPass = target.lastPass;
+	}
+
+	// the targets a pass uses must be distinct textures
+	for (const PASS& pass : m_passes)
+	{
+		if (pass.bCulled == true)
+		{
+			continue;
+		}
+
+		std::vector<int> used = pass.reads;
+		used.insert(used.end(), pass.writes.begin(), pass.writes.end());
+		for (size_t i = 0; i < used.size(); i++)
+		{
+			for (size_t j = i + 1; j < used.size(); j++)
+			{
+				const TARGET& first = m_targets[used[i]];
+				const TARGET& second = m_targets[used[j]];
+				if ((used[i] != used[j]) && (first.bImported == false) && (second.bImported == false) &&
+					(first.texture == second.texture))
+				{
+					std::cout << "Render pass " << pass.name << " uses " << first.name << " and "
+						<< second.name << " as the same texture" << std::endl;
+					return(false);
+				}
+			}
+		}
+	}
+
+	m_bCompiled = true;
+	return(true);
+}
+
+/***********************************************************
+ *  CreateTextures()
+ *
+ *  This method is used to create the pool textures and the
+ *  framebuffer of each kept pass at the passed in size.
+ *  The texture bindings of the scene are left as they were.
+ ***********************************************************/
+bool RenderGraph::CreateTextures(int width, int height)
+{
+	GLint activeTexture = 0;
+	GLint boundTexture = 0;
+	GLint boundFramebuffer = 0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &boundFramebuffer);
+
+	m_width = width;
+	m_height = height;
+	for (POOL_TEXTURE& texture : m_pool)
+	{
+		const bool bDepth = (texture.internalFormat == GL_DEPTH_COMPONENT24) ||
+			(texture.internalFormat == GL_DEPTH_COMPONENT32F);
+		GLenum format = GL_RGBA;
+		if (bDepth == true)
+		{
+			format = GL_DEPTH_COMPONENT;
+		}
+		else if ((texture.internalFormat == GL_R8) || (texture.internalFormat == GL_R16F) ||
+			(texture.internalFormat == GL_R32F))
+		{
+			format = GL_RED;
+		}
+
+		glGenTextures(1, &texture.texture);
+		glBindTexture(GL_TEXTURE_2D, texture.texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, texture.internalFormat, width, height, 0, format, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, (GLuint)boundTexture);
+	glActiveTexture((GLenum)activeTexture);
+
+	bool bResult = true;
+	for (PASS& pass : m_passes)
+	{
+		if ((pass.bCulled == true) || (pass.bImported == true))
+		{
+			continue;
+		}
+
+		glGenFramebuffers(1, &pass.framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pass.framebuffer);
+		std::vector<GLenum> drawBuffers;
+		for (int index : pass.writes)
+		{
+			const TARGET& target = m_targets[index];
+			const GLuint texture = m_pool[target.texture].texture;
+			if ((target.internalFormat == GL_DEPTH_COMPONENT24) || (target.internalFormat == GL_DEPTH_COMPONENT32F))
+			{
+				glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+			}
+			else
+			{
+				const GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)drawBuffers.size();
+				glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+				drawBuffers.push_back(attachment);
+			}
+		}
+		if (drawBuffers.empty())
+		{
+			glDrawBuffer(GL_NONE);
+		}
+		else
+		{
+			glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+		}
+
+		if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "The framebuffer of render pass " << pass.name << " is incomplete" << std::endl;
+			bResult = false;
+		}
+	}
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)boundFramebuffer);
+
+	return(bResult);
+}
+
+/***********************************************************
+ *  DestroyTextures()
+ *
+ *  This method is used to free the pool textures and the
+ *  framebuffers of the passes.
+ ***********************************************************/
+void RenderGraph::DestroyTextures()
+{
+	for (PASS& pass : m_passes)
+	{
+		if (0 != pass.framebuffer)
+		{
+			glDeleteFramebuffers(1, &pass.framebuffer);
+			pass.framebuffer = 0;
+		}
+	}
+	for (POOL_TEXTURE& texture : m_pool)
+	{
+		if (0 != texture.texture)
+		{
+			glDeleteTextures(1, &texture.texture);
+			texture.texture = 0;
+		}
+	}
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  Execute()
+ *
+ *  This method is used to run the kept passes in order over
+ *  the width x height corner of the targets.  A
+ *  transient target's old contents are discarded before the
+ *  first pass that writes it, so they are never loaded; the
+ *  other barriers OpenGL keeps itself, as a target that is
+ *  read is never attached to the framebuffer of the pass.
+ ***********************************************************/
+void RenderGraph::Execute(int width, int height)
+{
+	if ((m_bCompiled == false) && (Compile() == false))
+	{
+		return;
+	}
+
+	GLint boundFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &boundFramebuffer);
+	// the frame size changes with each view that is rendered, so
+	// the textures are only made again when the frame outgrows them
+	if ((width > m_width) || (height > m_height))
+	{
+		const int textureWidth = std::max(width, m_width);
+		const int textureHeight = std::max(height, m_height);
+		DestroyTextures();
+		if (CreateTextures(textureWidth, textureHeight) == false)
+		{
+			return;
+		}
+	}
+
+	const bool bInvalidate = (GLEW_VERSION_4_3 || GLEW_ARB_invalidate_subdata);
+	const int slot = m_frame % 2;
+	for (PASS& pass : m_passes)
+	{
+		if (pass.bCulled == true)
+		{
+			continue;
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (pass.bImported == true) ? (GLuint)boundFramebuffer : pass.framebuffer);
+		glViewport(0, 0, width, height);
+
+		// skip loading what the first write will replace
+		if ((bInvalidate == true) && (pass.bImported == false))
+		{
+			std::vector<GLenum> attachments;
+			GLenum colorAttachment = GL_COLOR_ATTACHMENT0;
+			for (int index : pass.writes)
+			{
+				const TARGET& target = m_targets[index];
+				const bool bDepth = (target.internalFormat == GL_DEPTH_COMPONENT24) ||
+					(target.internalFormat == GL_DEPTH_COMPONENT32F);
+				const GLenum attachment = (bDepth == true) ? GL_DEPTH_ATTACHMENT : colorAttachment++;
+				for (const BARRIER& barrier : pass.barriers)
+				{
+					if ((barrier.target == index) && (barrier.before == ACCESS_NONE))
+					{
+						attachments.push_back(attachment);
+					}
+				}
+			}
+			if (attachments.empty() == false)
+			{
+				glInvalidateFramebuffer(GL_DRAW_FRAMEBUFFER, (GLsizei)attachments.size(), attachments.data());
+			}
+		}
+
+		if (m_bTimings == true)
+		{
+			if (0 == pass.queries[0][0])
+			{
+				glGenQueries(4, &pass.queries[0][0]);
+			}
+			// the timestamps of two frames ago are long finished
+			if (pass.bQueried[slot] == true)
+			{
+				GLuint64 begin = 0;
+				GLuint64 end = 0;
+				glGetQueryObjectui64v(pass.queries[slot][0], GL_QUERY_RESULT, &begin);
+				glGetQueryObjectui64v(pass.queries[slot][1], GL_QUERY_RESULT, &end);
+				pass.totalGpuTime += (double)(end - begin) / 1.0e6;
+				pass.gpuFrames++;
+			}
+			glQueryCounter(pass.queries[slot][0], GL_TIMESTAMP);
+		}
+
+		pass.execute();
+
+		if (m_bTimings == true)
+		{
+			glQueryCounter(pass.queries[slot][1], GL_TIMESTAMP);
+			pass.bQueried[slot] = true;
+			pass.totalCpuTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			pass.cpuFrames++;
+		}
+	}
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)boundFramebuffer);
+	m_frame++;
+}
+
+/***********************************************************
+ *  GetTexture()
+ *
+ *  This method is used to get the texture a transient target
+ *  is drawn into, for the passes that read it.
+ ***********************************************************/
+GLuint RenderGraph::GetTexture(int target) const
+{
+	if ((target < 0) || (target >= (int)m_targets.size()) || (m_targets[target].texture < 0))
+	{
+		return(0);
+	}
+	return(m_pool[m_targets[target].texture].texture);
+}
+
+/***********************************************************
+ *  GetTargetBytes()
+ *
+ *  This method is used to get the memory a target of the
+ *  passed in format takes at the size of the frame.
+ ***********************************************************/
+size_t RenderGraph::GetTargetBytes(GLenum internalFormat) const
+{
+	size_t pixelBytes = 4;
+	switch (internalFormat)
+	{
+	case GL_R8:
+		pixelBytes = 1;
+		break;
+	case GL_R16F:
+		pixelBytes = 2;
+		break;
+	case GL_RGBA16F:
+		pixelBytes = 8;
+		break;
+	case GL_RGBA32F:
+		pixelBytes = 16;
+		break;
+	default:
+		break;
+	}
+	return(pixelBytes * m_width * m_height);
+}
+
+/***********************************************************
+ *  Report()
+ *
+ *  This method is used to print the passes that run and the
+ *  ones culled, the barriers between them, the memory the
+ *  transient targets take with and without aliasing, and,
+ *  when pass timings are on, the average CPU and GPU time
+ *  of each pass.
+ ***********************************************************/
+void RenderGraph::Report() const
+{
+	int passCount = 0;
+	size_t barrierCount = 0;
+	for (const PASS& pass : m_passes)
+	{
+		if (pass.bCulled == false)
+		{
+			passCount++;
+			barrierCount += pass.barriers.size();
+		}
+	}
+
+	// the pool textures all live for the whole frame
+	size_t transientBytes = 0;
+	size_t unaliasedBytes = 0;
+	for (const POOL_TEXTURE& texture : m_pool)
+	{
+		transientBytes += GetTargetBytes(texture.internalFormat);
+	}
+	for (const TARGET& target : m_targets)
+	{
+		if ((target.bImported == false) && (target.texture >= 0))
+		{
+			unaliasedBytes += GetTargetBytes(target.internalFormat);
+		}
+	}
+
+	std::cout << "INFO: Render graph ran " << passCount << " of " << m_passes.size()
+		<< " passes with " << barrierCount << " barriers, peak transient memory "
+		<< transientBytes / (1024.0 * 1024.0) << " MB at " << m_width << "x" << m_height
+		<< " (" << unaliasedBytes / (1024.0 * 1024.0) << " MB without aliasing)" << std::endl;
+
+	for (const PASS& pass : m_passes)
+	{
+		if (pass.bCulled == true)
+		{
+			std::cout << "INFO: Pass " << pass.name << " culled" << std::endl;
+		}
+		else if (pass.cpuFrames > 0)
+		{
+			std::cout << "INFO: Pass " << pass.name << ": "
+				<< pass.totalCpuTime / pass.cpuFrames << " ms CPU, "
+				<< ((pass.gpuFrames > 0) ? (pass.totalGpuTime / pass.gpuFrames) : 0.0) << " ms GPU per frame" << std::endl;
+		}
+	}
+}
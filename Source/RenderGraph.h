@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendergraph.h
+// =============
+// orders the passes of a frame from the render targets they read and write
+//
+// Each pass of a frame declares the render targets it reads - as textures -
+// and writes - as framebuffer attachments - instead of binding framebuffers
+// itself.  Compiling the graph keeps only the passes whose results reach an
+// imported target, the framebuffer the frame is presented from, and works
+// out from the declarations where each target changes from being written to
+// being read.  Transient targets, which only live between two passes of the
+// frame, are given textures from a pool: two targets of the same format
+// whose passes do not overlap share one texture, and a target's old contents
+// are discarded before its first pass writes it, so they are never loaded.
+//
+// When pass timings are on, each pass is timed on the CPU and, with
+// timestamp queries read back two frames later, on the GPU.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  RenderGraph
+ *
+ *  This class holds the passes of a frame and the render
+ *  targets they use, and runs the passes with the targets
+ *  bound.
+ ***********************************************************/
+class RenderGraph
+{
+public:
+	// the work of a pass, run with its framebuffer bound
+	typedef std::function<void()> PASS_FUNCTION;
+
+	// constructor
+	RenderGraph();
+	// destructor
+	~RenderGraph();
+
+	// a target the frame ends up in, which keeps the passes that
+	// write it - the framebuffer bound when the frame starts
+	int ImportTarget(const char* name);
+	// a target of the passed in internal format, at least the size
+	// of the frame, that only lives during the frame - passes read
+	// it by texel, from the corner the frame covers
+	int CreateTarget(const char* name, GLenum internalFormat);
+	// a pass, run in the order the passes are added
+	int AddPass(const char* name, PASS_FUNCTION execute);
+	// the pass samples the target
+	void Read(int pass, int target);
+	// the pass draws into the target - a pass that is not the
+	// first to write a target keeps what is already there
+	void Write(int pass, int target);
+
+	// cull the passes, find the barriers and alias the transient
+	// targets - returns false if the passes cannot be run
+	bool Compile();
+	// run the passes over width x height - the targets are only
+	// made again when the frame is larger than they are
+	void Execute(int width, int height);
+
+	// the texture of a transient target during the frame
+	GLuint GetTexture(int target) const;
+
+	// time each pass from now on
+	void SetTimings(bool bTimings) { m_bTimings = bTimings; }
+	// report the passes, their average times and the memory of
+	// the transient targets
+	void Report() const;
+
+private:
+	// how a pass uses a target
+	enum ACCESS
+	{
+		ACCESS_NONE,
+		ACCESS_READ,
+		ACCESS_WRITE
+	};
+
+	// a change in how a target is used, before a pass runs
+	struct BARRIER
+	{
+		int target;
+		ACCESS before;
+		ACCESS after;
+	};
+
+	struct PASS
+	{
+		std::string name;
+		PASS_FUNCTION execute;
+		std::vector<int> reads;
+		std::vector<int> writes;
+		bool bCulled;
+		// set when the pass draws into the imported framebuffer
+		bool bImported;
+		std::vector<BARRIER> barriers;
+		GLuint framebuffer;
+		// timestamps before and after the pass, of this frame and
+		// of the one before
+		GLuint queries[2][2];
+		bool bQueried[2];
+		double totalCpuTime;
+		double totalGpuTime;
+		int cpuFrames;
+		int gpuFrames;
+	};
+
+	struct TARGET
+	{
+		std::string name;
+		GLenum internalFormat;
+		bool bImported;
+		// passes that first and last use the target
+		int firstPass;
+		int lastPass;
+		// texture of the pool the target is given
+		int texture;
+	};
+
+	// a texture of the pool, shared by targets that do not overlap
+	struct POOL_TEXTURE
+	{
+		GLenum internalFormat;
+		GLuint texture;
+		int lastPass;
+	};
+
+	std::vector<PASS> m_passes;
+	std::vector<TARGET> m_targets;
+	std::vector<POOL_TEXTURE> m_pool;
+	bool m_bCompiled;
+	// size of the pool textures
+	int m_width;
+	int m_height;
+	int m_frame;
+	bool m_bTimings;
+
+	// create the pool textures and pass framebuffers at the passed
+	// in size
+	bool CreateTextures(int width, int height);
+	void DestroyTextures();
+	// bytes a target of the passed in format takes at the size the
+	// textures were created
+	size_t GetTargetBytes(GLenum internalFormat) const;
+};
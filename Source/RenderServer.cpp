@@ -0,0 +1,615 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderserver.cpp
+// ================
+// persistent render server answering camera requests over a UNIX socket
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderServer.h"
+#include "ImageEncoders.h"
+#include "WorkerThreads.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const unsigned int REQUEST_MAGIC = 0x31515352;		// "RSQ1"
+	const unsigned int RESPONSE_MAGIC = 0x31505352;		// "RSP1"
+	const size_t REQUEST_WORDS = 17;
+	const size_t RESPONSE_WORDS = 6;
+	const unsigned int REQUEST_RENDER = 0;
+	const unsigned int REQUEST_SHUTDOWN = 1;
+
+	// rendered images allowed to wait for an encoder before the
+	// render thread waits for one to be taken
+	const size_t MAX_QUEUED_IMAGES = 8;
+	// how often the listener checks whether the server stopped
+	const int ACCEPT_POLL_MILLISECONDS = 100;
+	// the latencies are counted in buckets that grow by a fixed
+	// ratio - eight per doubling from 10 microseconds, up to
+	// almost three minutes - so the percentiles are known to
+	// within 9% however many requests are served
+	const double LATENCY_BUCKET_MINIMUM = 0.01;
+	const int LATENCY_BUCKETS_PER_DOUBLING = 8;
+	const int LATENCY_BUCKET_COUNT = 24 * LATENCY_BUCKETS_PER_DOUBLING;
+
+	// bucket of a latency in milliseconds
+	int GetLatencyBucket(double latency)
+	{
+		if (latency <= LATENCY_BUCKET_MINIMUM)
+		{
+			return(0);
+		}
+		const int bucket = (int)(std::log2(latency / LATENCY_BUCKET_MINIMUM) * LATENCY_BUCKETS_PER_DOUBLING) + 1;
+		return(std::min(bucket, LATENCY_BUCKET_COUNT - 1));
+	}
+
+	// largest latency in milliseconds a bucket counts
+	double GetBucketLatency(int bucket)
+	{
+		return(LATENCY_BUCKET_MINIMUM * std::exp2((double)bucket / LATENCY_BUCKETS_PER_DOUBLING));
+	}
+
+#ifndef _WIN32
+#ifdef MSG_NOSIGNAL
+	// a client that hangs up must not kill the server
+	const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+	const int SEND_FLAGS = 0;
+#endif
+
+	// read exactly size bytes, returning false at the end of
+	// the connection
+	bool ReceiveAll(int socket, unsigned char* pData, size_t size)
+	{
+		while (size > 0)
+		{
+			const ssize_t received = recv(socket, pData, size, 0);
+			if (received <= 0)
+			{
+				return(false);
+			}
+			pData += received;
+			size -= (size_t)received;
+		}
+		return(true);
+	}
+
+	// write exactly size bytes, returning false if the
+	// connection broke
+	bool SendAll(int socket, const unsigned char* pData, size_t size)
+	{
+		while (size > 0)
+		{
+			const ssize_t sent = send(socket, pData, size, SEND_FLAGS);
+			if (sent <= 0)
+			{
+				return(false);
+			}
+			pData += sent;
+			size -= (size_t)sent;
+		}
+		return(true);
+	}
+#endif
+
+	unsigned int GetWord(const unsigned char* pMessage, size_t index)
+	{
+		unsigned int word = 0;
+		memcpy(&word, pMessage + (index * 4), 4);
+		return(word);
+	}
+
+	float GetFloat(const unsigned char* pMessage, size_t index)
+	{
+		float value = 0.0f;
+		memcpy(&value, pMessage + (index * 4), 4);
+		return(value);
+	}
+}
+
+/***********************************************************
+ *  RenderServer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderServer::RenderServer()
+{
+	m_pFrameCache = NULL;
+	m_sceneVersion = 0;
+	m_maxWidth = 0;
+	m_maxHeight = 0;
+	m_bStopping = false;
+	m_bReceived = false;
+	m_latencyCount = 0;
+	m_latencyTotal = 0.0;
+	m_latencyMax = 0.0;
+}
+
+/***********************************************************
+ *  ~RenderServer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderServer::~RenderServer()
+{
+}
+
+/***********************************************************
+ *  SetFrameCache()
+ *
+ *  This method is used for giving the server a cache to look
+ *  requests up in and store the encoded frames into.
+ ***********************************************************/
+void RenderServer::SetFrameCache(FrameCache* pFrameCache, uint64_t sceneVersion)
+{
+	m_pFrameCache = pFrameCache;
+	m_sceneVersion = sceneVersion;
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for listening on the socket, starting
+ *  the encoder threads, and rendering the queued requests in
+ *  order until one asks the server to shut down.  Requests
+ *  still queued then are answered as refused, and every
+ *  thread is finished before the results are reported.
+ ***********************************************************/
+bool RenderServer::Run(
+	const char* socketPath,
+	int maxWidth,
+	int maxHeight,
+	const RENDER_FUNCTION& render,
+	unsigned int encoderThreads)
+{
+#ifdef _WIN32
+	std::cout << "The render server needs UNIX domain sockets, which this build does not have" << std::endl;
+	return(false);
+#else
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		std::cout << "The socket path " << socketPath << " is too long" << std::endl;
+		return(false);
+	}
+	strcpy(address.sun_path, socketPath);
+
+	// a socket file left by an earlier server would fail the bind
+	unlink(socketPath);
+	const int listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if ((listenSocket < 0) ||
+		(bind(listenSocket, (const sockaddr*)&address, sizeof(address)) != 0) ||
+		(listen(listenSocket, SOMAXCONN) != 0))
+	{
+		std::cout << "Could not listen on " << socketPath << ": " << strerror(errno) << std::endl;
+		if (listenSocket >= 0)
+		{
+			close(listenSocket);
+		}
+		return(false);
+	}
+
+	m_maxWidth = maxWidth;
+	m_maxHeight = maxHeight;
+	m_bStopping = false;
+	m_bReceived = false;
+	m_latencyBuckets.assign(LATENCY_BUCKET_COUNT, 0);
+	m_latencyCount = 0;
+	m_latencyTotal = 0.0;
+	m_latencyMax = 0.0;
+
+	// the render thread is one of the hardware threads
+	const unsigned int threadCount = std::max(1u, WorkerThreads::ResolveThreadCount(encoderThreads) - ((encoderThreads == 0) ? 1u : 0u));
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		m_encoders.emplace_back(&RenderServer::EncodeResponses, this);
+	}
+	std::thread listener(&RenderServer::AcceptClients, this, listenSocket);
+
+	std::cout << "INFO: Render server listening on " << socketPath << " for frames up to "
+		<< maxWidth << "x" << maxHeight << " with " << threadCount << " encoder threads" << std::endl;
+
+	while (true)
+	{
+		RENDER_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_renderQueued.wait(lock, [this]() { return(m_renderJobs.empty() == false); });
+			job = std::move(m_renderJobs.front());
+			m_renderJobs.pop_front();
+		}
+
+		// cached frames need no rendering
+		if ((job.status == RENDER_OK) && (job.bShutdown == false) && (job.frame == NULL))
+		{
+			if (render(job.request, job.pixels) == false)
+			{
+				job.status = RENDER_FAILED;
+				job.pixels.clear();
+			}
+		}
+		const bool bShutdown = (job.status == RENDER_OK) && (job.bShutdown == true);
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_encodeTaken.wait(lock, [this]() { return(m_encodeJobs.size() < MAX_QUEUED_IMAGES); });
+			m_encodeJobs.push_back(std::move(job));
+			m_encodeQueued.notify_one();
+		}
+		if (bShutdown == true)
+		{
+			break;
+		}
+	}
+
+	// refuse what is still queued - the readers queue nothing
+	// more once the server is stopping
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+		for (RENDER_JOB& job : m_renderJobs)
+		{
+			job.status = RENDER_SHUTTING_DOWN;
+			m_encodeJobs.push_back(std::move(job));
+		}
+		m_renderJobs.clear();
+	}
+	m_encodeQueued.notify_all();
+	m_responseSent.notify_all();
+
+	listener.join();
+	close(listenSocket);
+	unlink(socketPath);
+
+	// wake the readers still waiting for requests
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (const std::shared_ptr<CLIENT>& pClient : m_clients)
+		{
+			if (pClient->bFinished == false)
+			{
+				shutdown(pClient->socket, SHUT_RD);
+			}
+		}
+	}
+	for (std::thread& encoder : m_encoders)
+	{
+		encoder.join();
+	}
+	m_encoders.clear();
+	for (const std::shared_ptr<CLIENT>& pClient : m_clients)
+	{
+		pClient->reader.join();
+	}
+	m_clients.clear();
+
+	ReportResults();
+	if (NULL != m_pFrameCache)
+	{
+		m_pFrameCache->ReportStatistics();
+	}
+	return(true);
+#endif
+}
+
+/***********************************************************
+ *  AcceptClients()
+ *
+ *  This method is used for accepting connections and giving
+ *  each its own reader thread, joining the readers of the
+ *  connections that have closed as it goes.
+ ***********************************************************/
+void RenderServer::AcceptClients(int listenSocket)
+{
+#ifndef _WIN32
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_bStopping == true)
+			{
+				return;
+			}
+		}
+
+		pollfd listener;
+		listener.fd = listenSocket;
+		listener.events = POLLIN;
+		listener.revents = 0;
+		if (poll(&listener, 1, ACCEPT_POLL_MILLISECONDS) <= 0)
+		{
+			continue;
+		}
+		const int clientSocket = accept(listenSocket, NULL, NULL);
+		if (clientSocket < 0)
+		{
+			continue;
+		}
+#ifdef SO_NOSIGPIPE
+		int noSignal = 1;
+		setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSignal, sizeof(noSignal));
+#endif
+
+		std::shared_ptr<CLIENT> pClient = std::make_shared<CLIENT>();
+		pClient->socket = clientSocket;
+		pClient->nextRequest = 0;
+		pClient->nextResponse = 0;
+		pClient->inFlight = 0;
+		pClient->bBroken = false;
+		pClient->bFinished = false;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_clients.size(); )
+		{
+			if (m_clients[i]->bFinished == true)
+			{
+				m_clients[i]->reader.join();
+				m_clients.erase(m_clients.begin() + i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+		if (m_bStopping == true)
+		{
+			close(clientSocket);
+			return;
+		}
+		pClient->reader = std::thread(&RenderServer::ReadRequests, this, pClient);
+		m_clients.push_back(pClient);
+	}
+#endif
+}
+
+/***********************************************************
+ *  ReadRequests()
+ *
+ *  This method is used for reading one connection's
+ *  requests and queueing them for rendering, pausing while
+ *  MAX_IN_FLIGHT of them are unanswered.  Once the client
+ *  hangs up, or sends a message that is not a request, the
+ *  connection is closed after its last response is sent.
+ ***********************************************************/
+void RenderServer::ReadRequests(std::shared_ptr<CLIENT> pClient)
+{
+#ifndef _WIN32
+	unsigned char message[REQUEST_WORDS * 4];
+	while (ReceiveAll(pClient->socket, message, sizeof(message)))
+	{
+		RENDER_JOB job;
+		job.received = std::chrono::steady_clock::now();
+		job.status = ParseRequest(message, job.request, job.bShutdown);
+		const bool bLost = (GetWord(message, 0) != REQUEST_MAGIC);
+		if ((NULL != m_pFrameCache) && (job.status == RENDER_OK) && (job.bShutdown == false))
+		{
+			job.key = FrameCache::MakeKey(job.request.pose, job.request.width, job.request.height, job.request.format, m_sceneVersion);
+			job.frame = m_pFrameCache->Find(job.key);
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_responseSent.wait(lock, [this, &pClient]() { return((pClient->inFlight < MAX_IN_FLIGHT) || (m_bStopping == true)); });
+		if (m_bStopping == true)
+		{
+			break;
+		}
+		if (m_bReceived == false)
+		{
+			m_firstRequest = job.received;
+			m_bReceived = true;
+		}
+		job.pClient = pClient;
+		job.sequence = pClient->nextRequest++;
+		pClient->inFlight++;
+		m_renderJobs.push_back(std::move(job));
+		m_renderQueued.notify_one();
+
+		// the stream is out of step with the protocol
+		if (bLost == true)
+		{
+			break;
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_responseSent.wait(lock, [&pClient]() { return(pClient->inFlight == 0); });
+	close(pClient->socket);
+	pClient->bFinished = true;
+#endif
+}
+
+/***********************************************************
+ *  ParseRequest()
+ *
+ *  This method is used for decoding a request message and
+ *  checking its type, format and viewport size.
+ ***********************************************************/
+RENDER_STATUS RenderServer::ParseRequest(const unsigned char* pMessage, RENDER_REQUEST& request, bool& bShutdown) const
+{
+	request.id = GetWord(pMessage, 1);
+	request.width = (int)GetWord(pMessage, 3);
+	request.height = (int)GetWord(pMessage, 4);
+	request.format = (RENDER_IMAGE_FORMAT)GetWord(pMessage, 5);
+	request.pose.position = glm::vec3(GetFloat(pMessage, 6), GetFloat(pMessage, 7), GetFloat(pMessage, 8));
+	request.pose.front = glm::vec3(GetFloat(pMessage, 9), GetFloat(pMessage, 10), GetFloat(pMessage, 11));
+	request.pose.up = glm::vec3(GetFloat(pMessage, 12), GetFloat(pMessage, 13), GetFloat(pMessage, 14));
+	request.pose.zoom = GetFloat(pMessage, 15);
+	request.pose.bOrthographic = (GetWord(pMessage, 16) != 0);
+
+	const unsigned int type = GetWord(pMessage, 2);
+	bShutdown = (type == REQUEST_SHUTDOWN);
+	if ((GetWord(pMessage, 0) != REQUEST_MAGIC) ||
+		((type != REQUEST_RENDER) && (type != REQUEST_SHUTDOWN)))
+	{
+		return(RENDER_BAD_REQUEST);
+	}
+	if (bShutdown == true)
+	{
+		return(RENDER_OK);
+	}
+	if (GetWord(pMessage, 5) > RENDER_RGB)
+	{
+		return(RENDER_BAD_REQUEST);
+	}
+	if ((request.width <= 0) || (request.width > m_maxWidth) ||
+		(request.height <= 0) || (request.height > m_maxHeight))
+	{
+		return(RENDER_BAD_VIEWPORT);
+	}
+
+	return(RENDER_OK);
+}
+
+/***********************************************************
+ *  EncodeResponses()
+ *
+ *  This method is used for running one encoder thread.  Each
+ *  image is encoded from its bottom-up readback, then sent
+ *  once the connection's earlier responses have gone out.
+ *  Jobs are taken in the order they were rendered, so the
+ *  response a connection waits for next is always with
+ *  some encoder already.
+ ***********************************************************/
+void RenderServer::EncodeResponses()
+{
+#ifndef _WIN32
+	while (true)
+	{
+		RENDER_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_encodeQueued.wait(lock, [this]() { return((m_encodeJobs.empty() == false) || (m_bStopping == true)); });
+			if (m_encodeJobs.empty())
+			{
+				return;
+			}
+			job = std::move(m_encodeJobs.front());
+			m_encodeJobs.pop_front();
+			m_encodeTaken.notify_one();
+		}
+
+		if ((job.status == RENDER_OK) && (job.frame == NULL) && (job.pixels.empty() == false))
+		{
+			std::shared_ptr<std::vector<unsigned char>> pPayload = std::make_shared<std::vector<unsigned char>>();
+			std::vector<unsigned char>& payload = *pPayload;
+			const ptrdiff_t rowSize = (ptrdiff_t)job.request.width * 4;
+			const unsigned char* pTopRow = job.pixels.data() + ((job.request.height - 1) * rowSize);
+			switch (job.request.format)
+			{
+			case RENDER_PNG:
+				ImageEncoders::EncodePng(pTopRow, job.request.width, job.request.height, -rowSize, payload);
+				break;
+			case RENDER_QOI:
+				ImageEncoders::EncodeQoi(pTopRow, job.request.width, job.request.height, -rowSize, payload);
+				break;
+			default:
+				ImageEncoders::EncodeRgb(pTopRow, job.request.width, job.request.height, -rowSize, payload);
+				break;
+			}
+
+			job.frame = pPayload;
+			if (NULL != m_pFrameCache)
+			{
+				m_pFrameCache->Insert(job.key, job.frame);
+			}
+		}
+		const bool bImage = (job.frame != NULL) && (job.frame->empty() == false);
+		static const std::vector<unsigned char> noPayload;
+		const std::vector<unsigned char>& payload = bImage ? *job.frame : noPayload;
+
+		unsigned int header[RESPONSE_WORDS] = {
+			RESPONSE_MAGIC,
+			job.request.id,
+			(unsigned int)job.status,
+			bImage ? (unsigned int)job.request.width : 0,
+			bImage ? (unsigned int)job.request.height : 0,
+			(unsigned int)payload.size() };
+
+		CLIENT& client = *job.pClient;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_responseSent.wait(lock, [&client, &job]() { return(client.nextResponse == job.sequence); });
+		}
+		// only the encoder whose turn it is touches the connection
+		if (client.bBroken == false)
+		{
+			client.bBroken = (SendAll(client.socket, (const unsigned char*)header, sizeof(header)) == false) ||
+				(SendAll(client.socket, payload.data(), payload.size()) == false);
+		}
+		const double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job.received).count();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if ((client.bBroken == false) && (job.status == RENDER_OK) && (job.bShutdown == false))
+		{
+			m_latencyBuckets[GetLatencyBucket(latency)]++;
+			m_latencyCount++;
+			m_latencyTotal += latency;
+			m_latencyMax = std::max(m_latencyMax, latency);
+		}
+		client.nextResponse++;
+		client.inFlight--;
+		m_responseSent.notify_all();
+	}
+#endif
+}
+
+/***********************************************************
+ *  ReportResults()
+ *
+ *  This method is used for printing the images served per
+ *  second since the first request and the spread of the
+ *  request latencies.
+ ***********************************************************/
+void RenderServer::ReportResults() const
+{
+	const double seconds = m_bReceived ? std::chrono::duration<double>(std::chrono::steady_clock::now() - m_firstRequest).count() : 0.0;
+	std::cout << "INFO: Served " << m_latencyCount << " images in " << seconds << " s, "
+		<< ((seconds > 0.0) ? m_latencyCount / seconds : 0.0) << " requests per second" << std::endl;
+	if (m_latencyCount == 0)
+	{
+		return;
+	}
+
+	std::cout << "INFO: Request latency: mean " << m_latencyTotal / m_latencyCount
+		<< " ms, median " << GetLatencyPercentile(50)
+		<< " ms, 95th percentile " << GetLatencyPercentile(95)
+		<< " ms, 99th percentile " << GetLatencyPercentile(99)
+		<< " ms, max " << m_latencyMax << " ms" << std::endl;
+}
+
+/***********************************************************
+ *  GetLatencyPercentile()
+ *
+ *  This method is used for finding the latency the passed
+ *  in percent of the requests were answered within, from
+ *  the bucket that holds it.  The bucket's largest latency
+ *  is returned, but never more than the largest seen.
+ ***********************************************************/
+double RenderServer::GetLatencyPercentile(int percent) const
+{
+	const size_t rank = ((m_latencyCount - 1) * percent) / 100;
+	size_t counted = 0;
+	for (int bucket = 0; bucket < (int)m_latencyBuckets.size(); bucket++)
+	{
+		counted += m_latencyBuckets[bucket];
+		if (counted > rank)
+		{
+			return(std::min(GetBucketLatency(bucket), m_latencyMax));
+		}
+	}
+	return(m_latencyMax);
+}
@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderserver.h
+// ==============
+// persistent render server answering camera requests over a UNIX socket
+//
+// Launching the program for every image pays for the context, shaders,
+// textures and meshes each time.  The server prepares the scene once and then
+// renders an image for each request it receives on a UNIX domain socket.
+//
+// Every message is made of little-endian 32-bit words.  A request is 17 words:
+//
+//     magic 'RSQ1'  id  type  width  height  format
+//     posX posY posZ  frontX frontY frontZ  upX upY upZ  zoom  ortho
+//
+// where type is 0 to render and 1 to shut the server down, format is 0 for
+// PNG, 1 for QOI and 2 for raw RGB rows (top row first), the vector values
+// and zoom are floats and ortho is 1 for the orthographic projection.  The
+// image is rendered into the lower left width x height corner of the
+// server's framebuffer, so neither may exceed the size it was started with.
+// Each request is answered by a 6 word response header followed by the
+// encoded image:
+//
+//     magic 'RSP1'  id  status  width  height  payloadSize
+//
+// Clients may send many requests without waiting; each connection's
+// responses come back in the order its requests were sent.  Reader threads
+// take requests off the connections, the calling thread, which owns the
+// OpenGL context, renders them one after another, and a pool of encoder
+// threads compresses and sends the images while the next ones render.
+// With a frame cache, requests for a frame it holds skip rendering and
+// encoding and are answered with the stored frame.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameCache.h"
+#include "ViewManager.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// the image formats a request can ask for
+enum RENDER_IMAGE_FORMAT
+{
+	RENDER_PNG,
+	RENDER_QOI,
+	RENDER_RGB
+};
+
+// the status word of a response
+enum RENDER_STATUS
+{
+	RENDER_OK,
+	RENDER_BAD_REQUEST,
+	RENDER_BAD_VIEWPORT,
+	RENDER_FAILED,
+	RENDER_SHUTTING_DOWN
+};
+
+/***********************************************************
+ *  RENDER_REQUEST
+ *
+ *  One image asked for by a client.
+ ***********************************************************/
+struct RENDER_REQUEST
+{
+	unsigned int id;
+	int width;
+	int height;
+	RENDER_IMAGE_FORMAT format;
+	CAMERA_POSE pose;
+};
+
+/***********************************************************
+ *  RenderServer
+ *
+ *  This class accepts render requests on a UNIX socket and
+ *  answers them with encoded images.
+ ***********************************************************/
+class RenderServer
+{
+public:
+	// function that renders a request into the lower left corner
+	// of the framebuffer and reads it back as bottom-up RGBA rows
+	typedef std::function<bool(const RENDER_REQUEST& request, std::vector<unsigned char>& pixels)> RENDER_FUNCTION;
+
+	// requests a connection may have unanswered before the server
+	// stops reading from it
+	static const int MAX_IN_FLIGHT = 16;
+
+	// constructor
+	RenderServer();
+	// destructor
+	~RenderServer();
+
+	// answer repeated requests from a frame cache, storing frames
+	// under the passed in scene version - called before Run()
+	void SetFrameCache(FrameCache* pFrameCache, uint64_t sceneVersion);
+
+	// listen on socketPath and render requests up to the passed
+	// in size on the calling thread until a shutdown request,
+	// then report the requests served per second and latencies
+	bool Run(
+		const char* socketPath,
+		int maxWidth,
+		int maxHeight,
+		const RENDER_FUNCTION& render,
+		unsigned int encoderThreads = 0);
+
+private:
+	// one client connection
+	struct CLIENT
+	{
+		int socket;
+		std::thread reader;
+		// sequence numbers of the next request read and response sent
+		unsigned int nextRequest;
+		unsigned int nextResponse;
+		int inFlight;
+		bool bBroken;
+		bool bFinished;
+	};
+
+	// a request on its way through rendering and encoding
+	struct RENDER_JOB
+	{
+		std::shared_ptr<CLIENT> pClient;
+		unsigned int sequence;
+		RENDER_REQUEST request;
+		RENDER_STATUS status;
+		bool bShutdown;
+		std::chrono::steady_clock::time_point received;
+		// the rendered pixels, or the encoded frame once known
+		std::vector<unsigned char> pixels;
+		FRAME_KEY key;
+		CACHED_FRAME frame;
+	};
+
+	FrameCache* m_pFrameCache;
+	uint64_t m_sceneVersion;
+	int m_maxWidth;
+	int m_maxHeight;
+	bool m_bStopping;
+
+	// connections, threads and queues, all guarded by m_mutex
+	std::vector<std::shared_ptr<CLIENT>> m_clients;
+	std::vector<std::thread> m_encoders;
+	std::deque<RENDER_JOB> m_renderJobs;
+	std::deque<RENDER_JOB> m_encodeJobs;
+	std::mutex m_mutex;
+	std::condition_variable m_renderQueued;
+	std::condition_variable m_encodeQueued;
+	std::condition_variable m_encodeTaken;
+	std::condition_variable m_responseSent;
+
+	// milliseconds from receiving each request to answering it,
+	// counted in a histogram of fixed size so a server that runs
+	// for a long time does not keep every request's latency
+	std::vector<size_t> m_latencyBuckets;
+	size_t m_latencyCount;
+	double m_latencyTotal;
+	double m_latencyMax;
+	std::chrono::steady_clock::time_point m_firstRequest;
+	bool m_bReceived;
+
+	// accept connections until the server stops
+	void AcceptClients(int listenSocket);
+	// read and queue the requests of one connection
+	void ReadRequests(std::shared_ptr<CLIENT> pClient);
+	// decode a request, returning the status it is answered with
+	RENDER_STATUS ParseRequest(const unsigned char* pMessage, RENDER_REQUEST& request, bool& bShutdown) const;
+	// the loop each encoder thread runs
+	void EncodeResponses();
+	// print the requests per second and the latencies
+	void ReportResults() const;
+	// latency the passed in percent of the requests were answered
+	// within - called with requests counted
+	double GetLatencyPercentile(int percent) const;
+};
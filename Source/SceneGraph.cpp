@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ==============
+// parent/child transform hierarchy with dirty-flag incremental updates
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+// declaration of global variables
+namespace
+{
+	// insert a value into a vector at the passed in position
+	template <typename T>
+	void InsertAt(std::vector<T>& values, int index, const T& value)
+	{
+		values.insert(values.begin() + index, value);
+	}
+}
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+	m_lastUpdateCount = 0;
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a node at the end of its
+ *  parent's subtree, which keeps the arrays in depth-first
+ *  order.  Nodes are normally added once while the scene is
+ *  prepared, so the cost of shifting the arrays is not paid
+ *  per frame.
+ ***********************************************************/
+int SceneGraph::AddNode(
+	int parentHandle,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	int parentIndex = NO_PARENT;
+	int index = (int)m_parents.size();
+
+	if (parentHandle != NO_PARENT)
+	{
+		parentIndex = m_handleToIndex[parentHandle];
+		index = parentIndex + m_subtreeSizes[parentIndex];
+
+		// every ancestor's subtree grows by the new node
+		for (int ancestor = parentIndex; ancestor != NO_PARENT; ancestor = m_parents[ancestor])
+		{
+			m_subtreeSizes[ancestor]++;
+		}
+	}
+
+	// nodes after the insertion point move down by one
+	for (int i = 0; i < (int)m_parents.size(); i++)
+	{
+		if (m_parents[i] >= index)
+		{
+			m_parents[i]++;
+		}
+	}
+	for (int& nodeIndex : m_handleToIndex)
+	{
+		if (nodeIndex >= index)
+		{
+			nodeIndex++;
+		}
+	}
+
+	InsertAt(m_local.scaleX, index, scaleXYZ.x);
+	InsertAt(m_local.scaleY, index, scaleXYZ.y);
+	InsertAt(m_local.scaleZ, index, scaleXYZ.z);
+	InsertAt(m_local.rotationX, index, XrotationDegrees);
+	InsertAt(m_local.rotationY, index, YrotationDegrees);
+	InsertAt(m_local.rotationZ, index, ZrotationDegrees);
+	InsertAt(m_local.positionX, index, positionXYZ.x);
+	InsertAt(m_local.positionY, index, positionXYZ.y);
+	InsertAt(m_local.positionZ, index, positionXYZ.z);
+	OBJECT_TRANSFORM identity;
+	identity.model = glm::mat4(1.0f);
+	identity.normal = glm::mat4(1.0f);
+	InsertAt(m_localTransforms, index, identity);
+	InsertAt(m_worldTransforms, index, identity);
+	InsertAt(m_parents, index, parentIndex);
+	InsertAt(m_subtreeSizes, index, 1);
+	InsertAt(m_dirty, index, (unsigned char)1);
+
+	int handle = (int)m_handleToIndex.size();
+	m_handleToIndex.push_back(index);
+
+	return(handle);
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for replacing the transform of a node
+ *  relative to its parent and marking it dirty.
+ ***********************************************************/
+void SceneGraph::SetLocalTransform(
+	int handle,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	int index = m_handleToIndex[handle];
+
+	m_local.Set(index, scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	m_dirty[index] = 1;
+}
+
+/***********************************************************
+ *  SetLocalPosition()
+ *
+ *  This method is used for moving a node relative to its
+ *  parent and marking it dirty.
+ ***********************************************************/
+void SceneGraph::SetLocalPosition(int handle, glm::vec3 positionXYZ)
+{
+	int index = m_handleToIndex[handle];
+
+	m_local.positionX[index] = positionXYZ.x;
+	m_local.positionY[index] = positionXYZ.y;
+	m_local.positionZ[index] = positionXYZ.z;
+	m_dirty[index] = 1;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for re-deriving the world matrices.
+ *  Runs of dirty nodes have their local matrices recomposed
+ *  with the batched kernel, then every node inside a dirty
+ *  subtree is rebuilt from its parent's world matrices.  The
+ *  inverse-transpose of a product is the product of the
+ *  inverse-transposes, so normal matrices chain the same way
+ *  as model matrices.  Clean subtrees are not touched.
+ ***********************************************************/
+void SceneGraph::Update()
+{
+	const int nodeCount = (int)m_parents.size();
+
+	// recompose the local matrices of the dirty nodes
+	int runStart = 0;
+	while (runStart < nodeCount)
+	{
+		if (m_dirty[runStart] == 0)
+		{
+			runStart++;
+			continue;
+		}
+
+		int runEnd = runStart + 1;
+		while ((runEnd < nodeCount) && (m_dirty[runEnd] != 0))
+		{
+			runEnd++;
+		}
+		ComposeTransformBatch(m_local, runStart, runEnd - runStart, &m_localTransforms[runStart]);
+		runStart = runEnd;
+	}
+
+	// rebuild the world matrices of every dirty subtree
+	m_lastUpdateCount = 0;
+	int index = 0;
+	while (index < nodeCount)
+	{
+		if (m_dirty[index] == 0)
+		{
+			index++;
+			continue;
+		}
+
+		const int subtreeEnd = index + m_subtreeSizes[index];
+		for (int node = index; node < subtreeEnd; node++)
+		{
+			const int parent = m_parents[node];
+			if (parent == NO_PARENT)
+			{
+				m_worldTransforms[node] = m_localTransforms[node];
+			}
+			else
+			{
+				m_worldTransforms[node].model = m_worldTransforms[parent].model * m_localTransforms[node].model;
+				m_worldTransforms[node].normal = m_worldTransforms[parent].normal * m_localTransforms[node].normal;
+			}
+			m_dirty[node] = 0;
+		}
+		m_lastUpdateCount += subtreeEnd - index;
+		index = subtreeEnd;
+	}
+}
+
+/***********************************************************
+ *  GetWorldTransform()
+ *
+ *  This method is used for getting the world model and normal
+ *  matrices of the node associated with the passed in handle.
+ ***********************************************************/
+const OBJECT_TRANSFORM& SceneGraph::GetWorldTransform(int handle) const
+{
+	return(m_worldTransforms[m_handleToIndex[handle]]);
+}
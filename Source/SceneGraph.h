@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// parent/child transform hierarchy with dirty-flag incremental updates
+//
+// Nodes are kept flattened in depth-first order, so every subtree occupies a
+// contiguous range of the arrays and a parent always precedes its children.
+// Moving a node marks it dirty; Update() then re-derives only the world
+// matrices inside the dirty subtrees with one forward pass.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TransformBatch.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class SceneGraph
+{
+public:
+	// constructor
+	SceneGraph();
+
+	// value used for a node without a parent
+	static const int NO_PARENT = -1;
+
+	// add a node under the passed in parent (or NO_PARENT) with a
+	// transform relative to the parent, and return its handle
+	int AddNode(
+		int parentHandle,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// replace the transform of a node relative to its parent
+	void SetLocalTransform(
+		int handle,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// move a node relative to its parent, keeping scale and rotation
+	void SetLocalPosition(int handle, glm::vec3 positionXYZ);
+
+	// re-derive the world matrices of all dirty subtrees
+	void Update();
+
+	// world model and normal matrices of a node as of the last Update()
+	const OBJECT_TRANSFORM& GetWorldTransform(int handle) const;
+
+	// number of nodes whose world matrix was rebuilt by the last Update()
+	int GetLastUpdateCount() const { return(m_lastUpdateCount); }
+
+private:
+	// local transform values, structure-of-arrays in depth-first order
+	TRANSFORM_BATCH m_local;
+	// composed local matrices, in depth-first order
+	std::vector<OBJECT_TRANSFORM> m_localTransforms;
+	// world matrices, in depth-first order
+	std::vector<OBJECT_TRANSFORM> m_worldTransforms;
+	// parent index of each node, always less than the node index
+	std::vector<int> m_parents;
+	// number of nodes in the subtree rooted at each node, itself included
+	std::vector<int> m_subtreeSizes;
+	// set when the local transform of a node has changed
+	std::vector<unsigned char> m_dirty;
+	// stable handles mapped to the current node index
+	std::vector<int> m_handleToIndex;
+	// number of nodes rebuilt by the last update
+	int m_lastUpdateCount;
+};
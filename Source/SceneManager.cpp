@@ -24,6 +24,10 @@
 
 
 #include "SceneManager.h"
+#include "ClusterAtlas.h"
+#include "SharedImages.h"
+#include "FrameCache.h"
+#include "MeshCache.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -32,15 +36,85 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
 
 // declaration of global variables
 namespace
 {
 	const char* g_ModelName = "model";
+	const char* g_NormalMatrixName = "normalMatrix";
 	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_ClusterAtlasTag = "cluster_atlas";
+
+	// whether the shader lights the scene, and the lights it is
+	// lit with - the point lights and spot light left out are
+	// switched off
+	const bool g_bUseLighting = true;
+	const SHADER_LIGHT g_DirectionalLight =
+		{ {}, { -0.05f, -0.3f, -0.1f }, { 0.18f, 0.18f, 0.18f }, { 0.6f, 0.6f, 0.6f }, { 0.0f, 0.0f, 0.0f }, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, true };
+	const SHADER_LIGHT g_PointLights[] =
+	{
+		{ { -15.0f, 17.0f, 5.0f }, {}, { 0.2f, 0.2f, 0.2f }, { 0.7f, 0.7f, 0.7f }, { 0.1f, 0.1f, 0.1f }, 1.0f, 0.09f, 0.032f, 0.0f, 0.0f, true },
+		{ { 15.0f, 17.0f, 5.0f }, {}, { 0.05f, 0.05f, 0.05f }, { 0.3f, 0.3f, 0.3f }, { 0.1f, 0.1f, 0.1f }, 1.0f, 0.09f, 0.032f, 0.0f, 0.0f, true },
+		{ { -15.0f, 17.0f, 6.0f }, {}, { 0.05f, 0.05f, 0.05f }, { 0.2f, 0.2f, 0.2f }, { 0.8f, 0.8f, 0.8f }, 1.0f, 0.09f, 0.032f, 0.0f, 0.0f, true },
+		{ { 15.0f, 17.0f, 6.0f }, {}, { 0.05f, 0.05f, 0.05f }, { 0.2f, 0.2f, 0.2f }, { 0.8f, 0.8f, 0.8f }, 1.0f, 0.09f, 0.032f, 0.0f, 0.0f, true },
+	};
+
+	// image files of the scene textures and the tags they are
+	// found by
+	struct TEXTURE_FILE
+	{
+		const char* filename;
+		const char* tag;
+	};
+	const TEXTURE_FILE g_TextureFiles[] =
+	{
+		{ "textures/dark_wood_floor.JPG", "floor" },
+		{ "textures/shiplap.JPG", "shiplap" },
+		{ "textures/bricks.JPG", "brick" },
+		{ "textures/Wood_mantle.JPG", "mantle" },
+		{ "textures/black_metal.JPG", "metal" },
+		{ "textures/black_metal2.JPG", "metal2" },
+		{ "textures/pine_bark.JPG", "bark" },
+		{ "textures/Tree_end.JPG", "tree_end" },
+		{ "textures/rusticwood.JPG", "rusticwood" },
+		{ "textures/Leaf.JPG", "leaf" },
+		{ "textures/BLUEY.JPG", "cartoon" },
+	};
+
+	// the shader values left after a group of draws that started
+	// from the before values and set the flagged group values
+	SceneManager::DRAW_APPEARANCE CombineAppearance(
+		const SceneManager::DRAW_APPEARANCE& before,
+		const SceneManager::DRAW_APPEARANCE& group)
+	{
+		SceneManager::DRAW_APPEARANCE combined = before;
+		if (group.bColorSet == true)
+		{
+			combined.color = group.color;
+		}
+		if (group.bTextureSet == true)
+		{
+			combined.textureTag = group.textureTag;
+		}
+		if ((group.bColorSet == true) || (group.bTextureSet == true))
+		{
+			combined.bTextured = group.bTextured;
+		}
+		if (group.bUVScaleSet == true)
+		{
+			combined.uvScale = group.uvScale;
+		}
+		if (group.bMaterialSet == true)
+		{
+			combined.materialTag = group.materialTag;
+		}
+		return(combined);
+	}
 }
 
 /***********************************************************
@@ -51,15 +125,48 @@ namespace
 SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_basicMeshes = new SceneMeshes(pShaderManager);
+	m_pipelineStates = new PipelineStates(pShaderManager);
+	m_basicMeshes->SetPipelineStates(m_pipelineStates);
+	for (int program = 0; program < PROGRAM_VARIANT_COUNT; program++)
+	{
+		for (int blend = 0; blend < BLEND_MODE_COUNT; blend++)
+		{
+			m_drawStates[program][blend] = -1;
+		}
+	}
+	m_bTransparentAppearance = false;
+	m_transparentBlend = BLEND_ALPHA;
 
 	//initialize the texture collection
 	for (int i = 0; i < 16; i++)
 	{
 		m_textureIDs[i].tag = "/0";
 		m_textureIDs[i].ID = -1;
+		m_textureIDs[i].bAlpha = false;
 	}
 	m_loadedTextures = 0;
+
+	// the shader starts with its default uniform values
+	m_appearance.color = glm::vec4(0.0f);
+	m_appearance.bTextured = false;
+	m_appearance.uvScale = glm::vec2(1.0f, 1.0f);
+	m_appearance.bColorSet = false;
+	m_appearance.bTextureSet = false;
+	m_appearance.bUVScaleSet = false;
+	m_appearance.bMaterialSet = false;
+	m_bRecording = false;
+
+	m_bClusters = true;
+	m_sceneRevision = 0;
+	OBJECT_CLUSTER noCluster;
+	noCluster.mesh = -1;
+	noCluster.rootNode = SceneGraph::NO_PARENT;
+	noCluster.finalAppearance = m_appearance;
+	m_fireBoxCluster = noCluster;
+	m_leftTreeCluster = noCluster;
+	m_rightTreeCluster = noCluster;
+	m_woodenBowlCluster = noCluster;
 }
 
 /***********************************************************
@@ -76,6 +183,11 @@ SceneManager::~SceneManager()
 		delete m_basicMeshes;
 		m_basicMeshes = NULL;
 	}
+	if (NULL != m_pipelineStates)
+	{
+		delete m_pipelineStates;
+		m_pipelineStates = NULL;
+	}
 
 	// free the allocated OpenGL textures
 	DestroyGLTextures();
@@ -95,17 +207,32 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	int height = 0;
 	int colorChannels = 0;
 	GLuint textureID = 0;
+	unsigned char* image = NULL;
 
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
+	// use the image a batch render decoded into shared memory,
+	// if there is one, instead of decoding the file again
+	SHARED_IMAGE sharedImage;
+	const bool bShared = SharedImages::Find(filename, sharedImage);
+	if (bShared == true)
+	{
+		width = sharedImage.width;
+		height = sharedImage.height;
+		colorChannels = sharedImage.channels;
+		image = (unsigned char*)sharedImage.pixels;
+	}
+	else
+	{
+		// indicate to always flip images vertically when loaded
+		stbi_set_flip_vertically_on_load(true);
+
+		// try to parse the image data from the specified image file
+		image = stbi_load(
+			filename,
+			&width,
+			&height,
+			&colorChannels,
+			0);
+	}
 
 	// if the image was successfully read from the image file
 	if (image)
@@ -138,12 +265,16 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		glGenerateMipmap(GL_TEXTURE_2D);
 
 		// free the image data from local memory
-		stbi_image_free(image);
+		if (bShared == false)
+		{
+			stbi_image_free(image);
+		}
 		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
 
 		// register the loaded texture and associate it with the special tag string
 		m_textureIDs[m_loadedTextures].ID = textureID;
 		m_textureIDs[m_loadedTextures].tag = tag;
+		m_textureIDs[m_loadedTextures].bAlpha = (colorChannels == 4);
 		m_loadedTextures++;
 
 		return true;
@@ -302,9 +433,63 @@ void SceneManager::SetTransformations(
 
 	modelView = translation * rotationZ * rotationY * rotationX * scale;
 
+	// the normal matrix is the inverse-transpose of rotation * scale,
+	// which is the rotation times the reciprocal scale
+	glm::vec3 inverseScale(
+		(scaleXYZ.x != 0.0f) ? 1.0f / scaleXYZ.x : 1.0f,
+		(scaleXYZ.y != 0.0f) ? 1.0f / scaleXYZ.y : 1.0f,
+		(scaleXYZ.z != 0.0f) ? 1.0f / scaleXYZ.z : 1.0f);
+	glm::mat4 normalMatrix = rotationZ * rotationY * rotationX * glm::scale(inverseScale);
+
+	// the level of detail of the next mesh depends on its placement
+	m_basicMeshes->SetModelMatrix(modelView);
+
 	if (NULL != m_pShaderManager)
 	{
 		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		m_pShaderManager->setMat4Value(g_NormalMatrixName, normalMatrix);
+	}
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  from a model matrix that was composed at compile time,
+ *  so no matrix math is done per frame for static objects.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	const BAKED_TRANSFORM& transform)
+{
+	glm::mat4 model = glm::make_mat4(transform.model);
+
+	// the level of detail of the next mesh depends on its placement
+	m_basicMeshes->SetModelMatrix(model);
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setMat4Value(g_ModelName, model);
+		m_pShaderManager->setMat4Value(g_NormalMatrixName, glm::make_mat4(transform.normal));
+	}
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  from model and normal matrices that were already composed,
+ *  such as a world transform from the scene graph.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	const OBJECT_TRANSFORM& transform)
+{
+	// the level of detail of the next mesh depends on its placement
+	m_basicMeshes->SetModelMatrix(transform.model);
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setMat4Value(g_ModelName, transform.model);
+		m_pShaderManager->setMat4Value(g_NormalMatrixName, transform.normal);
 	}
 }
 
@@ -312,7 +497,9 @@ void SceneManager::SetTransformations(
  *  SetShaderColor()
  *
  *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  into the shader for the next draw command, and selecting
+ *  the colored pipeline state, which only blends a color
+ *  that is not opaque.
  ***********************************************************/
 void SceneManager::SetShaderColor(
 	float redColorValue,
@@ -330,28 +517,56 @@ void SceneManager::SetShaderColor(
 
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
 		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
 	}
+
+	m_appearance.color = currentColor;
+	m_appearance.bTextured = false;
+	m_appearance.bColorSet = true;
+	m_bTransparentAppearance = (alphaValue < 1.0f);
+	SelectPipelineState();
+	RecordAppearance();
 }
 
 /***********************************************************
  *  SetShaderTexture()
  *
  *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  associated with the passed in ID into the shader, and
+ *  selecting the textured pipeline state, which only blends
+ *  a texture with an alpha channel.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
 	std::string textureTag)
 {
+	int textureID = -1;
+	textureID = FindTextureSlot(textureTag);
+
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
 		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
 	}
+
+	m_appearance.textureTag = textureTag;
+	m_appearance.bTextured = true;
+	m_appearance.bTextureSet = true;
+	m_bTransparentAppearance = (textureID >= 0) && (m_textureIDs[textureID].bAlpha == true);
+	SelectPipelineState();
+	RecordAppearance();
+}
+
+/***********************************************************
+ *  SelectPipelineState()
+ *
+ *  This method is used for selecting the pipeline state of
+ *  the next draw, from whether it is textured and whether
+ *  its color or texture is transparent.
+ ***********************************************************/
+void SceneManager::SelectPipelineState()
+{
+	const PROGRAM_VARIANT program = m_appearance.bTextured ? PROGRAM_TEXTURED : PROGRAM_COLORED;
+	const BLEND_MODE blend = m_bTransparentAppearance ? m_transparentBlend : BLEND_OPAQUE;
+	m_pipelineStates->Select(m_drawStates[program][blend]);
 }
 
 /***********************************************************
@@ -366,6 +581,10 @@ void SceneManager::SetTextureUVScale(float u, float v)
 	{
 		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
 	}
+
+	m_appearance.uvScale = glm::vec2(u, v);
+	m_appearance.bUVScaleSet = true;
+	RecordAppearance();
 }
 
 /***********************************************************
@@ -388,7 +607,94 @@ void SceneManager::SetShaderMaterial(
 			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
 			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
 			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+
+			m_appearance.materialTag = materialTag;
+			m_appearance.bMaterialSet = true;
+			RecordAppearance();
+		}
+	}
+}
+
+/***********************************************************
+ *  ApplyAppearance()
+ *
+ *  This method is used for setting every shader value of a
+ *  saved appearance, in the order that leaves the color or
+ *  the texture in use as it was.
+ ***********************************************************/
+void SceneManager::ApplyAppearance(const DRAW_APPEARANCE& appearance)
+{
+	if (appearance.bTextured == true)
+	{
+		SetShaderColor(appearance.color.r, appearance.color.g, appearance.color.b, appearance.color.a);
+		SetShaderTexture(appearance.textureTag);
+	}
+	else
+	{
+		if (appearance.textureTag.empty() == false)
+		{
+			SetShaderTexture(appearance.textureTag);
 		}
+		SetShaderColor(appearance.color.r, appearance.color.g, appearance.color.b, appearance.color.a);
+	}
+
+	SetTextureUVScale(appearance.uvScale.x, appearance.uvScale.y);
+	if (appearance.materialTag.empty() == false)
+	{
+		SetShaderMaterial(appearance.materialTag);
+	}
+}
+
+/***********************************************************
+ *  BeginRecording()
+ *
+ *  This method is used for capturing the draws of a group
+ *  of objects instead of drawing them.  The set flags of
+ *  the current shader values are cleared, so at the end
+ *  they show which values the group itself changed.
+ ***********************************************************/
+void SceneManager::BeginRecording()
+{
+	m_appearance.bColorSet = false;
+	m_appearance.bTextureSet = false;
+	m_appearance.bUVScaleSet = false;
+	m_appearance.bMaterialSet = false;
+
+	m_recordedAppearances.clear();
+	m_basicMeshes->BeginRecording();
+	m_bRecording = true;
+	// draws made before the group sets any value use the
+	// values it started with
+	RecordAppearance();
+}
+
+/***********************************************************
+ *  EndRecording()
+ *
+ *  This method is used for returning the draws captured
+ *  since BeginRecording(), along with the shader values
+ *  the group leaves behind.
+ ***********************************************************/
+std::vector<SceneMeshes::RECORDED_DRAW> SceneManager::EndRecording(DRAW_APPEARANCE& finalAppearance)
+{
+	m_bRecording = false;
+	finalAppearance = m_appearance;
+	return(m_basicMeshes->EndRecording());
+}
+
+/***********************************************************
+ *  RecordAppearance()
+ *
+ *  This method is used for saving the current shader values
+ *  while recording and tagging the draws that follow with
+ *  them.
+ ***********************************************************/
+void SceneManager::RecordAppearance()
+{
+	if (m_bRecording == true)
+	{
+		m_recordedAppearances.push_back(m_appearance);
+		m_basicMeshes->SetRecordedAppearance((int)m_recordedAppearances.size() - 1);
 	}
 }
 
@@ -493,54 +799,29 @@ void SceneManager::SetupSceneLights()
 	/*** in the OpenGL Sample for help                              ***/
 
 	// Enable lighting in the shader
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
+	m_pShaderManager->setBoolValue(g_UseLightingName, g_bUseLighting);
 
 	// Directional light setup
-	m_pShaderManager->setVec3Value("directionalLight.direction", -0.05f, -0.3f, -0.1f);
-	m_pShaderManager->setVec3Value("directionalLight.ambient", .18f, .18f, .18f);
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 0.6f, 0.6f, 0.6f);
-	m_pShaderManager->setVec3Value("directionalLight.specular", 0.0f, 0.0f, 0.0f);
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
-
-	// Point light 1
-	m_pShaderManager->setVec3Value("pointLights[0].position", -15.0f, 17.0f, 5.0f);
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", 0.7f, 0.7f, 0.7f);
-	m_pShaderManager->setVec3Value("pointLights[0].specular", 0.1f, 0.1f, 0.1f);
-	m_pShaderManager->setFloatValue("pointLights[0].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[0].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[0].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[0].bActive", true);
-
-	// Point light 2
-	m_pShaderManager->setVec3Value("pointLights[1].position", 15.0f, 17.0f, 5.0f);
-	m_pShaderManager->setVec3Value("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[1].diffuse", 0.3f, 0.3f, 0.3f);
-	m_pShaderManager->setVec3Value("pointLights[1].specular", 0.1f, 0.1f, 0.1f);
-	m_pShaderManager->setFloatValue("pointLights[1].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[1].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[1].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[1].bActive", true);
-
-	// Point light 3
-	m_pShaderManager->setVec3Value("pointLights[2].position", -15.0f, 17.0f, 6.0f);
-	m_pShaderManager->setVec3Value("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[2].diffuse", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setVec3Value("pointLights[2].specular", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setFloatValue("pointLights[2].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[2].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[2].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[2].bActive", true);
-
-	// Point light 4
-	m_pShaderManager->setVec3Value("pointLights[3].position", 15.0f, 17.0f, 6.0f);
-	m_pShaderManager->setVec3Value("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[3].diffuse", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setVec3Value("pointLights[3].specular", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setFloatValue("pointLights[3].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[3].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[3].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[3].bActive", true);
+	m_pShaderManager->setVec3Value("directionalLight.direction", g_DirectionalLight.direction);
+	m_pShaderManager->setVec3Value("directionalLight.ambient", g_DirectionalLight.ambient);
+	m_pShaderManager->setVec3Value("directionalLight.diffuse", g_DirectionalLight.diffuse);
+	m_pShaderManager->setVec3Value("directionalLight.specular", g_DirectionalLight.specular);
+	m_pShaderManager->setBoolValue("directionalLight.bActive", g_DirectionalLight.bActive);
+
+	// Point lights 1 to 4, from the table the software rasterizer
+	// is lit with as well
+	for (int i = 0; i < (int)(sizeof(g_PointLights) / sizeof(g_PointLights[0])); i++)
+	{
+		const std::string name = "pointLights[" + std::to_string(i) + "].";
+		m_pShaderManager->setVec3Value(name + "position", g_PointLights[i].position);
+		m_pShaderManager->setVec3Value(name + "ambient", g_PointLights[i].ambient);
+		m_pShaderManager->setVec3Value(name + "diffuse", g_PointLights[i].diffuse);
+		m_pShaderManager->setVec3Value(name + "specular", g_PointLights[i].specular);
+		m_pShaderManager->setFloatValue(name + "constant", g_PointLights[i].constant);
+		m_pShaderManager->setFloatValue(name + "linear", g_PointLights[i].linear);
+		m_pShaderManager->setFloatValue(name + "quadratic", g_PointLights[i].quadratic);
+		m_pShaderManager->setBoolValue(name + "bActive", g_PointLights[i].bActive);
+	}
 
 	/*// Point light 5
 	m_pShaderManager->setVec3Value("pointLights[4].position", -3.2f, 6.0f, -4.0f);
@@ -568,58 +849,44 @@ void SceneManager::SetupSceneLights()
  *
  *  This method is used for preparing the 3D scene by loading
  *  the shapes, textures in memory to support the 3D scene
- *  rendering
+ *  rendering.  The textures that load are still bound when
+ *  another one fails, and the failure is returned.
  ***********************************************************/
-void SceneManager::LoadSceneTextures()
+bool SceneManager::LoadSceneTextures()
 {
-	bool bReturn = false;
-
-	
-	bReturn = CreateGLTexture(
-		"textures/dark_wood_floor.JPG",
-		"floor");
+	bool bReturn = true;
 
-	bReturn = CreateGLTexture(
-		"textures/shiplap.JPG",
-		"shiplap");
-
-	bReturn = CreateGLTexture(
-		"textures/bricks.JPG",
-		"brick");
-
-	bReturn = CreateGLTexture(
-		"textures/Wood_mantle.JPG",
-		"mantle");
-
-	bReturn = CreateGLTexture(
-		"textures/black_metal.JPG",
-		"metal");
-
-	bReturn = CreateGLTexture(         
-		"textures/black_metal2.JPG",
-		"metal2");
-
-	bReturn = CreateGLTexture(
-		"textures/pine_bark.JPG",
-		"bark");
-	
-	bReturn = CreateGLTexture(
-		"textures/Tree_end.JPG", 
-		"tree_end");
+	for (const TEXTURE_FILE& texture : g_TextureFiles)
+	{
+		if (CreateGLTexture(
+			texture.filename,
+			texture.tag) == false)
+		{
+			std::cout << "Texture " << texture.tag << " is missing from the scene" << std::endl;
+			bReturn = false;
+		}
+	}
 
-	bReturn = CreateGLTexture(
-		"textures/rusticwood.JPG",
-		"rusticwood");
+	BindGLTextures();
 
-	bReturn = CreateGLTexture(
-		"textures/Leaf.JPG",
-		"leaf");
+	return(bReturn);
+}
 
-	bReturn = CreateGLTexture(
-		"textures/BLUEY.JPG",
-		"cartoon");
+/***********************************************************
+ *  GetTextureFilenames()
+ *
+ *  This method is used for getting the image files of the
+ *  scene textures, so they can be decoded ahead of time.
+ ***********************************************************/
+std::vector<std::string> SceneManager::GetTextureFilenames()
+{
+	std::vector<std::string> filenames;
+	for (const TEXTURE_FILE& texture : g_TextureFiles)
+	{
+		filenames.push_back(texture.filename);
+	}
 
-	BindGLTextures();
+	return(filenames);
 }
 
 /***********************************************************
@@ -629,11 +896,11 @@ void SceneManager::LoadSceneTextures()
  *  the shapes, textures in memory to support the 3D scene 
  *  rendering
  ***********************************************************/
-void SceneManager::PrepareScene()
+bool SceneManager::PrepareScene()
 {
 	// load the texture image files for the textures applied
 	// to objects in the 3D scene
-	LoadSceneTextures();
+	const bool bTexturesLoaded = LoadSceneTextures();
 	// define the materials that will be used for the objects
 	// in the 3D scene
 	DefineObjectMaterials();
@@ -650,144 +917,717 @@ void SceneManager::PrepareScene()
 	m_basicMeshes->LoadTorusMesh();
 	m_basicMeshes->LoadSphereMesh();
 	m_basicMeshes->LoadConeMesh();
-	m_basicMeshes->DrawExtraTorusMesh1();
-	m_basicMeshes->DrawExtraTorusMesh2();
 
-		
+	// build the transform hierarchy for the composite objects
+	BuildSceneGraph();
+	// merge the object groups into cluster meshes, which are
+	// uploaded with the shapes
+	if (m_bClusters == true)
+	{
+		BuildClusters();
+	}
+
+	// all of the loaded meshes share one vertex and index buffer
+	m_basicMeshes->UploadMeshes();
+
+	// the draws switch between states that are checked once here
+	CreatePipelineStates();
+
+	return(bTexturesLoaded);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  CreatePipelineStates()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for creating a pipeline state for
+ *  each program variant and blend mode the draws are made
+ *  with, each with a front culling variant for the impostor
+ *  proxy boxes, and validating them against the shader
+ *  program and the shared vertex array.  Opaque draws are
+ *  made with blending off, which gives the same pixels and
+ *  does not read the framebuffer.  The weighted transparent
+ *  draws test depth without writing it, so surfaces behind
+ *  them still add to the blend, and are only created when
+ *  the context can blend them.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::CreatePipelineStates()
 {
-	RenderWall();
-	RenderFireBox();
-	RenderTrees();
-	RenderWoodenBowl();
-	/****************************************************************/
-
-	//Plane for Floor surface
-	//set the XYZ scale for the mesh
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//SetShaderColor(0.627, 0.322, 0.176, 1);
-	SetShaderTexture("floor");
-	SetTextureUVScale(1, 1);
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
+	const char* stateNames[PROGRAM_VARIANT_COUNT][BLEND_MODE_COUNT] =
+	{
+		{ "opaque colored", "blended colored", "weighted colored" },
+		{ "opaque textured", "blended textured", "weighted textured" },
+	};
 
-	// Baseboards for scene.
-		//set the XYZ scale for the mesh
-	
+	for (int program = 0; program < PROGRAM_VARIANT_COUNT; program++)
+	{
+		for (int blend = 0; blend < BLEND_MODE_COUNT; blend++)
+		{
+			if ((blend == BLEND_WEIGHTED) && (PipelineStates::SupportsWeightedBlend() == false))
+			{
+				continue;
+			}
+
+			PIPELINE_STATE_DESC desc;
+			desc.program = (PROGRAM_VARIANT)program;
+			desc.vertexLayout = VERTEX_LAYOUT_PACKED;
+			desc.blend = (BLEND_MODE)blend;
+			desc.depth = (blend == BLEND_WEIGHTED) ? DEPTH_READ_ONLY : DEPTH_READ_WRITE;
+			desc.cull = CULL_NONE;
+			m_drawStates[program][blend] = m_pipelineStates->Create(stateNames[program][blend], desc);
+
+			// only the back faces of the proxy boxes are drawn
+			desc.cull = CULL_FRONT;
+			m_pipelineStates->Create((std::string(stateNames[program][blend]) + " proxy").c_str(), desc);
+		}
+	}
 
-	scaleXYZ = glm::vec3(40.0f, 0.5f, 0.1f);
+	if (m_pipelineStates->Validate() == false)
+	{
+		std::cout << "The pipeline states of the scene are not valid" << std::endl;
+		for (int program = 0; program < PROGRAM_VARIANT_COUNT; program++)
+		{
+			m_drawStates[program][BLEND_WEIGHTED] = -1;
+		}
+	}
+}
 
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  HasTransparencyPass()
+ *
+ *  This method is used for checking whether the weighted
+ *  states the transparent pass draws with were created.
+ ***********************************************************/
+bool SceneManager::HasTransparencyPass() const
+{
+	return((m_drawStates[PROGRAM_COLORED][BLEND_WEIGHTED] >= 0) &&
+		(m_drawStates[PROGRAM_TEXTURED][BLEND_WEIGHTED] >= 0));
+}
 
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.25f, -9.95f);
+/***********************************************************
+ *  BuildClusters()
+ *
+ *  This method is used for recording the draws of each
+ *  object group - the fire box, each tree and the wooden
+ *  bowl - and merging them into one cluster mesh per group.
+ *  Every distinct texture or color of the groups, tinted by
+ *  its material, becomes a tile of one shared atlas, so a
+ *  merged group is drawn with one texture and one material.
+ *  Parts are placed relative to the group's root node, so
+ *  a moved tree or bowl takes its cluster with it.
+ ***********************************************************/
+void SceneManager::BuildClusters()
+{
+	const int GROUP_COUNT = 4;
+	OBJECT_CLUSTER* clusters[GROUP_COUNT] = { &m_fireBoxCluster, &m_leftTreeCluster, &m_rightTreeCluster, &m_woodenBowlCluster };
+	const char* names[GROUP_COUNT] = { "fire box", "left tree", "right tree", "wooden bowl" };
+	std::vector<SceneMeshes::RECORDED_DRAW> draws[GROUP_COUNT];
+	std::vector<DRAW_APPEARANCE> appearances[GROUP_COUNT];
+
+	m_fireBoxCluster.rootNode = SceneGraph::NO_PARENT;
+	m_leftTreeCluster.rootNode = m_leftTree.root;
+	m_rightTreeCluster.rootNode = m_rightTree.root;
+	m_woodenBowlCluster.rootNode = m_woodenBowl.root;
+
+	// the recorded draws use the world matrices of the scene graph
+	m_sceneGraph.Update();
+	for (int group = 0; group < GROUP_COUNT; group++)
+	{
+		BeginRecording();
+		switch (group)
+		{
+		case 0:
+			RenderFireBox();
+			break;
+		case 1:
+			RenderTree(m_leftTree);
+			break;
+		case 2:
+			RenderTree(m_rightTree);
+			break;
+		default:
+			RenderWoodenBowl();
+			break;
+		}
+		draws[group] = EndRecording(clusters[group]->finalAppearance);
+		appearances[group].swap(m_recordedAppearances);
+	}
 
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// one atlas tile for every distinct surface of the groups
+	std::vector<ATLAS_TILE> tiles;
+	std::vector<std::string> tileKeys;
+	std::vector<int> drawTiles[GROUP_COUNT];
+	for (int group = 0; group < GROUP_COUNT; group++)
+	{
+		for (const SceneMeshes::RECORDED_DRAW& draw : draws[group])
+		{
+			const DRAW_APPEARANCE& appearance = appearances[group][draw.appearance];
+			std::string key = (appearance.bTextured == true) ?
+				("texture " + appearance.textureTag + " " + std::to_string(appearance.uvScale.x) + " " + std::to_string(appearance.uvScale.y)) :
+				("color " + std::to_string(appearance.color.r) + " " + std::to_string(appearance.color.g) + " " + std::to_string(appearance.color.b));
+			key += " material " + appearance.materialTag;
+
+			size_t tile = std::find(tileKeys.begin(), tileKeys.end(), key) - tileKeys.begin();
+			if (tile == tileKeys.size())
+			{
+				ATLAS_TILE newTile;
+				const int textureID = (appearance.bTextured == true) ? FindTextureID(appearance.textureTag) : -1;
+				newTile.texture = (textureID > 0) ? (GLuint)textureID : 0;
+				newTile.uvScale = appearance.uvScale;
+				newTile.color = glm::vec3(appearance.color);
+
+				// the merged mesh is lit with a white material, so the
+				// diffuse color of the part's material is baked in
+				OBJECT_MATERIAL material;
+				material.diffuseColor = glm::vec3(1.0f);
+				if (appearance.materialTag.empty() == false)
+				{
+					FindMaterial(appearance.materialTag, material);
+				}
+				newTile.tint = material.diffuseColor;
+
+				tiles.push_back(newTile);
+				tileKeys.push_back(key);
+			}
+			drawTiles[group].push_back((int)tile);
+		}
+	}
 
-	SetShaderColor(1, 1, 1, 1);
-	SetShaderMaterial("wood");
+	std::vector<ATLAS_RECT> rects;
+	GLuint atlas = ClusterAtlas::BakeAtlas(tiles, rects);
+	if (atlas == 0)
+	{
+		return;
+	}
+	if (m_loadedTextures >= 16)
+	{
+		std::cout << "No texture slot is left for the cluster atlas" << std::endl;
+		glDeleteTextures(1, &atlas);
+		return;
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	// register the atlas like a loaded texture, on its own unit
+	m_textureIDs[m_loadedTextures].ID = atlas;
+	m_textureIDs[m_loadedTextures].tag = g_ClusterAtlasTag;
+	// the tiles are baked fully opaque
+	m_textureIDs[m_loadedTextures].bAlpha = false;
+	glActiveTexture(GL_TEXTURE0 + m_loadedTextures);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	m_loadedTextures++;
 
-	/****************************************************************/
+	for (int group = 0; group < GROUP_COUNT; group++)
+	{
+		glm::mat4 rootModel(1.0f);
+		if (clusters[group]->rootNode != SceneGraph::NO_PARENT)
+		{
+			rootModel = m_sceneGraph.GetWorldTransform(clusters[group]->rootNode).model;
+		}
+		const glm::mat4 inverseRoot = glm::inverse(rootModel);
 
-	/****************************************************************/
+		std::vector<SceneMeshes::CLUSTER_PART> parts;
+		for (size_t i = 0; i < draws[group].size(); i++)
+		{
+			SceneMeshes::CLUSTER_PART part;
+			part.mesh = draws[group][i].mesh;
+			part.model = inverseRoot * draws[group][i].model;
+			part.atlasOffset = rects[drawTiles[group][i]].offset;
+			part.atlasScale = rects[drawTiles[group][i]].scale;
+			parts.push_back(part);
+		}
+		clusters[group]->mesh = m_basicMeshes->LoadClusterMesh(names[group], parts);
+	}
 
-	// Baseboards for scene.
-		//set the XYZ scale for the mesh
+	std::cout << "INFO: Merged " << GROUP_COUNT << " object groups into cluster meshes with "
+		<< tiles.size() << " atlas tiles" << std::endl;
+}
 
+/***********************************************************
+ *  DrawCluster()
+ *
+ *  This method is used for drawing an object group as its
+ *  cluster mesh, in one draw, when the group is small on
+ *  screen.  The shader values the group's own draws would
+ *  have left behind are set afterwards, so the draws that
+ *  follow look the same either way.
+ ***********************************************************/
+bool SceneManager::DrawCluster(const OBJECT_CLUSTER& cluster)
+{
+	// the cluster draw is not recorded, so a recorded frame
+	// draws the group's own shapes
+	if ((m_bClusters == false) || (cluster.mesh < 0) || (m_bRecording == true))
+	{
+		return(false);
+	}
 
-	scaleXYZ = glm::vec3(5.25f, 0.5f, 0.1f);
+	// the cluster is placed by its root node, or in world space
+	if (cluster.rootNode != SceneGraph::NO_PARENT)
+	{
+		SetTransformations(m_sceneGraph.GetWorldTransform(cluster.rootNode));
+	}
+	else
+	{
+		OBJECT_TRANSFORM identity;
+		identity.model = glm::mat4(1.0f);
+		identity.normal = glm::mat4(1.0f);
+		SetTransformations(identity);
+	}
 
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
+	if (m_basicMeshes->UseClusterMesh(cluster.mesh) == false)
+	{
+		return(false);
+	}
 
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-6.03f, 0.25f, -6.87f);
+	const DRAW_APPEARANCE previous = m_appearance;
+	SetShaderTexture(g_ClusterAtlasTag);
+	SetTextureUVScale(1.0f, 1.0f);
+	if (NULL != m_pShaderManager)
+	{
+		// the material colors are baked into the atlas
+		m_pShaderManager->setVec3Value("material.diffuseColor", glm::vec3(1.0f));
+		m_pShaderManager->setVec3Value("material.specularColor", glm::vec3(0.0f));
+		m_pShaderManager->setFloatValue("material.shininess", 1.0f);
+	}
 
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_basicMeshes->DrawClusterMesh(cluster.mesh);
 
-	SetShaderColor(1, 1, 1, 1);
-	SetShaderMaterial("wood");
+	ApplyAppearance(CombineAppearance(previous, cluster.finalAppearance));
+	return(true);
+}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+/***********************************************************
+ *  BuildSceneGraph()
+ *
+ *  This method is used for adding the composite objects to
+ *  the scene graph.  Each part is placed relative to a root
+ *  node for its object, so moving the root moves the whole
+ *  object and only touches that object's nodes.
+ ***********************************************************/
+void SceneManager::BuildSceneGraph()
+{
+	m_leftTree = AddTreeNodes(glm::vec3(-4.5f, 8.75f, -2.75f));
+	m_rightTree = AddTreeNodes(glm::vec3(4.5f, 8.75f, -2.75f));
+
+	// the wooden bowl pivots on the bottom of its basin
+	m_woodenBowl.root = m_sceneGraph.AddNode(
+		SceneGraph::NO_PARENT,
+		glm::vec3(1.0f), 0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 8.7f, -2.9f));
+	m_woodenBowl.rim = m_sceneGraph.AddNode(
+		m_woodenBowl.root,
+		glm::vec3(1.35f, 0.4f, 0.4f), 90.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 0.05f, 0.0f));
+	m_woodenBowl.basin = m_sceneGraph.AddNode(
+		m_woodenBowl.root,
+		glm::vec3(1.7f, 0.2f, 0.5f), 180.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 0.0f, 0.0f));
+}
 
-	/****************************************************************/
+/***********************************************************
+ *  AddTreeNodes()
+ *
+ *  This method is used for adding the parts of one mantle
+ *  tree under a root node placed where the trunk meets the
+ *  foliage.
+ ***********************************************************/
+SceneManager::TREE_NODES SceneManager::AddTreeNodes(glm::vec3 positionXYZ)
+{
+	TREE_NODES tree;
 
-	/****************************************************************/
+	tree.root = m_sceneGraph.AddNode(
+		SceneGraph::NO_PARENT,
+		glm::vec3(1.0f), 0.0f, 0.0f, 0.0f,
+		positionXYZ);
+	tree.base = m_sceneGraph.AddNode(
+		tree.root,
+		glm::vec3(0.25f, 0.25f, 0.25f), 0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, -0.25f, 0.0f));
+	tree.ring = m_sceneGraph.AddNode(
+		tree.root,
+		glm::vec3(0.19f, 0.19f, 0.19f), 90.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 0.0f, 0.0f));
+	tree.foliage = m_sceneGraph.AddNode(
+		tree.root,
+		glm::vec3(0.5f, 2.5f, 0.5f), 0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 0.0f, 0.0f));
+
+	return(tree);
+}
 
-	// Baseboards for scene.
-		//set the XYZ scale for the mesh
+/***********************************************************
+ *  SetTreePosition()
+ *
+ *  This method is used for moving one of the mantle trees.
+ ***********************************************************/
+void SceneManager::SetTreePosition(bool bLeftTree, glm::vec3 positionXYZ)
+{
+	if (bLeftTree == true)
+	{
+		m_sceneGraph.SetLocalPosition(m_leftTree.root, positionXYZ);
+	}
+	else
+	{
+		m_sceneGraph.SetLocalPosition(m_rightTree.root, positionXYZ);
+	}
+	m_sceneRevision++;
+}
 
+/***********************************************************
+ *  SetWoodenBowlPosition()
+ *
+ *  This method is used for moving the wooden bowl.
+ ***********************************************************/
+void SceneManager::SetWoodenBowlPosition(glm::vec3 positionXYZ)
+{
+	m_sceneGraph.SetLocalPosition(m_woodenBowl.root, positionXYZ);
+	m_sceneRevision++;
+}
 
-	scaleXYZ = glm::vec3(5.25f, 0.5f, 0.1f);
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for passing the camera matrices of
+ *  the frame to the meshes, which use them to choose the
+ *  level of detail of each draw.
+ ***********************************************************/
+void SceneManager::SetViewProjection(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_basicMeshes->SetViewProjection(view, projection);
+}
 
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  SetTessellation()
+ *
+ *  This method is used for drawing the curved shapes as
+ *  patches, when the shader program has been relinked with
+ *  the hardware tessellation stages.
+ ***********************************************************/
+void SceneManager::SetTessellation(bool bEnabled)
+{
+	m_basicMeshes->SetTessellation(bEnabled);
+}
 
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(6.03f, 0.25f, -6.87f);
+/***********************************************************
+ *  ResetDetailState()
+ *
+ *  This method is used for choosing the levels of detail and
+ *  cluster meshes of the next frame from its camera alone,
+ *  for frames whose poses do not follow each other.
+ ***********************************************************/
+void SceneManager::ResetDetailState()
+{
+	m_basicMeshes->ResetDetailState();
+}
 
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  SetImpostors()
+ *
+ *  This method is used for drawing the curved shapes as
+ *  ray-cast impostors instead of triangle meshes.
+ ***********************************************************/
+bool SceneManager::SetImpostors(bool bEnabled)
+{
+	return(m_basicMeshes->SetImpostors(bEnabled));
+}
+
+/***********************************************************
+ *  SetMeshletCulling()
+ *
+ *  This method is used for switching the culling of the
+ *  meshlets that are off screen or facing away on or off.
+ ***********************************************************/
+void SceneManager::SetMeshletCulling(bool bEnabled)
+{
+	m_basicMeshes->SetMeshletCulling(bEnabled);
+}
+
+/***********************************************************
+ *  SetClusters()
+ *
+ *  This method is used for switching the merged cluster
+ *  meshes of the object groups on or off.  They are only
+ *  built when enabled before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetClusters(bool bEnabled)
+{
+	m_bClusters = bEnabled;
+}
+
+/***********************************************************
+ *  SetKeepGeometry()
+ *
+ *  This method is used for keeping a copy of the shared
+ *  vertex and index buffers in memory after the upload, so
+ *  the scene can also be rendered by the software rasterizer.
+ ***********************************************************/
+void SceneManager::SetKeepGeometry(bool bEnabled)
+{
+	m_basicMeshes->SetKeepGeometry(bEnabled);
+}
+
+/***********************************************************
+ *  RecordRasterScene()
+ *
+ *  This method is used for capturing everything the software
+ *  rasterizer needs to render a frame - the draws of the
+ *  scene in submission order with the shader values of each,
+ *  the texture images and the lights.  The textures are read
+ *  back from OpenGL the first time only.  The camera of the
+ *  frame is set by the caller.
+ ***********************************************************/
+void SceneManager::RecordRasterScene(RASTER_SCENE& scene)
+{
+	// capture the frame's draws instead of drawing them
+	m_sceneGraph.Update();
+	BeginRecording();
+	RenderObjects();
+	DRAW_APPEARANCE finalAppearance;
+	std::vector<SceneMeshes::RECORDED_DRAW> draws = EndRecording(finalAppearance);
+
+	// the textures are indexed by the slot they are bound to
+	if (scene.textures.size() != (size_t)m_loadedTextures)
+	{
+		scene.textures.resize(m_loadedTextures);
+		for (int slot = 0; slot < m_loadedTextures; slot++)
+		{
+			RASTER_TEXTURE& texture = scene.textures[slot];
+			glActiveTexture(GL_TEXTURE0 + slot);
+			glBindTexture(GL_TEXTURE_2D, m_textureIDs[slot].ID);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &texture.width);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &texture.height);
+			texture.texels.resize((size_t)texture.width * texture.height);
+			glPixelStorei(GL_PACK_ALIGNMENT, 4);
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.texels.data());
+		}
+	}
+
+	// one surface for each set of shader values the draws used
+	scene.surfaces.clear();
+	for (const DRAW_APPEARANCE& appearance : m_recordedAppearances)
+	{
+		RASTER_SURFACE surface;
+		surface.color = appearance.color;
+		surface.texture = -1;
+		if (appearance.bTextured == true)
+		{
+			surface.texture = FindTextureSlot(appearance.textureTag);
+		}
+		surface.uvScale = appearance.uvScale;
+
+		OBJECT_MATERIAL material;
+		material.diffuseColor = glm::vec3(0.0f);
+		material.specularColor = glm::vec3(0.0f);
+		material.shininess = 0.0f;
+		if (appearance.materialTag.empty() == false)
+		{
+			FindMaterial(appearance.materialTag, material);
+		}
+		surface.diffuseColor = material.diffuseColor;
+		surface.specularColor = material.specularColor;
+		surface.shininess = material.shininess;
+		scene.surfaces.push_back(surface);
+	}
+
+	// every shape is drawn at its finest level of detail
+	scene.draws.clear();
+	scene.draws.reserve(draws.size());
+	for (const SceneMeshes::RECORDED_DRAW& recorded : draws)
+	{
+		const MESH_RANGE& range = m_basicMeshes->GetMeshRange(recorded.mesh, 0);
+		RASTER_DRAW draw;
+		draw.baseVertex = range.baseVertex;
+		draw.firstIndex = range.firstIndex;
+		draw.indexCount = (uint32_t)range.indexCount;
+		draw.bounds = range.bounds;
+		draw.model = recorded.model;
+		draw.surface = recorded.appearance;
+		scene.draws.push_back(draw);
+	}
+
+	const std::vector<PACKED_VERTEX>& vertices = m_basicMeshes->GetKeptVertices();
+	const std::vector<uint32_t>& indices = m_basicMeshes->GetKeptIndices();
+	scene.pVertices = vertices.data();
+	scene.vertexCount = vertices.size();
+	scene.pIndices = indices.data();
+	scene.indexCount = indices.size();
+
+	// the lights are the ones SetupSceneLights() gives the shader
+	scene.bUseLighting = g_bUseLighting;
+	scene.directionalLight = g_DirectionalLight;
+	const int pointLightCount = (int)(sizeof(g_PointLights) / sizeof(g_PointLights[0]));
+	for (int i = 0; i < RASTER_SCENE::POINT_LIGHT_COUNT; i++)
+	{
+		scene.pointLights[i] = g_PointLights[0];
+		scene.pointLights[i].bActive = false;
+		if (i < pointLightCount)
+		{
+			scene.pointLights[i] = g_PointLights[i];
+		}
+	}
+	scene.spotLight = g_PointLights[0];
+	scene.spotLight.bActive = false;
+}
+
+/***********************************************************
+ *  GetFrameTriangles()
+ *
+ *  This method is used for getting the number of triangles
+ *  the last rendered frame drew.
+ ***********************************************************/
+size_t SceneManager::GetFrameTriangles() const
+{
+	return(m_basicMeshes->GetFrameTriangles());
+}
+
+/***********************************************************
+ *  GetSceneVersion()
+ *
+ *  This method is used for hashing the inputs of a frame
+ *  other than the camera, so frames stored by a frame cache
+ *  are not served once the scene has changed.
+ ***********************************************************/
+uint64_t SceneManager::GetSceneVersion() const
+{
+	const uint64_t values[] = { m_bClusters ? 1u : 0u, m_sceneRevision };
+	uint64_t version = MeshCache::Hash(values, sizeof(values), m_basicMeshes->ComputeSceneKey());
+	for (const TEXTURE_FILE& texture : g_TextureFiles)
+	{
+		version = FrameCache::HashFile(texture.filename, version);
+	}
+
+	return(version);
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  transforming and drawing the basic 3D shapes.  The
+ *  transparent pass traverses the scene again, after the
+ *  opaque pass of the frame, but only when the opaque pass
+ *  held back some transparent draws.
+ ***********************************************************/
+void SceneManager::RenderScene(RENDER_PASS pass)
+{
+	if (pass == RENDER_TRANSPARENT)
+	{
+		if (m_basicMeshes->GetFrameDeferredDraws() == 0)
+		{
+			return;
+		}
+		m_basicMeshes->BindMeshes();
+		m_basicMeshes->SetDrawQueue(SceneMeshes::QUEUE_TRANSPARENT);
+		m_transparentBlend = BLEND_WEIGHTED;
+	}
+	else
+	{
+		// re-derive the world matrices of any moved objects
+		m_sceneGraph.Update();
+
+		// every mesh is drawn from the shared vertex array
+		m_basicMeshes->BeginFrame();
+		m_basicMeshes->SetDrawQueue((pass == RENDER_OPAQUE) ? SceneMeshes::QUEUE_OPAQUE : SceneMeshes::QUEUE_ALL);
+		m_transparentBlend = BLEND_ALPHA;
+	}
+
+	// the state of the shader values left by the last draw
+	SelectPipelineState();
+	RenderObjects();
+
+	m_basicMeshes->SetDrawQueue(SceneMeshes::QUEUE_ALL);
+	m_transparentBlend = BLEND_ALPHA;
+	SelectPipelineState();
+}
+
+/***********************************************************
+ *  RenderObjects()
+ *
+ *  This method is used for drawing every object of the
+ *  scene, or recording the draws while recording.
+ ***********************************************************/
+void SceneManager::RenderObjects()
+{
+	m_basicMeshes->BeginObject(OBJECT_WALL);
+	RenderWall();
+	// distant object groups are drawn as their cluster meshes
+	m_basicMeshes->BeginObject(OBJECT_FIRE_BOX);
+	if (DrawCluster(m_fireBoxCluster) == false)
+	{
+		RenderFireBox();
+	}
+	RenderTrees();
+	m_basicMeshes->BeginObject(OBJECT_WOODEN_BOWL);
+	if (DrawCluster(m_woodenBowlCluster) == false)
+	{
+		RenderWoodenBowl();
+	}
+	m_basicMeshes->BeginObject(OBJECT_ROOM);
+	/****************************************************************/
+
+	//Plane for Floor surface
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM floorPlane = BakeTransformations(
+		{ 20.0f, 1.0f, 10.0f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 0.0f, 0.0f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(floorPlane);
+
+	//SetShaderColor(0.627, 0.322, 0.176, 1);
+	SetShaderTexture("floor");
+	SetTextureUVScale(1, 1);
+	// draw the mesh with transformation values
+	m_basicMeshes->DrawPlaneMesh();
+	/****************************************************************/
+
+	// Baseboards for scene.
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM backBaseboard = BakeTransformations(
+		{ 40.0f, 0.5f, 0.1f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 0.25f, -9.95f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(backBaseboard);
+
+	SetShaderColor(1, 1, 1, 1);
+	SetShaderMaterial("wood");
+
+	// draw the mesh with transformation values
+	m_basicMeshes->DrawBoxMesh();
+
+	/****************************************************************/
+
+	/****************************************************************/
+
+	// Baseboards for scene.
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM leftBaseboard = BakeTransformations(
+		{ 5.25f, 0.5f, 0.1f },
+		0.0f, 90.0f, 0.0f,
+		{ -6.03f, 0.25f, -6.87f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(leftBaseboard);
+
+	SetShaderColor(1, 1, 1, 1);
+	SetShaderMaterial("wood");
+
+	// draw the mesh with transformation values
+	m_basicMeshes->DrawBoxMesh();
+
+	/****************************************************************/
+
+	/****************************************************************/
+
+	// Baseboards for scene.
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM rightBaseboard = BakeTransformations(
+		{ 5.25f, 0.5f, 0.1f },
+		0.0f, 90.0f, 0.0f,
+		{ 6.03f, 0.25f, -6.87f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(rightBaseboard);
 
 	SetShaderColor(1, 1, 1, 1);
 	SetShaderMaterial("wood");
@@ -798,24 +1638,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Outset Fireplace wall strucure box
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(12.0f, 10.0f, 6.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 11.0f, -7.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM fireplaceWall = BakeTransformations(
+		{ 12.0f, 10.0f, 6.0f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 11.0f, -7.0f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(fireplaceWall);
 
 	//SetShaderColor(0.961, 0.400, 0.100, 1); //(0.961, 0.961, 0.961, 1);
 	SetShaderTexture("shiplap");
@@ -826,24 +1656,14 @@ void SceneManager::RenderScene()
 
 	/****************************************************************/
 	//Outset Fireplace wall strucure box (Lower left of fireplace)
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(2.75f, 6.0f, 6.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-4.6f, 3.0f, -7.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM fireplaceWallLowerLeft = BakeTransformations(
+		{ 2.75f, 6.0f, 6.0f },
+		0.0f, 0.0f, 0.0f,
+		{ -4.6f, 3.0f, -7.0f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(fireplaceWallLowerLeft);
 
 	//SetShaderColor(0.500, 0.600, 0.200, 1);// Change colors to same as rest of enclosure when final placemnt decided
 	SetShaderTexture("shiplap");
@@ -854,24 +1674,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Outset Fireplace wall strucure box (Lower right of fireplace)
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(2.75f, 6.0f, 6.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(4.6f, 3.0f, -7.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM fireplaceWallLowerRight = BakeTransformations(
+		{ 2.75f, 6.0f, 6.0f },
+		0.0f, 0.0f, 0.0f,
+		{ 4.6f, 3.0f, -7.0f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(fireplaceWallLowerRight);
 
 	//SetShaderColor(0.500, 0.600, 0.200, 1); // Change colors to same as rest of enclosure when final placemnt decided
 	SetShaderTexture("shiplap");
@@ -881,28 +1691,17 @@ void SceneManager::RenderScene()
 
 	/****************************************************************/
 
-	
 	/****************************************************************/
 
 	// Verticle corner trim for fireplace outside corner left side.
-		//set the XYZ scale for the mesh
-		scaleXYZ = glm::vec3(0.5f, 16.0f, 0.5f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-5.9f, 8.0f, -4.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM outsideCornerTrimLeft = BakeTransformations(
+		{ 0.5f, 16.0f, 0.5f },
+		0.0f, 0.0f, 0.0f,
+		{ -5.9f, 8.0f, -4.0f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(outsideCornerTrimLeft);
 
 	SetShaderColor(1, 1, 1, 1);
 	SetShaderMaterial("wood");
@@ -913,24 +1712,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	// Verticle corner trim for fireplace outside corner left side.
-		//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 16.0f, 0.5f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(5.9f, 8.0f, -4.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM outsideCornerTrimRight = BakeTransformations(
+		{ 0.5f, 16.0f, 0.5f },
+		0.0f, 0.0f, 0.0f,
+		{ 5.9f, 8.0f, -4.0f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(outsideCornerTrimRight);
 
 	SetShaderColor(1, 1, 1, 1);
 	SetShaderMaterial("wood");
@@ -941,24 +1730,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	// Verticle corner trim for fireplace Inside back corner left side.
-		//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 16.0f, 0.5f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-5.9f, 8.0f, -9.75f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM insideCornerTrimLeft = BakeTransformations(
+		{ 0.5f, 16.0f, 0.5f },
+		0.0f, 0.0f, 0.0f,
+		{ -5.9f, 8.0f, -9.75f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(insideCornerTrimLeft);
 
 	SetShaderColor(1, 1, 1, 1);
 	SetShaderMaterial("wood");
@@ -969,24 +1748,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	// Verticle corner trim for fireplace Inside back corner right side.
-		//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 16.0f, 0.5f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(5.9f, 8.0f, -9.75f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM insideCornerTrimRight = BakeTransformations(
+		{ 0.5f, 16.0f, 0.5f },
+		0.0f, 0.0f, 0.0f,
+		{ 5.9f, 8.0f, -9.75f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(insideCornerTrimRight);
 
 	SetShaderColor(1, 1, 1, 1);
 	SetShaderMaterial("wood");
@@ -997,24 +1766,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Mantle
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(10.0f, 1.0f, 2.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 8.0f, -3.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM mantle = BakeTransformations(
+		{ 10.0f, 1.0f, 2.0f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 8.0f, -3.0f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(mantle);
 
 	//SetShaderColor(0.545, 0.271, 0.075, 1);
 	SetShaderTexture("mantle");
@@ -1024,24 +1783,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 //Box For Television(Black Outer trim)
-//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(9.0f, 5.0f, 0.25f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 11.5f, -3.6f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM televisionTrim = BakeTransformations(
+		{ 9.0f, 5.0f, 0.25f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 11.5f, -3.6f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(televisionTrim);
 
 	SetShaderColor(0, 0, 0, 1);
 
@@ -1050,24 +1799,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Box For Television(Screen)
-//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(8.75f, 4.75f, 0.25f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 11.5f, -3.59f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM televisionScreen = BakeTransformations(
+		{ 8.75f, 4.75f, 0.25f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 11.5f, -3.59f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(televisionScreen);
 
 	SetShaderColor(0.01, 0.01, 0.01, 1);
 	//SetShaderTexture("cartoon");
@@ -1080,24 +1819,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Sphere for snowman base
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.21f, 0.21f, 0.17f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-3.5f, 8.6f, -2.6f); //(2.0f, 2.0f, 2.0f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM snowmanBase = BakeTransformations(
+		{ 0.21f, 0.21f, 0.17f },
+		90.0f, 0.0f, 0.0f,
+		{ -3.5f, 8.6f, -2.6f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(snowmanBase);
 
 	SetShaderColor(0.9, 0.9, 0.9, 1);
 	SetShaderMaterial("metal");
@@ -1107,24 +1836,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Sphere for snowman abdomen.
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.15f, 0.15f, 0.15f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-3.5f, 8.74f, -2.6f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM snowmanAbdomen = BakeTransformations(
+		{ 0.15f, 0.15f, 0.15f },
+		90.0f, 0.0f, 0.0f,
+		{ -3.5f, 8.74f, -2.6f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(snowmanAbdomen);
 
 	SetShaderColor(0.9, 0.9, 0.9, 1);
 	SetShaderMaterial("metal");
@@ -1134,24 +1853,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Snowman Head.
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.11f, 0.11f, 0.11f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-3.5f, 8.87f, -2.6f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM snowmanHead = BakeTransformations(
+		{ 0.11f, 0.11f, 0.11f },
+		90.0f, 0.0f, 0.0f,
+		{ -3.5f, 8.87f, -2.6f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(snowmanHead);
 
 	SetShaderColor(0.9, 0.9, 0.9, 1);
 	SetShaderMaterial("metal");
@@ -1160,24 +1869,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Snowman Hat main.
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.09f, 0.13f, 0.09f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-3.5f, 8.94f, -2.6f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM snowmanHat = BakeTransformations(
+		{ 0.09f, 0.13f, 0.09f },
+		0.0f, 0.0f, 0.0f,
+		{ -3.5f, 8.94f, -2.6f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(snowmanHat);
 
 	SetShaderColor(0.01, 0.01, 0.01, 1);
 	SetShaderMaterial("metal");
@@ -1187,24 +1886,14 @@ void SceneManager::RenderScene()
 	/****************************************************************/
 
 	//Snowman Hat Brim.
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.1f, 0.1f, 0.03f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-3.5f, 8.94f, -2.6f);  //2.37
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM snowmanHatBrim = BakeTransformations(
+		{ 0.1f, 0.1f, 0.03f },
+		90.0f, 0.0f, 0.0f,
+		{ -3.5f, 8.94f, -2.6f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(snowmanHatBrim);
 
 	SetShaderColor(0.01, 0.01, 0.01, 1);
 	SetShaderMaterial("metal");
@@ -1214,32 +1903,15 @@ void SceneManager::RenderScene()
 
 void SceneManager::RenderFireBox()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
 	//Back Wall Plane of Fireplace
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(3.5f, 6.0f, 3.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 3.0f, -7.5f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM fireboxBackWall = BakeTransformations(
+		{ 3.5f, 6.0f, 3.0f },
+		90.0f, 0.0f, 0.0f,
+		{ 0.0f, 3.0f, -7.5f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(fireboxBackWall);
 
 	//SetShaderColor(0.00, 0.00, 0.00, 1);
 	SetShaderTexture("brick");
@@ -1249,24 +1921,14 @@ void SceneManager::RenderFireBox()
 	/****************************************************************/
 
 	//left Wall Plane of Fireplace Angled
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(3.0f, 0.0f, 3.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 70.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-2.4f, 3.0f, -6.84f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM fireboxLeftWall = BakeTransformations(
+		{ 3.0f, 0.0f, 3.0f },
+		90.0f, 70.0f, 0.0f,
+		{ -2.4f, 3.0f, -6.84f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(fireboxLeftWall);
 
 	//SetShaderColor(0.200, 0.200, 0.100, 1);
 	SetShaderTexture("brick");
@@ -1276,24 +1938,14 @@ void SceneManager::RenderFireBox()
 	/****************************************************************/
 
 	//righy Wall Plane of Fireplace Angled
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(3.0f, 0.0f, 3.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = -70.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(2.4f, 3.0f, -6.84f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM fireboxRightWall = BakeTransformations(
+		{ 3.0f, 0.0f, 3.0f },
+		90.0f, -70.0f, 0.0f,
+		{ 2.4f, 3.0f, -6.84f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(fireboxRightWall);
 
 	//SetShaderColor(0.200, 0.200, 0.100, 1);
 	SetShaderTexture("brick");
@@ -1302,24 +1954,14 @@ void SceneManager::RenderFireBox()
 
 	/****************************************************************/
 	//Fireplace Base Box
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 1.0f, 5.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.5f, -7.00f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM fireboxBase = BakeTransformations(
+		{ 6.5f, 1.0f, 5.0f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 0.5f, -7.00f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(fireboxBase);
 
 	//SetShaderColor(0, 0, 0, 1);
 	SetShaderTexture("metal");
@@ -1329,24 +1971,14 @@ void SceneManager::RenderFireBox()
 
 	/****************************************************************/
 	//Fireplace Top Box
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(6.5f, 1.0f, 5.0f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 5.5f, -7.00f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM fireboxTop = BakeTransformations(
+		{ 6.5f, 1.0f, 5.0f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 5.5f, -7.00f });
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(fireboxTop);
 
 	//SetShaderColor(0, 0, 0, 1);
 	SetShaderTexture("metal");
@@ -1359,24 +1991,14 @@ void SceneManager::RenderFireBox()
 	/***************************************************************/
 
 	//Black bottom metallic fire place trim.
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM bottomTrim = BakeTransformations(
+		{ 7.0f, 1.0f, 0.45f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 0.5f, -4.3f });
 
-	scaleXYZ = glm::vec3(7.0f, 1.0f, 0.45f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.5f, -4.3f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(bottomTrim);
 
 	//SetShaderColor(0.100, 0.171, 0.100, 1);
 	SetShaderTexture("metal2");
@@ -1387,24 +2009,14 @@ void SceneManager::RenderFireBox()
 	/*************************************************************/
 
 	//Black top metallic fire place trim.
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM topTrim = BakeTransformations(
+		{ 7.0f, 1.0f, 0.45f },
+		0.0f, 0.0f, 0.0f,
+		{ 0.0f, 5.5f, -4.3f });
 
-	scaleXYZ = glm::vec3(7.0f, 1.0f, 0.45f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 5.5f, -4.3f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(topTrim);
 
 	//SetShaderColor(0.100, 0.171, 0.100, 1);
 	SetShaderTexture("metal2");
@@ -1417,24 +2029,14 @@ void SceneManager::RenderFireBox()
 	/*************************************************************/
 
 	//Black left side metallic fire place trim.
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM leftTrim = BakeTransformations(
+		{ 5.0f, 0.10f, 0.45f },
+		0.0f, 0.0f, 90.0f,
+		{ -3.2f, 3.5f, -4.3f });
 
-	scaleXYZ = glm::vec3(5.0f, 0.10f, 0.45f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-3.2f, 3.5f, -4.3f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(leftTrim);
 
 	//SetShaderColor(0.100, 0.171, 0.100, 1);
 	SetShaderTexture("metal2");
@@ -1445,24 +2047,14 @@ void SceneManager::RenderFireBox()
 	/*************************************************************/
 
 	//Black right side metallic fire place trim.
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM rightTrim = BakeTransformations(
+		{ 5.0f, 0.10f, 0.45f },
+		0.0f, 0.0f, 90.0f,
+		{ 3.2f, 3.5f, -4.3f });
 
-	scaleXYZ = glm::vec3(5.0f, 0.10f, 0.45f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(3.2f, 3.5f, -4.3f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(rightTrim);
 
 	//SetShaderColor(0.100, 0.171, 0.100, 1);
 	SetShaderTexture("metal2");
@@ -1473,24 +2065,14 @@ void SceneManager::RenderFireBox()
 	/*************************************************************/
 
 	//Black Log holder left
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM logHolderLeft = BakeTransformations(
+		{ 0.8f, 0.2f, 0.2f },
+		0.0f, 90.0f, 180.0f,
+		{ -1.5f, 1.5f, -6.0f });
 
-	scaleXYZ = glm::vec3(0.8f, 0.2f, 0.2f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 180.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-1.5f, 1.5f, -6.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(logHolderLeft);
 
 	//SetShaderColor(0.100, 0.171, 0.100, 1);
 	SetShaderTexture("metal2");
@@ -1500,24 +2082,14 @@ void SceneManager::RenderFireBox()
 	/*************************************************************/
 
 	//Black Log holder base left
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM logHolderBaseLeft = BakeTransformations(
+		{ 0.5f, 0.2f, 0.2f },
+		0.0f, 90.0f, 0.0f,
+		{ -1.5f, 1.0f, -6.0f });
 
-	scaleXYZ = glm::vec3(0.5f, 0.2f, 0.2f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-1.5f, 1.0f, -6.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(logHolderBaseLeft);
 
 	//SetShaderColor(0.100, 0.171, 0.100, 1);
 	SetShaderTexture("metal2");
@@ -1528,24 +2100,14 @@ void SceneManager::RenderFireBox()
 	/*************************************************************/
 
 	//Black Log holder right
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM logHolderRight = BakeTransformations(
+		{ 0.8f, 0.2f, 0.2f },
+		0.0f, 90.0f, 180.0f,
+		{ 1.5f, 1.5f, -6.0f });
 
-	scaleXYZ = glm::vec3(0.8f, 0.2f, 0.2f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 180.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(1.5f, 1.5f, -6.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(logHolderRight);
 
 	//SetShaderColor(0.100, 0.171, 0.100, 1);
 	SetShaderTexture("metal2");
@@ -1555,24 +2117,14 @@ void SceneManager::RenderFireBox()
 	/*************************************************************/
 
 	//Black Log holder base right
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM logHolderBaseRight = BakeTransformations(
+		{ 0.5f, 0.2f, 0.2f },
+		0.0f, 90.0f, 0.0f,
+		{ 1.5f, 1.0f, -6.0f });
 
-	scaleXYZ = glm::vec3(0.5f, 0.2f, 0.2f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 90.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(1.5f, 1.0f, -6.0f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(logHolderBaseRight);
 
 	//SetShaderColor(0.100, 0.171, 0.100, 1);
 	SetShaderTexture("metal2");
@@ -1587,24 +2139,14 @@ void SceneManager::RenderFireBox()
 	/****************************************************************/
 
 	//front bottonm log
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM frontBottomLog = BakeTransformations(
+		{ .3f, 3.50f, .3f },
+		0.0f, 0.0f, 90.0f,
+		{ 1.8f, 1.6f, -5.6f });
 
-	scaleXYZ = glm::vec3(.3f, 3.50f, .3f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(1.8f, 1.6f, -5.6f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(frontBottomLog);
 
 	//SetShaderColor(0.100, 0.171, 0.300, 1);
 	SetShaderTexture("bark");
@@ -1620,24 +2162,14 @@ void SceneManager::RenderFireBox()
 	/***********************************************************/
 
 	//back bottonm log
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM backBottomLog = BakeTransformations(
+		{ .3f, 3.50f, .3f },
+		0.0f, 0.0f, 90.0f,
+		{ 1.8f, 1.6f, -6.3f });
 
-	scaleXYZ = glm::vec3(.3f, 3.50f, .3f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(1.8f, 1.6f, -6.3f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(backBottomLog);
 
 	//SetShaderColor(0.100, 0.171, 0.300, 1);
 	SetShaderTexture("bark");
@@ -1652,24 +2184,14 @@ void SceneManager::RenderFireBox()
 	/***********************************************************/
 
 	//Top Diagonal log
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM topDiagonalLog = BakeTransformations(
+		{ .3f, 3.50f, .3f },
+		20.0f, 0.0f, 90.0f,
+		{ 1.8f, 2.1f, -6.5f });
 
-	scaleXYZ = glm::vec3(.3f, 3.50f, .3f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 20.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(1.8f, 2.1f, -6.5f);
-
-	//set the transformatinos into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(topDiagonalLog);
 
 	//SetShaderColor(0.100, 0.171, 0.300, 1);
 	SetShaderTexture("bark");
@@ -1686,35 +2208,20 @@ void SceneManager::RenderFireBox()
 void SceneManager::RenderWall() // restructure code to resemble this
 {
 	//Back Wall Plane
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
 
 	/*** Set needed transformations before drawing the basic mesh.  ***/
 	/*** This same ordering of code should be used for transforming ***/
 	/*** and drawing all the basic 3D shapes.						***/
 	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 8.0f);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 8.0f, -10.0f);
+	// bake the model and normal matrices at compile time
+	static constexpr BAKED_TRANSFORM backWall = BakeTransformations(
+		{ 20.0f, 1.0f, 8.0f },
+		90.0f, 0.0f, 0.0f,
+		{ 0.0f, 8.0f, -10.0f });
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(backWall);
 
 	//SetShaderColor(0.961, 0.961, 0.961, 1);
 	SetShaderTexture("shiplap");
@@ -1725,34 +2232,24 @@ void SceneManager::RenderWall() // restructure code to resemble this
 }
 void SceneManager::RenderTrees()
 {
+	// distant trees are drawn as their cluster meshes
+	m_basicMeshes->BeginObject(OBJECT_LEFT_TREE);
+	if (DrawCluster(m_leftTreeCluster) == false)
+	{
+		RenderTree(m_leftTree);
+	}
+	m_basicMeshes->BeginObject(OBJECT_RIGHT_TREE);
+	if (DrawCluster(m_rightTreeCluster) == false)
+	{
+		RenderTree(m_rightTree);
+	}
+}
 
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-
-	// Cylinder for left tree base
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.25f, 0.25f, 0.25f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-4.5f, 8.5f, -2.75f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+void SceneManager::RenderTree(const TREE_NODES& tree)
+{
+	// Cylinder for tree base
+	// set the world transformation from the scene graph
+	SetTransformations(m_sceneGraph.GetWorldTransform(tree.base));
 
 	SetShaderColor(0.961, 0.871, 0.702, 1);
 
@@ -1760,25 +2257,9 @@ void SceneManager::RenderTrees()
 	m_basicMeshes->DrawCylinderMesh();
 	/****************************************************************/
 
-	//Torus for left tree base
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.19f, 0.19f, 0.19f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-4.5f, 8.75f, -2.75f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	//Torus for tree base
+	// set the world transformation from the scene graph
+	SetTransformations(m_sceneGraph.GetWorldTransform(tree.ring));
 
 	SetShaderColor(0.961, 0.871, 0.702, 1);
 
@@ -1786,25 +2267,9 @@ void SceneManager::RenderTrees()
 	m_basicMeshes->DrawTorusMesh();
 	/****************************************************************/
 
-	//Cone for left tree foliage
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 2.5f, 0.5f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(-4.5f, 8.75f, -2.75f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	//Cone for tree foliage
+	// set the world transformation from the scene graph
+	SetTransformations(m_sceneGraph.GetWorldTransform(tree.foliage));
 
 	SetShaderColor(0.1, 0.1, 0.1, 1);
 	SetShaderTexture("leaf");
@@ -1813,115 +2278,12 @@ void SceneManager::RenderTrees()
 	//Draw the mesh with the transformation values
 	m_basicMeshes->DrawConeMesh();
 	/****************************************************************/
-
-	// Cylinder for right tree base
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.25f, 0.25f, 0.25f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(4.5f, 8.5f, -2.75f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(0.961, 0.871, 0.702, 1);
-
-	//Draw the mesh with the transformation values
-	m_basicMeshes->DrawCylinderMesh();
-	/****************************************************************/
-
-	//Torus for right tree base
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.19f, 0.19f, 0.19f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(4.5f, 8.75f, -2.75f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(0.961, 0.871, 0.702, 1);
-
-	//Draw the mesh with the transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
-
-	//Cone for right tree foliage
-	//set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.5f, 2.5f, 0.5f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set the XYZ positions for the mesh
-	positionXYZ = glm::vec3(4.5f, 8.75f, -2.75f);
-
-	//set the transformation into memmory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(0.1, 0.1, 0.1, 1);
-	SetShaderTexture("leaf");
-	SetTextureUVScale(4, 4);
-	//Draw the mesh with the transformation values
-	m_basicMeshes->DrawConeMesh();
-	/****************************************************************/
 }
 
-
 void SceneManager::RenderWoodenBowl()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	//set XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.35f, 0.4f, 0.4f); 
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 8.75f, -2.9f);
-
-	//set transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the world transformation from the scene graph
+	SetTransformations(m_sceneGraph.GetWorldTransform(m_woodenBowl.rim));
 	
 	//SetShaderColor(1.0, 1.0, 1.0, 1);
 	SetShaderTexture("rusticwood");
@@ -1932,24 +2294,8 @@ void SceneManager::RenderWoodenBowl()
 
 	/************************************************************************/
 
-	//set XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.7f, 0.2f, 0.5f);
-
-	//set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	//set XYZ positions for the mesh
-	positionXYZ = glm::vec3(0.0f, 8.7f, -2.9f); //(0.0f, 2.95f, 4.0f)
-
-	//set transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// set the world transformation from the scene graph
+	SetTransformations(m_sceneGraph.GetWorldTransform(m_woodenBowl.basin));
 
 	//SetShaderColor(1.0, 1.0, 1.0, 1);
 	SetShaderTexture("rusticwood");
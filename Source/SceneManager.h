@@ -10,7 +10,11 @@
 #pragma once
 
 #include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "SceneMeshes.h"
+#include "PipelineStates.h"
+#include "BakedTransforms.h"
+#include "SceneGraph.h"
+#include "SoftwareRasterizer.h"
 
 #include <string>
 #include <vector>
@@ -33,6 +37,8 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// whether the texels have an alpha channel to blend with
+		bool bAlpha;
 	};
 
 	struct OBJECT_MATERIAL
@@ -43,17 +49,101 @@ public:
 		std::string tag;
 	};
 
+	// scene graph nodes for one of the mantle trees
+	struct TREE_NODES
+	{
+		int root;
+		int base;
+		int ring;
+		int foliage;
+	};
+
+	// scene graph nodes for the wooden bowl
+	struct BOWL_NODES
+	{
+		int root;
+		int rim;
+		int basin;
+	};
+
+	// shader values a draw is made with, and which of them were
+	// set since the flags were last cleared
+	struct DRAW_APPEARANCE
+	{
+		glm::vec4 color;
+		std::string textureTag;
+		bool bTextured;
+		glm::vec2 uvScale;
+		std::string materialTag;
+		bool bColorSet;
+		bool bTextureSet;
+		bool bUVScaleSet;
+		bool bMaterialSet;
+	};
+
+	// merged mesh of a group of objects, drawn in place of the
+	// group while the group is small on screen
+	struct OBJECT_CLUSTER
+	{
+		// cluster mesh handle, or -1 for none
+		int mesh;
+		// scene graph node the merged parts are placed under,
+		// or SceneGraph::NO_PARENT for world space
+		int rootNode;
+		// the shader values the group leaves behind when drawn
+		DRAW_APPEARANCE finalAppearance;
+	};
+
+	// the objects the draws of a frame belong to, which keep the
+	// levels of detail of their draws apart
+	enum SCENE_OBJECT
+	{
+		OBJECT_WALL = 0,
+		OBJECT_FIRE_BOX,
+		OBJECT_LEFT_TREE,
+		OBJECT_RIGHT_TREE,
+		OBJECT_WOODEN_BOWL,
+		OBJECT_ROOM
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
+	SceneMeshes* m_basicMeshes;
+	// pointer to the pipeline states of the draws, and the state
+	// of each program variant and blend mode
+	PipelineStates* m_pipelineStates;
+	int m_drawStates[PROGRAM_VARIANT_COUNT][BLEND_MODE_COUNT];
+	// whether the color or texture in use is transparent, and the
+	// blend mode transparent draws are made with
+	bool m_bTransparentAppearance;
+	BLEND_MODE m_transparentBlend;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// transform hierarchy for the composite objects
+	SceneGraph m_sceneGraph;
+	// scene graph nodes of the composite objects
+	TREE_NODES m_leftTree;
+	TREE_NODES m_rightTree;
+	BOWL_NODES m_woodenBowl;
+	// shader values of the next draw, and those captured while
+	// recording a group for its cluster
+	DRAW_APPEARANCE m_appearance;
+	bool m_bRecording;
+	std::vector<DRAW_APPEARANCE> m_recordedAppearances;
+	// bumped whenever a composite object moves
+	uint64_t m_sceneRevision;
+	// merged meshes of the object groups
+	bool m_bClusters;
+	OBJECT_CLUSTER m_fireBoxCluster;
+	OBJECT_CLUSTER m_leftTreeCluster;
+	OBJECT_CLUSTER m_rightTreeCluster;
+	OBJECT_CLUSTER m_woodenBowlCluster;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
@@ -76,6 +166,26 @@ private:
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
 
+	// set a transform baked at compile time
+	// into the transform buffer
+	void SetTransformations(
+		const BAKED_TRANSFORM& transform);
+
+	// set already composed model and normal
+	// matrices into the transform buffer
+	void SetTransformations(
+		const OBJECT_TRANSFORM& transform);
+
+	// create and validate the pipeline states of the draws -
+	// called once the meshes are uploaded
+	void CreatePipelineStates();
+	// select the pipeline state of the color or texture in use
+	void SelectPipelineState();
+
+	// add the composite objects to the scene graph
+	void BuildSceneGraph();
+	TREE_NODES AddTreeNodes(glm::vec3 positionXYZ);
+
 	// set the color values into the shader
 	void SetShaderColor(
 		float redColorValue,
@@ -95,20 +205,90 @@ private:
 	void SetShaderMaterial(
 		std::string materialTag);
 
+	// capture the draws of a group and the shader values of each
+	void BeginRecording();
+	std::vector<SceneMeshes::RECORDED_DRAW> EndRecording(DRAW_APPEARANCE& finalAppearance);
+	// snapshot the shader values while recording
+	void RecordAppearance();
+	// merge the object groups into cluster meshes with one
+	// texture atlas - called before the meshes are uploaded
+	void BuildClusters();
+	// draw a group as its cluster mesh if it is small enough
+	// on screen - returns false when the group must be drawn
+	bool DrawCluster(const OBJECT_CLUSTER& cluster);
+	// set all of the passed in shader values
+	void ApplyAppearance(const DRAW_APPEARANCE& appearance);
+	// draw every object of the scene
+	void RenderObjects();
+
 public:
 	void DefineObjectMaterials();
 	void SetupSceneLights();
 	// The following methods are for the students to 
-	// customize for their own 3D scene
-	void PrepareScene();
-	void RenderScene();
+	// customize for their own 3D scene - returns false when
+	// a texture could not be loaded
+	bool PrepareScene();
 
-	//load all of the needed textures before rendering
-	void LoadSceneTextures();
+	// the draws RenderScene() makes - all of them, with the
+	// transparent ones blended in drawing order, or the opaque
+	// and transparent ones on their own
+	enum RENDER_PASS
+	{
+		RENDER_ALL = 0,
+		RENDER_OPAQUE,
+		RENDER_TRANSPARENT
+	};
+	// draw the scene - the transparent pass follows the opaque
+	// pass of the same frame, and draws the transparent surfaces
+	// with weighted blending and without writing depth
+	void RenderScene(RENDER_PASS pass = RENDER_ALL);
+	// whether the transparent surfaces can be drawn in a pass of
+	// their own with weighted blending
+	bool HasTransparencyPass() const;
+
+	//load all of the needed textures before rendering - returns
+	// false when any of them could not be loaded
+	bool LoadSceneTextures();
+	// image files of the textures LoadSceneTextures() loads
+	static std::vector<std::string> GetTextureFilenames();
 
 	void RenderWall();
 	void RenderFireBox();
 	void RenderTrees();
+	void RenderTree(const TREE_NODES& tree);
 	void RenderWoodenBowl();
 
+	// move the composite objects - only their own scene
+	// graph nodes are updated on the next frame
+	void SetTreePosition(bool bLeftTree, glm::vec3 positionXYZ);
+	void SetWoodenBowlPosition(glm::vec3 positionXYZ);
+
+	// camera matrices of the frame, used for the level of detail
+	void SetViewProjection(const glm::mat4& view, const glm::mat4& projection);
+	// choose the levels of detail of the next frame without the
+	// hysteresis of the frames before it
+	void ResetDetailState();
+	// draw the curved shapes as patches for the tessellation stages
+	void SetTessellation(bool bEnabled);
+	// ray-cast the curved shapes as impostors in proxy boxes -
+	// returns false when the impostor program does not build
+	bool SetImpostors(bool bEnabled);
+	// cull the meshlets of each draw before submitting it
+	void SetMeshletCulling(bool bEnabled);
+	// draw distant object groups as merged cluster meshes -
+	// called before PrepareScene()
+	void SetClusters(bool bEnabled);
+	// keep a copy of the shared geometry for the software
+	// rasterizer - called before PrepareScene()
+	void SetKeepGeometry(bool bEnabled);
+	// capture the draws, textures and lights of a frame for the
+	// software rasterizer - the camera is left to the caller
+	void RecordRasterScene(RASTER_SCENE& scene);
+	// triangles drawn by the last rendered frame
+	size_t GetFrameTriangles() const;
+	// hash of everything the rendered frames depend on besides
+	// the camera - the geometry, draw modes, texture files and
+	// the positions of the composite objects
+	uint64_t GetSceneVersion() const;
+
 };
\ No newline at end of file
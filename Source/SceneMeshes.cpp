@@ -0,0 +1,1633 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenemeshes.cpp
+// ===============
+// basic 3D shapes suballocated from one shared vertex and index buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneMeshes.h"
+#include "MeshCache.h"
+#include "MeshImporter.h"
+#include "ParallelMeshes.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// tessellation of each level of detail of the curved shapes,
+	// followed by the coarse patches for hardware tessellation -
+	// sphere stacks and torus main segments must stay even so the
+	// half shapes end on a ring of vertices
+	const int g_CylinderSlices[SceneMeshes::LEVEL_COUNT] = { 36, 18, 9, 8 };
+	const int g_ConeSlices[SceneMeshes::LEVEL_COUNT] = { 36, 18, 9, 8 };
+	const int g_SphereSlices[SceneMeshes::LEVEL_COUNT] = { 36, 24, 12, 8 };
+	const int g_SphereStacks[SceneMeshes::LEVEL_COUNT] = { 18, 12, 6, 4 };
+	const int g_TorusMainSegments[SceneMeshes::LEVEL_COUNT] = { 48, 24, 12, 8 };
+	const int g_TorusTubeSegments[SceneMeshes::LEVEL_COUNT] = { 24, 12, 8, 4 };
+
+	// surface evaluated by the tessellation evaluation shader for
+	// each shape - 0 passes flat shapes through
+	const int g_SurfaceTypes[SceneMeshes::MESH_COUNT] = { 0, 0, 1, 1, 1, 2, 3, 3, 4, 4, 0 };
+
+	// shape ray-cast by the fragment shader for each mesh drawn as
+	// an impostor, and the object space box each one fills
+	const int g_ImpostorTypes[SceneMeshes::MESH_COUNT] = { 0, 0, 1, 1, 1, 2, 3, 4, 5, 6, 0 };
+	const float g_TorusOuterRadius = 1.0f + PrimitiveMeshes::TORUS_TUBE_RADIUS;
+	const MESH_BOUNDS g_ImpostorBounds[] =
+	{
+		{ glm::vec3(0.0f), glm::vec3(0.0f) },
+		{ glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(2.0f, 1.0f, 2.0f) },
+		{ glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(2.0f, 1.0f, 2.0f) },
+		{ glm::vec3(-1.0f, -1.0f, -1.0f), glm::vec3(2.0f, 2.0f, 2.0f) },
+		{ glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(2.0f, 1.0f, 2.0f) },
+		{ glm::vec3(-g_TorusOuterRadius, -g_TorusOuterRadius, -PrimitiveMeshes::TORUS_TUBE_RADIUS),
+			glm::vec3(2.0f * g_TorusOuterRadius, 2.0f * g_TorusOuterRadius, 2.0f * PrimitiveMeshes::TORUS_TUBE_RADIUS) },
+		{ glm::vec3(-g_TorusOuterRadius, 0.0f, -PrimitiveMeshes::TORUS_TUBE_RADIUS),
+			glm::vec3(2.0f * g_TorusOuterRadius, g_TorusOuterRadius, 2.0f * PrimitiveMeshes::TORUS_TUBE_RADIUS) }
+	};
+	// cylinder parts intersected by the impostor
+	const int g_ImpostorPartTop = 1;
+	const int g_ImpostorPartBottom = 2;
+	const int g_ImpostorPartSides = 4;
+	const int g_ImpostorAllParts = 7;
+
+	// shapes with no open edges, whose back faces are always hidden
+	// by their front faces, so back-facing meshlets can be culled
+	const bool g_ClosedMeshes[SceneMeshes::MESH_COUNT] =
+		{ false, true, false, false, false, true, true, false, true, false, true };
+	// distance behind the eye of an orthographic projection that the
+	// back-face culling views from
+	const float g_OrthographicCameraDistance = 10000.0f;
+
+	// a draw switches to the next coarser level once the radius of
+	// its bounding sphere on screen, as a fraction of the viewport
+	// height, falls below the threshold of its current level
+	const float g_LodThresholds[SceneMeshes::LOD_COUNT - 1] = { 0.08f, 0.025f };
+	// the radius must move this far past a threshold to switch back
+	const float g_LodHysteresis = 0.15f;
+	// marks a draw that has no level chosen yet
+	const unsigned char g_NoLod = 0xFF;
+	// a cluster is drawn as its merged mesh once its bounding sphere
+	// on screen is smaller than this, with the same margin as the
+	// levels of detail
+	const float g_ClusterScreenRadius = 0.06f;
+
+	// generated shapes are cached here between runs
+	const char* g_MeshCacheFilename = "meshcache.bin";
+
+	// shader uniforms that decode the quantized positions
+	const char* g_BoundsMinName = "meshBoundsMin";
+	const char* g_BoundsExtentName = "meshBoundsExtent";
+
+	// name of one level of a shape for the optimizer report
+	std::string LodName(const char* name, int lod)
+	{
+		if (lod == SceneMeshes::PATCH_LEVEL)
+		{
+			return(std::string(name) + " patches");
+		}
+		return(std::string(name) + " LOD" + std::to_string(lod));
+	}
+
+	// shader uniforms used by the tessellation stages
+	const char* g_SurfaceTypeName = "surfaceType";
+	const char* g_ViewportSizeName = "viewportSize";
+	// shader uniform the tessellated torus is made with
+	const char* g_TorusTubeRadiusName = "torusTubeRadius";
+
+	// a range that draws nothing
+	MESH_RANGE EmptyRange()
+	{
+		MESH_RANGE range;
+		range.baseVertex = 0;
+		range.firstIndex = 0;
+		range.indexCount = 0;
+		range.bounds.minimum = glm::vec3(0.0f);
+		range.bounds.extent = glm::vec3(0.0f);
+		range.firstMeshlet = 0;
+		range.meshletCount = 0;
+		return(range);
+	}
+
+	// append the vertices and triangles of one mesh to another
+	void AppendMesh(MESH_DATA& target, const MESH_DATA& source)
+	{
+		const uint32_t vertexOffset = (uint32_t)target.vertices.size();
+
+		target.vertices.insert(target.vertices.end(), source.vertices.begin(), source.vertices.end());
+		for (uint32_t index : source.indices)
+		{
+			target.indices.push_back(index + vertexOffset);
+		}
+	}
+}
+
+/***********************************************************
+ *  SceneMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneMeshes::SceneMeshes(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_pPipelineStates = NULL;
+	m_drawQueue = QUEUE_ALL;
+	m_frameDeferredDraws = 0;
+	m_boundsBaseVertex = -1;
+	m_surfaceType = -1;
+	m_bTessellation = false;
+	m_impostorType = -1;
+	m_impostorParts = -1;
+	m_bImpostors = false;
+	m_bMeshletCulling = true;
+	m_bRecording = false;
+	m_recordedAppearance = -1;
+	m_bKeepGeometry = false;
+	m_frameMeshletTriangles = 0;
+	m_frameCulledTriangles = 0;
+	m_reportedCulledTriangles = 0;
+	m_cameraPosition = glm::vec3(0.0f);
+	m_cameraForward = glm::vec3(0.0f, 0.0f, -1.0f);
+	m_model = glm::mat4(1.0f);
+	m_viewProjection = glm::mat4(1.0f);
+	m_projectionScaleY = 1.0f;
+	m_drawObject = 0;
+	m_drawSequence = 0;
+	m_frameTriangles = 0;
+	m_frameFullTriangles = 0;
+	m_reportedSavedTriangles = 0;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	for (int lod = 0; lod < LEVEL_COUNT; lod++)
+	{
+		for (int i = 0; i < MESH_COUNT; i++)
+		{
+			m_ranges[lod][i].baseVertex = 0;
+			m_ranges[lod][i].firstIndex = 0;
+			m_ranges[lod][i].indexCount = 0;
+			m_ranges[lod][i].bounds.minimum = glm::vec3(0.0f);
+			m_ranges[lod][i].bounds.extent = glm::vec3(0.0f);
+			m_ranges[lod][i].firstMeshlet = 0;
+			m_ranges[lod][i].meshletCount = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  ~SceneMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneMeshes::~SceneMeshes()
+{
+	if (m_indexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_indexBuffer);
+		m_indexBuffer = 0;
+	}
+	if (m_vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_vertexBuffer);
+		m_vertexBuffer = 0;
+	}
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		m_vao = 0;
+	}
+}
+
+/***********************************************************
+ *  StageMesh()
+ *
+ *  This method is used for splitting a generated mesh into
+ *  meshlets, reordering each meshlet for the vertex cache
+ *  and overdraw, reporting the cache efficiency before and
+ *  after, and appending the mesh to the staged geometry
+ *  quantized against its own bounds.  Each segment is a
+ *  range that is drawn on its own, and all of them share
+ *  one base vertex so any run of neighbouring segments can
+ *  be drawn as one.  Segments are split into meshlets
+ *  separately, so the meshlets of any run of segments are a
+ *  run of meshlets too.
+ ***********************************************************/
+void SceneMeshes::StageMesh(
+	const char* name,
+	MESH_DATA& mesh,
+	const std::vector<size_t>& segmentIndexCounts,
+	MESH_RANGE* pSegmentRanges)
+{
+	const VERTEX_CACHE_STATS before = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+	const MESH_BOUNDS bounds = VertexPacking::ComputeBounds(mesh.vertices);
+	const GLint baseVertex = (GLint)m_stagedVertices.size();
+	const GLuint meshFirstIndex = (GLuint)m_stagedIndices.size();
+	const size_t meshFirstMeshlet = m_meshlets.size();
+	size_t segmentStart = 0;
+	for (size_t segment = 0; segment < segmentIndexCounts.size(); segment++)
+	{
+		pSegmentRanges[segment].bounds = bounds;
+		pSegmentRanges[segment].baseVertex = baseVertex;
+		pSegmentRanges[segment].firstIndex = meshFirstIndex + (GLuint)segmentStart;
+		pSegmentRanges[segment].indexCount = (GLsizei)segmentIndexCounts[segment];
+		pSegmentRanges[segment].firstMeshlet = (GLuint)m_meshlets.size();
+		Meshlets::BuildMeshlets(mesh, segmentStart, segmentIndexCounts[segment], meshFirstIndex, m_meshlets);
+		pSegmentRanges[segment].meshletCount = (GLuint)m_meshlets.size() - pSegmentRanges[segment].firstMeshlet;
+		segmentStart += segmentIndexCounts[segment];
+	}
+
+	// each meshlet is optimized on its own so the triangles stay
+	// inside it - the bounds do not depend on the order
+	std::vector<size_t> meshletIndexCounts;
+	for (size_t meshlet = meshFirstMeshlet; meshlet < m_meshlets.size(); meshlet++)
+	{
+		meshletIndexCounts.push_back(m_meshlets[meshlet].indexCount);
+	}
+	MeshOptimizer::OptimizeMesh(mesh, meshletIndexCounts);
+
+	const VERTEX_CACHE_STATS after = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+	std::cout << "INFO: " << name << " vertex cache ACMR " << before.acmr << " -> " << after.acmr
+		<< ", ATVR " << before.atvr << " -> " << after.atvr
+		<< ", " << (m_meshlets.size() - meshFirstMeshlet) << " meshlets" << std::endl;
+
+	VertexPacking::PackVertices(mesh.vertices, bounds, m_stagedVertices);
+	m_stagedIndices.insert(m_stagedIndices.end(), mesh.indices.begin(), mesh.indices.end());
+}
+
+/***********************************************************
+ *  RequestShape()
+ *
+ *  This method is used for adding a shape to the list that
+ *  UploadMeshes() loads.  A shape is only loaded once.
+ ***********************************************************/
+void SceneMeshes::RequestShape(SHAPE_TYPE shape)
+{
+	for (SHAPE_TYPE requested : m_requestedShapes)
+	{
+		if (requested == shape)
+		{
+			return;
+		}
+	}
+	m_requestedShapes.push_back(shape);
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for requesting the plane shape.
+ ***********************************************************/
+void SceneMeshes::LoadPlaneMesh()
+{
+	RequestShape(SHAPE_PLANE);
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for requesting the box shape.
+ ***********************************************************/
+void SceneMeshes::LoadBoxMesh()
+{
+	RequestShape(SHAPE_BOX);
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for requesting the cylinder shape.
+ ***********************************************************/
+void SceneMeshes::LoadCylinderMesh()
+{
+	RequestShape(SHAPE_CYLINDER);
+}
+
+/***********************************************************
+ *  LoadConeMesh()
+ *
+ *  This method is used for requesting the cone shape.
+ ***********************************************************/
+void SceneMeshes::LoadConeMesh()
+{
+	RequestShape(SHAPE_CONE);
+}
+
+/***********************************************************
+ *  LoadSphereMesh()
+ *
+ *  This method is used for requesting the sphere shape.
+ ***********************************************************/
+void SceneMeshes::LoadSphereMesh()
+{
+	RequestShape(SHAPE_SPHERE);
+}
+
+/***********************************************************
+ *  LoadTorusMesh()
+ *
+ *  This method is used for requesting the torus shape.
+ ***********************************************************/
+void SceneMeshes::LoadTorusMesh()
+{
+	RequestShape(SHAPE_TORUS);
+}
+
+/***********************************************************
+ *  LoadMeshFile()
+ *
+ *  This method is used for requesting a model file.  The
+ *  returned handle stays valid even if the file cannot be
+ *  loaded, in which case drawing it draws nothing.
+ ***********************************************************/
+int SceneMeshes::LoadMeshFile(const char* filename)
+{
+	for (size_t i = 0; i < m_meshFiles.size(); i++)
+	{
+		if (m_meshFiles[i] == filename)
+		{
+			return((int)i);
+		}
+	}
+	m_meshFiles.push_back(filename);
+	return((int)m_meshFiles.size() - 1);
+}
+
+/***********************************************************
+ *  LoadClusterMesh()
+ *
+ *  This method is used for requesting a cluster mesh that
+ *  merges the passed in parts.
+ ***********************************************************/
+int SceneMeshes::LoadClusterMesh(const char* name, const std::vector<CLUSTER_PART>& parts)
+{
+	m_clusterNames.push_back(name);
+	m_clusterParts.push_back(parts);
+	m_clusterMerged.push_back(0);
+	return((int)m_clusterParts.size() - 1);
+}
+
+/***********************************************************
+ *  BeginRecording()
+ *
+ *  This method is used for capturing the following draws
+ *  with their model matrices instead of drawing them, so a
+ *  group of draws can be merged into a cluster mesh.
+ ***********************************************************/
+void SceneMeshes::BeginRecording()
+{
+	m_recordedDraws.clear();
+	m_recordedAppearance = -1;
+	m_bRecording = true;
+}
+
+/***********************************************************
+ *  EndRecording()
+ *
+ *  This method is used for returning to drawing and getting
+ *  the draws captured since BeginRecording().
+ ***********************************************************/
+std::vector<SceneMeshes::RECORDED_DRAW> SceneMeshes::EndRecording()
+{
+	std::vector<RECORDED_DRAW> draws;
+	draws.swap(m_recordedDraws);
+	m_bRecording = false;
+	return(draws);
+}
+
+/***********************************************************
+ *  SkipDraw()
+ *
+ *  This method is used for checking the queue of the next
+ *  draw against the queue being drawn.  A draw whose
+ *  pipeline state blends belongs to the transparent queue,
+ *  and is counted when the opaque queue holds it back.
+ ***********************************************************/
+bool SceneMeshes::SkipDraw()
+{
+	if ((m_drawQueue == QUEUE_ALL) || (NULL == m_pPipelineStates))
+	{
+		return(false);
+	}
+
+	const int state = m_pPipelineStates->GetSelected();
+	const bool bBlended = (state >= 0) && (m_pPipelineStates->GetDesc(state).blend != BLEND_OPAQUE);
+	if (m_drawQueue == QUEUE_OPAQUE)
+	{
+		if (bBlended)
+		{
+			m_frameDeferredDraws++;
+		}
+		return(bBlended);
+	}
+	return(!bBlended);
+}
+
+/***********************************************************
+ *  RecordDraw()
+ *
+ *  This method is used for capturing a draw of a shape when
+ *  recording.  It returns false when the shape should be
+ *  drawn instead.
+ ***********************************************************/
+bool SceneMeshes::RecordDraw(MESH_ID mesh)
+{
+	if (m_bRecording == false)
+	{
+		return(false);
+	}
+
+	RECORDED_DRAW draw;
+	draw.mesh = mesh;
+	draw.model = m_model;
+	draw.appearance = m_recordedAppearance;
+	m_recordedDraws.push_back(draw);
+	return(true);
+}
+
+/***********************************************************
+ *  StagePlaneMesh()
+ *
+ *  This method is used for generating the plane shape and
+ *  adding it to the staged geometry.  A flat shape has a
+ *  single level that every level of detail refers to.
+ ***********************************************************/
+void SceneMeshes::StagePlaneMesh()
+{
+	MESH_DATA plane = PrimitiveMeshes::GeneratePlane();
+	StageMesh("plane", plane, { plane.indices.size() }, &m_ranges[0][MESH_PLANE]);
+
+	for (int lod = 1; lod < LEVEL_COUNT; lod++)
+	{
+		m_ranges[lod][MESH_PLANE] = m_ranges[0][MESH_PLANE];
+	}
+}
+
+/***********************************************************
+ *  StageBoxMesh()
+ *
+ *  This method is used for generating the box shape and
+ *  adding it to the staged geometry.  A flat shape has a
+ *  single level that every level of detail refers to.
+ ***********************************************************/
+void SceneMeshes::StageBoxMesh()
+{
+	MESH_DATA box = PrimitiveMeshes::GenerateBox();
+	StageMesh("box", box, { box.indices.size() }, &m_ranges[0][MESH_BOX]);
+
+	for (int lod = 1; lod < LEVEL_COUNT; lod++)
+	{
+		m_ranges[lod][MESH_BOX] = m_ranges[0][MESH_BOX];
+	}
+}
+
+/***********************************************************
+ *  StageCylinderMesh()
+ *
+ *  This method is used for generating each level of the
+ *  cylinder shape and adding it to the staged geometry.  The
+ *  top, bottom and sides are stored in that order, so both
+ *  caps or the whole cylinder are each a single range.
+ ***********************************************************/
+void SceneMeshes::StageCylinderMesh()
+{
+	for (int lod = 0; lod < LEVEL_COUNT; lod++)
+	{
+		const int slices = g_CylinderSlices[lod];
+		MESH_DATA cylinder = PrimitiveMeshes::GenerateCylinderCap(slices, true);
+		const size_t topCount = cylinder.indices.size();
+		AppendMesh(cylinder, PrimitiveMeshes::GenerateCylinderCap(slices, false));
+		const size_t bottomCount = cylinder.indices.size() - topCount;
+		AppendMesh(cylinder, ParallelMeshes::GenerateCylinderSides(slices));
+		const size_t sidesCount = cylinder.indices.size() - topCount - bottomCount;
+
+		StageMesh(LodName("cylinder", lod).c_str(), cylinder,
+			{ topCount, bottomCount, sidesCount }, &m_ranges[lod][MESH_CYLINDER_TOP]);
+	}
+}
+
+/***********************************************************
+ *  StageConeMesh()
+ *
+ *  This method is used for generating each level of the
+ *  cone shape and adding it to the staged geometry.
+ ***********************************************************/
+void SceneMeshes::StageConeMesh()
+{
+	for (int lod = 0; lod < LEVEL_COUNT; lod++)
+	{
+		MESH_DATA cone = PrimitiveMeshes::GenerateCone(g_ConeSlices[lod]);
+		StageMesh(LodName("cone", lod).c_str(), cone, { cone.indices.size() }, &m_ranges[lod][MESH_CONE]);
+	}
+}
+
+/***********************************************************
+ *  StageSphereMesh()
+ *
+ *  This method is used for generating each level of the
+ *  sphere shape and adding it to the staged geometry.  The
+ *  stacks start at the north pole, so the upper half of the
+ *  generated indices is optimized as its own segment and
+ *  the half sphere is drawn from it.
+ ***********************************************************/
+void SceneMeshes::StageSphereMesh()
+{
+	for (int lod = 0; lod < LEVEL_COUNT; lod++)
+	{
+		const int slices = g_SphereSlices[lod];
+		const int stacks = g_SphereStacks[lod];
+		MESH_DATA sphere = ParallelMeshes::GenerateSphere(slices, stacks, false);
+		const size_t halfCount = (stacks / 2) * slices * 6;
+		MESH_RANGE halves[2];
+
+		StageMesh(LodName("sphere", lod).c_str(), sphere,
+			{ halfCount, sphere.indices.size() - halfCount }, halves);
+
+		m_ranges[lod][MESH_HALF_SPHERE] = halves[0];
+		m_ranges[lod][MESH_SPHERE] = halves[0];
+		m_ranges[lod][MESH_SPHERE].indexCount += halves[1].indexCount;
+		m_ranges[lod][MESH_SPHERE].meshletCount += halves[1].meshletCount;
+	}
+}
+
+/***********************************************************
+ *  StageTorusMesh()
+ *
+ *  This method is used for generating each level of the
+ *  torus shape and adding it to the staged geometry.  The
+ *  ring is swept from +X through +Y, so the first half of
+ *  the generated indices is optimized as its own segment
+ *  and the half torus is drawn from it.
+ ***********************************************************/
+void SceneMeshes::StageTorusMesh()
+{
+	for (int lod = 0; lod < LEVEL_COUNT; lod++)
+	{
+		const int mainSegments = g_TorusMainSegments[lod];
+		const int tubeSegments = g_TorusTubeSegments[lod];
+		MESH_DATA torus = ParallelMeshes::GenerateTorus(mainSegments, tubeSegments, 360.0f);
+		const size_t halfCount = (mainSegments / 2) * tubeSegments * 6;
+		MESH_RANGE halves[2];
+
+		StageMesh(LodName("torus", lod).c_str(), torus,
+			{ halfCount, torus.indices.size() - halfCount }, halves);
+
+		m_ranges[lod][MESH_HALF_TORUS] = halves[0];
+		m_ranges[lod][MESH_TORUS] = halves[0];
+		m_ranges[lod][MESH_TORUS].indexCount += halves[1].indexCount;
+		m_ranges[lod][MESH_TORUS].meshletCount += halves[1].meshletCount;
+	}
+}
+
+/***********************************************************
+ *  StageProxyMesh()
+ *
+ *  This method is used for generating the proxy box that the
+ *  impostors are drawn with and adding it to the staged
+ *  geometry.  Its corners quantize to exactly 0 and 1, so
+ *  setting the bounds of a shape when it is drawn stretches
+ *  the box over that shape.
+ ***********************************************************/
+void SceneMeshes::StageProxyMesh()
+{
+	MESH_DATA proxy = PrimitiveMeshes::GenerateBox();
+	StageMesh("impostor proxy", proxy, { proxy.indices.size() }, &m_ranges[0][MESH_PROXY]);
+
+	for (int lod = 1; lod < LEVEL_COUNT; lod++)
+	{
+		m_ranges[lod][MESH_PROXY] = m_ranges[0][MESH_PROXY];
+	}
+}
+
+/***********************************************************
+ *  StageMeshFiles()
+ *
+ *  This method is used for importing the requested model
+ *  files and adding each one to the staged geometry as a
+ *  single range.
+ ***********************************************************/
+void SceneMeshes::StageMeshFiles()
+{
+	m_fileRanges.assign(m_meshFiles.size(), EmptyRange());
+	for (size_t i = 0; i < m_meshFiles.size(); i++)
+	{
+		MESH_DATA model;
+		if (MeshImporter::ImportMesh(m_meshFiles[i].c_str(), model))
+		{
+			StageMesh(m_meshFiles[i].c_str(), model, { model.indices.size() }, &m_fileRanges[i]);
+		}
+	}
+}
+
+/***********************************************************
+ *  GenerateCoarsestMesh()
+ *
+ *  This method is used for generating one shape at the
+ *  coarsest level of detail, for merging into a cluster.
+ ***********************************************************/
+MESH_DATA SceneMeshes::GenerateCoarsestMesh(MESH_ID mesh) const
+{
+	const int lod = LOD_COUNT - 1;
+
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		return(PrimitiveMeshes::GeneratePlane());
+	case MESH_BOX:
+		return(PrimitiveMeshes::GenerateBox());
+	case MESH_CYLINDER_TOP:
+		return(PrimitiveMeshes::GenerateCylinderCap(g_CylinderSlices[lod], true));
+	case MESH_CYLINDER_BOTTOM:
+		return(PrimitiveMeshes::GenerateCylinderCap(g_CylinderSlices[lod], false));
+	case MESH_CYLINDER_SIDES:
+		return(ParallelMeshes::GenerateCylinderSides(g_CylinderSlices[lod]));
+	case MESH_CONE:
+		return(PrimitiveMeshes::GenerateCone(g_ConeSlices[lod]));
+	case MESH_SPHERE:
+	case MESH_HALF_SPHERE:
+		return(ParallelMeshes::GenerateSphere(g_SphereSlices[lod], g_SphereStacks[lod], mesh == MESH_HALF_SPHERE));
+	case MESH_TORUS:
+	case MESH_HALF_TORUS:
+		return(ParallelMeshes::GenerateTorus(g_TorusMainSegments[lod], g_TorusTubeSegments[lod],
+			(mesh == MESH_HALF_TORUS) ? 180.0f : 360.0f));
+	default:
+		return(MESH_DATA());
+	}
+}
+
+/***********************************************************
+ *  StageClusterMeshes()
+ *
+ *  This method is used for merging the parts of each
+ *  requested cluster into one mesh and adding it to the
+ *  staged geometry as a single range.  Normals are moved by
+ *  the cofactor matrix of each part's model matrix, which
+ *  stays valid for the flattened parts whose scale has a
+ *  zero, and mirrored parts have their triangles flipped.
+ ***********************************************************/
+void SceneMeshes::StageClusterMeshes()
+{
+	m_clusterRanges.clear();
+	for (size_t cluster = 0; cluster < m_clusterParts.size(); cluster++)
+	{
+		MESH_DATA merged;
+		for (const CLUSTER_PART& part : m_clusterParts[cluster])
+		{
+			MESH_DATA mesh = GenerateCoarsestMesh(part.mesh);
+			const glm::vec3 axes[3] = { glm::vec3(part.model[0]), glm::vec3(part.model[1]), glm::vec3(part.model[2]) };
+			const glm::mat3 cofactor(
+				glm::cross(axes[1], axes[2]),
+				glm::cross(axes[2], axes[0]),
+				glm::cross(axes[0], axes[1]));
+			const float determinant = glm::dot(axes[0], cofactor[0]);
+
+			for (MESH_VERTEX& vertex : mesh.vertices)
+			{
+				vertex.position = glm::vec3(part.model * glm::vec4(vertex.position, 1.0f));
+				glm::vec3 normal = cofactor * vertex.normal;
+				if (determinant < 0.0f)
+				{
+					normal = -normal;
+				}
+				const float length = glm::length(normal);
+				vertex.normal = (length > 0.0f) ? (normal / length) : vertex.normal;
+				vertex.textureCoordinate = part.atlasOffset +
+					(glm::clamp(vertex.textureCoordinate, glm::vec2(0.0f), glm::vec2(1.0f)) * part.atlasScale);
+			}
+			if (determinant < 0.0f)
+			{
+				for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+				{
+					std::swap(mesh.indices[i + 1], mesh.indices[i + 2]);
+				}
+			}
+			AppendMesh(merged, mesh);
+		}
+
+		MESH_RANGE range = EmptyRange();
+		if (!merged.indices.empty())
+		{
+			StageMesh(("cluster " + m_clusterNames[cluster]).c_str(), merged, { merged.indices.size() }, &range);
+		}
+		m_clusterRanges.push_back(range);
+	}
+}
+
+/***********************************************************
+ *  ComputeCacheKey()
+ *
+ *  This method is used for hashing every value that affects
+ *  the generated buffer contents: the requested shapes and
+ *  their order, the requested model files with their sizes
+ *  and modification times, the tessellation, the optimizer
+ *  cache size and the layout of the stored structures.
+ ***********************************************************/
+uint64_t SceneMeshes::ComputeCacheKey() const
+{
+	const float parameters[] =
+	{
+		PrimitiveMeshes::TORUS_TUBE_RADIUS,
+		(float)MeshOptimizer::VERTEX_CACHE_SIZE,
+		(float)sizeof(MESH_RANGE),
+		(float)sizeof(PACKED_VERTEX),
+		(float)sizeof(MESHLET),
+		(float)Meshlets::MAX_VERTICES,
+		(float)Meshlets::MAX_TRIANGLES,
+		(float)MESH_COUNT,
+		(float)LOD_COUNT,
+		(float)LEVEL_COUNT
+	};
+
+	uint64_t key = MeshCache::Hash(parameters, sizeof(parameters));
+	key = MeshCache::Hash(g_CylinderSlices, sizeof(g_CylinderSlices), key);
+	key = MeshCache::Hash(g_ConeSlices, sizeof(g_ConeSlices), key);
+	key = MeshCache::Hash(g_SphereSlices, sizeof(g_SphereSlices), key);
+	key = MeshCache::Hash(g_SphereStacks, sizeof(g_SphereStacks), key);
+	key = MeshCache::Hash(g_TorusMainSegments, sizeof(g_TorusMainSegments), key);
+	key = MeshCache::Hash(g_TorusTubeSegments, sizeof(g_TorusTubeSegments), key);
+	for (SHAPE_TYPE shape : m_requestedShapes)
+	{
+		const int32_t shapeValue = (int32_t)shape;
+		key = MeshCache::Hash(&shapeValue, sizeof(shapeValue), key);
+	}
+	for (const std::string& filename : m_meshFiles)
+	{
+		struct stat status;
+		int64_t fileValues[2] = { -1, -1 };
+		if (stat(filename.c_str(), &status) == 0)
+		{
+			fileValues[0] = (int64_t)status.st_size;
+			fileValues[1] = (int64_t)status.st_mtime;
+		}
+		key = MeshCache::Hash(filename.c_str(), filename.size() + 1, key);
+		key = MeshCache::Hash(fileValues, sizeof(fileValues), key);
+	}
+	for (size_t cluster = 0; cluster < m_clusterParts.size(); cluster++)
+	{
+		const uint64_t partCount = m_clusterParts[cluster].size();
+		key = MeshCache::Hash(&partCount, sizeof(partCount), key);
+		for (const CLUSTER_PART& part : m_clusterParts[cluster])
+		{
+			const int32_t meshValue = (int32_t)part.mesh;
+			key = MeshCache::Hash(&meshValue, sizeof(meshValue), key);
+			key = MeshCache::Hash(&part.model[0][0], sizeof(glm::mat4), key);
+			key = MeshCache::Hash(&part.atlasOffset[0], sizeof(glm::vec2), key);
+			key = MeshCache::Hash(&part.atlasScale[0], sizeof(glm::vec2), key);
+		}
+	}
+
+	return(key);
+}
+
+/***********************************************************
+ *  ComputeSceneKey()
+ *
+ *  This method is used for extending the cache key with the
+ *  tessellation and impostor modes, which draw the same
+ *  geometry differently.  Meshlet culling only skips what
+ *  would not be seen, so it is left out.
+ ***********************************************************/
+uint64_t SceneMeshes::ComputeSceneKey() const
+{
+	const int32_t modes[] = { m_bTessellation ? 1 : 0, m_bImpostors ? 1 : 0 };
+	return(MeshCache::Hash(modes, sizeof(modes), ComputeCacheKey()));
+}
+
+/***********************************************************
+ *  UploadMeshes()
+ *
+ *  This method is used for loading all of the requested
+ *  shapes into the shared vertex and index buffers.  When
+ *  the mesh cache file matches, it is memory mapped and the
+ *  buffers are filled straight from the mapping.  Otherwise
+ *  the shapes are generated, optimized and packed, and the
+ *  result is written to the cache for the next run.
+ ***********************************************************/
+void SceneMeshes::UploadMeshes()
+{
+	const uint64_t key = ComputeCacheKey();
+	const uint32_t shapeRangeCount = LEVEL_COUNT * MESH_COUNT;
+	const uint32_t fileRangeEnd = shapeRangeCount + (uint32_t)m_meshFiles.size();
+	const uint32_t rangeCount = fileRangeEnd + (uint32_t)m_clusterParts.size();
+	MappedFile cacheFile;
+	MESH_CACHE_VIEW cached;
+
+	if (MeshCache::Open(g_MeshCacheFilename, key, rangeCount, cacheFile, cached))
+	{
+		memcpy(m_ranges, cached.pRanges, sizeof(m_ranges));
+		m_fileRanges.assign(cached.pRanges + shapeRangeCount, cached.pRanges + fileRangeEnd);
+		m_clusterRanges.assign(cached.pRanges + fileRangeEnd, cached.pRanges + rangeCount);
+		m_meshlets.assign(cached.pMeshlets, cached.pMeshlets + cached.meshletCount);
+		UploadBuffers(cached.pVertices, cached.vertexCount, cached.pIndices, cached.indexCount);
+		std::cout << "INFO: shared mesh buffer mapped from " << g_MeshCacheFilename << std::endl;
+		return;
+	}
+
+	for (SHAPE_TYPE shape : m_requestedShapes)
+	{
+		switch (shape)
+		{
+		case SHAPE_PLANE:
+			StagePlaneMesh();
+			break;
+		case SHAPE_BOX:
+			StageBoxMesh();
+			break;
+		case SHAPE_CYLINDER:
+			StageCylinderMesh();
+			break;
+		case SHAPE_CONE:
+			StageConeMesh();
+			break;
+		case SHAPE_SPHERE:
+			StageSphereMesh();
+			break;
+		case SHAPE_TORUS:
+			StageTorusMesh();
+			break;
+		}
+	}
+	StageProxyMesh();
+	StageMeshFiles();
+	StageClusterMeshes();
+
+	// the cache stores the model file ranges and then the cluster
+	// ranges after the shape ranges
+	std::vector<MESH_RANGE> ranges(&m_ranges[0][0], &m_ranges[0][0] + shapeRangeCount);
+	ranges.insert(ranges.end(), m_fileRanges.begin(), m_fileRanges.end());
+	ranges.insert(ranges.end(), m_clusterRanges.begin(), m_clusterRanges.end());
+
+	UploadBuffers(m_stagedVertices.data(), m_stagedVertices.size(), m_stagedIndices.data(), m_stagedIndices.size());
+	if (MeshCache::Save(g_MeshCacheFilename, key, ranges.data(), rangeCount, m_stagedVertices, m_stagedIndices, m_meshlets))
+	{
+		std::cout << "INFO: shared mesh buffer saved to " << g_MeshCacheFilename << std::endl;
+	}
+	else
+	{
+		std::cout << "Could not write the mesh cache " << g_MeshCacheFilename << std::endl;
+	}
+
+	// the geometry now lives on the GPU
+	std::vector<PACKED_VERTEX>().swap(m_stagedVertices);
+	std::vector<uint32_t>().swap(m_stagedIndices);
+}
+
+/***********************************************************
+ *  UploadBuffers()
+ *
+ *  This method is used for copying the packed vertices and
+ *  indices into the shared buffers, describing the vertex
+ *  layout once in the shared vertex array object, and
+ *  leaving that vertex array bound for the draws.  A copy
+ *  is kept when the geometry is also rendered on the CPU.
+ ***********************************************************/
+void SceneMeshes::UploadBuffers(
+	const PACKED_VERTEX* pVertices,
+	size_t vertexCount,
+	const uint32_t* pIndices,
+	size_t indexCount)
+{
+	if (m_vao == 0)
+	{
+		glGenVertexArrays(1, &m_vao);
+		glGenBuffers(1, &m_vertexBuffer);
+		glGenBuffers(1, &m_indexBuffer);
+	}
+	glBindVertexArray(m_vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(PACKED_VERTEX), pVertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t), pIndices, GL_STATIC_DRAW);
+
+	// quantized position, octahedral normal and texture coordinate
+	// at locations 0, 1 and 2, all normalized to floats on fetch
+	const GLsizei stride = sizeof(PACKED_VERTEX);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PACKED_VERTEX, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PACKED_VERTEX, normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PACKED_VERTEX, textureCoordinate));
+
+	if (m_bKeepGeometry == true)
+	{
+		m_keptVertices.assign(pVertices, pVertices + vertexCount);
+		m_keptIndices.assign(pIndices, pIndices + indexCount);
+	}
+
+	std::cout << "INFO: shared mesh buffer holds " << vertexCount << " vertices ("
+		<< sizeof(PACKED_VERTEX) << " bytes each, " << sizeof(MESH_VERTEX) << " unpacked) and "
+		<< indexCount << " indices" << std::endl;
+}
+
+/***********************************************************
+ *  BindMeshes()
+ *
+ *  This method is used for binding the shared vertex array,
+ *  in case other code has bound a different one since the
+ *  meshes were uploaded.  The quantization bounds and the
+ *  whole pipeline state are sent again with the next draw.
+ ***********************************************************/
+void SceneMeshes::BindMeshes()
+{
+	glBindVertexArray(m_vao);
+	m_boundsBaseVertex = -1;
+	m_surfaceType = -1;
+	m_impostorType = -1;
+	m_impostorParts = -1;
+	if (NULL != m_pPipelineStates)
+	{
+		m_pPipelineStates->Invalidate();
+	}
+}
+
+/***********************************************************
+ *  SetTessellation()
+ *
+ *  This method is used for switching the curved shapes to
+ *  coarse patches that the tessellation stages refine.  It
+ *  must match the shader program - once tessellation stages
+ *  are linked every draw has to be made of patches.
+ ***********************************************************/
+void SceneMeshes::SetTessellation(bool bEnabled)
+{
+	m_bTessellation = bEnabled;
+}
+
+/***********************************************************
+ *  SetImpostors()
+ *
+ *  This method is used for switching the curved shapes
+ *  between their rasterized meshes and ray-cast impostors.
+ *  The impostor program is built the first time they are
+ *  switched on, from the untessellated program in use, and
+ *  they stay off when it does not build.
+ ***********************************************************/
+bool SceneMeshes::SetImpostors(bool bEnabled)
+{
+	if (bEnabled && !m_bTessellation && !m_impostorShaders.IsCreated())
+	{
+		if (m_impostorShaders.Create() == false)
+		{
+			m_bImpostors = false;
+			return(false);
+		}
+
+		// the ray-cast torus has the radius its mesh has
+		m_impostorShaders.Begin();
+		m_impostorShaders.SetFloat(IMPOSTOR_TUBE_RADIUS, PrimitiveMeshes::TORUS_TUBE_RADIUS);
+		m_impostorShaders.End();
+	}
+
+	m_bImpostors = bEnabled;
+	return(true);
+}
+
+/***********************************************************
+ *  SetMeshletCulling()
+ *
+ *  This method is used for switching the meshlet culling of
+ *  the rasterized draws on or off.
+ ***********************************************************/
+void SceneMeshes::SetMeshletCulling(bool bEnabled)
+{
+	m_bMeshletCulling = bEnabled;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for binding the shared vertex array
+ *  and restarting the draw order for a new frame.  The
+ *  triangles saved by the level of detail selection in the
+ *  frame that just ended are reported whenever they change.
+ ***********************************************************/
+void SceneMeshes::BeginFrame()
+{
+	BindMeshes();
+
+	// the control shader measures edges in pixels
+	if (m_bTessellation && (NULL != m_pShaderManager))
+	{
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		m_pShaderManager->setVec2Value(g_ViewportSizeName, glm::vec2((float)viewport[2], (float)viewport[3]));
+	}
+
+	// the shaders build the torus with the radius its mesh has
+	if (m_bTessellation && (NULL != m_pShaderManager))
+	{
+		m_pShaderManager->setFloatValue(g_TorusTubeRadiusName, PrimitiveMeshes::TORUS_TUBE_RADIUS);
+	}
+
+	// triangle counts mean nothing for patches
+	if ((m_frameFullTriangles > 0) && !m_bTessellation)
+	{
+		const size_t savedTriangles = m_frameFullTriangles - m_frameTriangles;
+		if (savedTriangles != m_reportedSavedTriangles)
+		{
+			std::cout << "INFO: " << (UseImpostors() ? "impostors" : "level of detail")
+				<< " saved " << savedTriangles << " of "
+				<< m_frameFullTriangles << " triangles per frame" << std::endl;
+			m_reportedSavedTriangles = savedTriangles;
+		}
+	}
+
+	if ((m_frameMeshletTriangles > 0) && (m_frameCulledTriangles != m_reportedCulledTriangles))
+	{
+		std::cout << "INFO: meshlet culling dropped " << m_frameCulledTriangles << " of "
+			<< m_frameMeshletTriangles << " triangles per frame ("
+			<< ((100.0 * m_frameCulledTriangles) / m_frameMeshletTriangles) << "%)" << std::endl;
+		m_reportedCulledTriangles = m_frameCulledTriangles;
+	}
+
+	m_drawObject = 0;
+	m_drawSequence = 0;
+	m_frameTriangles = 0;
+	m_frameFullTriangles = 0;
+	m_frameMeshletTriangles = 0;
+	m_frameCulledTriangles = 0;
+	m_frameDeferredDraws = 0;
+}
+
+/***********************************************************
+ *  BeginObject()
+ *
+ *  This method is used for starting the draws of an object
+ *  of the scene.  Its curved draws are numbered from zero,
+ *  so they keep their levels of detail when the draws of
+ *  other objects come and go.
+ ***********************************************************/
+void SceneMeshes::BeginObject(int object)
+{
+	m_drawObject = (object > 0) ? object : 0;
+	m_drawSequence = 0;
+}
+
+/***********************************************************
+ *  ResetDetailState()
+ *
+ *  This method is used for forgetting the levels of detail
+ *  and cluster choices kept from the frames drawn so far.
+ *  A frame drawn after the reset only depends on its own
+ *  camera, which frames of unrelated poses need.
+ ***********************************************************/
+void SceneMeshes::ResetDetailState()
+{
+	m_drawLods.clear();
+	std::fill(m_clusterMerged.begin(), m_clusterMerged.end(), (unsigned char)0);
+}
+
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for setting the camera matrices that
+ *  the level of detail of the following draws is chosen with
+ *  and their meshlets are culled against.
+ ***********************************************************/
+void SceneMeshes::SetViewProjection(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_viewProjection = projection * view;
+	m_projectionScaleY = projection[1][1];
+
+	// an orthographic projection views along parallel rays, which
+	// a point far behind the eye approximates
+	const glm::mat4 inverseView = glm::inverse(view);
+	m_cameraPosition = glm::vec3(inverseView[3]);
+	m_cameraForward = -glm::vec3(inverseView[2]);
+	if (projection[3][3] != 0.0f)
+	{
+		m_cameraPosition += glm::vec3(inverseView[2]) * g_OrthographicCameraDistance;
+	}
+}
+
+/***********************************************************
+ *  GetScreenRadius()
+ *
+ *  This method is used for getting how large the bounding
+ *  sphere of a box appears on screen.  The sphere is moved
+ *  by the model matrix and projected; its clip space w is
+ *  the view depth for a perspective projection and 1 for an
+ *  orthographic one, so the same formula gives the on-screen
+ *  radius for both.
+ ***********************************************************/
+float SceneMeshes::GetScreenRadius(const MESH_BOUNDS& bounds) const
+{
+	const glm::vec3 localCenter = bounds.minimum + (bounds.extent * 0.5f);
+	const float scale = std::max(glm::length(glm::vec3(m_model[0])),
+		std::max(glm::length(glm::vec3(m_model[1])), glm::length(glm::vec3(m_model[2]))));
+	const float radius = glm::length(bounds.extent) * 0.5f * scale;
+	const glm::vec4 clipCenter = m_viewProjection * (m_model * glm::vec4(localCenter, 1.0f));
+
+	// the camera is inside or too close to the bounding sphere
+	if (clipCenter.w <= radius)
+	{
+		return(1.0f);
+	}
+	return((radius * m_projectionScaleY) / (2.0f * clipCenter.w));
+}
+
+/***********************************************************
+ *  SelectLod()
+ *
+ *  This method is used for choosing the level of detail of
+ *  a draw of a shape from the on-screen radius of the
+ *  finest level's bounds.  A draw keeps its level from the
+ *  last frame unless the radius has moved past a threshold
+ *  by the hysteresis margin.  With hardware tessellation the
+ *  patches are always drawn and the tessellation stages
+ *  choose the detail instead.
+ ***********************************************************/
+int SceneMeshes::SelectLod(MESH_ID mesh, size_t slot)
+{
+	if (m_bTessellation)
+	{
+		return(PATCH_LEVEL);
+	}
+
+	const float screenRadius = GetScreenRadius(m_ranges[0][mesh].bounds);
+
+	if ((size_t)m_drawObject >= m_drawLods.size())
+	{
+		m_drawLods.resize(m_drawObject + 1);
+	}
+	std::vector<unsigned char>& objectLods = m_drawLods[m_drawObject];
+	if (slot >= objectLods.size())
+	{
+		objectLods.resize(slot + 1, g_NoLod);
+	}
+
+	int lod = objectLods[slot];
+	if (lod == g_NoLod)
+	{
+		lod = 0;
+		while ((lod < LOD_COUNT - 1) && (screenRadius < g_LodThresholds[lod]))
+		{
+			lod++;
+		}
+	}
+	else
+	{
+		while ((lod > 0) && (screenRadius > g_LodThresholds[lod - 1] * (1.0f + g_LodHysteresis)))
+		{
+			lod--;
+		}
+		while ((lod < LOD_COUNT - 1) && (screenRadius < g_LodThresholds[lod] * (1.0f - g_LodHysteresis)))
+		{
+			lod++;
+		}
+	}
+	objectLods[slot] = (unsigned char)lod;
+
+	return(lod);
+}
+
+/***********************************************************
+ *  DrawRange()
+ *
+ *  This method is used for drawing the start of a range of
+ *  the shared index buffer.  Every range of one mesh shares
+ *  a base vertex and bounds, so the bounds uniforms are only
+ *  set when a different mesh is drawn.  With hardware
+ *  tessellation the range is drawn as patches and the type
+ *  of surface to evaluate is set when it changes.  Otherwise
+ *  the meshlets of the range are culled first, when enabled.
+ ***********************************************************/
+void SceneMeshes::DrawRange(const MESH_RANGE& range, GLsizei indexCount, int surfaceType, bool bClosed)
+{
+	if (NULL != m_pPipelineStates)
+	{
+		m_pPipelineStates->Apply();
+	}
+
+	if (m_bTessellation && (surfaceType != m_surfaceType) && (NULL != m_pShaderManager))
+	{
+		m_pShaderManager->setIntValue(g_SurfaceTypeName, surfaceType);
+		m_surfaceType = surfaceType;
+	}
+
+	if ((range.baseVertex != m_boundsBaseVertex) && (NULL != m_pShaderManager))
+	{
+		m_pShaderManager->setVec3Value(g_BoundsMinName, range.bounds.minimum);
+		m_pShaderManager->setVec3Value(g_BoundsExtentName, range.bounds.extent);
+		m_boundsBaseVertex = range.baseVertex;
+	}
+
+	// the evaluated patches bulge past the bounds of their
+	// control points, so they are not culled by meshlet
+	if (m_bMeshletCulling && !m_bTessellation && (range.meshletCount > 0))
+	{
+		DrawMeshlets(range, indexCount, bClosed);
+		return;
+	}
+
+	glDrawElementsBaseVertex(
+		m_bTessellation ? GL_PATCHES : GL_TRIANGLES,
+		indexCount,
+		GL_UNSIGNED_INT,
+		(void*)(range.firstIndex * sizeof(uint32_t)),
+		range.baseVertex);
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing one level of a loaded
+ *  shape and counting its triangles against the finest.
+ ***********************************************************/
+void SceneMeshes::DrawMesh(MESH_ID mesh, int lod)
+{
+	const MESH_RANGE& range = m_ranges[lod][mesh];
+
+	m_frameTriangles += range.indexCount / 3;
+	m_frameFullTriangles += m_ranges[0][mesh].indexCount / 3;
+	DrawRange(range, range.indexCount, g_SurfaceTypes[mesh], g_ClosedMeshes[mesh]);
+}
+
+/***********************************************************
+ *  DrawMeshlets()
+ *
+ *  This method is used for culling the meshlets that cover
+ *  the start of a range and drawing the survivors.  The
+ *  camera is moved into the object space of the model
+ *  matrix so the meshlet bounds are tested untransformed.
+ *  Neighbouring visible meshlets are contiguous in the index
+ *  buffer, so each run of them becomes one draw of a single
+ *  multi-draw call.
+ ***********************************************************/
+void SceneMeshes::DrawMeshlets(const MESH_RANGE& range, GLsizei indexCount, bool bClosed)
+{
+	// a merged run of ranges continues into the following meshlets
+	const GLuint endIndex = range.firstIndex + (GLuint)indexCount;
+	size_t meshletCount = 0;
+	while (((range.firstMeshlet + meshletCount) < m_meshlets.size()) &&
+		(m_meshlets[range.firstMeshlet + meshletCount].firstIndex < endIndex))
+	{
+		meshletCount++;
+	}
+	const MESHLET* pMeshlets = &m_meshlets[range.firstMeshlet];
+
+	const glm::vec3 objectCamera = glm::vec3(glm::inverse(m_model) * glm::vec4(m_cameraPosition, 1.0f));
+	const MESHLET_CULL_VIEW view = Meshlets::MakeCullView(m_viewProjection * m_model, objectCamera, bClosed);
+	m_meshletVisibility.resize(meshletCount);
+	Meshlets::CullMeshlets(pMeshlets, meshletCount, view, m_meshletVisibility.data());
+
+	m_drawCounts.clear();
+	m_drawOffsets.clear();
+	m_drawBaseVertices.clear();
+	for (size_t i = 0; i < meshletCount; i++)
+	{
+		m_frameMeshletTriangles += pMeshlets[i].indexCount / 3;
+		if (m_meshletVisibility[i] == 0)
+		{
+			m_frameCulledTriangles += pMeshlets[i].indexCount / 3;
+		}
+		else if ((i > 0) && (m_meshletVisibility[i - 1] != 0))
+		{
+			m_drawCounts.back() += (GLsizei)pMeshlets[i].indexCount;
+		}
+		else
+		{
+			m_drawCounts.push_back((GLsizei)pMeshlets[i].indexCount);
+			m_drawOffsets.push_back((const void*)(pMeshlets[i].firstIndex * sizeof(uint32_t)));
+			m_drawBaseVertices.push_back(range.baseVertex);
+		}
+	}
+
+	if (!m_drawCounts.empty())
+	{
+		glMultiDrawElementsBaseVertex(
+			GL_TRIANGLES,
+			m_drawCounts.data(),
+			GL_UNSIGNED_INT,
+			m_drawOffsets.data(),
+			(GLsizei)m_drawCounts.size(),
+			m_drawBaseVertices.data());
+	}
+}
+
+/***********************************************************
+ *  DrawImpostor()
+ *
+ *  This method is used for drawing a curved shape as a proxy
+ *  box that the fragment shader ray-casts the exact shape
+ *  in.  Only the back faces of the box are drawn, so every
+ *  covered pixel is ray-cast once and the shape still shows
+ *  when the camera is inside the box.  The front faces are
+ *  culled by the front culling variant of the selected
+ *  pipeline state, and the state selected before is kept
+ *  for the next draw.  The box alone is drawn with the
+ *  impostor program, which gets the uniform values of the
+ *  scene program once the pipeline state has set them, and
+ *  the camera moved into the object space of the shape, so
+ *  the vertex shader does not invert any matrix.
+ ***********************************************************/
+void SceneMeshes::DrawImpostor(MESH_ID mesh, int parts)
+{
+	const int impostorType = g_ImpostorTypes[mesh];
+	const MESH_RANGE& proxy = m_ranges[0][MESH_PROXY];
+
+	m_frameTriangles += proxy.indexCount / 3;
+
+	int state = -1;
+	if (NULL != m_pPipelineStates)
+	{
+		state = m_pPipelineStates->GetSelected();
+		const int culledState = m_pPipelineStates->GetCullVariant(state, CULL_FRONT);
+		if (culledState >= 0)
+		{
+			m_pPipelineStates->Select(culledState);
+		}
+		m_pPipelineStates->Apply();
+	}
+
+	m_impostorShaders.Begin();
+	if (impostorType != m_impostorType)
+	{
+		// the bounds of the shape take the place of the bounds
+		// the box was quantized against
+		m_impostorShaders.SetInt(IMPOSTOR_TYPE, impostorType);
+		m_impostorShaders.SetVec3(IMPOSTOR_BOUNDS_MIN, g_ImpostorBounds[impostorType].minimum);
+		m_impostorShaders.SetVec3(IMPOSTOR_BOUNDS_EXTENT, g_ImpostorBounds[impostorType].extent);
+		m_impostorType = impostorType;
+	}
+	if (parts != m_impostorParts)
+	{
+		m_impostorShaders.SetInt(IMPOSTOR_PARTS, parts);
+		m_impostorParts = parts;
+	}
+
+	// the rays start at the eye of a perspective projection, and
+	// run along the view direction of an orthographic one
+	const glm::mat4 inverseModel = glm::inverse(m_model);
+	m_impostorShaders.SetVec3(IMPOSTOR_CAMERA_POSITION, glm::vec3(inverseModel * glm::vec4(m_cameraPosition, 1.0f)));
+	m_impostorShaders.SetVec3(IMPOSTOR_CAMERA_FORWARD, glm::normalize(glm::vec3(inverseModel * glm::vec4(m_cameraForward, 0.0f))));
+
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		proxy.indexCount,
+		GL_UNSIGNED_INT,
+		(void*)(proxy.firstIndex * sizeof(uint32_t)),
+		proxy.baseVertex);
+
+	m_impostorShaders.End();
+
+	if (NULL != m_pPipelineStates)
+	{
+		m_pPipelineStates->Select(state);
+	}
+}
+
+/***********************************************************
+ *  DrawCurvedMesh()
+ *
+ *  This method is used for drawing a curved shape either at
+ *  the level of detail chosen for it or as an impostor.
+ ***********************************************************/
+void SceneMeshes::DrawCurvedMesh(MESH_ID mesh)
+{
+	if (RecordDraw(mesh))
+	{
+		return;
+	}
+	// the slot is taken by every queue, so a draw has the same
+	// slot whichever queue draws it
+	const size_t slot = NextDrawSlot();
+	if (SkipDraw())
+	{
+		return;
+	}
+
+	if (UseImpostors())
+	{
+		m_frameFullTriangles += m_ranges[0][mesh].indexCount / 3;
+		DrawImpostor(mesh, g_ImpostorAllParts);
+		return;
+	}
+
+	DrawMesh(mesh, SelectLod(mesh, slot));
+}
+
+/***********************************************************
+ *  DrawPlaneMesh()
+ *
+ *  This method is used for drawing the plane shape.
+ ***********************************************************/
+void SceneMeshes::DrawPlaneMesh()
+{
+	if (RecordDraw(MESH_PLANE) || SkipDraw())
+	{
+		return;
+	}
+
+	DrawMesh(MESH_PLANE, 0);
+}
+
+/***********************************************************
+ *  DrawBoxMesh()
+ *
+ *  This method is used for drawing the box shape.
+ ***********************************************************/
+void SceneMeshes::DrawBoxMesh()
+{
+	if (RecordDraw(MESH_BOX) || SkipDraw())
+	{
+		return;
+	}
+
+	DrawMesh(MESH_BOX, 0);
+}
+
+/***********************************************************
+ *  DrawCylinderMesh()
+ *
+ *  This method is used for drawing the selected parts of
+ *  the cylinder shape.  Neighbouring selected parts are
+ *  merged into one draw call.
+ ***********************************************************/
+void SceneMeshes::DrawCylinderMesh(bool bDrawTop, bool bDrawBottom, bool bDrawSides)
+{
+	const bool bSelected[3] = { bDrawTop, bDrawBottom, bDrawSides };
+
+	if (m_bRecording)
+	{
+		for (int part = 0; part < 3; part++)
+		{
+			if (bSelected[part])
+			{
+				RecordDraw((MESH_ID)(MESH_CYLINDER_TOP + part));
+			}
+		}
+		return;
+	}
+	const size_t slot = NextDrawSlot();
+	if (SkipDraw())
+	{
+		return;
+	}
+
+	if (UseImpostors())
+	{
+		const int partBits[3] = { g_ImpostorPartTop, g_ImpostorPartBottom, g_ImpostorPartSides };
+		int parts = 0;
+		for (int part = 0; part < 3; part++)
+		{
+			if (bSelected[part])
+			{
+				parts |= partBits[part];
+				m_frameFullTriangles += m_ranges[0][MESH_CYLINDER_TOP + part].indexCount / 3;
+			}
+		}
+		if (parts != 0)
+		{
+			DrawImpostor(MESH_CYLINDER_SIDES, parts);
+		}
+		return;
+	}
+
+	const int lod = SelectLod(MESH_CYLINDER_SIDES, slot);
+
+	int part = 0;
+	while (part < 3)
+	{
+		if (!bSelected[part])
+		{
+			part++;
+			continue;
+		}
+
+		const MESH_RANGE& first = m_ranges[lod][MESH_CYLINDER_TOP + part];
+		GLsizei indexCount = 0;
+		while ((part < 3) && bSelected[part])
+		{
+			indexCount += m_ranges[lod][MESH_CYLINDER_TOP + part].indexCount;
+			m_frameFullTriangles += m_ranges[0][MESH_CYLINDER_TOP + part].indexCount / 3;
+			part++;
+		}
+		m_frameTriangles += indexCount / 3;
+		DrawRange(first, indexCount, g_SurfaceTypes[MESH_CYLINDER_SIDES], bDrawTop && bDrawBottom && bDrawSides);
+	}
+}
+
+/***********************************************************
+ *  DrawConeMesh()
+ *
+ *  This method is used for drawing the cone shape.
+ ***********************************************************/
+void SceneMeshes::DrawConeMesh()
+{
+	DrawCurvedMesh(MESH_CONE);
+}
+
+/***********************************************************
+ *  DrawSphereMesh()
+ *
+ *  This method is used for drawing the sphere shape.
+ ***********************************************************/
+void SceneMeshes::DrawSphereMesh()
+{
+	DrawCurvedMesh(MESH_SPHERE);
+}
+
+/***********************************************************
+ *  DrawHalfSphereMesh()
+ *
+ *  This method is used for drawing the upper half of the
+ *  sphere shape.
+ ***********************************************************/
+void SceneMeshes::DrawHalfSphereMesh()
+{
+	DrawCurvedMesh(MESH_HALF_SPHERE);
+}
+
+/***********************************************************
+ *  DrawTorusMesh()
+ *
+ *  This method is used for drawing the torus shape.
+ ***********************************************************/
+void SceneMeshes::DrawTorusMesh()
+{
+	DrawCurvedMesh(MESH_TORUS);
+}
+
+/***********************************************************
+ *  DrawHalfTorusMesh()
+ *
+ *  This method is used for drawing the upper half of the
+ *  torus shape.
+ ***********************************************************/
+void SceneMeshes::DrawHalfTorusMesh()
+{
+	DrawCurvedMesh(MESH_HALF_TORUS);
+}
+
+/***********************************************************
+ *  DrawMeshFile()
+ *
+ *  This method is used for drawing a loaded model file.
+ *  Imported models are not known to be closed, so only
+ *  their meshlets outside the view are culled.
+ ***********************************************************/
+void SceneMeshes::DrawMeshFile(int file)
+{
+	if ((file < 0) || (file >= (int)m_fileRanges.size()) || (m_fileRanges[file].indexCount == 0) || SkipDraw())
+	{
+		return;
+	}
+
+	const MESH_RANGE& range = m_fileRanges[file];
+	m_frameTriangles += range.indexCount / 3;
+	m_frameFullTriangles += range.indexCount / 3;
+	DrawRange(range, range.indexCount, 0, false);
+}
+
+/***********************************************************
+ *  UseClusterMesh()
+ *
+ *  This method is used for choosing whether a cluster is
+ *  drawn as its merged mesh, from the on-screen radius of
+ *  the merged mesh's bounds under the current model matrix.
+ *  Like the levels of detail, a cluster keeps its choice
+ *  from the last frame unless the radius has moved past the
+ *  threshold by the hysteresis margin.
+ ***********************************************************/
+bool SceneMeshes::UseClusterMesh(int cluster)
+{
+	if ((cluster < 0) || (cluster >= (int)m_clusterRanges.size()) || (m_clusterRanges[cluster].indexCount == 0))
+	{
+		return(false);
+	}
+
+	const float screenRadius = GetScreenRadius(m_clusterRanges[cluster].bounds);
+	const float margin = (m_clusterMerged[cluster] != 0) ? (1.0f + g_LodHysteresis) : (1.0f - g_LodHysteresis);
+	m_clusterMerged[cluster] = (screenRadius < g_ClusterScreenRadius * margin) ? 1 : 0;
+
+	return(m_clusterMerged[cluster] != 0);
+}
+
+/***********************************************************
+ *  DrawClusterMesh()
+ *
+ *  This method is used for drawing the merged mesh of a
+ *  cluster.  Clusters mix open and closed parts, so only
+ *  their meshlets outside the view are culled.
+ ***********************************************************/
+void SceneMeshes::DrawClusterMesh(int cluster)
+{
+	if ((cluster < 0) || (cluster >= (int)m_clusterRanges.size()) || (m_clusterRanges[cluster].indexCount == 0) || SkipDraw())
+	{
+		return;
+	}
+
+	const MESH_RANGE& range = m_clusterRanges[cluster];
+	m_frameTriangles += range.indexCount / 3;
+	m_frameFullTriangles += range.indexCount / 3;
+	DrawRange(range, range.indexCount, 0, false);
+}
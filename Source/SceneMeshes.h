@@ -0,0 +1,402 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenemeshes.h
+// =============
+// basic 3D shapes suballocated from one shared vertex and index buffer
+//
+// Offers the same Load*Mesh() / Draw*Mesh() calls as the ShapeMeshes library,
+// but every loaded shape is appended to one vertex buffer and one index
+// buffer that live under a single vertex array object.  Each shape is only a
+// range of those buffers, drawn with a base vertex and first index offset,
+// so switching between shapes never changes vertex array state.  Shapes are
+// reordered for the vertex cache and for overdraw as they are loaded, and
+// stored in the quantized 16 byte vertex format from vertexpacking.h.
+//
+// The curved shapes are generated at several levels of detail.  Each draw
+// picks a level from how large the shape's bounding sphere appears on
+// screen, with a margin around each threshold so an object sitting near one
+// does not flicker between levels from frame to frame.  When the shader
+// program has hardware tessellation stages, the curved shapes are instead
+// drawn as coarse patches that are refined on the GPU.
+//
+// In impostor mode the curved shapes are not rasterized at all.  Each one
+// draws the 12 triangles of a proxy box around it, and the fragment shader
+// intersects the view ray with the exact analytic shape inside the box,
+// writing the depth and normal of the hit, so silhouettes are exact at any
+// distance.  The box is drawn with the front culling variant of the
+// selected pipeline state, and with the separate impostor program from
+// impostorshaders.h, so the other draws keep early depth testing.
+//
+// Each range is also split into meshlets of up to 64 vertices and 124
+// triangles.  Before a range is rasterized its meshlets are culled against
+// the view frustum, and on closed shapes against their normal cones, and
+// only the surviving index runs are submitted in one multi-draw call.
+//
+// A group of draws that always appear together can be recorded and merged
+// into one cluster mesh.  Every part is generated at its coarsest level,
+// moved into the group's space and has its texture coordinates mapped into
+// its rectangle of a texture atlas, so once the group is small on screen
+// the whole group is one draw.
+//
+// The packed geometry can also be kept in memory after the upload, so the
+// recorded draws can be rendered by the software rasterizer.
+//
+// A frame can be drawn in two queues: the draws whose pipeline state blends
+// are held back from the opaque queue, and drawn on their own when the scene
+// is traversed again for the transparent queue.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+#include "MeshOptimizer.h"
+#include "VertexPacking.h"
+#include "Meshlets.h"
+#include "ShaderManager.h"
+#include "PipelineStates.h"
+#include "ImpostorShaders.h"
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MESH_RANGE
+ *
+ *  Location of one shape inside the shared buffers, the
+ *  bounds its positions were quantized against, and its
+ *  first meshlet and number of meshlets.
+ ***********************************************************/
+struct MESH_RANGE
+{
+	GLint baseVertex;
+	GLuint firstIndex;
+	GLsizei indexCount;
+	MESH_BOUNDS bounds;
+	GLuint firstMeshlet;
+	GLuint meshletCount;
+};
+
+/***********************************************************
+ *  SceneMeshes
+ *
+ *  This class contains the code for loading the basic
+ *  shapes into the shared buffers and drawing them.
+ ***********************************************************/
+class SceneMeshes
+{
+public:
+	// constructor
+	SceneMeshes(ShaderManager* pShaderManager);
+	// destructor
+	~SceneMeshes();
+
+	// number of tessellation levels of the curved shapes, where
+	// level 0 is the finest
+	static const int LOD_COUNT = 3;
+	// level holding the coarse patches for hardware tessellation
+	static const int PATCH_LEVEL = LOD_COUNT;
+	static const int LEVEL_COUNT = LOD_COUNT + 1;
+
+	// the shapes that can be loaded into the shared buffers
+	enum MESH_ID
+	{
+		MESH_PLANE = 0,
+		MESH_BOX,
+		MESH_CYLINDER_TOP,
+		MESH_CYLINDER_BOTTOM,
+		MESH_CYLINDER_SIDES,
+		MESH_CONE,
+		MESH_SPHERE,
+		MESH_HALF_SPHERE,
+		MESH_TORUS,
+		MESH_HALF_TORUS,
+		MESH_PROXY,
+		MESH_COUNT
+	};
+
+	// the shapes that can be requested, each of which fills
+	// one or more of the mesh ranges
+	enum SHAPE_TYPE
+	{
+		SHAPE_PLANE = 0,
+		SHAPE_BOX,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_SPHERE,
+		SHAPE_TORUS
+	};
+
+	// request the shapes to be loaded by UploadMeshes()
+	void LoadPlaneMesh();
+	void LoadBoxMesh();
+	void LoadCylinderMesh();
+	void LoadConeMesh();
+	void LoadSphereMesh();
+	void LoadTorusMesh();
+	// request a model file (.obj or .glb) to be loaded by
+	// UploadMeshes() and return the handle to draw it with
+	int LoadMeshFile(const char* filename);
+
+	/***********************************************************
+	 *  CLUSTER_PART
+	 *
+	 *  One shape of a cluster mesh, placed in the cluster's
+	 *  space by a model matrix, with its texture coordinates
+	 *  mapped into a rectangle of the cluster's atlas.
+	 ***********************************************************/
+	struct CLUSTER_PART
+	{
+		MESH_ID mesh;
+		glm::mat4 model;
+		glm::vec2 atlasOffset;
+		glm::vec2 atlasScale;
+	};
+
+	/***********************************************************
+	 *  RECORDED_DRAW
+	 *
+	 *  A draw captured while recording: the shape, its model
+	 *  matrix, and the appearance the caller set for it.
+	 ***********************************************************/
+	struct RECORDED_DRAW
+	{
+		MESH_ID mesh;
+		glm::mat4 model;
+		int appearance;
+	};
+
+	// capture the Draw*Mesh() calls instead of drawing them
+	void BeginRecording();
+	// tag the recorded draws that follow with an appearance
+	void SetRecordedAppearance(int appearance) { m_recordedAppearance = appearance; }
+	// stop capturing and return the captured draws
+	std::vector<RECORDED_DRAW> EndRecording();
+	// request a cluster mesh merged from the passed in parts to be
+	// loaded by UploadMeshes() and return the handle to draw it with
+	int LoadClusterMesh(const char* name, const std::vector<CLUSTER_PART>& parts);
+
+	// fill the shared GPU buffers with the requested shapes, from
+	// the mesh cache when it is current, and bind the vertex array -
+	// called once after all the loads
+	void UploadMeshes();
+	// bind the shared vertex array before drawing
+	void BindMeshes();
+	// bind the shared vertex array and start the level of detail
+	// bookkeeping for a new frame - called before the first draw
+	void BeginFrame();
+	// the draws that follow belong to the passed in object of the
+	// scene, which keeps the levels of detail of its draws apart
+	// from those of the other objects
+	void BeginObject(int object);
+	// forget the levels of detail and cluster choices of the frames
+	// drawn so far, so the next frame is chosen without hysteresis
+	// as if it were the first
+	void ResetDetailState();
+
+	// camera matrices used to choose the level of detail
+	void SetViewProjection(const glm::mat4& view, const glm::mat4& projection);
+	// model matrix of the next draw
+	void SetModelMatrix(const glm::mat4& model) { m_model = model; }
+	// draw the curved shapes as patches for the tessellation stages
+	void SetTessellation(bool bEnabled);
+	// ray-cast the curved shapes inside proxy boxes instead of
+	// rasterizing their meshes - ignored while tessellating.  The
+	// impostor program is built from the program in use the first
+	// time, returning false when it does not build
+	bool SetImpostors(bool bEnabled);
+	// cull the meshlets of each draw before submitting it
+	void SetMeshletCulling(bool bEnabled);
+	// keep a copy of the packed geometry once it is uploaded -
+	// called before UploadMeshes()
+	void SetKeepGeometry(bool bEnabled) { m_bKeepGeometry = bEnabled; }
+	// pipeline states whose selected state is applied before each
+	// draw call
+	void SetPipelineStates(PipelineStates* pPipelineStates) { m_pPipelineStates = pPipelineStates; }
+
+	// the draws the Draw*Mesh() calls make, by whether the selected
+	// pipeline state blends
+	enum DRAW_QUEUE
+	{
+		QUEUE_ALL = 0,
+		QUEUE_OPAQUE,
+		QUEUE_TRANSPARENT
+	};
+	void SetDrawQueue(DRAW_QUEUE queue) { m_drawQueue = queue; }
+	// blending draws held back from the opaque queue this frame
+	size_t GetFrameDeferredDraws() const { return(m_frameDeferredDraws); }
+
+	// draw the loaded shapes
+	void DrawPlaneMesh();
+	void DrawBoxMesh();
+	void DrawCylinderMesh(bool bDrawTop = true, bool bDrawBottom = true, bool bDrawSides = true);
+	void DrawConeMesh();
+	void DrawSphereMesh();
+	void DrawHalfSphereMesh();
+	void DrawTorusMesh();
+	void DrawHalfTorusMesh();
+	// draw a model file loaded by LoadMeshFile()
+	void DrawMeshFile(int file);
+	// whether a cluster is small enough on screen under the current
+	// model matrix to be drawn as its cluster mesh
+	bool UseClusterMesh(int cluster);
+	// draw a cluster mesh loaded by LoadClusterMesh()
+	void DrawClusterMesh(int cluster);
+
+	// location of a loaded shape inside the shared buffers
+	const MESH_RANGE& GetMeshRange(MESH_ID mesh, int lod = 0) const { return(m_ranges[lod][mesh]); }
+	// packed geometry of the shared buffers, empty unless it was
+	// kept by SetKeepGeometry()
+	const std::vector<PACKED_VERTEX>& GetKeptVertices() const { return(m_keptVertices); }
+	const std::vector<uint32_t>& GetKeptIndices() const { return(m_keptIndices); }
+	// triangles drawn since the frame began
+	size_t GetFrameTriangles() const { return(m_frameTriangles); }
+	// hash of the geometry and of the draw modes that change the
+	// rendered image
+	uint64_t ComputeSceneKey() const;
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// pointer to the pipeline states of the draws
+	PipelineStates* m_pPipelineStates;
+	// the draws that are made, and those held back this frame
+	DRAW_QUEUE m_drawQueue;
+	size_t m_frameDeferredDraws;
+	// shared vertex array object and buffers
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	// location of each level of each loaded shape in the shared buffers
+	MESH_RANGE m_ranges[LEVEL_COUNT][MESH_COUNT];
+	// base vertex of the mesh whose bounds are set in the shader
+	GLint m_boundsBaseVertex;
+	// surface type set in the shader, and whether the draws are patches
+	int m_surfaceType;
+	bool m_bTessellation;
+	// impostor type and cylinder parts set in the impostor program,
+	// whether the curved shapes are ray-cast, and the program itself
+	int m_impostorType;
+	int m_impostorParts;
+	bool m_bImpostors;
+	ImpostorShaders m_impostorShaders;
+	// meshlets of every range, in index buffer order, and whether
+	// they are culled
+	std::vector<MESHLET> m_meshlets;
+	bool m_bMeshletCulling;
+	// per draw scratch space for the meshlet culling
+	std::vector<unsigned char> m_meshletVisibility;
+	std::vector<GLsizei> m_drawCounts;
+	std::vector<const void*> m_drawOffsets;
+	std::vector<GLint> m_drawBaseVertices;
+	// triangles tested and culled by the meshlet culling this frame
+	size_t m_frameMeshletTriangles;
+	size_t m_frameCulledTriangles;
+	size_t m_reportedCulledTriangles;
+	// shapes requested by the Load*Mesh() calls, in order
+	std::vector<SHAPE_TYPE> m_requestedShapes;
+	// model files requested by LoadMeshFile(), in handle order, and
+	// the location of each one in the shared buffers
+	std::vector<std::string> m_meshFiles;
+	std::vector<MESH_RANGE> m_fileRanges;
+	// cluster meshes requested by LoadClusterMesh(), their location
+	// in the shared buffers, and whether each was merged last frame
+	std::vector<std::string> m_clusterNames;
+	std::vector<std::vector<CLUSTER_PART>> m_clusterParts;
+	std::vector<MESH_RANGE> m_clusterRanges;
+	std::vector<unsigned char> m_clusterMerged;
+	// draws captured while recording
+	bool m_bRecording;
+	int m_recordedAppearance;
+	std::vector<RECORDED_DRAW> m_recordedDraws;
+	// matrices used to choose the level of detail of a draw
+	glm::mat4 m_model;
+	glm::mat4 m_viewProjection;
+	float m_projectionScaleY;
+	// world space point the culling views from - the eye for a
+	// perspective projection, far behind it for an orthographic one
+	glm::vec3 m_cameraPosition;
+	// world space direction the camera looks in
+	glm::vec3 m_cameraForward;
+	// level chosen for each level of detail draw of the last frame, by
+	// the object it belongs to and its position among the curved draws
+	// of that object - an object issues its draws in the same order
+	// every frame, whether the objects before it were drawn as their
+	// cluster meshes or not, and in the same order in every queue
+	std::vector<std::vector<unsigned char>> m_drawLods;
+	int m_drawObject;
+	size_t m_drawSequence;
+	// triangles drawn this frame, and the triangles the finest
+	// level would have drawn
+	size_t m_frameTriangles;
+	size_t m_frameFullTriangles;
+	size_t m_reportedSavedTriangles;
+	// geometry waiting to be uploaded
+	std::vector<PACKED_VERTEX> m_stagedVertices;
+	std::vector<uint32_t> m_stagedIndices;
+	// copy of the uploaded geometry, and whether it is kept
+	bool m_bKeepGeometry;
+	std::vector<PACKED_VERTEX> m_keptVertices;
+	std::vector<uint32_t> m_keptIndices;
+
+	// add a shape to the requested list
+	void RequestShape(SHAPE_TYPE shape);
+	// generate the shapes into the staged geometry
+	void StagePlaneMesh();
+	void StageBoxMesh();
+	void StageCylinderMesh();
+	void StageConeMesh();
+	void StageSphereMesh();
+	void StageTorusMesh();
+	void StageProxyMesh();
+	void StageMeshFiles();
+	void StageClusterMeshes();
+	// generate the coarsest level of a shape
+	MESH_DATA GenerateCoarsestMesh(MESH_ID mesh) const;
+	// capture a draw while recording - returns false when drawing
+	bool RecordDraw(MESH_ID mesh);
+	// whether the next draw belongs to another queue
+	bool SkipDraw();
+	// radius of a bounding box on screen under the current model
+	// matrix, as a fraction of the viewport height
+	float GetScreenRadius(const MESH_BOUNDS& bounds) const;
+	// hash of everything that affects the generated geometry
+	uint64_t ComputeCacheKey() const;
+	// copy packed geometry into the shared GPU buffers
+	void UploadBuffers(
+		const PACKED_VERTEX* pVertices,
+		size_t vertexCount,
+		const uint32_t* pIndices,
+		size_t indexCount);
+	// optimize a generated mesh whose index list is made of the passed
+	// in segments, append it to the staged geometry, and store the
+	// location of each segment - segments share one base vertex
+	void StageMesh(
+		const char* name,
+		MESH_DATA& mesh,
+		const std::vector<size_t>& segmentIndexCounts,
+		MESH_RANGE* pSegmentRanges);
+	// position of the next curved draw among those of its object
+	size_t NextDrawSlot() { return(m_drawSequence++); }
+	// choose the level of detail of a draw of a shape, kept in the
+	// passed in slot of the current object
+	int SelectLod(MESH_ID mesh, size_t slot);
+	// draw the first indexCount indices of a range of the shared
+	// index buffer, setting its quantization bounds and surface
+	// type when needed - bClosed allows back-facing meshlets to
+	// be culled
+	void DrawRange(const MESH_RANGE& range, GLsizei indexCount, int surfaceType, bool bClosed);
+	// draw the meshlets of the first indexCount indices of a range
+	// that survive culling
+	void DrawMeshlets(const MESH_RANGE& range, GLsizei indexCount, bool bClosed);
+	void DrawMesh(MESH_ID mesh, int lod);
+	// whether the curved shapes are drawn as impostors
+	bool UseImpostors() const { return(m_bImpostors && !m_bTessellation); }
+	// draw a curved shape as an impostor in its proxy box, limited
+	// to the passed in parts for the cylinder
+	void DrawImpostor(MESH_ID mesh, int parts);
+	// draw a curved shape at its chosen level of detail, or as
+	// an impostor
+	void DrawCurvedMesh(MESH_ID mesh);
+};
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+// sharedimages.cpp
+// ================
+// decoded texture images shared between render processes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SharedImages.h"
+
+#include "stb_image.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// where each decoded image lives inside the shared block
+	struct IMAGE_ENTRY
+	{
+		std::string filename;
+		int width;
+		int height;
+		int channels;
+		size_t offset;
+	};
+
+	std::vector<IMAGE_ENTRY> g_Entries;
+	unsigned char* g_pBlock = NULL;
+	size_t g_BlockSize = 0;
+#ifdef _WIN32
+	// there is no fork to share with, so the block is plain memory
+	std::vector<unsigned char> g_BlockStorage;
+#endif
+
+	// allocate the block that holds every decoded image
+	unsigned char* AllocateBlock(size_t size)
+	{
+#ifdef _WIN32
+		g_BlockStorage.resize(size);
+		return(g_BlockStorage.data());
+#else
+		void* pBlock = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		return((pBlock == MAP_FAILED) ? NULL : (unsigned char*)pBlock);
+#endif
+	}
+}
+
+/***********************************************************
+ *  Decode()
+ *
+ *  This method is used for decoding every image file once,
+ *  with the same vertical flip the texture loader uses, and
+ *  packing the results into one shared memory block.
+ ***********************************************************/
+bool SharedImages::Decode(const std::vector<std::string>& filenames)
+{
+	Release();
+
+	std::vector<unsigned char*> decoded;
+	size_t totalSize = 0;
+	stbi_set_flip_vertically_on_load(true);
+	for (const std::string& filename : filenames)
+	{
+		IMAGE_ENTRY entry;
+		entry.filename = filename;
+		entry.width = 0;
+		entry.height = 0;
+		entry.channels = 0;
+		unsigned char* image = stbi_load(filename.c_str(), &entry.width, &entry.height, &entry.channels, 0);
+		if (image == NULL)
+		{
+			continue;
+		}
+
+		entry.offset = totalSize;
+		totalSize += (size_t)entry.width * entry.height * entry.channels;
+		g_Entries.push_back(entry);
+		decoded.push_back(image);
+	}
+
+	g_pBlock = (totalSize > 0) ? AllocateBlock(totalSize) : NULL;
+	if (g_pBlock != NULL)
+	{
+		g_BlockSize = totalSize;
+		for (size_t i = 0; i < g_Entries.size(); i++)
+		{
+			const size_t size = (size_t)g_Entries[i].width * g_Entries[i].height * g_Entries[i].channels;
+			memcpy(g_pBlock + g_Entries[i].offset, decoded[i], size);
+		}
+	}
+	else
+	{
+		g_Entries.clear();
+	}
+
+	for (unsigned char* image : decoded)
+	{
+		stbi_image_free(image);
+	}
+
+	std::cout << "INFO: Decoded " << g_Entries.size() << " images into "
+		<< g_BlockSize / (1024.0 * 1024.0) << " MB of shared memory" << std::endl;
+	return(g_pBlock != NULL);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the decoded image of the
+ *  passed in file, returning false when it was not decoded.
+ ***********************************************************/
+bool SharedImages::Find(const char* filename, SHARED_IMAGE& image)
+{
+	for (const IMAGE_ENTRY& entry : g_Entries)
+	{
+		if (entry.filename.compare(filename) == 0)
+		{
+			image.width = entry.width;
+			image.height = entry.height;
+			image.channels = entry.channels;
+			image.pixels = g_pBlock + entry.offset;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for unmapping the decoded images.
+ ***********************************************************/
+void SharedImages::Release()
+{
+	if (g_pBlock != NULL)
+	{
+#ifdef _WIN32
+		g_BlockStorage.clear();
+#else
+		munmap(g_pBlock, g_BlockSize);
+#endif
+	}
+
+	g_pBlock = NULL;
+	g_BlockSize = 0;
+	g_Entries.clear();
+}
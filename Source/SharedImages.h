@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// sharedimages.h
+// ==============
+// decoded texture images shared between render processes
+//
+// Decoding the scene's JPEG textures is a large part of preparing the scene,
+// and every batch render process would otherwise repeat it.  The batch mode
+// decodes them once, before starting its workers, into a single anonymous
+// shared memory mapping.  Forked workers inherit the mapping and upload the
+// decoded pixels straight from it, so the images exist once in memory no
+// matter how many processes render.  Where there is no fork the images are
+// held in ordinary memory for the one in-process worker.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SHARED_IMAGE
+ *
+ *  One decoded image, flipped so its first row is the
+ *  bottom of the image as OpenGL expects.
+ ***********************************************************/
+struct SHARED_IMAGE
+{
+	int width;
+	int height;
+	int channels;
+	const unsigned char* pixels;
+};
+
+namespace SharedImages
+{
+	// decode the passed in image files into shared memory - files
+	// that fail to decode are left to be loaded normally
+	bool Decode(const std::vector<std::string>& filenames);
+	// the decoded image of a file, if it was decoded
+	bool Find(const char* filename, SHARED_IMAGE& image);
+	// unmap the decoded images
+	void Release();
+}
@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+// simdmath.h
+// ==========
+// vectorized math helpers shared by the batched CPU kernels
+//
+// The SSE2 path is always available on the x86/x64 targets this project is
+// built for; the AVX2 path is compiled in when the compiler targets AVX2
+// (/arch:AVX2 or -mavx2).  The sine/cosine approximation is the Cephes
+// single precision polynomial, accurate to about 1e-7 for |x| < 8192.  The
+// base 2 logarithm and exponential are the Cephes logf and exp2f polynomials,
+// accurate to a few units in the last place.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_MATH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if (defined(__AVX2__) && defined(__FMA__)) || (defined(_MSC_VER) && defined(__AVX2__))
+#define SIMD_MATH_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace SimdMath
+{
+	// Cephes range reduction constants (PI/4 split into three parts)
+	constexpr float FOUR_OVER_PI = 1.27323954473516f;
+	constexpr float DP1 = 0.78515625f;
+	constexpr float DP2 = 2.4187564849853515625e-4f;
+	constexpr float DP3 = 3.77489497744594108e-8f;
+
+	// polynomial coefficients for sin and cos on [-PI/4, PI/4]
+	constexpr float SIN_P0 = -1.9515295891e-4f;
+	constexpr float SIN_P1 = 8.3321608736e-3f;
+	constexpr float SIN_P2 = -1.6666654611e-1f;
+	constexpr float COS_P0 = 2.443315711809948e-5f;
+	constexpr float COS_P1 = -1.388731625493765e-3f;
+	constexpr float COS_P2 = 4.166664568298827e-2f;
+
+	// polynomial coefficients for log(1 + x) on [sqrt(1/2) - 1, sqrt(2) - 1]
+	constexpr float SQRT_HALF = 0.707106781186547524f;
+	constexpr float LOG_P[9] =
+	{
+		7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+		-1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+		2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f
+	};
+	constexpr float LN_2 = 0.693147180559945309f;
+	constexpr float LOG2_E = 1.44269504088896341f;
+	// polynomial coefficients for 2^x on [-1/2, 1/2]
+	constexpr float EXP2_P[6] =
+	{
+		1.535336188319500e-4f, 1.339887440266574e-3f, 9.618437357674640e-3f,
+		5.550332471162809e-2f, 2.402264791363012e-1f, 6.931472028550421e-1f
+	};
+
+#ifdef SIMD_MATH_SSE2
+	/***********************************************************
+	 *  SinCos4()
+	 *
+	 *  Compute the sine and cosine of four angles in radians.
+	 ***********************************************************/
+	inline void SinCos4(__m128 x, __m128* pSin, __m128* pCos)
+	{
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+		// take the absolute value and remember the sign for sin
+		__m128 signSin = _mm_and_ps(x, signMask);
+		x = _mm_andnot_ps(signMask, x);
+
+		// j = (int)(x * 4/PI), rounded up to an even octant
+		__m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOUR_OVER_PI)));
+		j = _mm_add_epi32(j, _mm_set1_epi32(1));
+		j = _mm_and_si128(j, _mm_set1_epi32(~1));
+		__m128 y = _mm_cvtepi32_ps(j);
+
+		// octant bits select the polynomial and the result signs
+		__m128i swapSin = _mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29);
+		__m128i swapCos = _mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29);
+		__m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+		signSin = _mm_xor_ps(signSin, _mm_castsi128_ps(swapSin));
+
+		// extended precision modular arithmetic: x = ((x - y*DP1) - y*DP2) - y*DP3
+		x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+		x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+		x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+		__m128 z = _mm_mul_ps(x, x);
+
+		// cosine polynomial
+		__m128 c = _mm_set1_ps(COS_P0);
+		c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COS_P1));
+		c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COS_P2));
+		c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+		c = _mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+		c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+		// sine polynomial
+		__m128 s = _mm_set1_ps(SIN_P0);
+		s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SIN_P1));
+		s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SIN_P2));
+		s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+		__m128 sinResult = _mm_or_ps(_mm_and_ps(polyMask, s), _mm_andnot_ps(polyMask, c));
+		__m128 cosResult = _mm_or_ps(_mm_and_ps(polyMask, c), _mm_andnot_ps(polyMask, s));
+
+		*pSin = _mm_xor_ps(sinResult, signSin);
+		*pCos = _mm_xor_ps(cosResult, _mm_castsi128_ps(swapCos));
+	}
+#endif
+
+#ifdef SIMD_MATH_AVX2
+	/***********************************************************
+	 *  SinCos8()
+	 *
+	 *  Compute the sine and cosine of eight angles in radians.
+	 ***********************************************************/
+	inline void SinCos8(__m256 x, __m256* pSin, __m256* pCos)
+	{
+		const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+
+		__m256 signSin = _mm256_and_ps(x, signMask);
+		x = _mm256_andnot_ps(signMask, x);
+
+		__m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOUR_OVER_PI)));
+		j = _mm256_add_epi32(j, _mm256_set1_epi32(1));
+		j = _mm256_and_si256(j, _mm256_set1_epi32(~1));
+		__m256 y = _mm256_cvtepi32_ps(j);
+
+		__m256i swapSin = _mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29);
+		__m256i swapCos = _mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29);
+		__m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+		signSin = _mm256_xor_ps(signSin, _mm256_castsi256_ps(swapSin));
+
+		x = _mm256_fnmadd_ps(y, _mm256_set1_ps(DP1), x);
+		x = _mm256_fnmadd_ps(y, _mm256_set1_ps(DP2), x);
+		x = _mm256_fnmadd_ps(y, _mm256_set1_ps(DP3), x);
+		__m256 z = _mm256_mul_ps(x, x);
+
+		__m256 c = _mm256_set1_ps(COS_P0);
+		c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(COS_P1));
+		c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(COS_P2));
+		c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+		c = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), c);
+		c = _mm256_add_ps(c, _mm256_set1_ps(1.0f));
+
+		__m256 s = _mm256_set1_ps(SIN_P0);
+		s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(SIN_P1));
+		s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(SIN_P2));
+		s = _mm256_fmadd_ps(_mm256_mul_ps(s, z), x, x);
+
+		__m256 sinResult = _mm256_blendv_ps(c, s, polyMask);
+		__m256 cosResult = _mm256_blendv_ps(s, c, polyMask);
+
+		*pSin = _mm256_xor_ps(sinResult, signSin);
+		*pCos = _mm256_xor_ps(cosResult, _mm256_castsi256_ps(swapCos));
+	}
+
+	/***********************************************************
+	 *  Log2_8()
+	 *
+	 *  Compute the base 2 logarithm of eight positive, normal
+	 *  numbers.
+	 ***********************************************************/
+	inline __m256 Log2_8(__m256 x)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		// split x into its exponent and a mantissa in [0.5, 1)
+		__m256i bits = _mm256_castps_si256(x);
+		__m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+		__m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+			_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F000000)));
+
+		// move the mantissa into [sqrt(1/2), sqrt(2)) around 1
+		__m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+		e = _mm256_sub_ps(e, _mm256_and_ps(small, one));
+		m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), one);
+
+		__m256 z = _mm256_mul_ps(m, m);
+		__m256 y = _mm256_set1_ps(LOG_P[0]);
+		for (int i = 1; i < 9; i++)
+		{
+			y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(LOG_P[i]));
+		}
+		y = _mm256_mul_ps(_mm256_mul_ps(y, z), m);
+		y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+
+		// log2(x) = log(1 + m) / log(2) + e
+		return(_mm256_fmadd_ps(_mm256_add_ps(m, y), _mm256_set1_ps(LOG2_E), e));
+	}
+
+	/***********************************************************
+	 *  Exp2_8()
+	 *
+	 *  Compute 2 to the power of eight numbers, clamped to the
+	 *  range of normal floats.
+	 ***********************************************************/
+	inline __m256 Exp2_8(__m256 x)
+	{
+		x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.0f)), _mm256_set1_ps(127.0f));
+
+		// 2^x = 2^n * 2^f with n the nearest integer and |f| <= 1/2
+		__m256 n = _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256 f = _mm256_sub_ps(x, n);
+
+		__m256 p = _mm256_set1_ps(EXP2_P[0]);
+		for (int i = 1; i < 6; i++)
+		{
+			p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(EXP2_P[i]));
+		}
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.0f));
+
+		__m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+		return(_mm256_mul_ps(p, _mm256_castsi256_ps(scale)));
+	}
+#endif
+}
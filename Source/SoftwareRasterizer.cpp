@@ -0,0 +1,912 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.cpp
+// ======================
+// multithreaded tile based rasterizer that renders the scene on the CPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+#include "SimdMath.h"
+#include "WorkerThreads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	const int LANE_COUNT = 8;
+	// window positions are snapped to 1/256 of a pixel
+	const float SUBPIXEL_SCALE = 256.0f;
+	// triangles reaching further than this many half viewports from
+	// the center are clipped, which keeps the snapped positions and
+	// edge functions exact
+	const float GUARD_BAND = 4.0f;
+	// number of planes a triangle is clipped against - the near
+	// plane and the four sides of the guard band
+	const int CLIP_PLANE_COUNT = 5;
+	// the polygon left after clipping a triangle by every plane
+	const int MAX_CLIPPED_VERTICES = 3 + CLIP_PLANE_COUNT;
+	// clip space position followed by the attributes
+	const int CLIP_VALUE_COUNT = 4 + SoftwareRasterizer::ATTRIBUTE_COUNT;
+	typedef float CLIP_VERTEX[CLIP_VALUE_COUNT];
+	// the frame is cleared to opaque black and the far plane
+	const uint32_t CLEAR_COLOR = 0xFF000000u;
+	const float CLEAR_DEPTH = 1.0f;
+
+#if defined(SIMD_MATH_AVX2)
+	// eight floats and eight lane masks in AVX2 registers
+	struct LANES { __m256 v; };
+	struct MASK { __m256 v; };
+
+	inline LANES Set(float x) { LANES r = { _mm256_set1_ps(x) }; return(r); }
+	inline LANES LaneOffsets() { LANES r = { _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f) }; return(r); }
+	inline LANES Load(const float* p) { LANES r = { _mm256_loadu_ps(p) }; return(r); }
+	inline LANES operator+(LANES a, LANES b) { LANES r = { _mm256_add_ps(a.v, b.v) }; return(r); }
+	inline LANES operator-(LANES a, LANES b) { LANES r = { _mm256_sub_ps(a.v, b.v) }; return(r); }
+	inline LANES operator*(LANES a, LANES b) { LANES r = { _mm256_mul_ps(a.v, b.v) }; return(r); }
+	inline LANES operator/(LANES a, LANES b) { LANES r = { _mm256_div_ps(a.v, b.v) }; return(r); }
+	inline LANES Fma(LANES a, LANES b, LANES c) { LANES r = { _mm256_fmadd_ps(a.v, b.v, c.v) }; return(r); }
+	inline LANES Min(LANES a, LANES b) { LANES r = { _mm256_min_ps(a.v, b.v) }; return(r); }
+	inline LANES Max(LANES a, LANES b) { LANES r = { _mm256_max_ps(a.v, b.v) }; return(r); }
+	inline LANES Sqrt(LANES a) { LANES r = { _mm256_sqrt_ps(a.v) }; return(r); }
+	inline MASK Less(LANES a, LANES b) { MASK r = { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; return(r); }
+	inline MASK LessEqual(LANES a, LANES b) { MASK r = { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; return(r); }
+	inline MASK operator&(MASK a, MASK b) { MASK r = { _mm256_and_ps(a.v, b.v) }; return(r); }
+	inline bool Any(MASK a) { return(_mm256_movemask_ps(a.v) != 0); }
+	inline void StoreMasked(float* p, MASK mask, LANES a) { _mm256_maskstore_ps(p, _mm256_castps_si256(mask.v), a.v); }
+
+	// x to the power of the exponent, 0 where x is not positive
+	inline LANES Pow(LANES x, float exponent)
+	{
+		__m256 valid = _mm256_cmp_ps(x.v, _mm256_set1_ps(FLT_MIN), _CMP_GE_OQ);
+		__m256 result = SimdMath::Exp2_8(_mm256_mul_ps(_mm256_set1_ps(exponent),
+			SimdMath::Log2_8(_mm256_max_ps(x.v, _mm256_set1_ps(FLT_MIN)))));
+		LANES r = { _mm256_and_ps(valid, result) };
+		return(r);
+	}
+
+	// one 8-bit channel of eight RGBA8 values as 0..1 floats
+	inline __m256 UnpackChannel(__m256i texels, int shift)
+	{
+		__m256i channel = _mm256_and_si256(_mm256_srlv_epi32(texels, _mm256_set1_epi32(shift)), _mm256_set1_epi32(0xFF));
+		return(_mm256_mul_ps(_mm256_cvtepi32_ps(channel), _mm256_set1_ps(1.0f / 255.0f)));
+	}
+
+	/***********************************************************
+	 *  SampleTexture()
+	 *
+	 *  Bilinear fetch with repeat wrapping, the way the scene
+	 *  textures are sampled by GL_LINEAR and GL_REPEAT.
+	 ***********************************************************/
+	void SampleTexture(const RASTER_TEXTURE& texture, LANES u, LANES v, LANES* pRGBA)
+	{
+		const __m256 width = _mm256_set1_ps((float)texture.width);
+		const __m256 height = _mm256_set1_ps((float)texture.height);
+		const __m256 half = _mm256_set1_ps(0.5f);
+
+		__m256 x = _mm256_fmsub_ps(u.v, width, half);
+		__m256 y = _mm256_fmsub_ps(v.v, height, half);
+		__m256 x0 = _mm256_floor_ps(x);
+		__m256 y0 = _mm256_floor_ps(y);
+		const __m256 weightX = _mm256_sub_ps(x, x0);
+		const __m256 weightY = _mm256_sub_ps(y, y0);
+		x0 = _mm256_fnmadd_ps(width, _mm256_floor_ps(_mm256_div_ps(x0, width)), x0);
+		y0 = _mm256_fnmadd_ps(height, _mm256_floor_ps(_mm256_div_ps(y0, height)), y0);
+
+		// clamping also keeps lanes with no coverage inside the image
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i lastX = _mm256_set1_epi32(texture.width - 1);
+		const __m256i lastY = _mm256_set1_epi32(texture.height - 1);
+		__m256i column0 = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(x0), zero), lastX);
+		__m256i row0 = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(y0), zero), lastY);
+		__m256i column1 = _mm256_add_epi32(column0, _mm256_set1_epi32(1));
+		__m256i row1 = _mm256_add_epi32(row0, _mm256_set1_epi32(1));
+		column1 = _mm256_andnot_si256(_mm256_cmpgt_epi32(column1, lastX), column1);
+		row1 = _mm256_andnot_si256(_mm256_cmpgt_epi32(row1, lastY), row1);
+		row0 = _mm256_mullo_epi32(row0, _mm256_set1_epi32(texture.width));
+		row1 = _mm256_mullo_epi32(row1, _mm256_set1_epi32(texture.width));
+
+		const int* pTexels = (const int*)texture.texels.data();
+		const __m256i texels00 = _mm256_i32gather_epi32(pTexels, _mm256_add_epi32(row0, column0), 4);
+		const __m256i texels10 = _mm256_i32gather_epi32(pTexels, _mm256_add_epi32(row0, column1), 4);
+		const __m256i texels01 = _mm256_i32gather_epi32(pTexels, _mm256_add_epi32(row1, column0), 4);
+		const __m256i texels11 = _mm256_i32gather_epi32(pTexels, _mm256_add_epi32(row1, column1), 4);
+		for (int channel = 0; channel < 4; channel++)
+		{
+			const int shift = channel * 8;
+			const __m256 c00 = UnpackChannel(texels00, shift);
+			const __m256 c10 = UnpackChannel(texels10, shift);
+			const __m256 c01 = UnpackChannel(texels01, shift);
+			const __m256 c11 = UnpackChannel(texels11, shift);
+			const __m256 bottom = _mm256_fmadd_ps(weightX, _mm256_sub_ps(c10, c00), c00);
+			const __m256 top = _mm256_fmadd_ps(weightX, _mm256_sub_ps(c11, c01), c01);
+			pRGBA[channel].v = _mm256_fmadd_ps(weightY, _mm256_sub_ps(top, bottom), bottom);
+		}
+	}
+
+	/***********************************************************
+	 *  BlendSpan()
+	 *
+	 *  Blend the shaded colors of the masked pixels over the
+	 *  frame with SRC_ALPHA, ONE_MINUS_SRC_ALPHA, as set up for
+	 *  OpenGL, and store them as RGBA8.
+	 ***********************************************************/
+	void BlendSpan(uint32_t* pColor, MASK mask, const LANES* pRGBA)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256i destination = _mm256_loadu_si256((const __m256i*)pColor);
+		const __m256 alpha = _mm256_min_ps(_mm256_max_ps(pRGBA[3].v, zero), one);
+		const __m256 inverseAlpha = _mm256_sub_ps(one, alpha);
+
+		__m256i packed = _mm256_setzero_si256();
+		for (int channel = 0; channel < 4; channel++)
+		{
+			const __m256 source = (channel == 3) ? alpha : _mm256_min_ps(_mm256_max_ps(pRGBA[channel].v, zero), one);
+			const __m256 blended = _mm256_fmadd_ps(source, alpha,
+				_mm256_mul_ps(UnpackChannel(destination, channel * 8), inverseAlpha));
+			const __m256i value = _mm256_cvtps_epi32(_mm256_mul_ps(blended, _mm256_set1_ps(255.0f)));
+			packed = _mm256_or_si256(packed, _mm256_sllv_epi32(value, _mm256_set1_epi32(channel * 8)));
+		}
+		_mm256_maskstore_epi32((int*)pColor, _mm256_castps_si256(mask.v), packed);
+	}
+#else
+	// eight floats and eight lane masks as plain arrays, in loops
+	// the compiler can vectorize
+	struct LANES { float v[LANE_COUNT]; };
+	struct MASK { bool v[LANE_COUNT]; };
+
+	inline LANES Set(float x) { LANES r; for (int i = 0; i < LANE_COUNT; i++) { r.v[i] = x; } return(r); }
+	inline LANES LaneOffsets() { LANES r; for (int i = 0; i < LANE_COUNT; i++) { r.v[i] = (float)i; } return(r); }
+	inline LANES Load(const float* p) { LANES r; for (int i = 0; i < LANE_COUNT; i++) { r.v[i] = p[i]; } return(r); }
+	inline LANES operator+(LANES a, LANES b) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] += b.v[i]; } return(a); }
+	inline LANES operator-(LANES a, LANES b) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] -= b.v[i]; } return(a); }
+	inline LANES operator*(LANES a, LANES b) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] *= b.v[i]; } return(a); }
+	inline LANES operator/(LANES a, LANES b) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] /= b.v[i]; } return(a); }
+	inline LANES Fma(LANES a, LANES b, LANES c) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] = (a.v[i] * b.v[i]) + c.v[i]; } return(a); }
+	inline LANES Min(LANES a, LANES b) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] = std::min(a.v[i], b.v[i]); } return(a); }
+	inline LANES Max(LANES a, LANES b) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] = std::max(a.v[i], b.v[i]); } return(a); }
+	inline LANES Sqrt(LANES a) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] = std::sqrt(a.v[i]); } return(a); }
+	inline MASK Less(LANES a, LANES b) { MASK r; for (int i = 0; i < LANE_COUNT; i++) { r.v[i] = a.v[i] < b.v[i]; } return(r); }
+	inline MASK LessEqual(LANES a, LANES b) { MASK r; for (int i = 0; i < LANE_COUNT; i++) { r.v[i] = a.v[i] <= b.v[i]; } return(r); }
+	inline MASK operator&(MASK a, MASK b) { for (int i = 0; i < LANE_COUNT; i++) { a.v[i] = a.v[i] && b.v[i]; } return(a); }
+	inline bool Any(MASK a) { bool bAny = false; for (int i = 0; i < LANE_COUNT; i++) { bAny = bAny || a.v[i]; } return(bAny); }
+	inline void StoreMasked(float* p, MASK mask, LANES a) { for (int i = 0; i < LANE_COUNT; i++) { if (mask.v[i]) { p[i] = a.v[i]; } } }
+
+	// x to the power of the exponent, 0 where x is not positive
+	inline LANES Pow(LANES x, float exponent)
+	{
+		for (int i = 0; i < LANE_COUNT; i++)
+		{
+			x.v[i] = (x.v[i] > 0.0f) ? std::pow(x.v[i], exponent) : 0.0f;
+		}
+		return(x);
+	}
+
+	/***********************************************************
+	 *  SampleTexture()
+	 *
+	 *  Bilinear fetch with repeat wrapping, the way the scene
+	 *  textures are sampled by GL_LINEAR and GL_REPEAT.
+	 ***********************************************************/
+	void SampleTexture(const RASTER_TEXTURE& texture, LANES u, LANES v, LANES* pRGBA)
+	{
+		for (int i = 0; i < LANE_COUNT; i++)
+		{
+			const float x = (u.v[i] * texture.width) - 0.5f;
+			const float y = (v.v[i] * texture.height) - 0.5f;
+			float x0 = std::floor(x);
+			float y0 = std::floor(y);
+			const float weightX = x - x0;
+			const float weightY = y - y0;
+			x0 -= texture.width * std::floor(x0 / texture.width);
+			y0 -= texture.height * std::floor(y0 / texture.height);
+
+			// clamping also keeps lanes with no coverage inside the image
+			const int column0 = std::min(std::max((int)x0, 0), texture.width - 1);
+			const int row0 = std::min(std::max((int)y0, 0), texture.height - 1);
+			const int column1 = (column0 + 1 < texture.width) ? column0 + 1 : 0;
+			const int row1 = (row0 + 1 < texture.height) ? row0 + 1 : 0;
+			const uint32_t texels[4] =
+			{
+				texture.texels[(size_t)row0 * texture.width + column0],
+				texture.texels[(size_t)row0 * texture.width + column1],
+				texture.texels[(size_t)row1 * texture.width + column0],
+				texture.texels[(size_t)row1 * texture.width + column1]
+			};
+			for (int channel = 0; channel < 4; channel++)
+			{
+				float c[4];
+				for (int j = 0; j < 4; j++)
+				{
+					c[j] = ((texels[j] >> (channel * 8)) & 0xFF) / 255.0f;
+				}
+				const float bottom = c[0] + (weightX * (c[1] - c[0]));
+				const float top = c[2] + (weightX * (c[3] - c[2]));
+				pRGBA[channel].v[i] = bottom + (weightY * (top - bottom));
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  BlendSpan()
+	 *
+	 *  Blend the shaded colors of the masked pixels over the
+	 *  frame with SRC_ALPHA, ONE_MINUS_SRC_ALPHA, as set up for
+	 *  OpenGL, and store them as RGBA8.
+	 ***********************************************************/
+	void BlendSpan(uint32_t* pColor, MASK mask, const LANES* pRGBA)
+	{
+		for (int i = 0; i < LANE_COUNT; i++)
+		{
+			if (mask.v[i] == false)
+			{
+				continue;
+			}
+			const float alpha = std::min(std::max(pRGBA[3].v[i], 0.0f), 1.0f);
+			uint32_t packed = 0;
+			for (int channel = 0; channel < 4; channel++)
+			{
+				const float source = (channel == 3) ? alpha : std::min(std::max(pRGBA[channel].v[i], 0.0f), 1.0f);
+				const float destination = ((pColor[i] >> (channel * 8)) & 0xFF) / 255.0f;
+				const float blended = (source * alpha) + (destination * (1.0f - alpha));
+				packed |= (uint32_t)std::lrint(blended * 255.0f) << (channel * 8);
+			}
+			pColor[i] = packed;
+		}
+	}
+#endif
+
+	// three component vectors of lanes
+	struct LANES3
+	{
+		LANES x;
+		LANES y;
+		LANES z;
+	};
+
+	inline LANES3 Set(const glm::vec3& v)
+	{
+		LANES3 r = { Set(v.x), Set(v.y), Set(v.z) };
+		return(r);
+	}
+
+	inline LANES3 operator-(const LANES3& a, const LANES3& b)
+	{
+		LANES3 r = { a.x - b.x, a.y - b.y, a.z - b.z };
+		return(r);
+	}
+
+	inline LANES Dot(const LANES3& a, const LANES3& b)
+	{
+		return(Fma(a.x, b.x, Fma(a.y, b.y, a.z * b.z)));
+	}
+
+	inline LANES3 Normalize(const LANES3& a)
+	{
+		const LANES inverseLength = Set(1.0f) / Sqrt(Dot(a, a));
+		LANES3 r = { a.x * inverseLength, a.y * inverseLength, a.z * inverseLength };
+		return(r);
+	}
+
+	// add color * scale to the lit color
+	inline void AddScaled(LANES3& lit, const glm::vec3& color, LANES scale)
+	{
+		lit.x = Fma(Set(color.r), scale, lit.x);
+		lit.y = Fma(Set(color.g), scale, lit.y);
+		lit.z = Fma(Set(color.b), scale, lit.z);
+	}
+
+	/***********************************************************
+	 *  AddLight()
+	 *
+	 *  Add the ambient, diffuse and specular terms of one light
+	 *  for the unit direction to it, scaled by the attenuation,
+	 *  as CalcDirectionalLight(), CalcPointLight() and
+	 *  CalcSpotLight() of the fragment shader do.  Only the point
+	 *  lights leave the specular term untinted by the surface.
+	 ***********************************************************/
+	void AddLight(
+		const SHADER_LIGHT& light,
+		const RASTER_SURFACE& surface,
+		const LANES3& toLight,
+		const LANES3& normal,
+		const LANES3& toView,
+		const LANES3& base,
+		LANES scale,
+		bool bTintSpecular,
+		LANES3& lit)
+	{
+		const LANES zero = Set(0.0f);
+		const LANES normalDotLight = Dot(normal, toLight);
+		const LANES diffuse = Max(normalDotLight, zero) * scale;
+		const glm::vec3 diffuseColor = light.diffuse * surface.diffuseColor;
+
+		lit.x = Fma(Set(light.ambient.r) * scale, base.x, lit.x);
+		lit.y = Fma(Set(light.ambient.g) * scale, base.y, lit.y);
+		lit.z = Fma(Set(light.ambient.b) * scale, base.z, lit.z);
+		lit.x = Fma(Set(diffuseColor.r) * diffuse, base.x, lit.x);
+		lit.y = Fma(Set(diffuseColor.g) * diffuse, base.y, lit.y);
+		lit.z = Fma(Set(diffuseColor.b) * diffuse, base.z, lit.z);
+
+		// the specular term is skipped when it would add nothing
+		const glm::vec3 specularColor = light.specular * surface.specularColor;
+		if ((specularColor.r == 0.0f) && (specularColor.g == 0.0f) && (specularColor.b == 0.0f))
+		{
+			return;
+		}
+
+		// reflect(-toLight, normal) = 2 * dot(normal, toLight) * normal - toLight
+		const LANES twice = normalDotLight + normalDotLight;
+		const LANES3 reflected = { Fma(twice, normal.x, zero - toLight.x), Fma(twice, normal.y, zero - toLight.y), Fma(twice, normal.z, zero - toLight.z) };
+		const LANES specular = Pow(Max(Dot(toView, reflected), zero), surface.shininess) * scale;
+		if (bTintSpecular == true)
+		{
+			lit.x = Fma(Set(specularColor.r) * specular, base.x, lit.x);
+			lit.y = Fma(Set(specularColor.g) * specular, base.y, lit.y);
+			lit.z = Fma(Set(specularColor.b) * specular, base.z, lit.z);
+		}
+		else
+		{
+			AddScaled(lit, specularColor, specular);
+		}
+	}
+
+	/***********************************************************
+	 *  ShadeSpan()
+	 *
+	 *  Shade eight pixels of a surface from their interpolated
+	 *  world position, normal and texture coordinate, the way
+	 *  the fragment shader does.
+	 ***********************************************************/
+	void ShadeSpan(const RASTER_SCENE& scene, const RASTER_SURFACE& surface, const LANES* pAttributes, LANES* pRGBA)
+	{
+		// the unlit color of the surface
+		if (surface.texture >= 0)
+		{
+			SampleTexture(scene.textures[surface.texture],
+				pAttributes[6] * Set(surface.uvScale.x), pAttributes[7] * Set(surface.uvScale.y), pRGBA);
+		}
+		else
+		{
+			for (int channel = 0; channel < 4; channel++)
+			{
+				pRGBA[channel] = Set(surface.color[channel]);
+			}
+		}
+		if (scene.bUseLighting == false)
+		{
+			return;
+		}
+
+		const LANES3 position = { pAttributes[0], pAttributes[1], pAttributes[2] };
+		const LANES3 normal = Normalize({ pAttributes[3], pAttributes[4], pAttributes[5] });
+		const LANES3 toView = Normalize(Set(scene.viewPosition) - position);
+		const LANES3 base = { pRGBA[0], pRGBA[1], pRGBA[2] };
+		const LANES one = Set(1.0f);
+		LANES3 lit = { Set(0.0f), Set(0.0f), Set(0.0f) };
+
+		if (scene.directionalLight.bActive == true)
+		{
+			AddLight(scene.directionalLight, surface, Set(glm::normalize(-scene.directionalLight.direction)),
+				normal, toView, base, one, true, lit);
+		}
+		for (int i = 0; i < RASTER_SCENE::POINT_LIGHT_COUNT; i++)
+		{
+			if (scene.pointLights[i].bActive == true)
+			{
+				AddLight(scene.pointLights[i], surface, Normalize(Set(scene.pointLights[i].position) - position),
+					normal, toView, base, one, false, lit);
+			}
+		}
+		if (scene.spotLight.bActive == true)
+		{
+			const SHADER_LIGHT& light = scene.spotLight;
+			const LANES3 offset = Set(light.position) - position;
+			const LANES distance = Sqrt(Dot(offset, offset));
+			const LANES3 toLight = Normalize(offset);
+			const LANES attenuation = one / Fma(Set(light.quadratic) * distance, distance, Fma(Set(light.linear), distance, Set(light.constant)));
+			const LANES theta = Dot(toLight, Set(glm::normalize(-light.direction)));
+			const LANES intensity = Min(Max((theta - Set(light.outerCutOff)) / Set(light.cutOff - light.outerCutOff), Set(0.0f)), one);
+			AddLight(light, surface, toLight, normal, toView, base, attenuation * intensity, true, lit);
+		}
+
+		pRGBA[0] = lit.x;
+		pRGBA[1] = lit.y;
+		pRGBA[2] = lit.z;
+	}
+
+	// decode an octahedral normal the way the vertex shader does
+	glm::vec3 DecodeOctahedral(const int16_t* pEncoded)
+	{
+		glm::vec2 encoded(std::max(pEncoded[0] / 32767.0f, -1.0f), std::max(pEncoded[1] / 32767.0f, -1.0f));
+		glm::vec3 normal(encoded, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+		const float fold = std::max(-normal.z, 0.0f);
+		normal.x += (normal.x >= 0.0f) ? -fold : fold;
+		normal.y += (normal.y >= 0.0f) ? -fold : fold;
+		return(glm::normalize(normal));
+	}
+
+	// signed distance of a vertex to a clip plane, inside when not
+	// negative
+	inline float PlaneDistance(const CLIP_VERTEX& vertex, int plane)
+	{
+		switch (plane)
+		{
+		case 0:
+			return(vertex[2] + vertex[3]);
+		case 1:
+			return((GUARD_BAND * vertex[3]) - vertex[0]);
+		case 2:
+			return((GUARD_BAND * vertex[3]) + vertex[0]);
+		case 3:
+			return((GUARD_BAND * vertex[3]) - vertex[1]);
+		default:
+			return((GUARD_BAND * vertex[3]) + vertex[1]);
+		}
+	}
+
+	// outcode of the sides of the view volume a vertex is outside of
+	inline int ViewVolumeOutcode(const CLIP_VERTEX& vertex)
+	{
+		const float w = vertex[3];
+		return(((vertex[0] < -w) ? 1 : 0) | ((vertex[0] > w) ? 2 : 0) |
+			((vertex[1] < -w) ? 4 : 0) | ((vertex[1] > w) ? 8 : 0) |
+			((vertex[2] < -w) ? 16 : 0) | ((vertex[2] > w) ? 32 : 0));
+	}
+
+	/***********************************************************
+	 *  ClipPolygon()
+	 *
+	 *  Clip a convex polygon against every clip plane, keeping
+	 *  the vertices inside and adding one where an edge crosses
+	 *  a plane.  The crossing is always found from the inside
+	 *  end of the edge, so an edge two triangles share is cut
+	 *  at the same point for both.  Returns the number of
+	 *  vertices left.
+	 ***********************************************************/
+	int ClipPolygon(CLIP_VERTEX* pVertices, int count)
+	{
+		CLIP_VERTEX scratch[MAX_CLIPPED_VERTICES];
+		CLIP_VERTEX* pSource = pVertices;
+		CLIP_VERTEX* pTarget = scratch;
+		for (int plane = 0; (plane < CLIP_PLANE_COUNT) && (count > 0); plane++)
+		{
+			int clipped = 0;
+			for (int i = 0; i < count; i++)
+			{
+				const CLIP_VERTEX& current = pSource[i];
+				const CLIP_VERTEX& next = pSource[(i + 1) % count];
+				const float currentDistance = PlaneDistance(current, plane);
+				const float nextDistance = PlaneDistance(next, plane);
+				if (currentDistance >= 0.0f)
+				{
+					memcpy(pTarget[clipped++], current, sizeof(CLIP_VERTEX));
+				}
+				if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+				{
+					const bool bCurrentInside = (currentDistance >= 0.0f);
+					const CLIP_VERTEX& inside = bCurrentInside ? current : next;
+					const CLIP_VERTEX& outside = bCurrentInside ? next : current;
+					const float insideDistance = bCurrentInside ? currentDistance : nextDistance;
+					const float outsideDistance = bCurrentInside ? nextDistance : currentDistance;
+					const float t = insideDistance / (insideDistance - outsideDistance);
+					for (int value = 0; value < CLIP_VALUE_COUNT; value++)
+					{
+						pTarget[clipped][value] = inside[value] + (t * (outside[value] - inside[value]));
+					}
+					clipped++;
+				}
+			}
+			count = clipped;
+			std::swap(pSource, pTarget);
+		}
+		if (pSource != pVertices)
+		{
+			memcpy(pVertices, pSource, count * sizeof(CLIP_VERTEX));
+		}
+		return(count);
+	}
+}
+
+/***********************************************************
+ *  SoftwareRasterizer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareRasterizer::SoftwareRasterizer(unsigned int threadCount)
+{
+	m_threadCount = WorkerThreads::ResolveThreadCount(threadCount);
+	m_width = 0;
+	m_height = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+	m_stride = 0;
+	m_triangles.resize(m_threadCount);
+	m_bins.resize(m_threadCount);
+}
+
+/***********************************************************
+ *  GetFrameTriangles()
+ *
+ *  This method is used for counting the triangles of the
+ *  last frame that survived clipping and culling.
+ ***********************************************************/
+size_t SoftwareRasterizer::GetFrameTriangles() const
+{
+	size_t triangles = 0;
+	for (const std::vector<SETUP_TRIANGLE>& chunk : m_triangles)
+	{
+		triangles += chunk.size();
+	}
+
+	return(triangles);
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for rendering a frame of the scene.
+ *  The triangles are split into one contiguous run per
+ *  thread for the setup and binning, and the threads then
+ *  take tiles from a shared counter until all are drawn.
+ ***********************************************************/
+void SoftwareRasterizer::Render(const RASTER_SCENE& scene, int width, int height)
+{
+	if ((width != m_width) || (height != m_height))
+	{
+		m_width = width;
+		m_height = height;
+		m_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+		m_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+		m_stride = m_tilesX * TILE_SIZE;
+		m_color.resize((size_t)m_stride * m_tilesY * TILE_SIZE);
+		m_depth.resize((size_t)m_stride * m_tilesY * TILE_SIZE);
+		m_pixels.resize((size_t)width * height);
+	}
+	const int tileCount = m_tilesX * m_tilesY;
+
+	// the first triangle and the matrices of every draw
+	m_drawStarts.resize(scene.draws.size() + 1);
+	m_drawMatrices.resize(scene.draws.size());
+	const glm::mat4 viewProjection = scene.projection * scene.view;
+	size_t triangleCount = 0;
+	for (size_t i = 0; i < scene.draws.size(); i++)
+	{
+		const RASTER_DRAW& draw = scene.draws[i];
+		m_drawStarts[i] = triangleCount;
+		triangleCount += draw.indexCount / 3;
+
+		const glm::mat3 model3(draw.model);
+		m_drawMatrices[i].modelViewProjection = viewProjection * draw.model;
+		m_drawMatrices[i].model = draw.model;
+		m_drawMatrices[i].normal = (glm::determinant(model3) != 0.0f) ? glm::transpose(glm::inverse(model3)) : model3;
+	}
+	m_drawStarts[scene.draws.size()] = triangleCount;
+
+	const size_t chunkCount = m_threadCount;
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		m_triangles[chunk].clear();
+		m_bins[chunk].resize(tileCount);
+		for (std::vector<uint32_t>& bin : m_bins[chunk])
+		{
+			bin.clear();
+		}
+	}
+
+	WorkerThreads::ParallelFor(chunkCount, m_threadCount, 1,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t chunk = begin; chunk < end; chunk++)
+			{
+				SetupTriangles(scene, (triangleCount * chunk) / chunkCount, (triangleCount * (chunk + 1)) / chunkCount, chunk);
+			}
+		});
+
+	std::atomic<int> nextTile(0);
+	WorkerThreads::ParallelFor(m_threadCount, m_threadCount, 1,
+		[&](size_t, size_t)
+		{
+			for (int tile = nextTile++; tile < tileCount; tile = nextTile++)
+			{
+				RasterizeTile(scene, tile);
+			}
+		});
+}
+
+/***********************************************************
+ *  SetupTriangles()
+ *
+ *  This method is used for fetching and transforming the
+ *  vertices of a run of triangles as the vertex shader does,
+ *  dropping the ones outside the view, clipping the ones
+ *  crossing the near plane or the guard band, and binning
+ *  the rest.
+ ***********************************************************/
+void SoftwareRasterizer::SetupTriangles(const RASTER_SCENE& scene, size_t begin, size_t end, size_t chunk)
+{
+	size_t draw = std::upper_bound(m_drawStarts.begin(), m_drawStarts.end(), begin) - m_drawStarts.begin() - 1;
+	CLIP_VERTEX polygon[MAX_CLIPPED_VERTICES];
+
+	for (size_t triangle = begin; triangle < end; triangle++)
+	{
+		while (triangle >= m_drawStarts[draw + 1])
+		{
+			draw++;
+		}
+		const RASTER_DRAW& rasterDraw = scene.draws[draw];
+		const DRAW_MATRICES& matrices = m_drawMatrices[draw];
+		const uint32_t* pIndices = scene.pIndices + rasterDraw.firstIndex + ((triangle - m_drawStarts[draw]) * 3);
+
+		int outside = ~0;
+		bool bClip = false;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const PACKED_VERTEX& packed = scene.pVertices[rasterDraw.baseVertex + pIndices[corner]];
+			const glm::vec4 position(
+				rasterDraw.bounds.minimum + (glm::vec3(packed.position[0], packed.position[1], packed.position[2]) / 65535.0f) * rasterDraw.bounds.extent,
+				1.0f);
+			const glm::vec4 clip = matrices.modelViewProjection * position;
+			const glm::vec3 world = glm::vec3(matrices.model * position);
+			const glm::vec3 normal = matrices.normal * DecodeOctahedral(packed.normal);
+
+			float* pValues = polygon[corner];
+			pValues[0] = clip.x;
+			pValues[1] = clip.y;
+			pValues[2] = clip.z;
+			pValues[3] = clip.w;
+			pValues[4] = world.x;
+			pValues[5] = world.y;
+			pValues[6] = world.z;
+			pValues[7] = normal.x;
+			pValues[8] = normal.y;
+			pValues[9] = normal.z;
+			pValues[10] = packed.textureCoordinate[0] / 65535.0f;
+			pValues[11] = packed.textureCoordinate[1] / 65535.0f;
+
+			outside &= ViewVolumeOutcode(polygon[corner]);
+			for (int plane = 0; plane < CLIP_PLANE_COUNT; plane++)
+			{
+				bClip = bClip || (PlaneDistance(polygon[corner], plane) < 0.0f);
+			}
+		}
+
+		// every corner is outside the same side of the view
+		if (outside != 0)
+		{
+			continue;
+		}
+
+		int count = 3;
+		if (bClip == true)
+		{
+			count = ClipPolygon(polygon, count);
+		}
+		for (int i = 1; i + 1 < count; i++)
+		{
+			CLIP_VERTEX fan[3];
+			memcpy(fan[0], polygon[0], sizeof(CLIP_VERTEX));
+			memcpy(fan[1], polygon[i], sizeof(CLIP_VERTEX));
+			memcpy(fan[2], polygon[i + 1], sizeof(CLIP_VERTEX));
+			BinTriangle(fan, rasterDraw.surface, chunk);
+		}
+	}
+}
+
+/***********************************************************
+ *  BinTriangle()
+ *
+ *  This method is used for projecting a clipped triangle to
+ *  the window, snapping its corners, setting up its edge
+ *  functions and adding it to the bin of every tile its
+ *  bounds touch.  Both faces are drawn, as the scene does
+ *  not cull, so clockwise triangles are turned around.
+ ***********************************************************/
+void SoftwareRasterizer::BinTriangle(const float (*pVertices)[4 + ATTRIBUTE_COUNT], int surface, size_t chunk)
+{
+	SETUP_TRIANGLE triangle;
+	triangle.surface = surface;
+	for (int corner = 0; corner < 3; corner++)
+	{
+		const float* pValues = pVertices[corner];
+		const float inverseW = 1.0f / pValues[3];
+		const float x = ((pValues[0] * inverseW * 0.5f) + 0.5f) * m_width;
+		const float y = ((pValues[1] * inverseW * 0.5f) + 0.5f) * m_height;
+		triangle.x[corner] = std::floor((x * SUBPIXEL_SCALE) + 0.5f) / SUBPIXEL_SCALE;
+		triangle.y[corner] = std::floor((y * SUBPIXEL_SCALE) + 0.5f) / SUBPIXEL_SCALE;
+		triangle.depth[corner] = (pValues[2] * inverseW * 0.5f) + 0.5f;
+		triangle.inverseW[corner] = inverseW;
+		for (int i = 0; i < ATTRIBUTE_COUNT; i++)
+		{
+			triangle.attributes[corner][i] = pValues[4 + i] * inverseW;
+		}
+	}
+
+	// the snapped positions make the doubled area exact
+	double area = ((double)(triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0])) -
+		((double)(triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]));
+	if (area == 0.0)
+	{
+		return;
+	}
+	if (area < 0.0)
+	{
+		area = -area;
+		std::swap(triangle.x[1], triangle.x[2]);
+		std::swap(triangle.y[1], triangle.y[2]);
+		std::swap(triangle.depth[1], triangle.depth[2]);
+		std::swap(triangle.inverseW[1], triangle.inverseW[2]);
+		for (int i = 0; i < ATTRIBUTE_COUNT; i++)
+		{
+			std::swap(triangle.attributes[1][i], triangle.attributes[2][i]);
+		}
+	}
+	triangle.inverseArea = (float)(1.0 / area);
+
+	// pixel centers inside the triangle's bounds and the frame
+	const float minX = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+	const float maxX = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+	const float minY = std::min(std::min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+	const float maxY = std::max(std::max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+	triangle.minX = std::max((int)std::ceil(minX - 0.5f), 0);
+	triangle.maxX = std::min((int)std::floor(maxX - 0.5f), m_width - 1);
+	triangle.minY = std::max((int)std::ceil(minY - 0.5f), 0);
+	triangle.maxY = std::min((int)std::floor(maxY - 0.5f), m_height - 1);
+	if ((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+	{
+		return;
+	}
+
+	// pixel centers on an edge belong to the triangle the edge is
+	// a top or left edge of, so they are drawn exactly once
+	for (int edge = 0; edge < 3; edge++)
+	{
+		const int from = (edge + 1) % 3;
+		const int to = (edge + 2) % 3;
+		triangle.a[edge] = triangle.y[from] - triangle.y[to];
+		triangle.b[edge] = triangle.x[to] - triangle.x[from];
+		triangle.bInclusive[edge] = (triangle.a[edge] > 0.0f) || ((triangle.a[edge] == 0.0f) && (triangle.b[edge] < 0.0f));
+	}
+
+	std::vector<SETUP_TRIANGLE>& triangles = m_triangles[chunk];
+	const uint32_t index = (uint32_t)triangles.size();
+	triangles.push_back(triangle);
+	for (int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++)
+	{
+		for (int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++)
+		{
+			m_bins[chunk][(tileY * m_tilesX) + tileX].push_back(index);
+		}
+	}
+}
+
+/***********************************************************
+ *  RasterizeTile()
+ *
+ *  This method is used for clearing a tile, drawing the
+ *  triangles binned for it in submission order, and copying
+ *  the finished tile into the frame.
+ ***********************************************************/
+void SoftwareRasterizer::RasterizeTile(const RASTER_SCENE& scene, int tile)
+{
+	const int tileX = (tile % m_tilesX) * TILE_SIZE;
+	const int tileY = (tile / m_tilesX) * TILE_SIZE;
+	for (int row = 0; row < TILE_SIZE; row++)
+	{
+		const size_t offset = ((size_t)(tileY + row) * m_stride) + tileX;
+		std::fill_n(&m_color[offset], TILE_SIZE, CLEAR_COLOR);
+		std::fill_n(&m_depth[offset], TILE_SIZE, CLEAR_DEPTH);
+	}
+
+	for (size_t chunk = 0; chunk < m_bins.size(); chunk++)
+	{
+		for (uint32_t index : m_bins[chunk][tile])
+		{
+			DrawTriangle(scene, m_triangles[chunk][index], tileX, tileY);
+		}
+	}
+
+	const int width = std::min(TILE_SIZE, m_width - tileX);
+	const int height = std::min(TILE_SIZE, m_height - tileY);
+	for (int row = 0; row < height; row++)
+	{
+		memcpy(&m_pixels[((size_t)(tileY + row) * m_width) + tileX],
+			&m_color[((size_t)(tileY + row) * m_stride) + tileX], width * sizeof(uint32_t));
+	}
+}
+
+/***********************************************************
+ *  DrawTriangle()
+ *
+ *  This method is used for drawing the pixels of a triangle
+ *  inside a tile, eight at a time.  The edge functions start
+ *  from their exact values at the tile's first pixel center,
+ *  so a shared edge gives its two triangles exactly opposite
+ *  values at every pixel.  Covered pixels closer than the
+ *  depth buffer are interpolated with perspective correction,
+ *  shaded, and blended into the tile.
+ ***********************************************************/
+void SoftwareRasterizer::DrawTriangle(const RASTER_SCENE& scene, const SETUP_TRIANGLE& triangle, int tileX, int tileY)
+{
+	const int startX = std::max(triangle.minX, tileX);
+	const int endX = std::min(triangle.maxX, tileX + TILE_SIZE - 1);
+	const int startY = std::max(triangle.minY, tileY);
+	const int endY = std::min(triangle.maxY, tileY + TILE_SIZE - 1);
+	if ((startX > endX) || (startY > endY))
+	{
+		return;
+	}
+
+	float tileEdges[3];
+	for (int edge = 0; edge < 3; edge++)
+	{
+		const int from = (edge + 1) % 3;
+		tileEdges[edge] = (float)(((double)triangle.a[edge] * ((tileX + 0.5) - triangle.x[from])) +
+			((double)triangle.b[edge] * ((tileY + 0.5) - triangle.y[from])));
+	}
+
+	const RASTER_SURFACE& surface = scene.surfaces[triangle.surface];
+	const LANES zero = Set(0.0f);
+	const LANES lastX = Set((float)endX);
+	const LANES inverseArea = Set(triangle.inverseArea);
+	// spans start on a multiple of eight pixels inside the tile
+	const int firstSpan = tileX + ((startX - tileX) & ~(LANE_COUNT - 1));
+
+	for (int y = startY; y <= endY; y++)
+	{
+		const LANES rowY = Set((float)(y - tileY));
+		LANES rowEdges[3];
+		for (int edge = 0; edge < 3; edge++)
+		{
+			rowEdges[edge] = Fma(Set(triangle.b[edge]), rowY, Set(tileEdges[edge]));
+		}
+		uint32_t* pColorRow = &m_color[(size_t)y * m_stride];
+		float* pDepthRow = &m_depth[(size_t)y * m_stride];
+
+		for (int spanX = firstSpan; spanX <= endX; spanX += LANE_COUNT)
+		{
+			const LANES offsetX = Set((float)(spanX - tileX)) + LaneOffsets();
+			MASK covered = LessEqual(offsetX, lastX - Set((float)tileX));
+			LANES edges[3];
+			for (int edge = 0; edge < 3; edge++)
+			{
+				edges[edge] = Fma(Set(triangle.a[edge]), offsetX, rowEdges[edge]);
+				covered = covered & (triangle.bInclusive[edge] ? LessEqual(zero, edges[edge]) : Less(zero, edges[edge]));
+			}
+			if (Any(covered) == false)
+			{
+				continue;
+			}
+
+			// depth is linear in the window, tested with GL_LESS
+			const LANES weight0 = edges[0] * inverseArea;
+			const LANES weight1 = edges[1] * inverseArea;
+			const LANES weight2 = edges[2] * inverseArea;
+			const LANES depth = Fma(weight0, Set(triangle.depth[0]), Fma(weight1, Set(triangle.depth[1]), weight2 * Set(triangle.depth[2])));
+			covered = covered & Less(depth, Load(pDepthRow + spanX));
+			if (Any(covered) == false)
+			{
+				continue;
+			}
+			StoreMasked(pDepthRow + spanX, covered, depth);
+
+			// the attributes were divided by w, so dividing by the
+			// interpolated 1/w makes them perspective correct
+			const LANES w = Set(1.0f) / Fma(weight0, Set(triangle.inverseW[0]), Fma(weight1, Set(triangle.inverseW[1]), weight2 * Set(triangle.inverseW[2])));
+			LANES attributes[ATTRIBUTE_COUNT];
+			for (int i = 0; i < ATTRIBUTE_COUNT; i++)
+			{
+				attributes[i] = Fma(weight0, Set(triangle.attributes[0][i]),
+					Fma(weight1, Set(triangle.attributes[1][i]), weight2 * Set(triangle.attributes[2][i]))) * w;
+			}
+
+			LANES rgba[4];
+			ShadeSpan(scene, surface, attributes, rgba);
+			BlendSpan(pColorRow + spanX, covered, rgba);
+		}
+	}
+}
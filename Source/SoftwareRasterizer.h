@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.h
+// ====================
+// multithreaded tile based rasterizer that renders the scene on the CPU
+//
+// The rasterizer draws the same draws the scene submits to OpenGL, captured
+// with the scene's draw recording, from a copy of the shared packed vertex
+// and index buffers.  Each frame runs in two parallel passes.  The first
+// transforms the triangles, clips them against the near plane and a guard
+// band around the viewport, and sorts them into 64x64 pixel tiles, each
+// thread filling its own bins for a contiguous run of triangles so the
+// submission order is kept.  The second pass hands whole tiles to the
+// threads, which walk the binned triangles eight pixels at a time, testing
+// coverage with the top-left fill rule, then depth, and shading the covered
+// pixels with the same Phong model and alpha blending as the fragment
+// shader.  Vertex positions are snapped to 1/256 of a pixel, so triangles
+// that share an edge never leave a gap or touch a pixel twice.
+//
+// The eight pixel spans use AVX2 when the compiler targets it (/arch:AVX2
+// or -mavx2), and a portable loop over eight floats otherwise.  The frame
+// is RGBA8 with the bottom row first, the same layout glReadPixels returns.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "VertexPacking.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SHADER_LIGHT
+ *
+ *  Values of one light as the fragment shader receives
+ *  them.  Each kind of light uses only some of them.
+ ***********************************************************/
+struct SHADER_LIGHT
+{
+	glm::vec3 position;
+	glm::vec3 direction;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+	float constant;
+	float linear;
+	float quadratic;
+	float cutOff;
+	float outerCutOff;
+	bool bActive;
+};
+
+/***********************************************************
+ *  RASTER_SURFACE
+ *
+ *  Shader values a draw is made with - its color or
+ *  texture, the texture coordinate scale and material.
+ ***********************************************************/
+struct RASTER_SURFACE
+{
+	glm::vec4 color;
+	// index into the scene's textures, or -1 for the color
+	int texture;
+	glm::vec2 uvScale;
+	glm::vec3 diffuseColor;
+	glm::vec3 specularColor;
+	float shininess;
+};
+
+/***********************************************************
+ *  RASTER_TEXTURE
+ *
+ *  Level 0 of a texture, as RGBA8 texels with the row for
+ *  texture coordinate v = 0 first, like OpenGL stores it.
+ ***********************************************************/
+struct RASTER_TEXTURE
+{
+	int width;
+	int height;
+	std::vector<uint32_t> texels;
+};
+
+/***********************************************************
+ *  RASTER_DRAW
+ *
+ *  One indexed draw from the shared buffers, with the bounds
+ *  its positions were quantized against, its matrices and
+ *  the surface it is shaded with.
+ ***********************************************************/
+struct RASTER_DRAW
+{
+	int baseVertex;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	MESH_BOUNDS bounds;
+	glm::mat4 model;
+	int surface;
+};
+
+/***********************************************************
+ *  RASTER_SCENE
+ *
+ *  Everything a frame is rendered from - the shared buffers,
+ *  the draws in submission order, the camera and the lights.
+ ***********************************************************/
+struct RASTER_SCENE
+{
+	// number of point lights in the fragment shader
+	static const int POINT_LIGHT_COUNT = 5;
+
+	const PACKED_VERTEX* pVertices;
+	size_t vertexCount;
+	const uint32_t* pIndices;
+	size_t indexCount;
+	std::vector<RASTER_DRAW> draws;
+	std::vector<RASTER_SURFACE> surfaces;
+	std::vector<RASTER_TEXTURE> textures;
+
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 viewPosition;
+
+	bool bUseLighting;
+	SHADER_LIGHT directionalLight;
+	SHADER_LIGHT pointLights[POINT_LIGHT_COUNT];
+	SHADER_LIGHT spotLight;
+};
+
+/***********************************************************
+ *  SoftwareRasterizer
+ *
+ *  This class contains the code for rendering a recorded
+ *  scene into a CPU frame buffer.
+ ***********************************************************/
+class SoftwareRasterizer
+{
+public:
+	// constructor - 0 threads uses every hardware thread
+	SoftwareRasterizer(unsigned int threadCount = 0);
+
+	// width and height of the screen tiles in pixels
+	static const int TILE_SIZE = 64;
+
+	// render a frame of the passed in size
+	void Render(const RASTER_SCENE& scene, int width, int height);
+
+	// RGBA8 pixels of the last frame, bottom row first
+	const unsigned char* GetPixels() const { return((const unsigned char*)m_pixels.data()); }
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+	// threads the frames are rendered with
+	unsigned int GetThreadCount() const { return(m_threadCount); }
+	// triangles that reached the bins in the last frame
+	size_t GetFrameTriangles() const;
+
+	// number of values interpolated across a triangle - the
+	// world position, normal and texture coordinate
+	static const int ATTRIBUTE_COUNT = 8;
+
+	/***********************************************************
+	 *  SETUP_TRIANGLE
+	 *
+	 *  A triangle ready to rasterize - its snapped window
+	 *  positions, edge functions, and the depth, 1/w and
+	 *  perspective divided attributes of its vertices.
+	 ***********************************************************/
+	struct SETUP_TRIANGLE
+	{
+		// window positions in pixels, counter-clockwise
+		float x[3];
+		float y[3];
+		// covered pixels lie inside these bounds, inclusive
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		// edge i runs from vertex i + 1 to vertex i + 2 and is
+		// a * (x - x[i + 1]) + b * (y - y[i + 1]), positive inside
+		float a[3];
+		float b[3];
+		// whether pixel centers exactly on the edge are covered
+		bool bInclusive[3];
+		float inverseArea;
+		// window depth, 1/w, and the attributes divided by w
+		float depth[3];
+		float inverseW[3];
+		float attributes[3][ATTRIBUTE_COUNT];
+		int surface;
+	};
+
+private:
+	/***********************************************************
+	 *  DRAW_MATRICES
+	 *
+	 *  Matrices of a draw, composed once per frame.
+	 ***********************************************************/
+	struct DRAW_MATRICES
+	{
+		glm::mat4 modelViewProjection;
+		glm::mat4 model;
+		glm::mat3 normal;
+	};
+
+	unsigned int m_threadCount;
+	int m_width;
+	int m_height;
+	int m_tilesX;
+	int m_tilesY;
+	// color and depth of the frame, with the rows padded to
+	// whole tiles so no span of a tile reaches into another
+	int m_stride;
+	std::vector<uint32_t> m_color;
+	std::vector<float> m_depth;
+	// the finished frame with unpadded rows
+	std::vector<uint32_t> m_pixels;
+	// first triangle of each draw in the frame, and its matrices
+	std::vector<size_t> m_drawStarts;
+	std::vector<DRAW_MATRICES> m_drawMatrices;
+	// per thread triangles and their indices binned by tile
+	std::vector<std::vector<SETUP_TRIANGLE>> m_triangles;
+	std::vector<std::vector<std::vector<uint32_t>>> m_bins;
+
+	// transform, clip and bin a range of the frame's triangles
+	void SetupTriangles(const RASTER_SCENE& scene, size_t begin, size_t end, size_t chunk);
+	// add one clipped triangle to a chunk's bins
+	void BinTriangle(const float (*pVertices)[4 + ATTRIBUTE_COUNT], int surface, size_t chunk);
+	// clear a tile, draw its binned triangles in order and copy
+	// it into the finished frame
+	void RasterizeTile(const RASTER_SCENE& scene, int tile);
+	// draw the part of a triangle inside a tile
+	void DrawTriangle(const RASTER_SCENE& scene, const SETUP_TRIANGLE& triangle, int tileX, int tileY);
+};
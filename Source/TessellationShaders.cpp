@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellationshaders.cpp
+// =======================
+// hardware tessellation stages for the active shader program
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TessellationShaders.h"
+
+#include <GL/glew.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// read a whole shader file into a string
+	bool ReadShaderFile(const char* filename, std::string& source)
+	{
+		std::ifstream stream(filename);
+		if (!stream)
+		{
+			std::cout << "Could not open shader file " << filename << std::endl;
+			return(false);
+		}
+
+		std::stringstream contents;
+		contents << stream.rdbuf();
+		source = contents.str();
+		return(true);
+	}
+
+	// compile one shader from source, returning 0 on failure
+	GLuint CompileShader(GLenum type, const std::string& source, const char* name)
+	{
+		const char* pSource = source.c_str();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &pSource, NULL);
+		glCompileShader(shader);
+
+		GLint success = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR::SHADER_COMPILATION_ERROR of " << name << "\n" << infoLog << std::endl;
+			glDeleteShader(shader);
+			return(0);
+		}
+
+		return(shader);
+	}
+
+	// compile one shader file, returning 0 on failure
+	GLuint CompileShaderFile(GLenum type, const char* filename)
+	{
+		std::string source;
+		if (ReadShaderFile(filename, source) == false)
+		{
+			return(0);
+		}
+		return(CompileShader(type, source, filename));
+	}
+
+	// check the link status of a program and print its log on failure
+	bool CheckLink(GLuint program)
+	{
+		GLint success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			char infoLog[1024];
+			glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+			std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+			return(false);
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  Attach()
+ *
+ *  This method is used for relinking the program in use
+ *  with the tessellation stages.  The new shaders are all
+ *  compiled before the program is touched.  The source of
+ *  the original vertex shader is kept so it can be rebuilt
+ *  if the relink fails, since the ShaderManager may already
+ *  have flagged it for deletion.
+ ***********************************************************/
+bool TessellationShaders::Attach(
+	const char* vertexShaderFile,
+	const char* controlShaderFile,
+	const char* evaluationShaderFile)
+{
+	if (!GLEW_VERSION_4_0 && !GLEW_ARB_tessellation_shader)
+	{
+		std::cout << "Hardware tessellation needs OpenGL 4.0 - using the fixed levels of detail" << std::endl;
+		return(false);
+	}
+
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	if (program == 0)
+	{
+		return(false);
+	}
+
+	GLuint vertexShader = CompileShaderFile(GL_VERTEX_SHADER, vertexShaderFile);
+	GLuint controlShader = CompileShaderFile(GL_TESS_CONTROL_SHADER, controlShaderFile);
+	GLuint evaluationShader = CompileShaderFile(GL_TESS_EVALUATION_SHADER, evaluationShaderFile);
+	if ((vertexShader == 0) || (controlShader == 0) || (evaluationShader == 0))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(controlShader);
+		glDeleteShader(evaluationShader);
+		return(false);
+	}
+
+	// find the vertex shader the program was linked with
+	GLuint attached[8];
+	GLsizei attachedCount = 0;
+	GLuint originalShader = 0;
+	glGetAttachedShaders(program, 8, &attachedCount, attached);
+	for (GLsizei i = 0; i < attachedCount; i++)
+	{
+		GLint type = 0;
+		glGetShaderiv(attached[i], GL_SHADER_TYPE, &type);
+		if (type == GL_VERTEX_SHADER)
+		{
+			originalShader = attached[i];
+		}
+	}
+
+	std::string originalSource;
+	if (originalShader != 0)
+	{
+		GLint sourceLength = 0;
+		glGetShaderiv(originalShader, GL_SHADER_SOURCE_LENGTH, &sourceLength);
+		std::vector<char> source(sourceLength + 1, '\0');
+		glGetShaderSource(originalShader, (GLsizei)source.size(), NULL, source.data());
+		originalSource = source.data();
+		glDetachShader(program, originalShader);
+	}
+
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, controlShader);
+	glAttachShader(program, evaluationShader);
+	glLinkProgram(program);
+	bool bLinked = CheckLink(program);
+
+	// the program keeps the shaders alive while they are attached
+	glDeleteShader(vertexShader);
+	glDeleteShader(controlShader);
+	glDeleteShader(evaluationShader);
+
+	if (bLinked == false)
+	{
+		glDetachShader(program, vertexShader);
+		glDetachShader(program, controlShader);
+		glDetachShader(program, evaluationShader);
+		GLuint restoredShader = CompileShader(GL_VERTEX_SHADER, originalSource, "the original vertex shader");
+		if (restoredShader != 0)
+		{
+			glAttachShader(program, restoredShader);
+			glDeleteShader(restoredShader);
+		}
+		glLinkProgram(program);
+		CheckLink(program);
+	}
+
+	// install the relinked executable
+	glUseProgram(program);
+	if (bLinked)
+	{
+		glPatchParameteri(GL_PATCH_VERTICES, 3);
+		std::cout << "INFO: hardware tessellation enabled for the curved shapes" << std::endl;
+	}
+
+	return(bLinked);
+}
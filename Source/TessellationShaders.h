@@ -0,0 +1,29 @@
+///////////////////////////////////////////////////////////////////////////////
+// tessellationshaders.h
+// =====================
+// hardware tessellation stages for the active shader program
+//
+// The ShaderManager links a vertex and fragment shader into one program and
+// sets its uniforms by that program's ID.  To keep every uniform setter
+// working, the tessellation path relinks the same program object: its vertex
+// shader is swapped for one that passes the control points through in object
+// space, and tessellation control and evaluation shaders are attached that
+// pick tessellation factors from screen-space edge length and evaluate the
+// exact parametric surface of the curved shapes.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+namespace TessellationShaders
+{
+	// relink the program currently in use with the passed in vertex,
+	// tessellation control and tessellation evaluation shader files.
+	// Returns false, leaving the program as it was, when OpenGL 4.0
+	// tessellation is not available or the shaders do not build.
+	// Uniform values are reset by the relink, so this is called before
+	// the scene sets them.
+	bool Attach(
+		const char* vertexShaderFile,
+		const char* controlShaderFile,
+		const char* evaluationShaderFile);
+}
@@ -0,0 +1,411 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ==================
+// batched composition of model matrices for objects that move at runtime
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+#include "SimdMath.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+// declaration of global variables
+namespace
+{
+	const float g_DegreesToRadians = 0.01745329251994329577f;
+	// number of floats between consecutive OBJECT_TRANSFORM records
+	const int g_TransformStride = sizeof(OBJECT_TRANSFORM) / sizeof(float);
+	// offset of the normal matrix inside an OBJECT_TRANSFORM record
+	const int g_NormalOffset = sizeof(glm::mat4) / sizeof(float);
+
+	// reciprocal scale for the normal matrix - a zero scale flattens
+	// the object along that axis, where the normal is left unscaled
+	inline float InverseScale(float scale)
+	{
+		return((scale != 0.0f) ? 1.0f / scale : 1.0f);
+	}
+
+	/***********************************************************
+	 *  ComposeScalar()
+	 *
+	 *  Compose the model and normal matrices for one object,
+	 *  using the same closed form rotZ * rotY * rotX product as
+	 *  the SIMD paths.  Used for the tail of a batch.
+	 ***********************************************************/
+	void ComposeScalar(const TRANSFORM_BATCH& batch, size_t i, OBJECT_TRANSFORM* pTransform)
+	{
+		const float x = batch.rotationX[i] * g_DegreesToRadians;
+		const float y = batch.rotationY[i] * g_DegreesToRadians;
+		const float z = batch.rotationZ[i] * g_DegreesToRadians;
+		const float sx = std::sin(x), cx = std::cos(x);
+		const float sy = std::sin(y), cy = std::cos(y);
+		const float sz = std::sin(z), cz = std::cos(z);
+		const float scaleX = batch.scaleX[i];
+		const float scaleY = batch.scaleY[i];
+		const float scaleZ = batch.scaleZ[i];
+
+		const glm::vec4 rotation0(cz * cy, sz * cy, -sy, 0.0f);
+		const glm::vec4 rotation1(cz * sy * sx - sz * cx, sz * sy * sx + cz * cx, cy * sx, 0.0f);
+		const glm::vec4 rotation2(cz * sy * cx + sz * sx, sz * sy * cx - cz * sx, cy * cx, 0.0f);
+
+		// model = rotation * scale, normal = rotation * inverse(scale)
+		glm::mat4& model = pTransform->model;
+		model[0] = rotation0 * scaleX;
+		model[1] = rotation1 * scaleY;
+		model[2] = rotation2 * scaleZ;
+		model[3] = glm::vec4(batch.positionX[i], batch.positionY[i], batch.positionZ[i], 1.0f);
+
+		glm::mat4& normal = pTransform->normal;
+		normal[0] = rotation0 * InverseScale(scaleX);
+		normal[1] = rotation1 * InverseScale(scaleY);
+		normal[2] = rotation2 * InverseScale(scaleZ);
+		normal[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+#ifdef SIMD_MATH_SSE2
+	/***********************************************************
+	 *  StoreColumns4()
+	 *
+	 *  Transpose four lanes of (x, y, z, w) column values into
+	 *  the column at the passed in float offset of four
+	 *  consecutive transform records.
+	 ***********************************************************/
+	inline void StoreColumns4(
+		__m128 x, __m128 y, __m128 z, __m128 w,
+		float* pFirst, int offset)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(pFirst + 0 * g_TransformStride + offset, x);
+		_mm_storeu_ps(pFirst + 1 * g_TransformStride + offset, y);
+		_mm_storeu_ps(pFirst + 2 * g_TransformStride + offset, z);
+		_mm_storeu_ps(pFirst + 3 * g_TransformStride + offset, w);
+	}
+
+	// reciprocal of four scale values, with zero mapped to one
+	inline __m128 InverseScale4(__m128 scale)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 isZero = _mm_cmpeq_ps(scale, _mm_setzero_ps());
+		return(_mm_div_ps(one, _mm_or_ps(_mm_and_ps(isZero, one), _mm_andnot_ps(isZero, scale))));
+	}
+
+	/***********************************************************
+	 *  ComposeSSE()
+	 *
+	 *  Compose four transform records starting at index i.
+	 ***********************************************************/
+	inline void ComposeSSE(const TRANSFORM_BATCH& batch, size_t i, float* pOut)
+	{
+		const __m128 toRadians = _mm_set1_ps(g_DegreesToRadians);
+		__m128 sx, cx, sy, cy, sz, cz;
+		SimdMath::SinCos4(_mm_mul_ps(_mm_loadu_ps(&batch.rotationX[i]), toRadians), &sx, &cx);
+		SimdMath::SinCos4(_mm_mul_ps(_mm_loadu_ps(&batch.rotationY[i]), toRadians), &sy, &cy);
+		SimdMath::SinCos4(_mm_mul_ps(_mm_loadu_ps(&batch.rotationZ[i]), toRadians), &sz, &cz);
+
+		const __m128 scaleX = _mm_loadu_ps(&batch.scaleX[i]);
+		const __m128 scaleY = _mm_loadu_ps(&batch.scaleY[i]);
+		const __m128 scaleZ = _mm_loadu_ps(&batch.scaleZ[i]);
+		const __m128 zero = _mm_setzero_ps();
+
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 szsy = _mm_mul_ps(sz, sy);
+		const __m128 czsy = _mm_mul_ps(cz, sy);
+
+		// rotation = rotZ * rotY * rotX, one register per element
+		const __m128 r00 = _mm_mul_ps(cz, cy);
+		const __m128 r10 = _mm_mul_ps(sz, cy);
+		const __m128 r20 = _mm_sub_ps(zero, sy);
+		const __m128 r01 = _mm_sub_ps(_mm_mul_ps(czsy, sx), _mm_mul_ps(sz, cx));
+		const __m128 r11 = _mm_add_ps(_mm_mul_ps(szsy, sx), _mm_mul_ps(cz, cx));
+		const __m128 r21 = _mm_mul_ps(cy, sx);
+		const __m128 r02 = _mm_add_ps(_mm_mul_ps(czsy, cx), _mm_mul_ps(sz, sx));
+		const __m128 r12 = _mm_sub_ps(_mm_mul_ps(szsy, cx), _mm_mul_ps(cz, sx));
+		const __m128 r22 = _mm_mul_ps(cy, cx);
+
+		// model columns = rotation columns * scale, then translation
+		StoreColumns4(_mm_mul_ps(r00, scaleX), _mm_mul_ps(r10, scaleX), _mm_mul_ps(r20, scaleX), zero, pOut, 0);
+		StoreColumns4(_mm_mul_ps(r01, scaleY), _mm_mul_ps(r11, scaleY), _mm_mul_ps(r21, scaleY), zero, pOut, 4);
+		StoreColumns4(_mm_mul_ps(r02, scaleZ), _mm_mul_ps(r12, scaleZ), _mm_mul_ps(r22, scaleZ), zero, pOut, 8);
+		StoreColumns4(
+			_mm_loadu_ps(&batch.positionX[i]),
+			_mm_loadu_ps(&batch.positionY[i]),
+			_mm_loadu_ps(&batch.positionZ[i]),
+			one, pOut, 12);
+
+		// normal columns = rotation columns / scale
+		const __m128 inverseX = InverseScale4(scaleX);
+		const __m128 inverseY = InverseScale4(scaleY);
+		const __m128 inverseZ = InverseScale4(scaleZ);
+		StoreColumns4(_mm_mul_ps(r00, inverseX), _mm_mul_ps(r10, inverseX), _mm_mul_ps(r20, inverseX), zero, pOut, g_NormalOffset + 0);
+		StoreColumns4(_mm_mul_ps(r01, inverseY), _mm_mul_ps(r11, inverseY), _mm_mul_ps(r21, inverseY), zero, pOut, g_NormalOffset + 4);
+		StoreColumns4(_mm_mul_ps(r02, inverseZ), _mm_mul_ps(r12, inverseZ), _mm_mul_ps(r22, inverseZ), zero, pOut, g_NormalOffset + 8);
+		StoreColumns4(zero, zero, zero, one, pOut, g_NormalOffset + 12);
+	}
+#endif
+
+#ifdef SIMD_MATH_AVX2
+	/***********************************************************
+	 *  StoreColumns8()
+	 *
+	 *  Split eight lanes into two groups of four and store the
+	 *  column into eight consecutive transform records.
+	 ***********************************************************/
+	inline void StoreColumns8(
+		__m256 x, __m256 y, __m256 z, __m256 w,
+		float* pFirst, int offset)
+	{
+		StoreColumns4(
+			_mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+			_mm256_castps256_ps128(z), _mm256_castps256_ps128(w),
+			pFirst, offset);
+		StoreColumns4(
+			_mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1),
+			_mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1),
+			pFirst + 4 * g_TransformStride, offset);
+	}
+
+	// reciprocal of eight scale values, with zero mapped to one
+	inline __m256 InverseScale8(__m256 scale)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 isZero = _mm256_cmp_ps(scale, _mm256_setzero_ps(), _CMP_EQ_OQ);
+		return(_mm256_div_ps(one, _mm256_blendv_ps(scale, one, isZero)));
+	}
+
+	/***********************************************************
+	 *  ComposeAVX2()
+	 *
+	 *  Compose eight transform records starting at index i.
+	 ***********************************************************/
+	inline void ComposeAVX2(const TRANSFORM_BATCH& batch, size_t i, float* pOut)
+	{
+		const __m256 toRadians = _mm256_set1_ps(g_DegreesToRadians);
+		__m256 sx, cx, sy, cy, sz, cz;
+		SimdMath::SinCos8(_mm256_mul_ps(_mm256_loadu_ps(&batch.rotationX[i]), toRadians), &sx, &cx);
+		SimdMath::SinCos8(_mm256_mul_ps(_mm256_loadu_ps(&batch.rotationY[i]), toRadians), &sy, &cy);
+		SimdMath::SinCos8(_mm256_mul_ps(_mm256_loadu_ps(&batch.rotationZ[i]), toRadians), &sz, &cz);
+
+		const __m256 scaleX = _mm256_loadu_ps(&batch.scaleX[i]);
+		const __m256 scaleY = _mm256_loadu_ps(&batch.scaleY[i]);
+		const __m256 scaleZ = _mm256_loadu_ps(&batch.scaleZ[i]);
+		const __m256 zero = _mm256_setzero_ps();
+
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 szsy = _mm256_mul_ps(sz, sy);
+		const __m256 czsy = _mm256_mul_ps(cz, sy);
+
+		const __m256 r00 = _mm256_mul_ps(cz, cy);
+		const __m256 r10 = _mm256_mul_ps(sz, cy);
+		const __m256 r20 = _mm256_sub_ps(zero, sy);
+		const __m256 r01 = _mm256_fmsub_ps(czsy, sx, _mm256_mul_ps(sz, cx));
+		const __m256 r11 = _mm256_fmadd_ps(szsy, sx, _mm256_mul_ps(cz, cx));
+		const __m256 r21 = _mm256_mul_ps(cy, sx);
+		const __m256 r02 = _mm256_fmadd_ps(czsy, cx, _mm256_mul_ps(sz, sx));
+		const __m256 r12 = _mm256_fmsub_ps(szsy, cx, _mm256_mul_ps(cz, sx));
+		const __m256 r22 = _mm256_mul_ps(cy, cx);
+
+		StoreColumns8(_mm256_mul_ps(r00, scaleX), _mm256_mul_ps(r10, scaleX), _mm256_mul_ps(r20, scaleX), zero, pOut, 0);
+		StoreColumns8(_mm256_mul_ps(r01, scaleY), _mm256_mul_ps(r11, scaleY), _mm256_mul_ps(r21, scaleY), zero, pOut, 4);
+		StoreColumns8(_mm256_mul_ps(r02, scaleZ), _mm256_mul_ps(r12, scaleZ), _mm256_mul_ps(r22, scaleZ), zero, pOut, 8);
+		StoreColumns8(
+			_mm256_loadu_ps(&batch.positionX[i]),
+			_mm256_loadu_ps(&batch.positionY[i]),
+			_mm256_loadu_ps(&batch.positionZ[i]),
+			one, pOut, 12);
+
+		const __m256 inverseX = InverseScale8(scaleX);
+		const __m256 inverseY = InverseScale8(scaleY);
+		const __m256 inverseZ = InverseScale8(scaleZ);
+		StoreColumns8(_mm256_mul_ps(r00, inverseX), _mm256_mul_ps(r10, inverseX), _mm256_mul_ps(r20, inverseX), zero, pOut, g_NormalOffset + 0);
+		StoreColumns8(_mm256_mul_ps(r01, inverseY), _mm256_mul_ps(r11, inverseY), _mm256_mul_ps(r21, inverseY), zero, pOut, g_NormalOffset + 4);
+		StoreColumns8(_mm256_mul_ps(r02, inverseZ), _mm256_mul_ps(r12, inverseZ), _mm256_mul_ps(r22, inverseZ), zero, pOut, g_NormalOffset + 8);
+		StoreColumns8(zero, zero, zero, one, pOut, g_NormalOffset + 12);
+	}
+#endif
+
+	/***********************************************************
+	 *  ComposePerObject()
+	 *
+	 *  The original per-object path from SetTransformations(),
+	 *  plus a general inverse-transpose for the normal matrix,
+	 *  kept here as the benchmark baseline.
+	 ***********************************************************/
+	void ComposePerObject(const TRANSFORM_BATCH& batch, OBJECT_TRANSFORM* pTransforms)
+	{
+		for (size_t i = 0; i < batch.Size(); i++)
+		{
+			glm::mat4 scale = glm::scale(glm::vec3(batch.scaleX[i], batch.scaleY[i], batch.scaleZ[i]));
+			glm::mat4 rotationX = glm::rotate(glm::radians(batch.rotationX[i]), glm::vec3(1.0f, 0.0f, 0.0f));
+			glm::mat4 rotationY = glm::rotate(glm::radians(batch.rotationY[i]), glm::vec3(0.0f, 1.0f, 0.0f));
+			glm::mat4 rotationZ = glm::rotate(glm::radians(batch.rotationZ[i]), glm::vec3(0.0f, 0.0f, 1.0f));
+			glm::mat4 translation = glm::translate(glm::vec3(batch.positionX[i], batch.positionY[i], batch.positionZ[i]));
+
+			pTransforms[i].model = translation * rotationZ * rotationY * rotationX * scale;
+			pTransforms[i].normal = glm::mat4(glm::transpose(glm::inverse(glm::mat3(pTransforms[i].model))));
+		}
+	}
+}
+
+/***********************************************************
+ *  TRANSFORM_BATCH::Resize()
+ *
+ *  Resize every array in the batch to the passed in count.
+ ***********************************************************/
+void TRANSFORM_BATCH::Resize(size_t count)
+{
+	scaleX.resize(count, 1.0f);
+	scaleY.resize(count, 1.0f);
+	scaleZ.resize(count, 1.0f);
+	rotationX.resize(count, 0.0f);
+	rotationY.resize(count, 0.0f);
+	rotationZ.resize(count, 0.0f);
+	positionX.resize(count, 0.0f);
+	positionY.resize(count, 0.0f);
+	positionZ.resize(count, 0.0f);
+}
+
+/***********************************************************
+ *  TRANSFORM_BATCH::Set()
+ *
+ *  Store the transform values for the object at index.
+ ***********************************************************/
+void TRANSFORM_BATCH::Set(
+	size_t index,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	scaleX[index] = scaleXYZ.x;
+	scaleY[index] = scaleXYZ.y;
+	scaleZ[index] = scaleXYZ.z;
+	rotationX[index] = XrotationDegrees;
+	rotationY[index] = YrotationDegrees;
+	rotationZ[index] = ZrotationDegrees;
+	positionX[index] = positionXYZ.x;
+	positionY[index] = positionXYZ.y;
+	positionZ[index] = positionXYZ.z;
+}
+
+/***********************************************************
+ *  ComposeTransformBatch()
+ *
+ *  Compose the model matrices for a range of the batch, using
+ *  the widest SIMD path available and finishing the tail one
+ *  object at a time.
+ ***********************************************************/
+void ComposeTransformBatch(
+	const TRANSFORM_BATCH& batch,
+	size_t first,
+	size_t count,
+	OBJECT_TRANSFORM* pTransforms)
+{
+	size_t i = first;
+	const size_t end = first + count;
+	float* pOut = &pTransforms[0].model[0][0];
+
+#ifdef SIMD_MATH_AVX2
+	for (; i + 8 <= end; i += 8)
+	{
+		ComposeAVX2(batch, i, pOut + (i - first) * g_TransformStride);
+	}
+#endif
+#ifdef SIMD_MATH_SSE2
+	for (; i + 4 <= end; i += 4)
+	{
+		ComposeSSE(batch, i, pOut + (i - first) * g_TransformStride);
+	}
+#endif
+	for (; i < end; i++)
+	{
+		ComposeScalar(batch, i, &pTransforms[i - first]);
+	}
+}
+
+/***********************************************************
+ *  RunTransformBenchmark()
+ *
+ *  Time the batched kernel against the per-object glm path
+ *  on random transforms, and report the largest difference
+ *  between the two results.
+ ***********************************************************/
+void RunTransformBenchmark()
+{
+	const size_t objectCounts[] = { 1000, 100000, 1000000 };
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> angle(-360.0f, 360.0f);
+	std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> scale(0.1f, 10.0f);
+
+#if defined(SIMD_MATH_AVX2)
+	std::cout << "INFO: Transform benchmark using the AVX2 kernel\n";
+#elif defined(SIMD_MATH_SSE2)
+	std::cout << "INFO: Transform benchmark using the SSE2 kernel\n";
+#else
+	std::cout << "INFO: Transform benchmark using the scalar kernel\n";
+#endif
+
+	for (size_t objectCount : objectCounts)
+	{
+		TRANSFORM_BATCH batch;
+		batch.Resize(objectCount);
+		for (size_t i = 0; i < objectCount; i++)
+		{
+			batch.Set(i,
+				glm::vec3(scale(random), scale(random), scale(random)),
+				angle(random), angle(random), angle(random),
+				glm::vec3(position(random), position(random), position(random)));
+		}
+
+		std::vector<OBJECT_TRANSFORM> perObject(objectCount);
+		std::vector<OBJECT_TRANSFORM> batched(objectCount);
+
+		// repeat small batches so each measurement covers enough work
+		const int repetitions = (int)std::max<size_t>(1, 4000000 / objectCount);
+		double bestPerObject = 1e30;
+		double bestBatched = 1e30;
+		for (int trial = 0; trial < 3; trial++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int r = 0; r < repetitions; r++)
+			{
+				ComposePerObject(batch, perObject.data());
+			}
+			auto middle = std::chrono::high_resolution_clock::now();
+			for (int r = 0; r < repetitions; r++)
+			{
+				ComposeTransformBatch(batch, 0, objectCount, batched.data());
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+
+			bestPerObject = std::min(bestPerObject, std::chrono::duration<double, std::milli>(middle - start).count() / repetitions);
+			bestBatched = std::min(bestBatched, std::chrono::duration<double, std::milli>(end - middle).count() / repetitions);
+		}
+
+		// compare both paths element by element
+		float maxError = 0.0f;
+		for (size_t i = 0; i < objectCount; i++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					maxError = std::max(maxError, std::fabs(perObject[i].model[column][row] - batched[i].model[column][row]));
+					maxError = std::max(maxError, std::fabs(perObject[i].normal[column][row] - batched[i].normal[column][row]));
+				}
+			}
+		}
+
+		std::cout << "INFO: " << objectCount << " objects: per-object " << bestPerObject
+			<< " ms, batched " << bestBatched << " ms, speedup " << bestPerObject / bestBatched
+			<< "x, max abs difference " << maxError << std::endl;
+	}
+}
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ================
+// batched composition of model matrices for objects that move at runtime
+//
+// Objects are stored structure-of-arrays so the kernel can load four (SSE2)
+// or eight (AVX2) objects per register, evaluate the rotations with a
+// vectorized sine/cosine, and write finished column-major mat4s directly
+// into the destination, which may be a mapped instance buffer.  The normal
+// matrix of each object is written right after its model matrix, so one
+// contiguous record holds everything the vertex shader needs per draw.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  OBJECT_TRANSFORM
+ *
+ *  Per-draw transform record.  The normal matrix is the
+ *  inverse-transpose of the upper 3x3 of the model matrix,
+ *  stored as a mat4 so the record can be copied as-is into
+ *  a uniform or std140 buffer.
+ ***********************************************************/
+struct OBJECT_TRANSFORM
+{
+	glm::mat4 model;
+	glm::mat4 normal;
+};
+
+/***********************************************************
+ *  TRANSFORM_BATCH
+ *
+ *  Structure-of-arrays storage of the same scale, rotation
+ *  (in degrees) and position values that are passed to
+ *  SceneManager::SetTransformations().
+ ***********************************************************/
+struct TRANSFORM_BATCH
+{
+	std::vector<float> scaleX;
+	std::vector<float> scaleY;
+	std::vector<float> scaleZ;
+	std::vector<float> rotationX;
+	std::vector<float> rotationY;
+	std::vector<float> rotationZ;
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+
+	// number of objects held in the batch
+	size_t Size() const { return(positionX.size()); }
+	// resize every array to hold the passed in number of objects
+	void Resize(size_t count);
+	// store the transform values for one object
+	void Set(
+		size_t index,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+};
+
+// compose translation * rotZ * rotY * rotX * scale for the objects in
+// [first, first + count) and write the packed model and normal matrices
+void ComposeTransformBatch(
+	const TRANSFORM_BATCH& batch,
+	size_t first,
+	size_t count,
+	OBJECT_TRANSFORM* pTransforms);
+
+// time the batched kernel against the per-object glm composition at
+// 1k, 100k and 1M objects and print the results
+void RunTransformBenchmark();
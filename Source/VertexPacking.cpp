@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexpacking.cpp
+// =================
+// quantized 16 byte vertex format for the shared mesh buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// quantize a value in the 0..1 range to unsigned normalized 16 bits
+	uint16_t QuantizeUnorm16(float value)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+		return((uint16_t)std::lround(value * 65535.0f));
+	}
+
+	// quantize a value in the -1..1 range to signed normalized 16 bits
+	int16_t QuantizeSnorm16(float value)
+	{
+		value = std::min(std::max(value, -1.0f), 1.0f);
+		return((int16_t)std::lround(value * 32767.0f));
+	}
+}
+
+/***********************************************************
+ *  ComputeBounds()
+ *
+ *  This method is used for finding the bounding box of the
+ *  passed in vertices.
+ ***********************************************************/
+MESH_BOUNDS VertexPacking::ComputeBounds(const std::vector<MESH_VERTEX>& vertices)
+{
+	MESH_BOUNDS bounds;
+	bounds.minimum = glm::vec3(0.0f);
+	bounds.extent = glm::vec3(0.0f);
+
+	if (vertices.empty())
+	{
+		return(bounds);
+	}
+
+	glm::vec3 minimum = vertices[0].position;
+	glm::vec3 maximum = vertices[0].position;
+	for (const MESH_VERTEX& vertex : vertices)
+	{
+		minimum = glm::min(minimum, vertex.position);
+		maximum = glm::max(maximum, vertex.position);
+	}
+	bounds.minimum = minimum;
+	bounds.extent = maximum - minimum;
+
+	return(bounds);
+}
+
+/***********************************************************
+ *  EncodeOctahedral()
+ *
+ *  This method is used for projecting a unit normal onto the
+ *  octahedron |x| + |y| + |z| = 1 and unfolding the lower
+ *  half over the upper half, so two values describe it.
+ ***********************************************************/
+glm::vec2 VertexPacking::EncodeOctahedral(glm::vec3 normal)
+{
+	const float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (length <= 0.0f)
+	{
+		return(glm::vec2(0.0f, 0.0f));
+	}
+
+	glm::vec2 encoded(normal.x / length, normal.y / length);
+	if (normal.z < 0.0f)
+	{
+		const float x = (1.0f - std::fabs(encoded.y)) * ((encoded.x >= 0.0f) ? 1.0f : -1.0f);
+		const float y = (1.0f - std::fabs(encoded.x)) * ((encoded.y >= 0.0f) ? 1.0f : -1.0f);
+		encoded = glm::vec2(x, y);
+	}
+
+	return(encoded);
+}
+
+/***********************************************************
+ *  PackVertices()
+ *
+ *  This method is used for quantizing full float vertices
+ *  into the packed format.  An axis where the mesh is flat
+ *  has no extent and every position packs to its minimum.
+ ***********************************************************/
+void VertexPacking::PackVertices(
+	const std::vector<MESH_VERTEX>& vertices,
+	const MESH_BOUNDS& bounds,
+	std::vector<PACKED_VERTEX>& packedVertices)
+{
+	packedVertices.reserve(packedVertices.size() + vertices.size());
+
+	for (const MESH_VERTEX& vertex : vertices)
+	{
+		PACKED_VERTEX packed;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float extent = bounds.extent[axis];
+			const float offset = vertex.position[axis] - bounds.minimum[axis];
+			packed.position[axis] = QuantizeUnorm16((extent > 0.0f) ? (offset / extent) : 0.0f);
+		}
+		packed.position[3] = 65535;
+
+		const glm::vec2 normal = EncodeOctahedral(vertex.normal);
+		packed.normal[0] = QuantizeSnorm16(normal.x);
+		packed.normal[1] = QuantizeSnorm16(normal.y);
+
+		packed.textureCoordinate[0] = QuantizeUnorm16(vertex.textureCoordinate.x);
+		packed.textureCoordinate[1] = QuantizeUnorm16(vertex.textureCoordinate.y);
+
+		packedVertices.push_back(packed);
+	}
+}
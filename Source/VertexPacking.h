@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexpacking.h
+// ===============
+// quantized 16 byte vertex format for the shared mesh buffer
+//
+// Positions are stored as unsigned normalized 16-bit values relative to the
+// bounding box of their mesh, which the vertex shader receives through the
+// meshBoundsMin and meshBoundsExtent uniforms.  Normals are folded onto an
+// octahedron and stored as two signed normalized 16-bit values, and texture
+// coordinates in the 0..1 range are stored as unsigned normalized 16-bit
+// values.  The layout is half the size of the full float vertex.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveMeshes.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  PACKED_VERTEX
+ *
+ *  Quantized vertex as stored in the shared mesh buffer.
+ *  The fourth position value is always 65535 so the shader
+ *  can read the position as a vec4 with w = 1.
+ ***********************************************************/
+struct PACKED_VERTEX
+{
+	uint16_t position[4];
+	int16_t normal[2];
+	uint16_t textureCoordinate[2];
+};
+
+/***********************************************************
+ *  MESH_BOUNDS
+ *
+ *  Axis aligned box the positions of a mesh are quantized
+ *  against.
+ ***********************************************************/
+struct MESH_BOUNDS
+{
+	glm::vec3 minimum;
+	glm::vec3 extent;
+};
+
+namespace VertexPacking
+{
+	// bounding box of the passed in vertices
+	MESH_BOUNDS ComputeBounds(const std::vector<MESH_VERTEX>& vertices);
+
+	// quantize the passed in vertices against the mesh bounds and
+	// append them to the packed vertex list
+	void PackVertices(
+		const std::vector<MESH_VERTEX>& vertices,
+		const MESH_BOUNDS& bounds,
+		std::vector<PACKED_VERTEX>& packedVertices);
+
+	// fold a unit normal onto the octahedron and return the two
+	// coordinates in the -1..1 range
+	glm::vec2 EncodeOctahedral(glm::vec3 normal);
+}
@@ -21,6 +21,8 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
+	// half the height of the scene the orthographic view shows
+	const float ORTHOGRAPHIC_HALF_HEIGHT = 10.0f;
 	const char* g_ViewName = "view";
 	const char* g_ProjectionName = "projection";
 
@@ -53,6 +55,10 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_width = WINDOW_WIDTH;
+	m_height = WINDOW_HEIGHT;
+	m_view = glm::mat4(1.0f);
+	m_projection = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -101,6 +107,9 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 		return NULL;
 	}
 	glfwMakeContextCurrent(window);
+	// the frames fill the window's framebuffer, which is larger
+	// than the window on high density displays
+	glfwGetFramebufferSize(window, &m_width, &m_height);
 
 	// tell GLFW to capture all mouse events
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -111,15 +120,55 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// this callback is used to recieve mouse wheel scrolling events (Matthew Minton 1/28/2025)
 	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Wheel_Callback);
 
-	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
 	m_pWindow = window;
 
 	return(window);
 }
 
+/***********************************************************
+ *  CreateOffscreenView()
+ *
+ *  This method is used to set up the view for frames that
+ *  are rendered offscreen.  There is no window, so the
+ *  camera stays where it starts and no input is read.
+ ***********************************************************/
+void ViewManager::CreateOffscreenView(int width, int height)
+{
+	m_pWindow = NULL;
+	m_width = width;
+	m_height = height;
+}
+
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used to place the camera and choose the
+ *  projection directly, as a batch render does for each
+ *  image, instead of through keyboard and mouse input.
+ ***********************************************************/
+void ViewManager::SetCameraPose(const CAMERA_POSE& pose)
+{
+	g_pCamera->Position = pose.position;
+	g_pCamera->Front = pose.front;
+	g_pCamera->Up = pose.up;
+	g_pCamera->Zoom = pose.zoom;
+	bOrthographicProjection = pose.bOrthographic;
+}
+
+/***********************************************************
+ *  SetViewport()
+ *
+ *  This method is used to change the size of the frames
+ *  drawn into an offscreen framebuffer, which stays at its
+ *  full size, so the projection keeps the right aspect.
+ ***********************************************************/
+void ViewManager::SetViewport(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	glViewport(0, 0, width, height);
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
@@ -243,20 +292,39 @@ void ViewManager::PrepareSceneView()
 	glm::mat4 view;
 	glm::mat4 projection;
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
-
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
+	// offscreen frames have no window to time or take input from
+	if (NULL != m_pWindow)
+	{
+		// per-frame timing
+		float currentFrame = glfwGetTime();
+		gDeltaTime = currentFrame - gLastFrame;
+		gLastFrame = currentFrame;
+
+		// process any keyboard events that may be waiting in the 
+		// event queue
+		ProcessKeyboardEvents();
+	}
 
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
 
 	// define the current projection matrix
-	projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+	const GLfloat aspectRatio = (GLfloat)m_width / (GLfloat)m_height;
+	if (bOrthographicProjection == true)
+	{
+		projection = glm::ortho(
+			-ORTHOGRAPHIC_HALF_HEIGHT * aspectRatio, ORTHOGRAPHIC_HALF_HEIGHT * aspectRatio,
+			-ORTHOGRAPHIC_HALF_HEIGHT, ORTHOGRAPHIC_HALF_HEIGHT,
+			0.1f, 100.0f);
+	}
+	else
+	{
+		projection = glm::perspective(glm::radians(g_pCamera->Zoom), aspectRatio, 0.1f, 100.0f);
+	}
+
+	// keep the matrices for the rest of the frame
+	m_view = view;
+	m_projection = projection;
 
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
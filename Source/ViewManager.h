@@ -15,6 +15,21 @@
 // GLFW library
 #include "GLFW/glfw3.h" 
 
+/***********************************************************
+ *  CAMERA_POSE
+ *
+ *  A camera placement to render the scene from, as given
+ *  in a batch render's camera list.
+ ***********************************************************/
+struct CAMERA_POSE
+{
+	glm::vec3 position;
+	glm::vec3 front;
+	glm::vec3 up;
+	float zoom;
+	bool bOrthographic;
+};
+
 class ViewManager
 {
 public:
@@ -33,8 +48,14 @@ public:
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
-	// active OpenGL display window
+	// active OpenGL display window, or NULL when headless
 	GLFWwindow* m_pWindow;
+	// size of the rendered frames
+	int m_width;
+	int m_height;
+	// view and projection matrices of the current frame
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
@@ -42,7 +63,22 @@ private:
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// set up the view for offscreen frames of the passed in size,
+	// with no window or input
+	void CreateOffscreenView(int width, int height);
+	// place the camera and choose the projection for the next frames
+	void SetCameraPose(const CAMERA_POSE& pose);
+	// render the next frames into the lower left width x height
+	// corner of the framebuffer
+	void SetViewport(int width, int height);
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// view and projection matrices set by the last PrepareSceneView()
+	const glm::mat4& GetViewMatrix() const { return(m_view); }
+	const glm::mat4& GetProjectionMatrix() const { return(m_projection); }
+	// size of the frames being drawn
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
 };
\ No newline at end of file
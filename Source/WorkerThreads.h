@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// workerthreads.h
+// ===============
+// splitting of CPU loops across short lived worker threads
+//
+// The loaders and generators split large loops into one even slice per
+// hardware thread.  The calling thread runs the last slice itself and then
+// waits for the others, so a loop with a single slice never starts a thread.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace WorkerThreads
+{
+	// loops shorter than this run on the calling thread only
+	const size_t MIN_PARALLEL_ITEMS = 1 << 14;
+
+	// the passed in thread count, or every hardware thread for 0
+	inline unsigned int ResolveThreadCount(unsigned int threadCount)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		return(threadCount);
+	}
+
+	/***********************************************************
+	 *  ParallelFor()
+	 *
+	 *  Call function(begin, end) over even slices of the range
+	 *  [0, count), one slice per thread, unless the range is
+	 *  shorter than minimumItems.
+	 ***********************************************************/
+	template <typename FUNCTION>
+	void ParallelFor(size_t count, unsigned int threadCount, size_t minimumItems, FUNCTION function)
+	{
+		threadCount = std::min(ResolveThreadCount(threadCount), (unsigned int)std::max<size_t>(count, 1));
+		if ((threadCount <= 1) || (count < minimumItems))
+		{
+			function((size_t)0, count);
+			return;
+		}
+
+		std::vector<std::thread> threads;
+		for (unsigned int i = 0; i + 1 < threadCount; i++)
+		{
+			const size_t begin = (count * i) / threadCount;
+			const size_t end = (count * (i + 1)) / threadCount;
+			threads.emplace_back(function, begin, end);
+		}
+		function((count * (threadCount - 1)) / threadCount, count);
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	// ParallelFor() over a range of small items
+	template <typename FUNCTION>
+	void ParallelFor(size_t count, unsigned int threadCount, FUNCTION function)
+	{
+		ParallelFor(count, threadCount, MIN_PARALLEL_ITEMS, function);
+	}
+}
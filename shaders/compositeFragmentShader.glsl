@@ -0,0 +1,21 @@
+#version 330 core
+// lays the weighted transparent surfaces over the opaque scene - the
+// accumulated weighted colors divided by their weights give the average
+// color of the surfaces, which covers all but the revealed part of the
+// opaque color behind them
+out vec4 fragmentColor;
+
+uniform sampler2D opaqueColor;
+uniform sampler2D accumulation;
+uniform sampler2D revealage;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 opaque = texelFetch(opaqueColor, texel, 0).rgb;
+    vec4 accumulated = texelFetch(accumulation, texel, 0);
+    float revealed = texelFetch(revealage, texel, 0).r;
+
+    vec3 average = accumulated.rgb / max(accumulated.a, 1e-5);
+    fragmentColor = vec4(mix(average, opaque, revealed), 1.0);
+}
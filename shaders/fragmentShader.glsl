@@ -1,9 +1,17 @@
 #version 330 core
-out vec4 fragmentColor;
+layout (location = 0) out vec4 fragmentColor;
+// what a transparent surface leaves visible behind it, written only
+// while drawing the weighted transparency pass
+layout (location = 1) out float fragmentRevealage;
 
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+#ifdef IMPOSTORS
+// object space proxy position and ray origin of an impostor draw
+in vec3 impostorPosition;
+in vec3 impostorRayOrigin;
+#endif
 
 struct Material {
     vec3 diffuseColor;
@@ -60,6 +68,45 @@ uniform SpotLight spotLight;
 uniform Material material;
 uniform sampler2D objectTexture;
 uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// write the weighted color and revealage of a transparent surface for
+// weighted blended order independent transparency
+uniform bool bWeightedBlend = false;
+
+#ifdef IMPOSTORS
+// impostor types, matching the values set by SceneMeshes - 0 shades the
+// rasterized mesh, any other value ray-casts that exact shape inside the
+// proxy box drawn for it.  Only the impostor program, built with IMPOSTORS
+// defined and used for the proxy box draws alone, has them, as the depth
+// they write turns off early depth testing for every draw of a program
+const int IMPOSTOR_NONE = 0;
+const int IMPOSTOR_CYLINDER = 1;
+const int IMPOSTOR_CONE = 2;
+const int IMPOSTOR_SPHERE = 3;
+const int IMPOSTOR_HALF_SPHERE = 4;
+const int IMPOSTOR_TORUS = 5;
+const int IMPOSTOR_HALF_TORUS = 6;
+// cylinder parts to intersect - 1 top, 2 bottom, 4 sides
+const int IMPOSTOR_PART_TOP = 1;
+const int IMPOSTOR_PART_BOTTOM = 2;
+const int IMPOSTOR_PART_SIDES = 4;
+
+uniform int impostorType = 0;
+uniform int impostorParts = 7;
+#endif
+uniform mat4 model;
+uniform mat4 normalMatrix;
+uniform mat4 view;
+uniform mat4 projection;
+#ifdef IMPOSTORS
+// the proxy box of an impostor, in object space
+uniform vec3 meshBoundsMin;
+uniform vec3 meshBoundsExtent;
+// tube radius of the torus relative to its main radius of 1, set from
+// the radius the torus mesh is generated with
+uniform float torusTubeRadius;
+
+const float PI = 3.14159265358979;
+#endif
 
 // the scaled texture coordinate to use in calculations
 vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
@@ -68,15 +115,38 @@ vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
 vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+#ifdef IMPOSTORS
+bool RayCastImpostor(out vec3 position, out vec3 normal, out vec2 uv);
+#endif
 
 void main()
 {   
+    // the surface being shaded - the rasterized mesh, or the exact shape
+    // an impostor ray hits, whose depth replaces the proxy box depth
+    vec3 surfacePosition = fragmentPosition;
+    vec3 surfaceNormal = fragmentVertexNormal;
+#ifdef IMPOSTORS
+    if(impostorType == IMPOSTOR_NONE)
+    {
+        gl_FragDepth = gl_FragCoord.z;
+    }
+    else
+    {
+        vec2 surfaceUV;
+        if(RayCastImpostor(surfacePosition, surfaceNormal, surfaceUV) == false)
+        {
+            discard;
+        }
+        fragmentTextureCoordinateScaled = surfaceUV * UVscale;
+    }
+#endif
+
     if(bUseLighting == true)
     {
         vec3 phongResult = vec3(0.0f);
         // properties
-        vec3 norm = normalize(fragmentVertexNormal);
-        vec3 viewDir = normalize(viewPosition - fragmentPosition);
+        vec3 norm = normalize(surfaceNormal);
+        vec3 viewDir = normalize(viewPosition - surfacePosition);
     
         // == =====================================================
         // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
@@ -94,13 +164,13 @@ void main()
         {
 	    if(pointLights[i].bActive == true)
             {
-                phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
+                phongResult += CalcPointLight(pointLights[i], norm, surfacePosition, viewDir);   
             }
         } 
         // phase 3: spot light
         if(spotLight.bActive == true)
         {
-            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
+            phongResult += CalcSpotLight(spotLight, norm, surfacePosition, viewDir);    
         }
     
         if(bUseTexture == true)
@@ -123,6 +193,17 @@ void main()
             fragmentColor = objectColor;
         }
     }
+
+    if(bWeightedBlend == true)
+    {
+        // nearer and more opaque surfaces weigh more, so the weighted
+        // average of the surfaces comes close to blending them in order
+        float alpha = fragmentColor.a;
+        float viewDepth = length(viewPosition - surfacePosition);
+        float weight = clamp(10.0 / (1e-5 + pow(viewDepth / 5.0, 2.0) + pow(viewDepth / 200.0, 6.0)), 1e-2, 3e3);
+        fragmentColor = vec4(fragmentColor.rgb * alpha, alpha) * weight;
+        fragmentRevealage = alpha;
+    }
 }
 
 // calculates the color when using a directional light.
@@ -226,3 +307,234 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
 }
+
+#ifdef IMPOSTORS
+// angle of a point around an axis as a 0..1 texture coordinate, matching
+// the way the shapes are generated
+float AngleToU(float y, float x)
+{
+    return fract(atan(y, x) / (2.0 * PI) + 1.0);
+}
+
+// both roots of a*t*t + b*t + c, nearest first
+bool SolveQuadratic(float a, float b, float c, out float t0, out float t1)
+{
+    t0 = -1.0;
+    t1 = -1.0;
+    if(abs(a) < 1e-7)
+    {
+        // the ray runs parallel to the surface - one root at most
+        if(abs(b) < 1e-7)
+        {
+            return false;
+        }
+        t0 = -c / b;
+        t1 = t0;
+        return true;
+    }
+    float discriminant = (b * b) - (4.0 * a * c);
+    if(discriminant < 0.0)
+    {
+        return false;
+    }
+    float root = sqrt(discriminant);
+    float q = (b < 0.0) ? (-0.5 * (b - root)) : (-0.5 * (b + root));
+    t0 = q / a;
+    t1 = (abs(q) > 1e-7) ? (c / q) : t0;
+    if(t0 > t1)
+    {
+        float swap = t0;
+        t0 = t1;
+        t1 = swap;
+    }
+    return true;
+}
+
+// keep a hit if it lies in front of the ray origin and is the nearest so far
+void KeepHit(float t, vec3 normal, vec2 uv, inout float hitT, inout vec3 hitNormal, inout vec2 hitUV)
+{
+    if((t > 0.0) && (t < hitT))
+    {
+        hitT = t;
+        hitNormal = normal;
+        hitUV = uv;
+    }
+}
+
+// flat disc of radius 1 at height y, facing up or down
+void IntersectDisc(vec3 origin, vec3 direction, float y, float normalY, inout float hitT, inout vec3 hitNormal, inout vec2 hitUV)
+{
+    if(abs(direction.y) < 1e-7)
+    {
+        return;
+    }
+    float t = (y - origin.y) / direction.y;
+    vec3 p = origin + (t * direction);
+    if(dot(p.xz, p.xz) <= 1.0)
+    {
+        KeepHit(t, vec3(0.0, normalY, 0.0), vec2((p.x * 0.5) + 0.5, 0.5 - (p.z * 0.5)), hitT, hitNormal, hitUV);
+    }
+}
+
+// unsigned distance to the torus surface, or to only its upper half
+float TorusDistance(vec3 p, bool bHalf)
+{
+    if(bHalf && (p.y < 0.0))
+    {
+        // nearest point is on one of the two open end circles
+        float right = length(vec2(length(vec2(p.x - 1.0, p.z)) - torusTubeRadius, p.y));
+        float left = length(vec2(length(vec2(p.x + 1.0, p.z)) - torusTubeRadius, p.y));
+        return min(right, left);
+    }
+    return abs(length(vec2(length(p.xy) - 1.0, p.z)) - torusTubeRadius);
+}
+
+// the quartic torus is sphere traced through the proxy box instead of
+// solved in closed form, which also handles the open half torus
+void IntersectTorus(vec3 origin, vec3 direction, bool bHalf, inout float hitT, inout vec3 hitNormal, inout vec2 hitUV)
+{
+    // the part of the ray inside the proxy box
+    vec3 inverseDirection = 1.0 / direction;
+    vec3 slabA = (meshBoundsMin - origin) * inverseDirection;
+    vec3 slabB = (meshBoundsMin + meshBoundsExtent - origin) * inverseDirection;
+    vec3 slabNear = min(slabA, slabB);
+    vec3 slabFar = max(slabA, slabB);
+    float t = max(max(max(slabNear.x, slabNear.y), slabNear.z), 0.0);
+    float tExit = min(min(slabFar.x, slabFar.y), slabFar.z);
+
+    // march in object space units along the normalized ray
+    float directionLength = length(direction);
+    vec3 unitDirection = direction / directionLength;
+    float distanceAlong = t * directionLength;
+    float distanceExit = tExit * directionLength;
+    for(int i = 0; i < 96; i++)
+    {
+        if(distanceAlong > distanceExit)
+        {
+            return;
+        }
+        vec3 p = origin + (distanceAlong * unitDirection);
+        float d = TorusDistance(p, bHalf);
+        if(d < 0.0005)
+        {
+            vec3 ringDirection = vec3(normalize(p.xy), 0.0);
+            vec3 normal = normalize(p - ringDirection);
+            vec2 uv = vec2(AngleToU(p.y, p.x), AngleToU(normal.z, dot(normal, ringDirection)));
+            KeepHit(distanceAlong / directionLength, normal, uv, hitT, hitNormal, hitUV);
+            return;
+        }
+        distanceAlong += d;
+    }
+}
+
+// intersect the view ray through this fragment with the exact shape of
+// the impostor in object space, returning the world space hit point and
+// normal and the texture coordinate the generated mesh has there, and
+// writing the depth of the hit
+bool RayCastImpostor(out vec3 position, out vec3 normal, out vec2 uv)
+{
+    vec3 origin = impostorRayOrigin;
+    vec3 direction = impostorPosition - impostorRayOrigin;
+
+    float hitT = 1e30;
+    vec3 hitNormal = vec3(0.0, 1.0, 0.0);
+    vec2 hitUV = vec2(0.0);
+    float t0;
+    float t1;
+
+    if(impostorType == IMPOSTOR_CYLINDER)
+    {
+        if((impostorParts & IMPOSTOR_PART_SIDES) != 0)
+        {
+            float a = dot(direction.xz, direction.xz);
+            float b = 2.0 * dot(origin.xz, direction.xz);
+            float c = dot(origin.xz, origin.xz) - 1.0;
+            if(SolveQuadratic(a, b, c, t0, t1))
+            {
+                vec3 p0 = origin + (t0 * direction);
+                vec3 p1 = origin + (t1 * direction);
+                if((p0.y >= 0.0) && (p0.y <= 1.0))
+                {
+                    KeepHit(t0, vec3(p0.x, 0.0, p0.z), vec2(AngleToU(-p0.z, p0.x), p0.y), hitT, hitNormal, hitUV);
+                }
+                if((p1.y >= 0.0) && (p1.y <= 1.0))
+                {
+                    KeepHit(t1, vec3(p1.x, 0.0, p1.z), vec2(AngleToU(-p1.z, p1.x), p1.y), hitT, hitNormal, hitUV);
+                }
+            }
+        }
+        if((impostorParts & IMPOSTOR_PART_TOP) != 0)
+        {
+            IntersectDisc(origin, direction, 1.0, 1.0, hitT, hitNormal, hitUV);
+        }
+        if((impostorParts & IMPOSTOR_PART_BOTTOM) != 0)
+        {
+            IntersectDisc(origin, direction, 0.0, -1.0, hitT, hitNormal, hitUV);
+        }
+    }
+    else if(impostorType == IMPOSTOR_CONE)
+    {
+        // x*x + z*z = (1 - y) * (1 - y), for y from 0 to 1
+        float h = 1.0 - origin.y;
+        float a = dot(direction.xz, direction.xz) - (direction.y * direction.y);
+        float b = 2.0 * (dot(origin.xz, direction.xz) + (h * direction.y));
+        float c = dot(origin.xz, origin.xz) - (h * h);
+        if(SolveQuadratic(a, b, c, t0, t1))
+        {
+            vec3 p0 = origin + (t0 * direction);
+            vec3 p1 = origin + (t1 * direction);
+            if((p0.y >= 0.0) && (p0.y <= 1.0))
+            {
+                KeepHit(t0, vec3(p0.x, 1.0 - p0.y, p0.z), vec2(AngleToU(-p0.z, p0.x), p0.y), hitT, hitNormal, hitUV);
+            }
+            if((p1.y >= 0.0) && (p1.y <= 1.0))
+            {
+                KeepHit(t1, vec3(p1.x, 1.0 - p1.y, p1.z), vec2(AngleToU(-p1.z, p1.x), p1.y), hitT, hitNormal, hitUV);
+            }
+        }
+        IntersectDisc(origin, direction, 0.0, -1.0, hitT, hitNormal, hitUV);
+    }
+    else if((impostorType == IMPOSTOR_SPHERE) || (impostorType == IMPOSTOR_HALF_SPHERE))
+    {
+        // the open half sphere shows its inside through the far root
+        float minimumY = (impostorType == IMPOSTOR_HALF_SPHERE) ? 0.0 : -1.0;
+        if(SolveQuadratic(dot(direction, direction), 2.0 * dot(origin, direction), dot(origin, origin) - 1.0, t0, t1))
+        {
+            vec3 p0 = origin + (t0 * direction);
+            vec3 p1 = origin + (t1 * direction);
+            if(p0.y >= minimumY)
+            {
+                KeepHit(t0, p0, vec2(AngleToU(-p0.z, p0.x), 1.0 - (acos(clamp(p0.y, -1.0, 1.0)) / PI)), hitT, hitNormal, hitUV);
+            }
+            if(p1.y >= minimumY)
+            {
+                KeepHit(t1, p1, vec2(AngleToU(-p1.z, p1.x), 1.0 - (acos(clamp(p1.y, -1.0, 1.0)) / PI)), hitT, hitNormal, hitUV);
+            }
+        }
+    }
+    else if((impostorType == IMPOSTOR_TORUS) || (impostorType == IMPOSTOR_HALF_TORUS))
+    {
+        IntersectTorus(origin, direction, impostorType == IMPOSTOR_HALF_TORUS, hitT, hitNormal, hitUV);
+    }
+
+    if(hitT >= 1e30)
+    {
+        return false;
+    }
+
+    vec4 worldPosition = model * vec4(origin + (hitT * direction), 1.0);
+    vec4 clipPosition = projection * view * worldPosition;
+    float depth = clipPosition.z / clipPosition.w;
+    if(depth < -1.0)
+    {
+        // the hit lies in front of the near plane
+        return false;
+    }
+
+    gl_FragDepth = (((gl_DepthRange.far - gl_DepthRange.near) * depth) + gl_DepthRange.near + gl_DepthRange.far) * 0.5;
+    position = worldPosition.xyz;
+    normal = mat3(normalMatrix) * normalize(hitNormal);
+    uv = hitUV;
+    return true;
+}
+#endif
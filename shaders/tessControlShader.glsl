@@ -0,0 +1,55 @@
+#version 400 core
+layout (vertices = 3) out;
+
+in vec3 controlPosition[];
+in vec3 controlNormal[];
+in vec2 controlTextureCoordinate[];
+
+out vec3 patchPosition[];
+out vec3 patchNormal[];
+out vec2 patchTextureCoordinate[];
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec2 viewportSize;
+// 0 for flat shapes, which are passed through untessellated
+uniform int surfaceType;
+// target length of a generated edge on screen, in pixels
+uniform float tessellationEdgePixels = 12.0;
+
+// position of a control point on screen, in pixels
+vec2 ToScreen(vec3 position)
+{
+   vec4 clip = projection * view * model * vec4(position, 1.0);
+   return (clip.xy / max(clip.w, 0.0001)) * 0.5 * viewportSize;
+}
+
+// tessellation level of the edge between two control points - it only
+// depends on the two end points, so the patches on either side of an
+// edge always agree and no cracks open along it
+float EdgeLevel(int first, int second)
+{
+   if (surfaceType == 0)
+   {
+      return 1.0;
+   }
+   float length = distance(ToScreen(controlPosition[first]), ToScreen(controlPosition[second]));
+   return clamp(length / tessellationEdgePixels, 1.0, 64.0);
+}
+
+void main()
+{
+   patchPosition[gl_InvocationID] = controlPosition[gl_InvocationID];
+   patchNormal[gl_InvocationID] = controlNormal[gl_InvocationID];
+   patchTextureCoordinate[gl_InvocationID] = controlTextureCoordinate[gl_InvocationID];
+
+   if (gl_InvocationID == 0)
+   {
+      // outer level i is the edge opposite control point i
+      gl_TessLevelOuter[0] = EdgeLevel(1, 2);
+      gl_TessLevelOuter[1] = EdgeLevel(2, 0);
+      gl_TessLevelOuter[2] = EdgeLevel(0, 1);
+      gl_TessLevelInner[0] = max(gl_TessLevelOuter[0], max(gl_TessLevelOuter[1], gl_TessLevelOuter[2]));
+   }
+}
@@ -0,0 +1,123 @@
+#version 400 core
+layout (triangles, fractional_odd_spacing, ccw) in;
+
+in vec3 patchPosition[];
+in vec3 patchNormal[];
+in vec2 patchTextureCoordinate[];
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+
+uniform mat4 model;
+uniform mat4 normalMatrix;
+uniform mat4 view;
+uniform mat4 projection;
+uniform int surfaceType;
+// tube radius of the torus relative to its main radius of 1, set each
+// frame from the radius the torus mesh is generated with
+uniform float torusTubeRadius;
+
+// surface types, matching the values set by SceneMeshes
+const int SURFACE_FLAT = 0;
+const int SURFACE_CYLINDER = 1;
+const int SURFACE_CONE = 2;
+const int SURFACE_SPHERE = 3;
+const int SURFACE_TORUS = 4;
+
+const float PI = 3.14159265358979;
+
+// angle of a point on a disc around the Y axis, matching the way the
+// shapes are generated from +X toward -Z
+float DiscAngle(vec3 position)
+{
+   return atan(-position.z, position.x);
+}
+
+// place a point of a cap triangle on the unit disc.  One corner is the
+// disc center; the distance from it and the angle between the two rim
+// corners are interpolated, so rim edges follow the circle exactly and
+// meet the side wall of the shape without a crack
+vec3 EvaluateDisc(vec3 weights, vec3 flatPosition)
+{
+   int center = 0;
+   for (int i = 1; i < 3; i++)
+   {
+      if (length(patchPosition[i].xz) < length(patchPosition[center].xz))
+      {
+         center = i;
+      }
+   }
+   int rimA = (center + 1) % 3;
+   int rimB = (center + 2) % 3;
+
+   float rimWeight = weights[rimA] + weights[rimB];
+   if (rimWeight <= 0.0)
+   {
+      return patchPosition[center];
+   }
+
+   float angleA = DiscAngle(patchPosition[rimA]);
+   float angleB = DiscAngle(patchPosition[rimB]);
+   if (angleB - angleA > PI)
+   {
+      angleB -= 2.0 * PI;
+   }
+   else if (angleA - angleB > PI)
+   {
+      angleB += 2.0 * PI;
+   }
+   float angle = ((weights[rimA] * angleA) + (weights[rimB] * angleB)) / rimWeight;
+
+   return vec3(rimWeight * cos(angle), flatPosition.y, -rimWeight * sin(angle));
+}
+
+void main()
+{
+   vec3 weights = gl_TessCoord;
+   vec3 position = (weights.x * patchPosition[0]) + (weights.y * patchPosition[1]) + (weights.z * patchPosition[2]);
+   vec3 normal = normalize((weights.x * patchNormal[0]) + (weights.y * patchNormal[1]) + (weights.z * patchNormal[2]));
+   vec2 uv = (weights.x * patchTextureCoordinate[0]) + (weights.y * patchTextureCoordinate[1]) + (weights.z * patchTextureCoordinate[2]);
+
+   // the texture coordinates of the curved shapes are their surface
+   // parameters, so the exact surface is evaluated from them
+   bool bCap = abs(normal.y) > 0.9;
+   if (((surfaceType == SURFACE_CYLINDER) || (surfaceType == SURFACE_CONE)) && bCap)
+   {
+      position = EvaluateDisc(weights, position);
+      uv = vec2((position.x * 0.5) + 0.5, 0.5 - (position.z * 0.5));
+   }
+   else if (surfaceType == SURFACE_CYLINDER)
+   {
+      float angle = uv.x * 2.0 * PI;
+      normal = vec3(cos(angle), 0.0, -sin(angle));
+      position = vec3(normal.x, uv.y, normal.z);
+   }
+   else if (surfaceType == SURFACE_CONE)
+   {
+      float angle = uv.x * 2.0 * PI;
+      float radius = 1.0 - uv.y;
+      normal = normalize(vec3(cos(angle), 1.0, -sin(angle)));
+      position = vec3(radius * cos(angle), uv.y, -radius * sin(angle));
+   }
+   else if (surfaceType == SURFACE_SPHERE)
+   {
+      float polarAngle = (1.0 - uv.y) * PI;
+      float angle = uv.x * 2.0 * PI;
+      normal = vec3(sin(polarAngle) * cos(angle), cos(polarAngle), -sin(polarAngle) * sin(angle));
+      position = normal;
+   }
+   else if (surfaceType == SURFACE_TORUS)
+   {
+      float mainAngle = uv.x * 2.0 * PI;
+      float tubeAngle = uv.y * 2.0 * PI;
+      vec3 ringDirection = vec3(cos(mainAngle), sin(mainAngle), 0.0);
+      normal = (ringDirection * cos(tubeAngle)) + vec3(0.0, 0.0, sin(tubeAngle));
+      position = ringDirection + (normal * torusTubeRadius);
+   }
+
+   fragmentPosition = vec3(model * vec4(position, 1.0));
+   gl_Position = projection * view * vec4(fragmentPosition, 1.0);
+   fragmentVertexNormal = mat3(normalMatrix) * normal;
+   fragmentTextureCoordinate = uv;
+}
@@ -0,0 +1,32 @@
+#version 400 core
+// quantized vertex - position normalized against the mesh bounds,
+// normal folded onto an octahedron, texture coordinate in 0..1
+layout (location = 0) in vec4 inVertexPosition;
+layout (location = 1) in vec2 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// patch control points stay in object space - the evaluation
+// shader places the generated vertices on the exact surface
+out vec3 controlPosition;
+out vec3 controlNormal;
+out vec2 controlTextureCoordinate;
+
+uniform vec3 meshBoundsMin;
+uniform vec3 meshBoundsExtent;
+
+// unfold an octahedral encoded normal back onto the unit sphere
+vec3 DecodeOctahedral(vec2 encoded)
+{
+   vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+   float fold = max(-normal.z, 0.0);
+   normal.x += (normal.x >= 0.0) ? -fold : fold;
+   normal.y += (normal.y >= 0.0) ? -fold : fold;
+   return normalize(normal);
+}
+
+void main()
+{
+   controlPosition = meshBoundsMin + (inVertexPosition.xyz * meshBoundsExtent);
+   controlNormal = DecodeOctahedral(inVertexNormal);
+   controlTextureCoordinate = inTextureCoordinate;
+}
@@ -1,20 +1,70 @@
 #version 330 core
-layout (location = 0) in vec3 inVertexPosition;
-layout (location = 1) in vec3 inVertexNormal;
+// quantized vertex - position normalized against the mesh bounds,
+// normal folded onto an octahedron, texture coordinate in 0..1
+layout (location = 0) in vec4 inVertexPosition;
+layout (location = 1) in vec2 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+#ifdef IMPOSTORS
+// object space proxy position and ray origin of an impostor draw
+out vec3 impostorPosition;
+out vec3 impostorRayOrigin;
+#endif
 
 uniform mat4 model;
+uniform mat4 normalMatrix;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec3 meshBoundsMin;
+uniform vec3 meshBoundsExtent;
+#ifdef IMPOSTORS
+// nonzero when the mesh is the proxy box of a ray-cast impostor
+uniform int impostorType = 0;
+// camera position and view direction in the object space of the
+// shape, moved there once per draw instead of once per vertex
+uniform vec3 impostorCameraPosition;
+uniform vec3 impostorCameraForward;
+#endif
+
+// unfold an octahedral encoded normal back onto the unit sphere
+vec3 DecodeOctahedral(vec2 encoded)
+{
+   vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+   float fold = max(-normal.z, 0.0);
+   normal.x += (normal.x >= 0.0) ? -fold : fold;
+   normal.y += (normal.y >= 0.0) ? -fold : fold;
+   return normalize(normal);
+}
 
 void main()
 {
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
+   vec3 position = meshBoundsMin + (inVertexPosition.xyz * meshBoundsExtent);
+
+   fragmentPosition = vec3(model * vec4(position, 1.0));
+   gl_Position = projection * view * model * vec4(position, 1.0f);
+   fragmentVertexNormal = mat3(normalMatrix) * DecodeOctahedral(inVertexNormal);
    fragmentTextureCoordinate = inTextureCoordinate;
+
+#ifdef IMPOSTORS
+   // the fragment shader casts the view ray in object space, where the
+   // shapes have their plain unit dimensions
+   impostorPosition = position;
+   impostorRayOrigin = position;
+   if (impostorType != 0)
+   {
+      if (projection[3][3] == 0.0)
+      {
+         // perspective - every ray starts at the camera
+         impostorRayOrigin = impostorCameraPosition;
+      }
+      else
+      {
+         // orthographic - parallel rays start behind the proxy box
+         impostorRayOrigin = position - (impostorCameraForward * 4.0);
+      }
+   }
+#endif
 }
\ No newline at end of file